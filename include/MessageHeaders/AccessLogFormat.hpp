@@ -0,0 +1,195 @@
+#ifndef MESSAGE_HEADERS_ACCESS_LOG_FORMAT_HPP
+#define MESSAGE_HEADERS_ACCESS_LOG_FORMAT_HPP
+
+/**
+ * @file AccessLogFormat.hpp
+ *
+ * This module declares the MessageHeaders::AccessLogFormat class,
+ * which renders access log lines from message headers.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MessageHeaders
+{
+    /**
+     * These are the ways in which the values put into
+     * an access log line may be escaped.
+     */
+    enum class AccessLogEscaping {
+        /**
+         * Double quotes, backslashes, control characters and
+         * characters outside of ASCII are written as \xHH
+         * (the nginx "default" escaping).
+         */
+        Default,
+
+        /**
+         * Values are escaped for use within JSON strings.
+         */
+        Json,
+
+        /**
+         * Values are written as they are.
+         */
+        None,
+    };
+
+    /**
+     * This renders access log lines in a format given in the style
+     * of nginx's log_format directive, such as:
+     *
+     *     $remote_addr "$http_user_agent" $sent_http_content_type
+     *
+     * Variables named $http_NAME are replaced by the request header
+     * NAME, and $sent_http_NAME by the response header NAME, with
+     * underscores in the name standing for dashes.  Any other variable
+     * is given a number, in the order the variables first appear,
+     * and its value is supplied when the line is rendered.  A name may
+     * be put in braces, as in ${http_host}, to separate it from text
+     * which follows.  Missing values are written as "-".  The values
+     * of several headers sharing a name are joined with commas.
+     *
+     * The format is compiled once, when the object is made, into a
+     * sequence of literal text and references to headers, whose names
+     * are hashed ahead of time.  Rendering then writes each line into
+     * a buffer in one pass, escaping values as they're copied in.
+     */
+    class AccessLogFormat {
+        // Public Methods
+    public:
+        /**
+         * This constructs the object by compiling the given format.
+         *
+         * @param[in] format
+         *     This is the format of the access log lines.
+         *
+         * @param[in] escaping
+         *     This is how to escape the values put into the lines.
+         */
+        explicit AccessLogFormat(
+            std::string_view format,
+            AccessLogEscaping escaping = AccessLogEscaping::Default
+        );
+
+        /**
+         * This method returns the names of the variables,
+         * other than headers, used in the format, in the order
+         * of their numbers.
+         *
+         * @return
+         *     The names of the variables used in the format,
+         *     without their dollar signs, are returned.
+         */
+        const std::vector< std::string >& GetVariables() const;
+
+        /**
+         * This method renders an access log line for the given
+         * request and response, replacing the contents of the given
+         * buffer, whose memory is reused.
+         *
+         * @param[in] request
+         *     These are the headers of the request.
+         *
+         * @param[in] response
+         *     These are the headers of the response.
+         *
+         * @param[in] variables
+         *     These are the values of the variables, other than headers,
+         *     used in the format, in the order given by GetVariables.
+         *     Missing or empty values are written as "-".
+         *
+         * @param[out] output
+         *     This is where to store the access log line.
+         */
+        void Render(
+            const MessageHeaders& request,
+            const MessageHeaders& response,
+            const std::vector< std::string_view >& variables,
+            std::string& output
+        ) const;
+
+        /**
+         * This method renders an access log line for the given
+         * request and response, for a format using only headers.
+         *
+         * @param[in] request
+         *     These are the headers of the request.
+         *
+         * @param[in] response
+         *     These are the headers of the response.
+         *
+         * @param[out] output
+         *     This is where to store the access log line.
+         */
+        void Render(
+            const MessageHeaders& request,
+            const MessageHeaders& response,
+            std::string& output
+        ) const;
+
+        // Private properties
+    private:
+        /**
+         * This is a single step of rendering a line.
+         */
+        struct Operation {
+            /**
+             * These are the kinds of step.
+             */
+            enum class Kind {
+                Literal,
+                RequestHeader,
+                ResponseHeader,
+                Variable,
+            };
+
+            /**
+             * This is the kind of step.
+             */
+            Kind kind;
+
+            /**
+             * This is the literal text, or the name of the header.
+             */
+            std::string text;
+
+            /**
+             * This is the hash of the name of the header.
+             */
+            uint64_t nameHash = 0;
+
+            /**
+             * This is the number of the variable.
+             */
+            size_t variable = 0;
+        };
+
+        /**
+         * These are the steps of rendering a line.
+         */
+        std::vector< Operation > operations_;
+
+        /**
+         * These are the names of the variables, other than headers,
+         * used in the format.
+         */
+        std::vector< std::string > variables_;
+
+        /**
+         * This is how to escape the values put into the lines.
+         */
+        AccessLogEscaping escaping_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
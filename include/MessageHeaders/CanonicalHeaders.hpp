@@ -0,0 +1,137 @@
+#ifndef MESSAGE_HEADERS_CANONICAL_HEADERS_HPP
+#define MESSAGE_HEADERS_CANONICAL_HEADERS_HPP
+
+/**
+ * @file CanonicalHeaders.hpp
+ *
+ * This module declares the MessageHeaders::CanonicalHeaders class,
+ * which produces the canonical headers of AWS Signature Version 4
+ * style request signing.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <functional>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+namespace MessageHeaders
+{
+    /**
+     * This produces the canonical headers of a request, and the list
+     * of signed headers, as used by AWS Signature Version 4:
+     *
+     *     host:example.amazonaws.com\n
+     *     x-amz-date:20150830T123600Z\n
+     *
+     * and
+     *
+     *     host;x-amz-date
+     *
+     * Headers are ordered by their lowercase names, with values of
+     * headers sharing a name joined with commas in the order they
+     * appear.  Values have whitespace at either end removed and runs
+     * of spaces inside reduced to one space.
+     *
+     * The headers are put in order once, when the object is made,
+     * by sorting their positions; nothing is copied.  The output is
+     * streamed, a piece at a time, to a sink such as a hash update.
+     * The object refers to the message headers, which must not be
+     * modified while it's in use.
+     */
+    class CanonicalHeaders {
+        // Public Methods
+    public:
+        /**
+         * This is the type of function which receives the output,
+         * in order, a piece at a time.
+         */
+        typedef std::function< void(std::string_view piece) > Sink;
+
+        /**
+         * This constructs the object to cover every header
+         * of the given message headers.
+         *
+         * @param[in] headers
+         *     These are the headers of the request.
+         */
+        explicit CanonicalHeaders(const MessageHeaders& headers);
+
+        /**
+         * This constructs the object to cover only the
+         * headers named in the given list of signed headers.
+         *
+         * @param[in] headers
+         *     These are the headers of the request.
+         *
+         * @param[in] signedHeaders
+         *     This is the list of names of headers to cover,
+         *     separated by semicolons, as found in the SignedHeaders
+         *     part of the Authorization header.
+         */
+        CanonicalHeaders(
+            const MessageHeaders& headers,
+            std::string_view signedHeaders
+        );
+
+        /**
+         * This method determines whether or not every header
+         * named in the list of signed headers was found.
+         *
+         * @return
+         *     An indication of whether or not every header named
+         *     in the list of signed headers was found is returned.
+         */
+        bool IsValid() const;
+
+        /**
+         * This method streams the canonical headers to the given sink.
+         *
+         * @param[in] sink
+         *     This is the function which receives the canonical headers.
+         */
+        void Emit(const Sink& sink) const;
+
+        /**
+         * This method streams the list of signed headers
+         * to the given sink.
+         *
+         * @param[in] sink
+         *     This is the function which receives the list.
+         */
+        void EmitSignedHeaders(const Sink& sink) const;
+
+        // Private Methods
+    private:
+        /**
+         * This method puts the positions of the covered headers
+         * in the order of their lowercase names.
+         */
+        void Sort();
+
+        // Private properties
+    private:
+        /**
+         * These are the headers of the request.
+         */
+        const MessageHeaders& headers_;
+
+        /**
+         * These are the positions of the covered headers,
+         * in canonical order.
+         */
+        std::vector< uint32_t > order_;
+
+        /**
+         * This indicates whether or not every header named
+         * in the list of signed headers was found.
+         */
+        bool isValid_ = true;
+    };
+
+} // namespace MessageHeaders
+
+#endif
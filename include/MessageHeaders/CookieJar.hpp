@@ -0,0 +1,175 @@
+#ifndef MESSAGE_HEADERS_COOKIE_JAR_HPP
+#define MESSAGE_HEADERS_COOKIE_JAR_HPP
+
+/**
+ * @file CookieJar.hpp
+ *
+ * This module declares the MessageHeaders::CookieJar class.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <memory>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/SetCookie.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+namespace MessageHeaders
+{
+    /**
+     * This holds the cookies a client has received (RFC 6265),
+     * and writes the Cookie header for each request it makes.
+     *
+     * Cookies are indexed by domain, in a tree of domain labels
+     * starting from the top-level domain, and then by path, so finding
+     * the cookies for a request costs in proportion to the number of
+     * labels in the host and segments in the path, rather than the
+     * number of cookies held.  Cookies which expire are kept in
+     * order of expiry, and are dropped as time passes.
+     *
+     * There is no public suffix list, so the only check made on the
+     * Domain attribute is that it matches the host of the request
+     * and holds at least two labels.
+     */
+    class CookieJar {
+        // Lifecycle Management
+    public:
+        ~CookieJar();
+        CookieJar(const CookieJar&) = delete;
+        CookieJar(CookieJar&&);
+        CookieJar& operator=(const CookieJar&) = delete;
+        CookieJar& operator=(CookieJar&&);
+
+        // Public Methods
+    public:
+        /**
+         * This is the default constructor.
+         */
+        CookieJar();
+
+        /**
+         * This method stores, replaces, or removes a cookie,
+         * as directed by a Set-Cookie header received in a response.
+         *
+         * @param[in] cookie
+         *     This is the Set-Cookie header.
+         *
+         * @param[in] requestHost
+         *     This is the host to which the request was made.
+         *
+         * @param[in] requestPath
+         *     This is the path of the request.
+         *
+         * @param[in] now
+         *     This is the current time, in seconds since the UNIX epoch.
+         *
+         * @return
+         *     An indication of whether or not the header was accepted
+         *     is returned.  Headers which are not valid, or which
+         *     name a domain not matching the request, are ignored.
+         */
+        bool StoreCookie(
+            const SetCookie& cookie,
+            std::string_view requestHost,
+            std::string_view requestPath,
+            int64_t now
+        );
+
+        /**
+         * This method applies every Set-Cookie header
+         * of the given response.
+         *
+         * @param[in] responseHeaders
+         *     These are the headers of the response.
+         *
+         * @param[in] requestHost
+         *     This is the host to which the request was made.
+         *
+         * @param[in] requestPath
+         *     This is the path of the request.
+         *
+         * @param[in] now
+         *     This is the current time, in seconds since the UNIX epoch.
+         *
+         * @return
+         *     The number of Set-Cookie headers accepted is returned.
+         */
+        size_t StoreCookies(
+            const MessageHeaders& responseHeaders,
+            std::string_view requestHost,
+            std::string_view requestPath,
+            int64_t now
+        );
+
+        /**
+         * This method drops every cookie which has expired.
+         *
+         * @param[in] now
+         *     This is the current time, in seconds since the UNIX epoch.
+         */
+        void RemoveExpiredCookies(int64_t now);
+
+        /**
+         * This method returns the number of cookies held.
+         *
+         * @return
+         *     The number of cookies held is returned.
+         */
+        size_t GetCookieCount() const;
+
+        /**
+         * This method adds a Cookie header to the given request,
+         * holding every unexpired cookie which should be sent with it,
+         * ordered with longer paths first, and then by when the
+         * cookies were first stored.  If no cookie should be sent,
+         * no header is added.
+         *
+         * @param[in,out] requestHeaders
+         *     These are the headers of the request.
+         *
+         * @param[in] requestHost
+         *     This is the host to which the request is made.
+         *
+         * @param[in] requestPath
+         *     This is the path of the request.
+         *
+         * @param[in] secure
+         *     This indicates whether or not the request is made over
+         *     a secure channel.  Secure cookies are only sent if it is.
+         *
+         * @param[in] now
+         *     This is the current time, in seconds since the UNIX epoch.
+         *
+         * @return
+         *     An indication of whether or not a Cookie header
+         *     was added is returned.
+         */
+        bool AddCookieHeader(
+            MessageHeaders& requestHeaders,
+            std::string_view requestHost,
+            std::string_view requestPath,
+            bool secure,
+            int64_t now
+        );
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< struct Impl > impl_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
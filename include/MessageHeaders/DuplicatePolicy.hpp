@@ -0,0 +1,49 @@
+#ifndef MESSAGE_HEADERS_DUPLICATE_POLICY_HPP
+#define MESSAGE_HEADERS_DUPLICATE_POLICY_HPP
+
+/**
+ * @file DuplicatePolicy.hpp
+ *
+ * This module declares the MessageHeaders::DuplicatePolicy enumeration.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+namespace MessageHeaders
+{
+    /**
+     * These are the ways of dealing with a header which appears
+     * more than once in the same message.
+     */
+    enum class DuplicatePolicy {
+        /**
+         * Keep every instance of the header, separately.
+         */
+        KeepSeparate,
+
+        /**
+         * Combine all instances into one, with the values
+         * separated by commas.
+         */
+        Combine,
+
+        /**
+         * Consider the message bad.
+         */
+        Reject,
+
+        /**
+         * Keep only the first instance of the header.
+         */
+        FirstWins,
+
+        /**
+         * Keep only the last instance of the header.
+         */
+        LastWins,
+    };
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,889 @@
+#ifndef MESSAGE_HEADERS_FIXED_MESSAGE_HEADERS_HPP
+#define MESSAGE_HEADERS_FIXED_MESSAGE_HEADERS_HPP
+
+/**
+ * @file FixedMessageHeaders.hpp
+ *
+ * This module declares the MessageHeaders::FixedMessageHeaders
+ * class template.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string_view>
+#include <utility>
+
+namespace MessageHeaders
+{
+    /**
+     * These are the reasons an operation on a
+     * FixedMessageHeaders may fail.
+     */
+    enum class FixedHeadersError {
+        /**
+         * The last operation succeeded.
+         */
+        None,
+
+        /**
+         * The headers were not valid, a line was longer
+         * than the line limit, or the headers didn't end.
+         */
+        Malformed,
+
+        /**
+         * There was no room for another header.
+         */
+        TooManyHeaders,
+
+        /**
+         * There was no room for the bytes of a header.
+         */
+        OutOfSpace,
+    };
+
+    /**
+     * This holds the headers of a message, like MessageHeaders, but
+     * keeps everything inside the object itself, up to a fixed number
+     * of headers and a fixed number of bytes of names and values.  It
+     * never allocates memory, so the time its operations take depends
+     * only on the sizes of the headers involved, for paths on which
+     * allocating memory isn't allowed.
+     *
+     * Headers are parsed following the same rules as HeaderParser,
+     * with folded values unfolded straight into the object.  Running
+     * out of room is an error reported by the operation which ran
+     * out, and leaves the headers as they were.
+     *
+     * Names and values are stored back to back, in the order of the
+     * headers, and room freed by removing or shortening headers is
+     * given back at once by moving the bytes after it.  Names and
+     * values passed in may refer to the object's own storage, such as
+     * values returned by GetHeaderValue.
+     *
+     * @tparam MaxHeaders
+     *     This is the largest number of headers held.
+     *
+     * @tparam MaxBytes
+     *     This is the largest number of bytes of names
+     *     and values held, all together.
+     */
+    template< size_t MaxHeaders, size_t MaxBytes > class FixedMessageHeaders {
+        // Public Methods
+    public:
+        /**
+         * This is a view of one header held.  Both parts refer
+         * to the object's storage, and so are only good until
+         * the headers are next changed.
+         */
+        struct Header {
+            /**
+             * This is the part of a header that comes before the colon.
+             */
+            std::string_view name;
+
+            /**
+             * This is the part of a header that comes after the colon.
+             */
+            std::string_view value;
+        };
+
+        /**
+         * This method sets a limit for the number of characters
+         * in any header line parsed.  Unlike MessageHeaders, the
+         * limit applies only to parsing; GenerateRawHeaders doesn't
+         * fold long lines.
+         *
+         * @param[in] newLineLengthLimit
+         *      This is the maximum number of characters, including
+         *      the 2-character CRLF line terminator, that should be
+         *      allowed for a single header line, or zero for no limit.
+         */
+        void SetLineLimit(size_t newLineLengthLimit) {
+            lineLengthLimit_ = newLineLengthLimit;
+        }
+
+        /**
+         * This method parses the headers of the given raw message,
+         * adding them to the headers held.  If the message is bad,
+         * or its headers don't fit, none of them are added.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message to parse.
+         *
+         * @param[out] bodyOffset
+         *     This is where to store the offset into the given
+         *     raw message where the headers ended and the body,
+         *     if any, begins.
+         *
+         * @return
+         *     An indication of whether or not the message was
+         *     parsed successfully is returned.  If it wasn't,
+         *     GetLastError says why.
+         */
+        bool ParseRawMessage(std::string_view rawMessage, size_t& bodyOffset) {
+            const auto oldCount = count_;
+            const auto oldUsed = used_;
+            const auto fail = [this, oldCount, oldUsed](FixedHeadersError error) {
+                count_ = oldCount;
+                used_ = oldUsed;
+                lastError_ = error;
+                return false;
+            };
+            size_t offset = 0;
+            while (offset < rawMessage.length()) {
+                // Find the end of the current line.
+                auto lineTerminator = rawMessage.find("\r\n", offset);
+                if (lineTerminator == std::string_view::npos) {
+                    break;
+                }
+                if (
+                    (lineLengthLimit_ > 0)
+                    && (lineTerminator + 2 - offset > lineLengthLimit_)
+                ) {
+                    return fail(FixedHeadersError::Malformed);
+                }
+
+                // Stop if empty line is found.
+                if (lineTerminator == offset) {
+                    offset += 2;
+                    break;
+                }
+
+                // Separate the header name from the header value.
+                const auto nameValueDelimiter = rawMessage.find(':', offset);
+                if (nameValueDelimiter > lineTerminator) {
+                    return fail(FixedHeadersError::Malformed);
+                }
+                for (auto i = offset; i < nameValueDelimiter; ++i) {
+                    if (
+                        (rawMessage[i] < 33)
+                        || (rawMessage[i] > 126)
+                    ) {
+                        return fail(FixedHeadersError::Malformed);
+                    }
+                }
+                if (count_ == MaxHeaders) {
+                    return fail(FixedHeadersError::TooManyHeaders);
+                }
+                auto& entry = entries_[count_];
+                entry.offset = used_;
+                entry.nameLength = nameValueDelimiter - offset;
+                if (
+                    !Append(rawMessage.substr(offset, entry.nameLength))
+                    || !Append(
+                        rawMessage.substr(
+                            nameValueDelimiter + 1,
+                            lineTerminator - nameValueDelimiter - 1
+                        )
+                    )
+                ) {
+                    return fail(FixedHeadersError::OutOfSpace);
+                }
+
+                // Unfold any following lines which begin with whitespace.
+                offset = lineTerminator + 2;
+                for (;;) {
+                    const auto nextLineStart = lineTerminator + 2;
+                    const auto nextLineTerminator = rawMessage.find("\r\n", nextLineStart);
+                    if (nextLineTerminator == std::string_view::npos) {
+                        return fail(FixedHeadersError::Malformed);
+                    }
+                    if (
+                        (nextLineTerminator - nextLineStart <= 2)
+                        || (
+                            (rawMessage[nextLineStart] != ' ')
+                            && (rawMessage[nextLineStart] != '\t')
+                        )
+                    ) {
+                        break;
+                    }
+                    auto foldStart = nextLineStart;
+                    while (
+                        (rawMessage[foldStart] == ' ')
+                        || (rawMessage[foldStart] == '\t')
+                    ) {
+                        ++foldStart;
+                    }
+                    if (
+                        !Append(" ")
+                        || !Append(rawMessage.substr(foldStart, nextLineTerminator - foldStart))
+                    ) {
+                        return fail(FixedHeadersError::OutOfSpace);
+                    }
+                    offset = nextLineTerminator + 2;
+                    lineTerminator = nextLineTerminator;
+                }
+
+                // Remove any whitespace that might be at the beginning
+                // or end of the header value.
+                auto valueStart = entry.offset + entry.nameLength;
+                auto valueEnd = used_;
+                while (
+                    (valueEnd > valueStart)
+                    && ((bytes_[valueEnd - 1] == ' ') || (bytes_[valueEnd - 1] == '\t'))
+                ) {
+                    --valueEnd;
+                }
+                auto strippedStart = valueStart;
+                while (
+                    (strippedStart < valueEnd)
+                    && ((bytes_[strippedStart] == ' ') || (bytes_[strippedStart] == '\t'))
+                ) {
+                    ++strippedStart;
+                }
+                entry.valueLength = valueEnd - strippedStart;
+                (void)memmove(bytes_.data() + valueStart, bytes_.data() + strippedStart, entry.valueLength);
+                used_ = valueStart + entry.valueLength;
+                entry.nameHash = HashHeaderName(GetName(entry));
+                ++count_;
+            }
+            if (offset == 0) {
+                return fail(FixedHeadersError::Malformed);
+            }
+            bodyOffset = offset;
+            lastError_ = FixedHeadersError::None;
+            return true;
+        }
+
+        /**
+         * This method parses the headers of the given raw message,
+         * adding them to the headers held.  If the message is bad,
+         * or its headers don't fit, none of them are added.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message to parse.
+         *
+         * @return
+         *     An indication of whether or not the message was
+         *     parsed successfully is returned.  If it wasn't,
+         *     GetLastError says why.
+         */
+        bool ParseRawMessage(std::string_view rawMessage) {
+            size_t bodyOffset;
+            return ParseRawMessage(rawMessage, bodyOffset);
+        }
+
+        /**
+         * This method returns why the last operation which
+         * could fail did so.
+         *
+         * @return
+         *     The reason the last operation failed is returned.
+         *
+         * @retval FixedHeadersError::None
+         *     This is returned if the last operation succeeded.
+         */
+        FixedHeadersError GetLastError() const {
+            return lastError_;
+        }
+
+        /**
+         * This method returns the number of headers held.
+         *
+         * @return
+         *     The number of headers held is returned.
+         */
+        size_t GetHeaderCount() const {
+            return count_;
+        }
+
+        /**
+         * This method returns the number of bytes of names
+         * and values held.
+         *
+         * @return
+         *     The number of bytes of names and values held is returned.
+         */
+        size_t GetBytesUsed() const {
+            return used_;
+        }
+
+        /**
+         * This method returns the header at the given position.
+         *
+         * @param[in] index
+         *     This is the position of the header to return.
+         *
+         * @return
+         *     The header is returned.
+         */
+        Header GetHeader(size_t index) const {
+            const auto& entry = entries_[index];
+            return {GetName(entry), GetValue(entry)};
+        }
+
+        /**
+         * This method finds the next header with the given name.
+         *
+         * @param[in] name
+         *     This is the name of the header to find.
+         *
+         * @param[in] startIndex
+         *     This is the position at which to start looking.
+         *
+         * @return
+         *     The position of the header is returned.
+         *
+         * @retval GetHeaderCount()
+         *     This is returned if there is no such header.
+         */
+        size_t FindHeader(std::string_view name, size_t startIndex = 0) const {
+            const auto nameHash = HashHeaderName(name);
+            for (auto index = startIndex; index < count_; ++index) {
+                const auto& entry = entries_[index];
+                if (
+                    (entry.nameHash == nameHash)
+                    && HeaderNamesEqual(GetName(entry), name)
+                ) {
+                    return index;
+                }
+            }
+            return count_;
+        }
+
+        /**
+         * This method determines whether or not there is
+         * a header with the given name.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @return
+         *     An indication of whether or not there is a header
+         *     with the given name is returned.
+         */
+        bool HasHeader(std::string_view name) const {
+            return FindHeader(name) < count_;
+        }
+
+        /**
+         * This method returns the value of the first header with the
+         * given name.  Unlike MessageHeaders::GetHeaderValue, values of
+         * repeated headers aren't joined, since that would need memory;
+         * use FindHeader to go through them.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @return
+         *     The value of the first header with the name is returned,
+         *     or an empty value if there is none.
+         */
+        std::string_view GetHeaderValue(std::string_view name) const {
+            const auto index = FindHeader(name);
+            if (index == count_) {
+                return {};
+            }
+            return GetValue(entries_[index]);
+        }
+
+        /**
+         * This method adds a header after the headers held.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @param[in] value
+         *     This is the value of the header.
+         *
+         * @return
+         *     An indication of whether or not the header was added
+         *     is returned.  If it wasn't, GetLastError says why.
+         */
+        bool AddHeader(std::string_view name, std::string_view value) {
+            if (count_ == MaxHeaders) {
+                lastError_ = FixedHeadersError::TooManyHeaders;
+                return false;
+            }
+            if (name.length() + value.length() > MaxBytes - used_) {
+                lastError_ = FixedHeadersError::OutOfSpace;
+                return false;
+            }
+            auto& entry = entries_[count_++];
+            entry.offset = used_;
+            entry.nameLength = name.length();
+            entry.valueLength = value.length();
+            entry.nameHash = HashHeaderName(name);
+            (void)Append(name);
+            (void)Append(value);
+            lastError_ = FixedHeadersError::None;
+            return true;
+        }
+
+        /**
+         * This method sets the value of the first header with the
+         * given name, removing any others with the name, or adds the
+         * header if there is none.  A value taken from the object's
+         * own storage is moved into place without being copied
+         * aside, except that one spanning more than one name or value
+         * needs room for a copy of it.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @param[in] value
+         *     This is the value of the header.
+         *
+         * @return
+         *     An indication of whether or not the header was set
+         *     is returned.  If it wasn't, GetLastError says why.
+         */
+        bool SetHeader(std::string_view name, std::string_view value) {
+            const auto first = FindHeader(name);
+            if (first == count_) {
+                return AddHeader(name, value);
+            }
+
+            // Find the other headers to remove before changing anything,
+            // since the name given may refer to one of them, and make
+            // sure everything fits.
+            std::array< size_t, MaxHeaders > others;
+            size_t numOthers = 0;
+            size_t freed = entries_[first].valueLength;
+            for (auto index = FindHeader(name, first + 1); index < count_; index = FindHeader(name, index + 1)) {
+                others[numOthers++] = index;
+                freed += entries_[index].nameLength + entries_[index].valueLength;
+            }
+            if (value.length() > MaxBytes - used_ + freed) {
+                lastError_ = FixedHeadersError::OutOfSpace;
+                return false;
+            }
+
+            // The value given may refer to the storage, which is about
+            // to be moved around.  It's safe to use as it is only if it
+            // lies before the value being replaced, which doesn't move.
+            const auto storage = bytes_.data();
+            const auto valueStart = entries_[first].offset + entries_[first].nameLength;
+            const std::less< const char* > isBefore;
+            if (
+                isBefore(value.data(), storage)
+                || !isBefore(value.data(), storage + MaxBytes)
+                || (value.data() + value.length() <= storage + valueStart)
+            ) {
+                while (numOthers > 0) {
+                    RemoveAt(others[--numOthers]);
+                }
+                ReplaceValue(first, value);
+            } else if (
+                !SetValueFromStorage(
+                    first,
+                    others,
+                    numOthers,
+                    (size_t)(value.data() - storage),
+                    value.length()
+                )
+            ) {
+                lastError_ = FixedHeadersError::OutOfSpace;
+                return false;
+            }
+            lastError_ = FixedHeadersError::None;
+            return true;
+        }
+
+        /**
+         * This method removes all headers with the given name.
+         *
+         * @param[in] name
+         *     This is the name of the headers to remove.
+         */
+        void RemoveHeader(std::string_view name) {
+            // Find the headers to remove before removing any, since
+            // the name given may refer to one of them.
+            std::array< size_t, MaxHeaders > matches;
+            size_t numMatches = 0;
+            for (auto index = FindHeader(name); index < count_; index = FindHeader(name, index + 1)) {
+                matches[numMatches++] = index;
+            }
+            while (numMatches > 0) {
+                RemoveAt(matches[--numMatches]);
+            }
+        }
+
+        /**
+         * This method removes all headers.
+         */
+        void Clear() {
+            count_ = 0;
+            used_ = 0;
+        }
+
+        /**
+         * This method returns the length of the raw headers
+         * GenerateRawHeaders would write.
+         *
+         * @return
+         *     The length of the raw headers is returned.
+         */
+        size_t GetRawHeadersLength() const {
+            return used_ + count_ * 4 + 2;
+        }
+
+        /**
+         * This method writes the raw headers, ending in the empty
+         * line which ends the headers, to the given buffer.
+         *
+         * @param[out] output
+         *     This is where to write the raw headers.
+         *
+         * @param[in] capacity
+         *     This is the number of bytes the buffer holds.
+         *
+         * @param[out] length
+         *     This is where to store the length of the raw headers.
+         *
+         * @return
+         *     An indication of whether or not the raw headers fit
+         *     into the buffer is returned.  If they didn't, nothing
+         *     is written.
+         */
+        bool GenerateRawHeaders(char* output, size_t capacity, size_t& length) const {
+            length = GetRawHeadersLength();
+            if (length > capacity) {
+                return false;
+            }
+            for (size_t index = 0; index < count_; ++index) {
+                const auto& entry = entries_[index];
+                (void)memcpy(output, bytes_.data() + entry.offset, entry.nameLength);
+                output += entry.nameLength;
+                *output++ = ':';
+                *output++ = ' ';
+                (void)memcpy(output, bytes_.data() + entry.offset + entry.nameLength, entry.valueLength);
+                output += entry.valueLength;
+                *output++ = '\r';
+                *output++ = '\n';
+            }
+            *output++ = '\r';
+            *output++ = '\n';
+            return true;
+        }
+
+        // Private Methods
+    private:
+        /**
+         * This is where one header is held.
+         */
+        struct Entry {
+            /**
+             * This is where the name of the header begins in the
+             * storage.  Its value follows right after it.
+             */
+            size_t offset;
+
+            /**
+             * This is the length of the name of the header.
+             */
+            size_t nameLength;
+
+            /**
+             * This is the length of the value of the header.
+             */
+            size_t valueLength;
+
+            /**
+             * This is the hash of the name of the header.
+             */
+            uint64_t nameHash;
+        };
+
+        /**
+         * This method returns the name of the given header.
+         *
+         * @param[in] entry
+         *     This is where the header is held.
+         *
+         * @return
+         *     The name of the header is returned.
+         */
+        std::string_view GetName(const Entry& entry) const {
+            return std::string_view(bytes_.data() + entry.offset, entry.nameLength);
+        }
+
+        /**
+         * This method returns the value of the given header.
+         *
+         * @param[in] entry
+         *     This is where the header is held.
+         *
+         * @return
+         *     The value of the header is returned.
+         */
+        std::string_view GetValue(const Entry& entry) const {
+            return std::string_view(bytes_.data() + entry.offset + entry.nameLength, entry.valueLength);
+        }
+
+        /**
+         * This method adds the given bytes to the end of the storage,
+         * if there's room.
+         *
+         * @param[in] bytes
+         *     These are the bytes to add.
+         *
+         * @return
+         *     An indication of whether or not there was room
+         *     is returned.
+         */
+        bool Append(std::string_view bytes) {
+            if (bytes.length() > MaxBytes - used_) {
+                return false;
+            }
+            (void)memcpy(bytes_.data() + used_, bytes.data(), bytes.length());
+            used_ += bytes.length();
+            return true;
+        }
+
+        /**
+         * This method removes the header at the given position,
+         * moving the bytes of the headers after it to take its place.
+         *
+         * @param[in] index
+         *     This is the position of the header to remove.
+         */
+        void RemoveAt(size_t index) {
+            const auto& entry = entries_[index];
+            const auto start = entry.offset;
+            const auto size = entry.nameLength + entry.valueLength;
+            RemoveBytes(start, size);
+            for (auto i = index + 1; i < count_; ++i) {
+                entries_[i - 1] = entries_[i];
+                entries_[i - 1].offset -= size;
+            }
+            --count_;
+        }
+
+        /**
+         * This method removes the given bytes from the storage,
+         * moving the bytes after them to take their place.  The
+         * headers aren't updated.
+         *
+         * @param[in] start
+         *     This is where the bytes to remove begin.
+         *
+         * @param[in] size
+         *     This is the number of bytes to remove.
+         */
+        void RemoveBytes(size_t start, size_t size) {
+            (void)memmove(bytes_.data() + start, bytes_.data() + start + size, used_ - start - size);
+            used_ -= size;
+        }
+
+        /**
+         * This method sets the value of the header at the given
+         * position to bytes already in the storage, at or after its
+         * old value, removing the other headers given.  There must be
+         * enough room for the result.
+         *
+         * Nothing is copied aside.  The removed bytes which don't
+         * hold the value are taken out first.  The value is then
+         * copied to the free room after the headers, if it fits
+         * there, or otherwise, if it lies within the bytes of one
+         * removed header or the old value, rotated into place.
+         *
+         * @param[in] index
+         *     This is the position of the header.
+         *
+         * @param[in] others
+         *     These are the positions of the other headers to
+         *     remove, in order.  They're all after the header.
+         *
+         * @param[in] numOthers
+         *     This is the number of other headers to remove.
+         *
+         * @param[in] valueOffset
+         *     This is where the new value begins in the storage.
+         *
+         * @param[in] valueLength
+         *     This is the length of the new value.
+         *
+         * @return
+         *     An indication of whether or not the value was set
+         *     is returned.  It isn't, and nothing is changed, if
+         *     there is no room to copy a value which spans more
+         *     than one name or value.
+         */
+        bool SetValueFromStorage(
+            size_t index,
+            const std::array< size_t, MaxHeaders >& others,
+            size_t numOthers,
+            size_t valueOffset,
+            size_t valueLength
+        ) {
+            const auto valueStart = entries_[index].offset + entries_[index].nameLength;
+            const auto range = [&](size_t i){
+                if (i == 0) {
+                    return std::make_pair(valueStart, entries_[index].valueLength);
+                }
+                const auto& entry = entries_[others[i - 1]];
+                return std::make_pair(entry.offset, entry.nameLength + entry.valueLength);
+            };
+            const auto holdsValue = [&](std::pair< size_t, size_t > bytes){
+                return (
+                    (bytes.first < valueOffset + valueLength)
+                    && (valueOffset < bytes.first + bytes.second)
+                );
+            };
+
+            // Decide how to proceed before changing anything.  Taking
+            // out bytes which don't hold the value doesn't change which
+            // ones do.
+            size_t numHolding = 0;
+            size_t notHolding = 0;
+            bool withinOne = false;
+            for (size_t i = 0; i <= numOthers; ++i) {
+                const auto bytes = range(i);
+                if (holdsValue(bytes)) {
+                    ++numHolding;
+                    withinOne = (
+                        (bytes.first <= valueOffset)
+                        && (valueOffset + valueLength <= bytes.first + bytes.second)
+                    );
+                } else {
+                    notHolding += bytes.second;
+                }
+            }
+            const auto copyFits = (valueLength <= MaxBytes - used_ + notHolding);
+            if (
+                !copyFits
+                && ((numHolding != 1) || !withinOne)
+            ) {
+                return false;
+            }
+
+            // Remove the bytes which don't hold any of the value: the
+            // old value and the other headers, in order, keeping track
+            // of where the rest of them and the new value end up.
+            std::array< std::pair< size_t, size_t >, MaxHeaders > holding;
+            numHolding = 0;
+            size_t removed = 0;
+            for (size_t i = 0; i <= numOthers; ++i) {
+                auto bytes = range(i);
+                bytes.first -= removed;
+                if (holdsValue(bytes)) {
+                    holding[numHolding++] = bytes;
+                } else {
+                    RemoveBytes(bytes.first, bytes.second);
+                    removed += bytes.second;
+                    if (bytes.first < valueOffset) {
+                        valueOffset -= bytes.second;
+                    }
+                }
+            }
+
+            // Put the value in place and remove the rest.
+            const auto storage = bytes_.data();
+            if (copyFits) {
+                auto copy = used_;
+                (void)memcpy(storage + copy, storage + valueOffset, valueLength);
+                used_ += valueLength;
+                while (numHolding > 0) {
+                    const auto& bytes = holding[--numHolding];
+                    RemoveBytes(bytes.first, bytes.second);
+                    copy -= bytes.second;
+                }
+                (void)std::rotate(storage + valueStart, storage + copy, storage + used_);
+            } else {
+                // Moving the value to the front leaves the rest of
+                // the bytes holding it together, right after it.
+                const auto& bytes = holding[0];
+                (void)std::rotate(
+                    storage + valueStart,
+                    storage + valueOffset,
+                    storage + valueOffset + valueLength
+                );
+                RemoveBytes(bytes.first + valueLength, bytes.second - valueLength);
+            }
+
+            // Update the headers to match.
+            entries_[index].valueLength = valueLength;
+            size_t next = index + 1;
+            size_t other = 0;
+            auto offset = valueStart + valueLength;
+            for (auto i = index + 1; i < count_; ++i) {
+                if (
+                    (other < numOthers)
+                    && (others[other] == i)
+                ) {
+                    ++other;
+                    continue;
+                }
+                entries_[next] = entries_[i];
+                entries_[next].offset = offset;
+                offset += entries_[next].nameLength + entries_[next].valueLength;
+                ++next;
+            }
+            count_ = next;
+            return true;
+        }
+
+        /**
+         * This method replaces the value of the header at the
+         * given position, moving the bytes of the headers after it
+         * to make room.  There must be enough room.
+         *
+         * @param[in] index
+         *     This is the position of the header.
+         *
+         * @param[in] value
+         *     This is the new value of the header.
+         */
+        void ReplaceValue(size_t index, std::string_view value) {
+            auto& entry = entries_[index];
+            const auto valueStart = entry.offset + entry.nameLength;
+            const auto oldEnd = valueStart + entry.valueLength;
+            const auto newEnd = valueStart + value.length();
+            (void)memmove(bytes_.data() + newEnd, bytes_.data() + oldEnd, used_ - oldEnd);
+            (void)memcpy(bytes_.data() + valueStart, value.data(), value.length());
+            used_ = used_ + newEnd - oldEnd;
+            entry.valueLength = value.length();
+            for (auto i = index + 1; i < count_; ++i) {
+                entries_[i].offset = entries_[i].offset + newEnd - oldEnd;
+            }
+        }
+
+        // Private properties
+    private:
+        /**
+         * These are where the headers are held.
+         */
+        std::array< Entry, MaxHeaders > entries_;
+
+        /**
+         * These are the names and values of the headers,
+         * back to back, in order.
+         */
+        std::array< char, MaxBytes > bytes_;
+
+        /**
+         * This is the number of headers held.
+         */
+        size_t count_ = 0;
+
+        /**
+         * This is the number of bytes of names and values held.
+         */
+        size_t used_ = 0;
+
+        /**
+         * This is the maximum number of characters allowed in
+         * a header line, or zero if there is no limit.
+         */
+        size_t lineLengthLimit_ = 0;
+
+        /**
+         * This is why the last operation which could fail did so.
+         */
+        FixedHeadersError lastError_ = FixedHeadersError::None;
+    };
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,307 @@
+#ifndef MESSAGE_HEADERS_HEADER_PARSER_HPP
+#define MESSAGE_HEADERS_HEADER_PARSER_HPP
+
+/**
+ * @file HeaderParser.hpp
+ *
+ * This module declares the MessageHeaders::HeaderParser class
+ * and the MessageHeaders::HeaderHandler interface.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace MessageHeaders
+{
+    /**
+     * This is the interface implemented by anything that wants to
+     * receive the headers of a raw message as they are recognized
+     * by a HeaderParser, rather than have them stored.
+     */
+    class HeaderHandler {
+        // Lifecycle Management
+    public:
+        virtual ~HeaderHandler() = default;
+
+        // Public Methods
+    public:
+        /**
+         * This method is called once for each header recognized
+         * in the raw message, in the order they appear.
+         *
+         * @param[in] name
+         *      This is the name of the header.  It refers directly
+         *      to the raw message.
+         *
+         * @param[in] value
+         *      This is the value of the header, with any folded lines
+         *      unfolded and the margin whitespace stripped.  It refers
+         *      either to the raw message or to a scratch buffer owned
+         *      by the parser, so it is only valid during the call.
+         *
+         * @return
+         *      An indication of whether or not the parser should
+         *      continue is returned.  Returning false makes the
+         *      parse fail.
+         */
+        virtual bool OnHeader(std::string_view name, std::string_view value) = 0;
+
+        /**
+         * This method is called once after the empty line that
+         * ends the headers has been found.
+         *
+         * @param[in] bodyOffset
+         *      This is the offset into the raw message where the
+         *      headers ended and the body, if any, begins.
+         */
+        virtual void OnEnd(size_t bodyOffset);
+    };
+
+    /**
+     * This class recognizes the headers of a raw internet message
+     * and reports each one to a HeaderHandler, without storing
+     * anything itself.  MessageHeaders::ParseRawMessage is built on it.
+     */
+    class HeaderParser {
+    public:
+        /**
+         * These are the different ways the parser can recognize headers.
+         */
+        enum class Engine {
+            /**
+             * Search for line terminators and delimiters with
+             * string find operations, line by line.
+             */
+            Scan,
+
+            /**
+             * Run every byte once through a table-driven state machine.
+             * This has a predictable per-byte cost and can be resumed
+             * at any byte, which is what Feed uses.
+             */
+            Dfa,
+        };
+
+        /**
+         * These are the possible outcomes of feeding part of
+         * a raw message to the parser.
+         */
+        enum class Status {
+            /**
+             * The end of the headers has not been reached yet.
+             */
+            Incomplete,
+
+            /**
+             * The end of the headers has been reached.
+             */
+            Complete,
+
+            /**
+             * The headers are not valid, or the handler asked to stop.
+             */
+            Error,
+        };
+
+        // Lifecycle Management
+    public:
+        ~HeaderParser() = default;
+        HeaderParser(const HeaderParser&) = default;
+        HeaderParser(HeaderParser&&) = default;
+        HeaderParser& operator=(const HeaderParser&) = default;
+        HeaderParser& operator=(HeaderParser&&) = default;
+
+        // Public Methods
+    public:
+        /**
+         * This is the default constructor.
+         */
+        HeaderParser() = default;
+
+        /**
+         * This method sets a limit for the number of characters
+         * in any header line.
+         *
+         * @param[in] newLineLengthLimit
+         *      This is the maximum number of characters, including
+         *      the 2-character CRLF line terminator, that should be
+         *      allowed for a single header line, or zero for no limit.
+         */
+        void SetLineLimit(size_t newLineLengthLimit);
+
+        /**
+         * This method selects how Parse recognizes headers.
+         * The default is Engine::Scan.
+         *
+         * @param[in] newEngine
+         *      This is the engine to use.
+         */
+        void SetEngine(Engine newEngine);
+
+        /**
+         * This method scans the headers of the given raw message,
+         * calling the given handler for each one.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message to parse.
+         *
+         * @param[in] handler
+         *     This is the object to notify about each header
+         *     and about the end of the headers.
+         *
+         * @return
+         *     An indication of whether or not the headers were
+         *     parsed successfully is returned.
+         */
+        bool Parse(std::string_view rawMessage, HeaderHandler& handler);
+
+        /**
+         * This method forgets any message fed so far, so that
+         * Feed starts over with a new message.
+         */
+        void Reset();
+
+        /**
+         * This method continues parsing the headers of a raw message
+         * that arrives in pieces, calling the given handler for each
+         * header as soon as it is complete.  Feed always uses
+         * Engine::Dfa, whatever engine was selected for Parse.
+         *
+         * Pieces of a header which straddles two calls are kept
+         * by the parser, so the caller may discard each piece after
+         * feeding it.
+         *
+         * @param[in] piece
+         *     This is the next piece of the raw message.
+         *
+         * @param[in] handler
+         *     This is the object to notify about each header
+         *     and about the end of the headers.  The body offset
+         *     given to it is counted from the start of the message.
+         *
+         * @return
+         *     The state of the parse after taking in the given piece
+         *     is returned.  Once it is Status::Complete, any remaining
+         *     bytes of the piece belong to the body.
+         */
+        Status Feed(std::string_view piece, HeaderHandler& handler);
+
+        // Private methods
+    private:
+        /**
+         * This method carries out the bookkeeping attached to
+         * a state machine transition.
+         *
+         * @param[in] action
+         *     This identifies the bookkeeping to carry out.
+         *
+         * @param[in] position
+         *     This is the offset, from the start of the message,
+         *     of the byte which caused the transition.
+         *
+         * @param[in] handler
+         *     This is the object to notify about headers.
+         *
+         * @return
+         *     An indication of whether or not parsing may continue
+         *     is returned.
+         */
+        bool PerformAction(
+            unsigned char action,
+            size_t position,
+            HeaderHandler& handler
+        );
+
+        /**
+         * This method reports the header recognized so far
+         * by the state machine to the given handler.
+         *
+         * @param[in] position
+         *     This is the offset, from the start of the message,
+         *     of the first byte after the header.
+         *
+         * @param[in] handler
+         *     This is the object to notify about the header.
+         *
+         * @return
+         *     The value returned by the handler is returned.
+         */
+        bool EmitHeader(size_t position, HeaderHandler& handler);
+
+        // Private properties
+    private:
+        /**
+         * This is the maximum number of characters allowed in
+         * a header line, or zero if there is no limit.
+         */
+        size_t lineLengthLimit_ = 0;
+
+        /**
+         * This is how Parse recognizes headers.
+         */
+        Engine engine_ = Engine::Scan;
+
+        /**
+         * This is the current state of the state machine.
+         */
+        unsigned char state_ = 0;
+
+        /**
+         * This is the offset, from the start of the message,
+         * of the first byte not yet fed to the state machine.
+         */
+        size_t position_ = 0;
+
+        /**
+         * This is the piece of the message currently being fed.
+         */
+        std::string_view piece_;
+
+        /**
+         * This is the offset, from the start of the message,
+         * of the first byte of the piece currently being fed.
+         */
+        size_t pieceOffset_ = 0;
+
+        /**
+         * This holds the bytes, from earlier pieces, of the header
+         * currently being recognized by the state machine.
+         */
+        std::string carried_;
+
+        /**
+         * These are offsets, from the start of the message, of the
+         * parts of the header currently being recognized by the state
+         * machine, and of the line currently being recognized.
+         */
+        size_t lineStart_ = 0;
+        size_t headerStart_ = 0;
+        size_t nameEnd_ = 0;
+        size_t valueStart_ = 0;
+        size_t valueEnd_ = 0;
+        size_t foldStart_ = 0;
+
+        /**
+         * These are the start and end offsets, from the start of
+         * the message, of the folded lines that continue the header
+         * currently being recognized by the state machine.
+         */
+        std::vector< std::pair< size_t, size_t > > folds_;
+
+        /**
+         * This is where header values spread over several lines
+         * are reassembled.  It is reused from header to header,
+         * and only touched when a value is actually folded.
+         */
+        std::string unfoldBuffer_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
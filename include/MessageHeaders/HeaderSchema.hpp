@@ -0,0 +1,488 @@
+#ifndef MESSAGE_HEADERS_HEADER_SCHEMA_HPP
+#define MESSAGE_HEADERS_HEADER_SCHEMA_HPP
+
+/**
+ * @file HeaderSchema.hpp
+ *
+ * This module declares the MessageHeaders::HeaderSchema class template,
+ * which binds the headers of a message directly to the members
+ * of a user structure.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <array>
+#include <charconv>
+#include <MessageHeaders/DuplicatePolicy.hpp>
+#include <MessageHeaders/HeaderParser.hpp>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <optional>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace MessageHeaders
+{
+    /**
+     * These functions convert the text of a header value into
+     * the type of the structure member to which it is bound.
+     * More types can be supported by adding overloads of
+     * ConvertHeaderValue in the namespace of the type.
+     *
+     * @param[in] text
+     *     This is the header value to convert.
+     *
+     * @param[out] value
+     *     This is where to store the converted value.
+     *
+     * @return
+     *     An indication of whether or not the header value
+     *     could be converted is returned.
+     */
+    bool ConvertHeaderValue(std::string_view text, std::string& value);
+    bool ConvertHeaderValue(std::string_view text, std::string_view& value);
+    template< typename T > std::enable_if_t< std::is_integral_v< T > && !std::is_same_v< T, bool >, bool > ConvertHeaderValue(std::string_view text, T& value);
+    template< typename T > bool ConvertHeaderValue(std::string_view text, std::optional< T >& value);
+    template< typename T > bool ConvertHeaderValue(std::string_view text, std::vector< T >& value);
+
+    /**
+     * These functions fold another instance of a header into the
+     * structure member to which the header is bound, for the
+     * DuplicatePolicy::Combine and DuplicatePolicy::KeepSeparate
+     * policies.  Only strings (joined with commas), vectors (each
+     * instance is another element), and optionals of those can do this.
+     *
+     * @param[in] text
+     *     This is the value of the additional header instance.
+     *
+     * @param[in,out] value
+     *     This is the structure member holding the earlier instances.
+     *
+     * @return
+     *     An indication of whether or not the header instance
+     *     could be combined is returned.
+     */
+    bool CombineHeaderValue(std::string_view text, std::string& value);
+    template< typename T > bool CombineHeaderValue(std::string_view text, T& value);
+    template< typename T > bool CombineHeaderValue(std::string_view text, std::optional< T >& value);
+    template< typename T > bool CombineHeaderValue(std::string_view text, std::vector< T >& value);
+
+    template< typename T >
+    std::enable_if_t< std::is_integral_v< T > && !std::is_same_v< T, bool >, bool > ConvertHeaderValue(
+        std::string_view text,
+        T& value
+    ) {
+        const auto end = text.data() + text.length();
+        const auto result = std::from_chars(text.data(), end, value);
+        return (
+            (result.ec == std::errc())
+            && (result.ptr == end)
+        );
+    }
+
+    template< typename T > bool ConvertHeaderValue(
+        std::string_view text,
+        std::optional< T >& value
+    ) {
+        T newValue{};
+        if (!ConvertHeaderValue(text, newValue)) {
+            return false;
+        }
+        value = std::move(newValue);
+        return true;
+    }
+
+    template< typename T > bool ConvertHeaderValue(
+        std::string_view text,
+        std::vector< T >& value
+    ) {
+        T newValue{};
+        if (!ConvertHeaderValue(text, newValue)) {
+            return false;
+        }
+        value.push_back(std::move(newValue));
+        return true;
+    }
+
+    template< typename T > bool CombineHeaderValue(std::string_view, T&) {
+        return false;
+    }
+
+    template< typename T > bool CombineHeaderValue(
+        std::string_view text,
+        std::optional< T >& value
+    ) {
+        return (
+            value.has_value()
+            && CombineHeaderValue(text, *value)
+        );
+    }
+
+    template< typename T > bool CombineHeaderValue(
+        std::string_view text,
+        std::vector< T >& value
+    ) {
+        return ConvertHeaderValue(text, value);
+    }
+
+    /**
+     * This tells whether or not a structure member type refers to
+     * header text rather than holding a copy of it.  Such members
+     * can't be bound to folded values when parsing raw messages,
+     * since the unfolded text doesn't outlive the parse.
+     */
+    template< typename T > struct IsHeaderView : std::false_type {};
+    template<> struct IsHeaderView< std::string_view > : std::true_type {};
+    template< typename T > struct IsHeaderView< std::optional< T > > : IsHeaderView< T > {};
+    template< typename T > struct IsHeaderView< std::vector< T > > : IsHeaderView< T > {};
+
+    /**
+     * This gives the duplicate policy used when none is given
+     * for a header field: vectors keep every instance, and
+     * anything else rejects the message.
+     */
+    template< typename T > struct DefaultDuplicatePolicy {
+        static constexpr DuplicatePolicy value = DuplicatePolicy::Reject;
+    };
+    template< typename T > struct DefaultDuplicatePolicy< std::vector< T > > {
+        static constexpr DuplicatePolicy value = DuplicatePolicy::KeepSeparate;
+    };
+
+    /**
+     * This binds one header, by name, to a member of a structure.
+     */
+    template< typename Record, typename Value > struct HeaderField {
+        /**
+         * This is the type of the structure member.
+         */
+        typedef Value ValueType;
+
+        /**
+         * This is the name of the header.
+         */
+        std::string_view name;
+
+        /**
+         * This selects the structure member.
+         */
+        Value Record::* member;
+
+        /**
+         * This is what to do if the header appears more than once.
+         */
+        DuplicatePolicy duplicatePolicy;
+    };
+
+    /**
+     * This function makes a header field binding.
+     *
+     * @param[in] name
+     *     This is the name of the header.
+     *
+     * @param[in] member
+     *     This selects the structure member to which to bind the header.
+     *
+     * @param[in] duplicatePolicy
+     *     This is what to do if the header appears more than once.
+     *
+     * @return
+     *     The header field binding is returned.
+     */
+    template< typename Record, typename Value >
+    constexpr HeaderField< Record, Value > MakeHeaderField(
+        std::string_view name,
+        Value Record::* member,
+        DuplicatePolicy duplicatePolicy = DefaultDuplicatePolicy< Value >::value
+    ) {
+        return {name, member, duplicatePolicy};
+    }
+
+    /**
+     * This class binds the headers of a message to the members of
+     * a structure, in a single pass over the headers.  Headers which
+     * aren't bound to any member are skipped, and members whose
+     * headers don't appear are left untouched.
+     *
+     * A schema is usually made once, as a constant, with MakeHeaderSchema:
+     *
+     *     constexpr auto schema = MessageHeaders::MakeHeaderSchema< Request >(
+     *         MessageHeaders::MakeHeaderField("Host", &Request::host),
+     *         MessageHeaders::MakeHeaderField("Content-Length", &Request::contentLength)
+     *     );
+     */
+    template< typename Record, typename... Fields > class HeaderSchema {
+        // Lifecycle Management
+    public:
+        ~HeaderSchema() = default;
+        constexpr HeaderSchema(const HeaderSchema&) = default;
+        constexpr HeaderSchema(HeaderSchema&&) = default;
+        HeaderSchema& operator=(const HeaderSchema&) = default;
+        HeaderSchema& operator=(HeaderSchema&&) = default;
+
+        // Public Methods
+    public:
+        /**
+         * This constructs the schema from its header field bindings.
+         *
+         * @param[in] newFields
+         *     These are the header field bindings.
+         */
+        constexpr explicit HeaderSchema(Fields... newFields)
+            : fields_(newFields...)
+        {
+        }
+
+        /**
+         * This method parses the headers of the given raw message
+         * straight into the given structure, without storing them
+         * anywhere else.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message to parse.
+         *     Any std::string_view members refer to it.
+         *
+         * @param[in,out] record
+         *     This is the structure into which to store the headers.
+         *
+         * @param[out] bodyOffset
+         *     This is where to store the offset into the given
+         *     raw message where the headers ended and the body,
+         *     if any, begins.
+         *
+         * @return
+         *     An indication of whether or not the message was parsed
+         *     successfully, and all its bound headers converted and
+         *     stored, is returned.
+         */
+        bool Parse(std::string_view rawMessage, Record& record, size_t& bodyOffset) const {
+            Binder binder(*this, rawMessage, record);
+            HeaderParser parser;
+            if (!parser.Parse(rawMessage, binder)) {
+                return false;
+            }
+            bodyOffset = binder.bodyOffset;
+            return true;
+        }
+
+        /**
+         * This method parses the headers of the given raw message
+         * straight into the given structure, without storing them
+         * anywhere else.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message to parse.
+         *     Any std::string_view members refer to it.
+         *
+         * @param[in,out] record
+         *     This is the structure into which to store the headers.
+         *
+         * @return
+         *     An indication of whether or not the message was parsed
+         *     successfully, and all its bound headers converted and
+         *     stored, is returned.
+         */
+        bool Parse(std::string_view rawMessage, Record& record) const {
+            size_t bodyOffset;
+            return Parse(rawMessage, record, bodyOffset);
+        }
+
+        /**
+         * This method stores the headers already collected in the given
+         * message into the given structure.
+         *
+         * @param[in] headers
+         *     These are the headers to bind.  Any std::string_view
+         *     members refer to them, until they are next modified.
+         *
+         * @param[in,out] record
+         *     This is the structure into which to store the headers.
+         *
+         * @return
+         *     An indication of whether or not all the bound headers
+         *     were converted and stored is returned.
+         */
+        bool Bind(const MessageHeaders& headers, Record& record) const {
+            Seen seen{};
+            for (size_t i = 0; i < headers.GetHeaderCount(); ++i) {
+                const auto& header = headers.GetHeader(i);
+                if (
+                    !Assign(
+                        static_cast< const std::string& >(header.name),
+                        header.value,
+                        true,
+                        record,
+                        seen
+                    )
+                ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Private Methods
+    private:
+        /**
+         * This keeps track of which header fields were already seen.
+         */
+        typedef std::array< bool, sizeof...(Fields) > Seen;
+
+        /**
+         * This is the header handler used to parse raw messages
+         * straight into a structure.
+         */
+        struct Binder
+            : public HeaderHandler
+        {
+            const HeaderSchema& schema;
+            std::string_view rawMessage;
+            Record& record;
+            Seen seen{};
+            size_t bodyOffset = 0;
+
+            Binder(
+                const HeaderSchema& newSchema,
+                std::string_view newRawMessage,
+                Record& newRecord
+            )
+                : schema(newSchema)
+                , rawMessage(newRawMessage)
+                , record(newRecord)
+            {
+            }
+
+            bool OnHeader(std::string_view name, std::string_view value) override {
+                const auto stable = (
+                    (value.data() >= rawMessage.data())
+                    && (value.data() + value.length() <= rawMessage.data() + rawMessage.length())
+                );
+                return schema.Assign(name, value, stable, record, seen);
+            }
+
+            void OnEnd(size_t newBodyOffset) override {
+                bodyOffset = newBodyOffset;
+            }
+        };
+
+        /**
+         * This method stores one header into the structure member
+         * to which it is bound, if any.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @param[in] value
+         *     This is the value of the header.
+         *
+         * @param[in] stable
+         *     This indicates whether or not the value will outlive
+         *     the call, so that members may refer to it.
+         *
+         * @param[in,out] record
+         *     This is the structure into which to store the header.
+         *
+         * @param[in,out] seen
+         *     This keeps track of which header fields were already seen.
+         *
+         * @return
+         *     An indication of whether or not the header
+         *     could be stored is returned.
+         */
+        bool Assign(
+            std::string_view name,
+            std::string_view value,
+            bool stable,
+            Record& record,
+            Seen& seen
+        ) const {
+            return AssignToFields(
+                name,
+                value,
+                stable,
+                record,
+                seen,
+                std::index_sequence_for< Fields... >()
+            );
+        }
+
+        template< size_t... I > bool AssignToFields(
+            std::string_view name,
+            std::string_view value,
+            bool stable,
+            Record& record,
+            Seen& seen,
+            std::index_sequence< I... >
+        ) const {
+            bool stored = true;
+            (void)(
+                (
+                    HeaderNamesEqual(std::get< I >(fields_).name, name)
+                    && ((stored = AssignToField(std::get< I >(fields_), value, stable, record, seen[I])), true)
+                ) || ...
+            );
+            return stored;
+        }
+
+        template< typename Field > static bool AssignToField(
+            const Field& field,
+            std::string_view value,
+            bool stable,
+            Record& record,
+            bool& seen
+        ) {
+            typedef typename Field::ValueType Value;
+            if (
+                IsHeaderView< Value >::value
+                && !stable
+            ) {
+                return false;
+            }
+            auto& member = record.*(field.member);
+            if (seen) {
+                switch (field.duplicatePolicy) {
+                    case DuplicatePolicy::Reject: return false;
+                    case DuplicatePolicy::FirstWins: return true;
+                    case DuplicatePolicy::Combine:
+                    case DuplicatePolicy::KeepSeparate: return CombineHeaderValue(value, member);
+                    case DuplicatePolicy::LastWins: break;
+                }
+            }
+            seen = true;
+            Value newValue{};
+            if (!ConvertHeaderValue(value, newValue)) {
+                return false;
+            }
+            member = std::move(newValue);
+            return true;
+        }
+
+        // Private properties
+    private:
+        /**
+         * These are the header field bindings.
+         */
+        std::tuple< Fields... > fields_;
+    };
+
+    /**
+     * This function makes a header schema from header field bindings.
+     *
+     * @param[in] fields
+     *     These are the header field bindings, made with MakeHeaderField.
+     *
+     * @return
+     *     The header schema is returned.
+     */
+    template< typename Record, typename... Fields >
+    constexpr HeaderSchema< Record, Fields... > MakeHeaderSchema(Fields... fields) {
+        return HeaderSchema< Record, Fields... >(fields...);
+    }
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef MESSAGE_HEADERS_HEADER_SIZE_ACCOUNTING_HPP
+#define MESSAGE_HEADERS_HEADER_SIZE_ACCOUNTING_HPP
+
+/**
+ * @file HeaderSizeAccounting.hpp
+ *
+ * This module declares the MessageHeaders::HeaderSizeAccounting class.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <array>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MessageHeaders
+{
+    /**
+     * These are the ways in which headers pass through
+     * MessageHeaders::MessageHeaders.
+     */
+    enum class HeaderSizeDirection {
+        /**
+         * The headers were parsed by ParseRawMessage.
+         */
+        Parsed,
+
+        /**
+         * The headers were written out by GenerateRawHeaders.
+         */
+        Generated,
+    };
+
+    /**
+     * This is the number of buckets in a HeaderSizeHistogram.
+     */
+    constexpr size_t HEADER_SIZE_BUCKETS = 16;
+
+    /**
+     * This function returns the bucket of a HeaderSizeHistogram
+     * which counts things of the given size.  Bucket 0 counts
+     * sizes under 16 bytes, and each bucket after it counts sizes
+     * up to twice as big as the one before, except the last, which
+     * counts everything bigger.
+     *
+     * @param[in] bytes
+     *     This is the size.
+     *
+     * @return
+     *     The bucket counting the size is returned.
+     */
+    size_t GetHeaderSizeBucket(size_t bytes);
+
+    /**
+     * This function returns the smallest size too big
+     * for the given bucket of a HeaderSizeHistogram.
+     *
+     * @param[in] bucket
+     *     This is the bucket.
+     *
+     * @return
+     *     The smallest size too big for the bucket is returned.
+     *
+     * @retval SIZE_MAX
+     *     This is returned for the last bucket.
+     */
+    size_t GetHeaderSizeBucketLimit(size_t bucket);
+
+    /**
+     * This counts things by their sizes.
+     */
+    struct HeaderSizeHistogram {
+        /**
+         * This is the number of things counted.
+         */
+        uint64_t count = 0;
+
+        /**
+         * This is the total size of the things counted, in bytes.
+         */
+        uint64_t bytes = 0;
+
+        /**
+         * These are the number of things counted of each size
+         * (see GetHeaderSizeBucket).
+         */
+        std::array< uint64_t, HEADER_SIZE_BUCKETS > buckets{};
+    };
+
+    /**
+     * This is how many bytes headers with one name have taken.
+     */
+    struct HeaderSizeRecord {
+        /**
+         * This is the header name, spelled as it was first seen,
+         * or "(other)" for names which didn't fit into the table.
+         */
+        std::string name;
+
+        /**
+         * These are the sizes of headers with the name
+         * parsed by MessageHeaders::ParseRawMessage.
+         */
+        HeaderSizeHistogram parsed;
+
+        /**
+         * These are the sizes of headers with the name written out
+         * by MessageHeaders::GenerateRawHeaders.
+         */
+        HeaderSizeHistogram generated;
+    };
+
+    /**
+     * This is how many bytes headers have taken, as of some moment.
+     */
+    struct HeaderSizeReport {
+        /**
+         * These are the sizes of the header blocks
+         * of the messages parsed.
+         */
+        HeaderSizeHistogram parsedMessages;
+
+        /**
+         * These are the sizes of the header blocks written out.
+         */
+        HeaderSizeHistogram generatedMessages;
+
+        /**
+         * These are the sizes of headers by name, those taking the most
+         * bytes first, leaving out names never seen.
+         */
+        std::vector< HeaderSizeRecord > names;
+    };
+
+    /**
+     * This counts the bytes taken by headers, by header name, as
+     * they're parsed and written out, in order to find which headers
+     * make messages big and to set limits on header sizes.
+     *
+     * Well-known names have their own places in the table, and
+     * others are given places by their hashes, up to a set number
+     * of them, beyond which they're counted together.
+     *
+     * Recording never locks.  Counters are kept in several sets, and
+     * each thread adds to its own set with atomic operations, so
+     * threads seldom touch the same memory; the sets are added
+     * together when a report is made.  Counts from different
+     * instances may be merged too.
+     */
+    class HeaderSizeAccounting {
+        // Lifecycle Management
+    public:
+        ~HeaderSizeAccounting();
+        HeaderSizeAccounting(const HeaderSizeAccounting&) = delete;
+        HeaderSizeAccounting(HeaderSizeAccounting&&);
+        HeaderSizeAccounting& operator=(const HeaderSizeAccounting&) = delete;
+        HeaderSizeAccounting& operator=(HeaderSizeAccounting&&);
+
+        // Public Methods
+    public:
+        /**
+         * This constructs the accounting.
+         *
+         * @param[in] maxOtherNames
+         *     This is the number of names which aren't well-known
+         *     to count separately.  It's rounded up to a power of two.
+         */
+        explicit HeaderSizeAccounting(size_t maxOtherNames = 256);
+
+        /**
+         * This method counts a header.
+         * It may be called from many threads at once.
+         *
+         * @param[in] direction
+         *     This is how the header passed through.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @param[in] bytes
+         *     This is the size of the header, in bytes.
+         */
+        void RecordHeader(
+            HeaderSizeDirection direction,
+            std::string_view name,
+            size_t bytes
+        );
+
+        /**
+         * This method counts a header block.
+         * It may be called from many threads at once.
+         *
+         * @param[in] direction
+         *     This is how the header block passed through.
+         *
+         * @param[in] bytes
+         *     This is the size of the header block, in bytes,
+         *     including the empty line ending it.
+         */
+        void RecordMessage(HeaderSizeDirection direction, size_t bytes);
+
+        /**
+         * This method adds everything counted by the given
+         * accounting into this one.
+         *
+         * @param[in] other
+         *     This is the accounting to add.
+         */
+        void Merge(const HeaderSizeAccounting& other);
+
+        /**
+         * This method returns everything counted so far.
+         *
+         * @return
+         *     A report of the header sizes counted is returned.
+         */
+        HeaderSizeReport GetReport() const;
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< struct Impl > impl_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef MESSAGE_HEADERS_HEADER_STATISTICS_HPP
+#define MESSAGE_HEADERS_HEADER_STATISTICS_HPP
+
+/**
+ * @file HeaderStatistics.hpp
+ *
+ * This module declares the MessageHeaders::HeaderStatistics class.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <memory>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MessageHeaders
+{
+    class RedactionPolicy;
+
+    /**
+     * This is a header name, or a header name and value,
+     * which is among the most common seen.
+     */
+    struct HeaderStatisticsEntry {
+        /**
+         * This is the header name, or the header name and value
+         * separated by ": ".  A value is shown as "#" followed by
+         * the sixteen hexadecimal digits of its hash, from
+         * HeaderStatistics::HashValue, unless values are shown as
+         * text, in which case long values are cut short.
+         */
+        std::string label;
+
+        /**
+         * This is the estimated number of headers seen with the
+         * name, or name and value.  It may be more than the true
+         * number, but never less, apart from value sampling.
+         */
+        uint64_t count = 0;
+    };
+
+    /**
+     * This is what HeaderStatistics has seen, as of some moment.
+     */
+    struct HeaderStatisticsSnapshot {
+        /**
+         * This is the number of messages seen.
+         */
+        uint64_t messages = 0;
+
+        /**
+         * These are the most common header names,
+         * most common first.
+         */
+        std::vector< HeaderStatisticsEntry > topNames;
+
+        /**
+         * These are the most common header names and values,
+         * most common first.
+         */
+        std::vector< HeaderStatisticsEntry > topValues;
+    };
+
+    /**
+     * This keeps statistics of which header names and values are
+     * most common across many messages, for watching the makeup
+     * of traffic, with little memory and little cost per message.
+     *
+     * Names and values are counted by their hashes in count-min
+     * sketches, so every count is an estimate which may be high but
+     * is never low.  The most common keys are tracked in a small
+     * table, after the manner of the space-saving algorithm; a key
+     * joins the table, taking the place of the least common one,
+     * only when its estimate passes it, so text is copied only then.
+     * Values are counted only for one in every few messages.
+     *
+     * Values are only kept as hashes, so credentials and other
+     * secrets in headers never end up in the statistics.  Showing
+     * values as text is opt-in, and still never done for headers
+     * a given RedactionPolicy says are sensitive.
+     *
+     * Messages may be recorded from many threads at once.  Each thread
+     * records into one of several independent sketches, picked by the
+     * thread, so threads seldom wait for each other; the sketches are
+     * merged when a snapshot is taken.  Sketches from different
+     * instances may be merged too.
+     */
+    class HeaderStatistics {
+        // Lifecycle Management
+    public:
+        ~HeaderStatistics();
+        HeaderStatistics(const HeaderStatistics&) = delete;
+        HeaderStatistics(HeaderStatistics&&);
+        HeaderStatistics& operator=(const HeaderStatistics&) = delete;
+        HeaderStatistics& operator=(HeaderStatistics&&);
+
+        // Public Methods
+    public:
+        /**
+         * This constructs the statistics.
+         *
+         * @param[in] topCount
+         *     This is the number of the most common names,
+         *     and of the most common values, to track.
+         *
+         * @param[in] valueSampleInterval
+         *     Values are counted for one in every this many messages,
+         *     and their counts scaled up to match.  If zero, values
+         *     are not counted.
+         *
+         * @param[in] valueText
+         *     If not null, common values are labelled with their
+         *     text, except for headers this policy says are
+         *     sensitive, whose values are labelled with their hashes.
+         *     The policy must outlive the statistics.  If null, all
+         *     values are labelled with their hashes.
+         */
+        explicit HeaderStatistics(
+            size_t topCount = 32,
+            size_t valueSampleInterval = 16,
+            const RedactionPolicy* valueText = nullptr
+        );
+
+        /**
+         * This function returns the hash by which a header value
+         * is shown in the labels of common values.
+         *
+         * @param[in] value
+         *     This is the header value.
+         *
+         * @return
+         *     The hash of the header value is returned.
+         */
+        static uint64_t HashValue(std::string_view value);
+
+        /**
+         * This method records the headers of the given message.
+         * It may be called from many threads at once.
+         *
+         * @param[in] headers
+         *     These are the headers of the message.
+         */
+        void Record(const MessageHeaders& headers);
+
+        /**
+         * This method adds everything recorded by the given
+         * statistics into these.  Both must track the same
+         * number of names and values.
+         *
+         * @param[in] other
+         *     These are the statistics to add.
+         */
+        void Merge(const HeaderStatistics& other);
+
+        /**
+         * This method returns the estimated number of headers
+         * seen with the given name.
+         *
+         * @param[in] name
+         *     This is the header name.
+         *
+         * @return
+         *     The estimated number of headers seen
+         *     with the name is returned.
+         */
+        uint64_t EstimateNameCount(std::string_view name) const;
+
+        /**
+         * This method returns what has been seen so far.
+         *
+         * @return
+         *     A snapshot of the statistics is returned.
+         */
+        HeaderStatisticsSnapshot GetSnapshot() const;
+
+        /**
+         * This method forgets everything seen so far,
+         * to begin a new period of time.
+         */
+        void Reset();
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< struct Impl > impl_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
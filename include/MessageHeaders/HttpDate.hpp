@@ -0,0 +1,73 @@
+#ifndef MESSAGE_HEADERS_HTTP_DATE_HPP
+#define MESSAGE_HEADERS_HTTP_DATE_HPP
+
+/**
+ * @file HttpDate.hpp
+ *
+ * This module declares the functions which convert between
+ * the date formats used in header values and points in time.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+namespace MessageHeaders
+{
+    /**
+     * This function recognizes a date in a header value, and returns
+     * the number of seconds between the UNIX epoch and that date.
+     *
+     * The preferred format (IMF-fixdate, for example
+     * "Sun, 06 Nov 1994 08:49:37 GMT") is recognized directly
+     * at fixed positions.  Anything else is recognized with the
+     * lenient algorithm for cookie dates in RFC 6265 section 5.1.1,
+     * which also covers the obsolete RFC 850 and asctime formats.
+     *
+     * @param[in] date
+     *     This is the date to recognize.
+     *
+     * @param[out] secondsSinceEpoch
+     *     This is where to store the point in time of the date.
+     *
+     * @return
+     *     An indication of whether or not the date was
+     *     recognized is returned.
+     */
+    bool ParseHttpDate(std::string_view date, int64_t& secondsSinceEpoch);
+
+    /**
+     * This function renders the given point in time as an IMF-fixdate,
+     * and appends it to the given string.  Points in time before 1601
+     * or after 9999 are clamped to the start of 1601 or the end of
+     * 9999, so the date always has a four-digit year which
+     * ParseHttpDate and cookie parsers accept.
+     *
+     * @param[in] secondsSinceEpoch
+     *     This is the number of seconds between the UNIX epoch
+     *     and the point in time to render.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append the date.
+     */
+    void AppendHttpDate(int64_t secondsSinceEpoch, std::string& output);
+
+    /**
+     * This function renders the given point in time as an IMF-fixdate,
+     * clamped as done by AppendHttpDate.
+     *
+     * @param[in] secondsSinceEpoch
+     *     This is the number of seconds between the UNIX epoch
+     *     and the point in time to render.
+     *
+     * @return
+     *     The rendered date is returned.
+     */
+    std::string FormatHttpDate(int64_t secondsSinceEpoch);
+
+} // namespace MessageHeaders
+
+#endif
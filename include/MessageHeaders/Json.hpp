@@ -0,0 +1,84 @@
+#ifndef MESSAGE_HEADERS_JSON_HPP
+#define MESSAGE_HEADERS_JSON_HPP
+
+/**
+ * @file Json.hpp
+ *
+ * This module declares the options and helper functions
+ * used to export message headers as JSON.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <string>
+#include <string_view>
+
+namespace MessageHeaders
+{
+    class RedactionPolicy;
+
+    /**
+     * These are the ways in which headers sharing a name
+     * may be exported as JSON.
+     */
+    enum class JsonDuplicates {
+        /**
+         * The values are joined with commas into a single string,
+         * as done by MessageHeaders::GetHeaderValue.
+         */
+        Combine,
+
+        /**
+         * The values are put into an array, in order.  A name
+         * appearing only once still has a single string.
+         */
+        Array,
+    };
+
+    /**
+     * These are the options for exporting message headers as JSON.
+     */
+    struct JsonOptions {
+        /**
+         * This is how headers sharing a name are exported.
+         */
+        JsonDuplicates duplicates = JsonDuplicates::Combine;
+
+        /**
+         * This indicates whether or not header names are
+         * lowercased.  Otherwise, each name is written as it
+         * appears in its first header.
+         */
+        bool lowercaseNames = false;
+
+        /**
+         * If not null, this says which headers are sensitive
+         * and how to hide their values.
+         */
+        const RedactionPolicy* redaction = nullptr;
+    };
+
+    /**
+     * This function appends the given text to the given string,
+     * escaped for use within a JSON string (without quotes).
+     * Valid UTF-8 is copied as is, but any byte which isn't part of
+     * a valid UTF-8 sequence, such as obs-text in a header value,
+     * is replaced by an escaped U+FFFD replacement character, so
+     * the output is always valid JSON.
+     *
+     * Where the processor supports it (SSE2), sixteen characters are
+     * checked at once for any which need escaping, and runs of
+     * characters which don't are copied all at once.
+     *
+     * @param[in] text
+     *     This is the text to append.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append the text.
+     */
+    void AppendJsonEscaped(std::string_view text, std::string& output);
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef MESSAGE_HEADERS_KEY_EXTRACTOR_HPP
+#define MESSAGE_HEADERS_KEY_EXTRACTOR_HPP
+
+/**
+ * @file KeyExtractor.hpp
+ *
+ * This module declares the MessageHeaders::KeyExtractor class,
+ * which computes rate-limit and sharding keys from message headers.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace MessageHeaders
+{
+    /**
+     * This describes one header which goes into a key,
+     * and how its value is normalized first.
+     */
+    struct KeyComponent {
+        /**
+         * This is the name of the header.
+         */
+        std::string name;
+
+        /**
+         * This indicates whether or not only the part of the value
+         * before the first comma is used, such as the client address
+         * in an X-Forwarded-For header.
+         */
+        bool firstMember = false;
+
+        /**
+         * This indicates whether or not the authentication scheme
+         * at the front of the value is skipped, such as the "Bearer"
+         * in an Authorization header, leaving the credentials.
+         */
+        bool credentialsOnly = false;
+
+        /**
+         * This indicates whether or not the value is compared
+         * without regard to case.
+         */
+        bool lowercase = false;
+    };
+
+    /**
+     * This computes a 64-bit key from a combination of headers of a
+     * message, as used for rate limiting or picking a shard.
+     *
+     * The headers making up the key are given once, when the object
+     * is made.  Each key is then computed in a single pass over the
+     * message headers, comparing the hashes of their names, after
+     * which the normalized values are fed to the hash directly from
+     * the headers, so no strings are built.  Whitespace at either end
+     * of each value is always ignored.  Only the first instance of
+     * each header is used, and a missing header is distinguished from
+     * one which is empty.
+     */
+    class KeyExtractor {
+        // Public Methods
+    public:
+        /**
+         * This is the largest number of headers which
+         * can go into a key.
+         */
+        static constexpr size_t MAX_COMPONENTS = 16;
+
+        /**
+         * This constructs the extractor.
+         *
+         * @param[in] components
+         *     These are the headers which go into the key,
+         *     in the order they're fed to the hash.
+         */
+        explicit KeyExtractor(const std::vector< KeyComponent >& components);
+
+        /**
+         * This method determines whether or not the extractor
+         * was given a usable list of headers: at least one,
+         * and no more than MAX_COMPONENTS.
+         *
+         * @return
+         *     An indication of whether or not the extractor
+         *     can be used is returned.
+         */
+        bool IsValid() const;
+
+        /**
+         * This method computes the key of the given message headers.
+         *
+         * @param[in] headers
+         *     These are the message headers.
+         *
+         * @return
+         *     The key is returned.
+         */
+        uint64_t GetKey(const MessageHeaders& headers) const;
+
+        /**
+         * This method picks the shard for the given message headers,
+         * from the key, with jump consistent hashing.
+         *
+         * @param[in] headers
+         *     These are the message headers.
+         *
+         * @param[in] shardCount
+         *     This is the number of shards.  It must not be zero.
+         *
+         * @return
+         *     The shard number, less than the shard count, is returned.
+         */
+        uint32_t GetShard(const MessageHeaders& headers, uint32_t shardCount) const;
+
+        // Private properties
+    private:
+        /**
+         * These are the headers which go into the key.
+         */
+        std::vector< KeyComponent > components_;
+
+        /**
+         * These are the hashes of the names of the headers
+         * which go into the key, in the same order.
+         */
+        std::vector< uint64_t > nameHashes_;
+    };
+
+    /**
+     * This function maps the given key to one of the given number
+     * of buckets, so that when the number of buckets grows from n
+     * to n + 1, only about 1 / (n + 1) of the keys move, all of them
+     * to the new bucket ("A Fast, Minimal Memory, Consistent Hash
+     * Algorithm", Lamping and Veach).
+     *
+     * @param[in] key
+     *     This is the key to map.
+     *
+     * @param[in] bucketCount
+     *     This is the number of buckets.  It must not be zero.
+     *
+     * @return
+     *     The bucket number, less than the bucket count, is returned.
+     */
+    uint32_t JumpConsistentHash(uint64_t key, uint32_t bucketCount);
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef MESSAGE_HEADERS_MEMORY_BUDGET_HPP
+#define MESSAGE_HEADERS_MEMORY_BUDGET_HPP
+
+/**
+ * @file MemoryBudget.hpp
+ *
+ * This module declares the MessageHeaders::MemoryBudget class.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace MessageHeaders
+{
+    /**
+     * This caps the memory taken by headers held by all the
+     * MessageHeaders instances sharing it (see
+     * MessageHeaders::SetMemoryBudget), so that many connections
+     * each sending big header blocks can't use up memory between
+     * them.  Instances charge the budget for the headers they store,
+     * and give the charges back when they're destroyed.
+     *
+     * The budget is kept in an atomic counter.  To keep threads from
+     * all hitting that counter, each thread takes budget from it a
+     * chunk at a time, and charges against what it took until it runs
+     * out; what it has left over beyond a couple of chunks goes back.
+     * Because of that, a charge may be refused while up to a couple
+     * of chunks per thread are taken but not yet used.  What a thread
+     * holds goes back to the budget when the thread exits.
+     */
+    class MemoryBudget {
+        // Lifecycle Management
+    public:
+        ~MemoryBudget();
+        MemoryBudget(const MemoryBudget&) = delete;
+        MemoryBudget(MemoryBudget&&);
+        MemoryBudget& operator=(const MemoryBudget&) = delete;
+        MemoryBudget& operator=(MemoryBudget&&);
+
+        // Public Methods
+    public:
+        /**
+         * This constructs the budget.
+         *
+         * @param[in] limit
+         *     This is the number of bytes in the budget.
+         *
+         * @param[in] chunkSize
+         *     This is the number of bytes each thread takes from the
+         *     budget at a time.  If zero, every charge goes straight
+         *     to the budget.
+         */
+        explicit MemoryBudget(size_t limit, size_t chunkSize = 65536);
+
+        /**
+         * This method charges the given number of bytes to the
+         * budget, unless that would go over it.
+         *
+         * @param[in] bytes
+         *     This is the number of bytes to charge.
+         *
+         * @return
+         *     An indication of whether or not the bytes
+         *     were charged is returned.
+         */
+        bool TryCharge(size_t bytes);
+
+        /**
+         * This method charges the given number of bytes
+         * to the budget, even if that goes over it.
+         *
+         * @param[in] bytes
+         *     This is the number of bytes to charge.
+         */
+        void Charge(size_t bytes);
+
+        /**
+         * This method gives back the given number of bytes
+         * charged to the budget.
+         *
+         * @param[in] bytes
+         *     This is the number of bytes to give back.
+         */
+        void Release(size_t bytes);
+
+        /**
+         * This method returns the number of bytes in the budget.
+         *
+         * @return
+         *     The number of bytes in the budget is returned.
+         */
+        size_t GetLimit() const;
+
+        /**
+         * This method returns the number of bytes taken from the
+         * budget.  This includes the credit threads have taken but
+         * not yet charged, up to a couple of chunks per thread, so it
+         * may be more than the bytes actually charged.
+         *
+         * @return
+         *     The number of bytes taken from the budget is returned.
+         */
+        size_t GetUsed() const;
+
+        /**
+         * This method returns the number of charges refused.
+         *
+         * @return
+         *     The number of charges refused is returned.
+         */
+        uint64_t GetRefusedCount() const;
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< struct Impl > impl_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
@@ -10,12 +10,25 @@
  * 
  */
 
+#include <functional>
 #include <memory>
+#include <MessageHeaders/DuplicatePolicy.hpp>
+#include <MessageHeaders/HeaderParser.hpp>
+#include <MessageHeaders/Json.hpp>
+#include <MessageHeaders/StaticHeaders.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+#include <stdint.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace MessageHeaders
 {
+    class HeaderSizeAccounting;
+    class HeaderStatistics;
+    class MemoryBudget;
+    class SamplingProfiler;
+
     /**
      * This class represents an MessageHeaders
      * as defined in RFC 2822 (https://tools.ietf.org/html/rfc2822) 
@@ -58,6 +71,7 @@ namespace MessageHeaders
              */
             HeaderName(const char* s)
                 : name_(s)
+                , hash_(HashHeaderName(name_))
             {
             }
 
@@ -81,6 +95,18 @@ namespace MessageHeaders
              */
             operator const std::string&() const noexcept;
 
+            /**
+             * This method returns the hash of the header name, which
+             * doesn't depend on the case of its letters.  It is computed
+             * once, when the name is made, so that names can be told
+             * apart without comparing their text.
+             *
+             * @return
+             *      The hash of the header name, as computed by
+             *      HashHeaderName, is returned.
+             */
+            uint64_t GetHash() const noexcept;
+
             /**
              * This method is used in range-for constructs, to get
              * the beginning iterator of the sequence.  It's merely
@@ -109,6 +135,11 @@ namespace MessageHeaders
              * This is the content of the header name.
              */
             std::string name_;
+
+            /**
+             * This is the hash of the header name.
+             */
+            uint64_t hash_ = HashHeaderName("");
         };
 
         /**
@@ -157,6 +188,35 @@ namespace MessageHeaders
          */
         typedef std::vector<Header> Headers;
 
+        /**
+         * These are the reasons ParseRawMessage may fail.
+         */
+        enum class ParseError {
+            /**
+             * The last message was parsed successfully,
+             * or no message has been parsed.
+             */
+            None,
+
+            /**
+             * The headers were not valid, a line was longer
+             * than the line limit, or the headers didn't end.
+             */
+            Malformed,
+
+            /**
+             * A header was repeated whose duplicate policy
+             * is DuplicatePolicy::Reject.
+             */
+            DuplicateRejected,
+
+            /**
+             * Storing a header would have gone over the memory budget
+             * (see SetMemoryBudget).
+             */
+            BudgetExhausted,
+        };
+
         // Lifecycle management
     public:
         ~MessageHeaders();
@@ -183,6 +243,174 @@ namespace MessageHeaders
          */
         void SetLineLimit(size_t newLineLengthLimit);
 
+        /**
+         * This method selects how ParseRawMessage recognizes headers.
+         *
+         * @param[in] engine
+         *      This is the engine to use.  The default is
+         *      HeaderParser::Engine::Scan.
+         */
+        void SetParseEngine(HeaderParser::Engine engine);
+
+        /**
+         * This method sets what ParseRawMessage does when it finds
+         * a header with the given name more than once in the same message.
+         * Until this method or UseDefaultDuplicatePolicies is called,
+         * every header is kept separately.
+         *
+         * @note
+         *     Duplicate policies are applied while parsing only.
+         *     Headers added with AddHeader are always kept separately.
+         *
+         * @param[in] name
+         *      This is the name of the header.
+         *
+         * @param[in] duplicatePolicy
+         *      This is what to do with repeated instances of the header.
+         *      With DuplicatePolicy::Reject, the parse fails.
+         */
+        void SetDuplicatePolicy(const HeaderName& name, DuplicatePolicy duplicatePolicy);
+
+        /**
+         * This method makes ParseRawMessage apply the duplicate policies
+         * given in the well-known header table (see WellKnownHeaders.hpp),
+         * replacing any set earlier for well-known headers.  For example,
+         * list headers such as Accept are combined, Set-Cookie is kept
+         * separate, and a second Host or Content-Length header makes
+         * the parse fail.  Other headers are kept separately unless
+         * SetDuplicatePolicy says otherwise.
+         */
+        void UseDefaultDuplicatePolicies();
+
+        /**
+         * This method makes ParseRawMessage parse very large header
+         * blocks on several threads.  The block is split only where a
+         * line begins that doesn't continue the previous one, and the
+         * headers of all the pieces are stored in their original order.
+         *
+         * @note
+         *     Pieces are always parsed with HeaderParser::Engine::Dfa.
+         *     Duplicate policies are applied while the pieces are
+         *     stitched together, once all have parsed.  If any piece is
+         *     bad, or a duplicate would be rejected, ParseRawMessage
+         *     stores no headers from the message at all, unlike parsing
+         *     in one go, which keeps the headers parsed before the
+         *     failure.  The block is then parsed again in one go, just
+         *     to find the reason, so GetLastParseError reports the same
+         *     reason as it would without parallel parsing, at the cost
+         *     of parsing a bad block twice.  If a thread can't be
+         *     started, its piece is parsed on the calling thread, and
+         *     anything thrown while parsing a piece is thrown again from
+         *     ParseRawMessage once all threads are done, with no headers
+         *     stored.
+         *
+         * @param[in] threshold
+         *      This is the smallest header block, in bytes, to split up,
+         *      or zero to never split up header blocks (the default).
+         *
+         * @param[in] maxThreads
+         *      This is the largest number of threads, including the
+         *      calling thread, to use for a single header block.
+         */
+        void SetParallelParsing(size_t threshold, size_t maxThreads);
+
+        /**
+         * This method makes ParseRawMessage compute a fingerprint of
+         * the headers of the message as it parses them, for telling
+         * clients apart by how they write their headers.  It covers
+         * the order in which header names appear, including repeats,
+         * and how each name is capitalized, but not the values.
+         *
+         * Well-known names are taken from the table in
+         * WellKnownHeaders.hpp, and others are hashed, in the same
+         * pass over the name which recognizes its capitalization, so
+         * fingerprinting costs little more than parsing.
+         *
+         * @param[in] fingerprinting
+         *      This indicates whether or not ParseRawMessage
+         *      should compute a fingerprint.
+         */
+        void SetFingerprinting(bool fingerprinting);
+
+        /**
+         * This method returns the fingerprint computed by the last
+         * call to ParseRawMessage (see SetFingerprinting).  It covers
+         * the headers as they appeared in the message, before any
+         * duplicate policies were applied.
+         *
+         * @return
+         *      The fingerprint of the headers of the last message
+         *      parsed is returned.
+         *
+         * @retval 0
+         *      This is returned if fingerprinting is off,
+         *      or no message has been parsed.
+         */
+        uint64_t GetFingerprint() const;
+
+        /**
+         * This method makes ParseRawMessage record the headers of
+         * each message it parses successfully into the given
+         * statistics, which may be shared by many instances
+         * parsing on different threads.
+         *
+         * @param[in] statistics
+         *      These are the statistics into which to record headers.
+         *      If null, headers are not recorded.  They must outlive
+         *      their use by this instance.
+         */
+        void SetStatistics(HeaderStatistics* statistics);
+
+        /**
+         * This method makes ParseRawMessage and GenerateRawHeaders
+         * count the bytes taken by each header, by name, and by each
+         * header block, into the given accounting, which may be shared
+         * by many instances on different threads.
+         *
+         * A parsed header is counted as if written on one line,
+         * as each is reported by the parser, even if the message
+         * turns out to be bad; a header block is counted only if
+         * parsed successfully.  A generated header is counted as
+         * written out, after any redaction and folding.
+         *
+         * @param[in] accounting
+         *      This is the accounting into which to count header sizes.
+         *      If null, header sizes are not counted.  It must outlive
+         *      its use by this instance.
+         */
+        void SetSizeAccounting(HeaderSizeAccounting* accounting);
+
+        /**
+         * This method makes ParseRawMessage, GetHeaderValue,
+         * GetHeaderMultiValue and GenerateRawHeaders time one in every
+         * few calls, as the given profiler decides, and record the
+         * samples into it.  The profiler may be shared by many
+         * instances on different threads.
+         *
+         * @param[in] profiler
+         *      This is the profiler into which to record samples.
+         *      If null, calls are not timed.  It must outlive
+         *      its use by this instance.
+         */
+        void SetProfiler(SamplingProfiler* profiler);
+
+        /**
+         * This method makes the instance charge the given budget for
+         * the headers it stores, giving the charges back when it's
+         * destroyed or given another budget.  Headers already stored
+         * are charged straight away.
+         *
+         * ParseRawMessage stops, with ParseError::BudgetExhausted,
+         * as soon as storing a header would go over the budget.  Other
+         * methods adding headers can't fail, so they charge the budget
+         * even if that goes over it.
+         *
+         * @param[in] budget
+         *      This is the budget to charge.  If null, no budget
+         *      is charged.  It must outlive its use by this instance.
+         */
+        void SetMemoryBudget(MemoryBudget* budget);
+
         /**
          * This method determines the headers and body
          * of the message by parsing the raw message from a string.
@@ -234,9 +462,100 @@ namespace MessageHeaders
          */
         bool ParseRawMessage(const std::string& rawMessage);
 
+        /**
+         * This method returns why the last call to ParseRawMessage
+         * failed.
+         *
+         * @return
+         *     The reason the last call to ParseRawMessage failed
+         *     is returned.
+         *
+         * @retval ParseError::None
+         *     This is returned if the last call to ParseRawMessage
+         *     succeeded, or there hasn't been one.
+         */
+        ParseError GetLastParseError() const;
 
         Headers GetAll() const;
 
+        /**
+         * This method returns the number of headers in the message.
+         *
+         * @return
+         *      The number of headers in the message is returned.
+         */
+        size_t GetHeaderCount() const;
+
+        /**
+         * This method returns the header at the given position
+         * in the message, without copying it.
+         *
+         * @param[in] index
+         *      This is the position of the header to return.
+         *      It must be less than GetHeaderCount().
+         *
+         * @return
+         *      The header is returned.  It remains valid until
+         *      the headers are next modified.
+         */
+        const Header& GetHeader(size_t index) const;
+
+        /**
+         * This method changes the value of the header at the given
+         * position in the message in place, rather than replacing it,
+         * keeping the semantic hash of the headers up to date.
+         *
+         * @param[in] index
+         *      This is the position of the header whose value
+         *      should be changed.  It must be less than GetHeaderCount().
+         *
+         * @param[in] editor
+         *      This is the function which is given the header value
+         *      to change.  The value must not be kept past the call.
+         */
+        void EditHeaderValue(
+            size_t index,
+            const std::function< void(HeaderValue& value) >& editor
+        );
+
+        /**
+         * This method returns a hash of the headers which doesn't
+         * depend on how headers with different names are interleaved,
+         * nor on the case of the names, but does depend on the order
+         * of the values of headers sharing a name.  Messages whose
+         * headers are equivalent have the same semantic hash.
+         *
+         * The hash is kept up to date as the headers are modified,
+         * so this method takes constant time.  Adding a header finds
+         * its ordinal among headers with the same name from the
+         * well-known header index when it can: for a well-known name
+         * stored at most once before.  Otherwise the stored headers
+         * are scanned.
+         *
+         * @return
+         *      The semantic hash of the headers is returned.
+         */
+        uint64_t SemanticHash() const;
+
+        /**
+         * This method finds the next header with the given name,
+         * comparing the hashes of the names before their text.
+         *
+         * @param[in] name
+         *      This is the name of the header to find.
+         *
+         * @param[in] startIndex
+         *      This is the position at which to begin looking.
+         *
+         * @return
+         *      The position of the header is returned.
+         *
+         * @retval GetHeaderCount()
+         *      This is returned if there is no header with the given
+         *      name at or after the given position.
+         */
+        size_t FindHeader(std::string_view name, size_t startIndex = 0) const;
+
         bool HasHeader(const HeaderName& name) const;
 
         /**
@@ -331,6 +650,25 @@ namespace MessageHeaders
             bool oneLine
         );
 
+        /**
+         * This method adds all the headers of the given
+         * constant header block, after any existing headers.
+         *
+         * @param[in] headers
+         *     These are the headers to add.
+         */
+        void AddHeaders(const StaticHeaderTable& headers);
+
+        /**
+         * This method adds all the headers of the given constant
+         * header block, after first removing any existing headers
+         * with the same names.
+         *
+         * @param[in] headers
+         *     These are the headers to add or replace.
+         */
+        void SetHeaders(const StaticHeaderTable& headers);
+
         /**
          * This method removes the header with the given name
          * from the headers.
@@ -351,6 +689,44 @@ namespace MessageHeaders
          */
         std::string GenerateRawHeaders() const;
 
+        /**
+         * This method constructs and returns the raw string
+         * headers, as GenerateRawHeaders does, but with the values
+         * of sensitive headers hidden, for logging.
+         *
+         * @param[in] redaction
+         *      This says which headers are sensitive
+         *      and how to hide their values.
+         *
+         * @return
+         *      The raw string internet message, with the values
+         *      of sensitive headers hidden, is returned.
+         */
+        std::string GenerateRawHeaders(const RedactionPolicy& redaction) const;
+
+        /**
+         * This method appends the headers to the given string as a
+         * JSON object, with a member for each header name, in the
+         * order the names first appear.  Values are written straight
+         * from the headers into the string, escaped as they go.
+         * Bytes which aren't valid UTF-8, such as obs-text, are
+         * replaced by U+FFFD, so the output is always valid JSON.
+         * Headers are grouped by name on the stack, without
+         * allocating, for up to 64 headers; more are grouped
+         * through a table by name hash.
+         *
+         * @param[in,out] output
+         *      This is the string to which to append the JSON object.
+         *      Its memory is reused, growing as needed.
+         *
+         * @param[in] options
+         *      These are the options for how headers are exported.
+         */
+        void ToJson(
+            std::string& output,
+            const JsonOptions& options = JsonOptions()
+        ) const;
+
         // Private properties
     private:
         /**
@@ -404,6 +780,50 @@ namespace MessageHeaders
         const MessageHeaders::HeaderName& rhs
         );
 
+    /**
+     * This function determines whether or not two header names
+     * are equivalent (case-insensitive).
+     *
+     * @param[in] lhs
+     *     This is one header name to compare.
+     *
+     * @param[in] rhs
+     *     This is the other header name to compare.
+     *
+     * @return
+     *     An indication of whether or not the two header names
+     *     are equivalent (case-insensitive) is returned.
+     */
+    bool HeaderNamesEqual(std::string_view lhs, std::string_view rhs) noexcept;
+
+    /**
+     * This function determines whether or not two sets of message
+     * headers are equivalent: they hold the same headers, ignoring
+     * the case of names and the interleaving of headers with
+     * different names, but with the values of headers sharing a
+     * name in the same order.
+     *
+     * The semantic hashes are compared first, so sets which differ
+     * are almost always told apart in constant time.  Otherwise, up
+     * to 32 headers are matched pairwise, without allocating; more
+     * are sorted by name on each side, in an index allocated for
+     * each, and compared in that order, in O(n log n) time.
+     *
+     * @param[in] lhs
+     *     This is one set of headers to compare.
+     *
+     * @param[in] rhs
+     *     This is the other set of headers to compare.
+     *
+     * @return
+     *     An indication of whether or not the two sets of
+     *     headers are equivalent is returned.
+     */
+    bool Equivalent(
+        const MessageHeaders& lhs,
+        const MessageHeaders& rhs
+    );
+
     /**
      * This is a support function for Google Test to print out
      * values of the MessageHeaders::HeaderName class.
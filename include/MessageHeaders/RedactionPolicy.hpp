@@ -0,0 +1,195 @@
+#ifndef MESSAGE_HEADERS_REDACTION_POLICY_HPP
+#define MESSAGE_HEADERS_REDACTION_POLICY_HPP
+
+/**
+ * @file RedactionPolicy.hpp
+ *
+ * This module declares the MessageHeaders::RedactionPolicy class.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <functional>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MessageHeaders
+{
+    /**
+     * These are the ways in which the value of a sensitive
+     * header may be hidden.
+     */
+    enum class RedactionMode {
+        /**
+         * The whole value is replaced by "[REDACTED]".
+         */
+        Full,
+
+        /**
+         * The authentication scheme at the front of the value
+         * is kept, as in "Bearer [REDACTED]".
+         */
+        KeepScheme,
+
+        /**
+         * The names in a list of name=value pairs separated by
+         * semicolons are kept, as in "id=[REDACTED]; lang=[REDACTED]",
+         * along with any members lacking values, such as the Secure
+         * attribute of a Set-Cookie header.
+         */
+        KeepCookieNames,
+
+        /**
+         * The last few characters of the value are kept, as in
+         * "[REDACTED]1234".  Values no longer than the number of
+         * characters kept are hidden completely.
+         */
+        KeepTail,
+    };
+
+    /**
+     * This says which headers are sensitive and how to hide their
+     * values when headers are rendered for logging, by
+     * MessageHeaders::GenerateRawHeaders or MessageHeaders::ToJson.
+     * The headers themselves are left untouched and not copied;
+     * values are hidden as they're written out.
+     *
+     * Names are looked up by their hashes in a table kept sorted
+     * as names are added.
+     */
+    class RedactionPolicy {
+        // Public Methods
+    public:
+        /**
+         * This is the type of function which receives a hidden
+         * value, in order, a piece at a time.
+         */
+        typedef std::function< void(std::string_view piece) > Sink;
+
+        /**
+         * This is what replaces the hidden parts of values.
+         */
+        static constexpr std::string_view MASK = "[REDACTED]";
+
+        /**
+         * This method adds the usual sensitive headers to the policy:
+         * Authorization and Proxy-Authorization (keeping the scheme),
+         * Cookie and Set-Cookie (keeping cookie names), and X-Api-Key,
+         * X-Auth-Token, and X-Csrf-Token (hidden completely).
+         */
+        void UseDefaultNames();
+
+        /**
+         * This method adds a sensitive header to the policy,
+         * replacing any rule already given for it.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @param[in] mode
+         *     This is how to hide the value of the header.
+         *
+         * @param[in] keepCharacters
+         *     This is the number of characters kept at the end
+         *     of the value, for RedactionMode::KeepTail.
+         */
+        void AddName(
+            std::string_view name,
+            RedactionMode mode = RedactionMode::Full,
+            size_t keepCharacters = 4
+        );
+
+        /**
+         * This method determines whether or not the
+         * given header is sensitive.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @return
+         *     An indication of whether or not the header
+         *     is sensitive is returned.
+         */
+        bool Covers(const MessageHeaders::HeaderName& name) const;
+
+        /**
+         * This method streams the value of the given header, hidden
+         * as the policy says, to the given sink.  Parts of the value
+         * which are kept are passed on without being copied.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @param[in] value
+         *     This is the value of the header.
+         *
+         * @param[in] sink
+         *     This is the function which receives the hidden value.
+         *
+         * @return
+         *     An indication of whether or not the header is sensitive
+         *     is returned.  If it isn't, the sink receives nothing.
+         */
+        bool Redact(
+            const MessageHeaders::HeaderName& name,
+            std::string_view value,
+            const Sink& sink
+        ) const;
+
+        // Private properties
+    private:
+        /**
+         * This says how to hide the value of one sensitive header.
+         */
+        struct Rule {
+            /**
+             * This is the hash of the name of the header.
+             */
+            uint64_t nameHash;
+
+            /**
+             * This is the name of the header.
+             */
+            std::string name;
+
+            /**
+             * This is how to hide the value of the header.
+             */
+            RedactionMode mode;
+
+            /**
+             * This is the number of characters kept at the end
+             * of the value, for RedactionMode::KeepTail.
+             */
+            size_t keepCharacters;
+        };
+
+        /**
+         * This method finds the rule for the given header.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @return
+         *     The rule for the header is returned.
+         *
+         * @retval nullptr
+         *     This is returned if the header isn't sensitive.
+         */
+        const Rule* FindRule(const MessageHeaders::HeaderName& name) const;
+
+        /**
+         * These are the rules for the sensitive headers,
+         * in order of the hashes of their names.
+         */
+        std::vector< Rule > rules_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
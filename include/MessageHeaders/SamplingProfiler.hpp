@@ -0,0 +1,178 @@
+#ifndef MESSAGE_HEADERS_SAMPLING_PROFILER_HPP
+#define MESSAGE_HEADERS_SAMPLING_PROFILER_HPP
+
+/**
+ * @file SamplingProfiler.hpp
+ *
+ * This module declares the MessageHeaders::SamplingProfiler class.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <chrono>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace MessageHeaders
+{
+    /**
+     * These are the operations of MessageHeaders::MessageHeaders
+     * which may be profiled.
+     */
+    enum class ProfiledOperation {
+        /**
+         * ParseRawMessage
+         */
+        Parse,
+
+        /**
+         * GetHeaderValue or GetHeaderMultiValue
+         */
+        Lookup,
+
+        /**
+         * GenerateRawHeaders
+         */
+        Generate,
+    };
+
+    /**
+     * This is how long one operation took, and how big it was.
+     */
+    struct ProfileSample {
+        /**
+         * This is the operation.
+         */
+        ProfiledOperation operation = ProfiledOperation::Parse;
+
+        /**
+         * This is when the operation started, in nanoseconds
+         * of std::chrono::steady_clock.
+         */
+        uint64_t startTime = 0;
+
+        /**
+         * This is how long the operation took, in nanoseconds.
+         */
+        uint64_t duration = 0;
+
+        /**
+         * This is the number of bytes the operation took in or gave
+         * out: the raw message parsed, the value looked up, or the
+         * raw headers generated.
+         */
+        uint64_t bytes = 0;
+
+        /**
+         * This is the number of headers held after the operation.
+         */
+        uint64_t headers = 0;
+    };
+
+    /**
+     * This times one in every few operations of the MessageHeaders
+     * instances which use it (see MessageHeaders::SetProfiler), so it
+     * may be left on in production to show how long parsing, lookups
+     * and generating take.
+     *
+     * Each thread decides which of its operations to time by counting
+     * them down, and puts the samples into its own ring buffer, which
+     * only it writes to, without locking.  A reporter, usually on
+     * a thread of its own, drains the samples from all the buffers
+     * from time to time.  If a buffer fills up before it's drained,
+     * new samples are dropped and counted.
+     */
+    class SamplingProfiler {
+        // Lifecycle Management
+    public:
+        ~SamplingProfiler();
+        SamplingProfiler(const SamplingProfiler&) = delete;
+        SamplingProfiler(SamplingProfiler&&);
+        SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+        SamplingProfiler& operator=(SamplingProfiler&&);
+
+        // Public Methods
+    public:
+        /**
+         * This is the clock used to time operations.
+         */
+        typedef std::chrono::steady_clock Clock;
+
+        /**
+         * This constructs the profiler.
+         *
+         * @param[in] sampleInterval
+         *     One in every this many operations on each thread is
+         *     timed.  If zero, no operations are timed.
+         *
+         * @param[in] bufferCapacity
+         *     This is the number of samples each thread's buffer holds.
+         *     It's rounded up to a power of two.
+         */
+        explicit SamplingProfiler(
+            size_t sampleInterval = 1024,
+            size_t bufferCapacity = 1024
+        );
+
+        /**
+         * This method decides whether or not to time
+         * the calling thread's next operation.
+         *
+         * @return
+         *     An indication of whether or not to time
+         *     the next operation is returned.
+         */
+        bool ShouldSample();
+
+        /**
+         * This method puts the given sample into
+         * the calling thread's buffer.
+         *
+         * @param[in] sample
+         *     This is the sample to record.
+         */
+        void Record(const ProfileSample& sample);
+
+        /**
+         * This method takes the samples out of all the
+         * threads' buffers and appends them to the given vector.
+         * It may be called from any thread.
+         *
+         * @param[in,out] samples
+         *     This is where to append the samples.
+         *
+         * @return
+         *     The number of samples taken out is returned.
+         */
+        size_t Drain(std::vector< ProfileSample >& samples);
+
+        /**
+         * This method returns the number of samples dropped
+         * because a buffer was full.
+         *
+         * @return
+         *     The number of samples dropped is returned.
+         */
+        uint64_t GetDroppedCount() const;
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< struct Impl > impl_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,441 @@
+#ifndef MESSAGE_HEADERS_SET_COOKIE_HPP
+#define MESSAGE_HEADERS_SET_COOKIE_HPP
+
+/**
+ * @file SetCookie.hpp
+ *
+ * This module declares the MessageHeaders::SetCookie,
+ * MessageHeaders::SetCookies and MessageHeaders::SetCookieBuilder
+ * classes, which read and write Set-Cookie headers (RFC 6265).
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+namespace MessageHeaders
+{
+    /**
+     * These are the values of the SameSite cookie attribute.
+     */
+    enum class SameSite {
+        /**
+         * The attribute is missing or has an unrecognized value.
+         */
+        Unspecified,
+
+        Strict,
+        Lax,
+        None,
+    };
+
+    /**
+     * This is a view of the value of a single Set-Cookie header.
+     * The cookie name and value are found when the view is made;
+     * the attributes are only looked for when asked for.  Everything
+     * returned refers to the header value, which must outlive the view.
+     */
+    class SetCookie {
+        // Public Methods
+    public:
+        /**
+         * This constructs the view of the given Set-Cookie header value.
+         *
+         * @param[in] headerValue
+         *     This is the value of the Set-Cookie header.
+         */
+        explicit SetCookie(std::string_view headerValue);
+
+        /**
+         * This method determines whether or not the header value
+         * has a cookie name and value, as required by RFC 6265
+         * section 5.2.  A user agent ignores headers which don't.
+         *
+         * @return
+         *     An indication of whether or not the header value
+         *     has a cookie name and value is returned.
+         */
+        bool IsValid() const;
+
+        /**
+         * This method returns the name of the cookie.
+         *
+         * @return
+         *     The name of the cookie is returned.
+         */
+        std::string_view GetName() const;
+
+        /**
+         * This method returns the value of the cookie.
+         *
+         * @return
+         *     The value of the cookie is returned.
+         */
+        std::string_view GetValue() const;
+
+        /**
+         * This method looks for the cookie attribute with the given
+         * name (case-insensitive).  If there is more than one,
+         * the last one is the one that counts.
+         *
+         * @param[in] name
+         *     This is the name of the attribute to look for.
+         *
+         * @param[out] value
+         *     This is where to store the value of the attribute,
+         *     which is empty for attributes without one, such as Secure.
+         *
+         * @return
+         *     An indication of whether or not the attribute
+         *     was found is returned.
+         */
+        bool FindAttribute(std::string_view name, std::string_view& value) const;
+
+        /**
+         * This method returns the point in time given by the
+         * Expires attribute of the cookie.
+         *
+         * @param[out] secondsSinceEpoch
+         *     This is where to store the number of seconds between
+         *     the UNIX epoch and the expiry of the cookie.
+         *
+         * @return
+         *     An indication of whether or not the cookie has an
+         *     Expires attribute with a date that could be
+         *     recognized is returned.
+         */
+        bool GetExpires(int64_t& secondsSinceEpoch) const;
+
+        /**
+         * This method returns the Max-Age attribute of the cookie.
+         *
+         * @param[out] seconds
+         *     This is where to store the number of seconds until
+         *     the cookie expires.  Zero or less means the cookie
+         *     has expired.  Values too large to represent are
+         *     clamped to the largest or smallest number of seconds
+         *     that can be, as RFC 6265 section 5.2.2 allows.
+         *
+         * @return
+         *     An indication of whether or not the cookie has a
+         *     valid Max-Age attribute is returned.
+         */
+        bool GetMaxAge(int64_t& seconds) const;
+
+        /**
+         * This method returns the Domain attribute of the cookie,
+         * without any leading dot.
+         *
+         * @return
+         *     The Domain attribute of the cookie is returned.
+         *
+         * @retval ""
+         *     This is returned if the cookie has no Domain attribute.
+         */
+        std::string_view GetDomain() const;
+
+        /**
+         * This method returns the Path attribute of the cookie.
+         *
+         * @return
+         *     The Path attribute of the cookie is returned.
+         *
+         * @retval ""
+         *     This is returned if the cookie has no Path attribute,
+         *     or one which doesn't begin with a slash.
+         */
+        std::string_view GetPath() const;
+
+        /**
+         * This method returns the SameSite attribute of the cookie.
+         *
+         * @return
+         *     The SameSite attribute of the cookie is returned.
+         */
+        SameSite GetSameSite() const;
+
+        /**
+         * This method determines whether or not the cookie
+         * has the Secure attribute.
+         *
+         * @return
+         *     An indication of whether or not the cookie
+         *     has the Secure attribute is returned.
+         */
+        bool IsSecure() const;
+
+        /**
+         * This method determines whether or not the cookie
+         * has the HttpOnly attribute.
+         *
+         * @return
+         *     An indication of whether or not the cookie
+         *     has the HttpOnly attribute is returned.
+         */
+        bool IsHttpOnly() const;
+
+        // Private properties
+    private:
+        /**
+         * This is the name of the cookie.
+         */
+        std::string_view name_;
+
+        /**
+         * This is the value of the cookie.
+         */
+        std::string_view value_;
+
+        /**
+         * This is the part of the header value holding the
+         * cookie attributes, starting after the first semicolon.
+         */
+        std::string_view attributes_;
+
+        /**
+         * This indicates whether or not the header value
+         * has a cookie name and value.
+         */
+        bool isValid_ = false;
+    };
+
+    /**
+     * This is the sequence of Set-Cookie headers of a message,
+     * presented as SetCookie views, in the order they appear.
+     * Nothing is copied; the views refer to the header values,
+     * which are valid until the headers are next modified.
+     */
+    class SetCookies {
+        // Public Methods
+    public:
+        /**
+         * This is used to step through the Set-Cookie headers.
+         */
+        class Iterator {
+            // Public Methods
+        public:
+            /**
+             * This constructs the iterator at the first Set-Cookie
+             * header found at or after the given position.
+             *
+             * @param[in] headers
+             *     These are the message headers to step through.
+             *
+             * @param[in] index
+             *     This is the position at which to begin looking.
+             */
+            Iterator(const MessageHeaders& headers, size_t index);
+
+            /**
+             * This method returns the view of the current header.
+             *
+             * @return
+             *     The view of the current header is returned.
+             */
+            SetCookie operator*() const;
+
+            /**
+             * This method advances to the next Set-Cookie header.
+             *
+             * @return
+             *     The iterator is returned.
+             */
+            Iterator& operator++();
+
+            /**
+             * These are the comparison operators for the class.
+             */
+            bool operator==(const Iterator& rhs) const;
+            bool operator!=(const Iterator& rhs) const;
+
+            // Private Methods
+        private:
+            /**
+             * This method moves the iterator forward until it's
+             * at a Set-Cookie header or the end of the headers.
+             */
+            void SkipOtherHeaders();
+
+            // Private properties
+        private:
+            /**
+             * These are the message headers being stepped through.
+             */
+            const MessageHeaders* headers_;
+
+            /**
+             * This is the position of the current header.
+             */
+            size_t index_;
+        };
+
+        /**
+         * This constructs the sequence of Set-Cookie headers
+         * of the given message headers.
+         *
+         * @param[in] headers
+         *     These are the message headers.
+         */
+        explicit SetCookies(const MessageHeaders& headers);
+
+        /**
+         * These methods are used in range-for constructs.
+         */
+        Iterator begin() const;
+        Iterator end() const;
+
+        // Private properties
+    private:
+        /**
+         * These are the message headers.
+         */
+        const MessageHeaders& headers_;
+    };
+
+    /**
+     * This adds a Set-Cookie header to message headers, and then
+     * writes each attribute given to it directly onto the end of
+     * the stored header value, without building it elsewhere first:
+     *
+     *     SetCookieBuilder(headers, "sid", sessionId)
+     *         .SetPath("/")
+     *         .SetMaxAge(3600)
+     *         .SetSecure()
+     *         .SetHttpOnly();
+     *
+     * Nothing checks that the names and values given are allowed
+     * in a cookie; that is up to the caller.
+     */
+    class SetCookieBuilder {
+        // Public Methods
+    public:
+        /**
+         * This constructs the builder, adding a Set-Cookie
+         * header with the given cookie name and value.
+         *
+         * @param[in,out] headers
+         *     These are the message headers to which to add the cookie.
+         *
+         * @param[in] name
+         *     This is the name of the cookie.
+         *
+         * @param[in] value
+         *     This is the value of the cookie.
+         */
+        SetCookieBuilder(
+            MessageHeaders& headers,
+            std::string_view name,
+            std::string_view value
+        );
+
+        /**
+         * This method adds the Expires attribute to the cookie.
+         *
+         * @param[in] secondsSinceEpoch
+         *     This is the number of seconds between the UNIX epoch
+         *     and the expiry of the cookie.
+         *
+         * @return
+         *     The builder is returned.
+         */
+        SetCookieBuilder& SetExpires(int64_t secondsSinceEpoch);
+
+        /**
+         * This method adds the Max-Age attribute to the cookie.
+         *
+         * @param[in] seconds
+         *     This is the number of seconds until the cookie expires.
+         *
+         * @return
+         *     The builder is returned.
+         */
+        SetCookieBuilder& SetMaxAge(int64_t seconds);
+
+        /**
+         * This method adds the Domain attribute to the cookie.
+         *
+         * @param[in] domain
+         *     This is the domain to which the cookie should be sent.
+         *
+         * @return
+         *     The builder is returned.
+         */
+        SetCookieBuilder& SetDomain(std::string_view domain);
+
+        /**
+         * This method adds the Path attribute to the cookie.
+         *
+         * @param[in] path
+         *     This is the path to which the cookie should be sent.
+         *
+         * @return
+         *     The builder is returned.
+         */
+        SetCookieBuilder& SetPath(std::string_view path);
+
+        /**
+         * This method adds the SameSite attribute to the cookie.
+         * Adding SameSite::Unspecified does nothing.
+         *
+         * @param[in] sameSite
+         *     This is the value of the attribute.
+         *
+         * @return
+         *     The builder is returned.
+         */
+        SetCookieBuilder& SetSameSite(SameSite sameSite);
+
+        /**
+         * This method adds the Secure attribute to the cookie.
+         *
+         * @return
+         *     The builder is returned.
+         */
+        SetCookieBuilder& SetSecure();
+
+        /**
+         * This method adds the HttpOnly attribute to the cookie.
+         *
+         * @return
+         *     The builder is returned.
+         */
+        SetCookieBuilder& SetHttpOnly();
+
+        // Private Methods
+    private:
+        /**
+         * This method appends an attribute to the Set-Cookie header.
+         *
+         * @param[in] attribute
+         *     This is the attribute, with its leading separator,
+         *     and its equals sign if it has a value.
+         *
+         * @param[in] value
+         *     This is the value of the attribute, if any.
+         */
+        void AppendAttribute(
+            std::string_view attribute,
+            std::string_view value = std::string_view()
+        );
+
+        // Private properties
+    private:
+        /**
+         * These are the message headers to which the cookie was added.
+         */
+        MessageHeaders& headers_;
+
+        /**
+         * This is the position of the Set-Cookie header
+         * in the message headers.
+         */
+        size_t index_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
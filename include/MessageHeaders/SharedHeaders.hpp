@@ -0,0 +1,154 @@
+#ifndef MESSAGE_HEADERS_SHARED_HEADERS_HPP
+#define MESSAGE_HEADERS_SHARED_HEADERS_HPP
+
+/**
+ * @file SharedHeaders.hpp
+ *
+ * This module declares the MessageHeaders::SharedHeaders class.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <memory>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/StaticHeaders.hpp>
+#include <stddef.h>
+
+namespace MessageHeaders
+{
+    /**
+     * This holds a set of headers, such as the default headers added
+     * to every response, which many threads read while it may be
+     * replaced at any time.  Each version published is never changed,
+     * so readers use it in place, merging it into a MessageHeaders
+     * with AddHeaders or SetHeaders, or writing out its raw rendering,
+     * without copying it first.
+     *
+     * Readers take no locks.  A reader marks its thread with the
+     * epoch in which it started reading, and a version replaced is
+     * only destroyed once no thread is still reading from an epoch
+     * in which that version could have been seen.  Publishing takes
+     * a lock only other publishers use, so reloading the headers
+     * doesn't hold up readers.
+     */
+    class SharedHeaders {
+        // Lifecycle Management
+    public:
+        ~SharedHeaders();
+        SharedHeaders(const SharedHeaders&) = delete;
+        SharedHeaders(SharedHeaders&&);
+        SharedHeaders& operator=(const SharedHeaders&) = delete;
+        SharedHeaders& operator=(SharedHeaders&&);
+
+        // Public Methods
+    public:
+        /**
+         * This is where a thread marks the epoch in which it
+         * started reading.  It's defined in the implementation.
+         */
+        struct ReaderSlot;
+
+        /**
+         * This keeps the version of the headers it was made with
+         * from being destroyed, for as long as it's kept.  It must
+         * be destroyed by the thread which made it.
+         */
+        class ReadGuard {
+            // Lifecycle Management
+        public:
+            ~ReadGuard();
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard(ReadGuard&& other) noexcept;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+            ReadGuard& operator=(ReadGuard&&) = delete;
+
+            // Public Methods
+        public:
+            /**
+             * This constructs the guard.
+             *
+             * @param[in] slot
+             *     This is where the calling thread marked the epoch
+             *     in which it started reading.
+             *
+             * @param[in] headers
+             *     These are the headers being read.
+             */
+            ReadGuard(ReaderSlot* slot, const StaticHeaderTable* headers);
+
+            /**
+             * This method returns the headers being read.
+             *
+             * @return
+             *     The headers being read are returned.
+             */
+            const StaticHeaderTable& GetHeaders() const;
+
+            // Private properties
+        private:
+            /**
+             * This is where the calling thread marked the epoch
+             * in which it started reading.
+             */
+            ReaderSlot* slot_;
+
+            /**
+             * These are the headers being read.
+             */
+            const StaticHeaderTable* headers_;
+        };
+
+        /**
+         * This constructs the set, with no headers in it.
+         */
+        SharedHeaders();
+
+        /**
+         * This method replaces the headers with a copy of the given
+         * headers.  The version replaced is destroyed once no reader
+         * can still be using it, which may be during this call or a
+         * later call to Publish or Reclaim.
+         *
+         * @param[in] headers
+         *     These are the headers to publish.
+         */
+        void Publish(const MessageHeaders& headers);
+
+        /**
+         * This method starts reading the headers.
+         *
+         * @return
+         *     A guard through which the current version of the headers
+         *     may be read is returned.  Reads may be nested.
+         */
+        ReadGuard Read() const;
+
+        /**
+         * This method destroys any versions replaced which
+         * no reader can still be using.
+         *
+         * @return
+         *     The number of versions replaced but still
+         *     waiting to be destroyed is returned.
+         */
+        size_t Reclaim();
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< struct Impl > impl_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef MESSAGE_HEADERS_SIGNATURE_BASE_HPP
+#define MESSAGE_HEADERS_SIGNATURE_BASE_HPP
+
+/**
+ * @file SignatureBase.hpp
+ *
+ * This module declares the functions which build the signature
+ * base of HTTP Message Signatures (RFC 9421).
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <functional>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <string_view>
+
+namespace MessageHeaders
+{
+    /**
+     * These are the parts of a message, outside of its headers,
+     * from which derived components (those whose names begin
+     * with "@") take their values.  Parts which are left empty
+     * can't be covered by a signature.
+     */
+    struct SignatureDerivedComponents {
+        /**
+         * This is the method of the request, such as "POST".
+         */
+        std::string_view method;
+
+        /**
+         * This is the full target URI of the request.
+         */
+        std::string_view targetUri;
+
+        /**
+         * This is the authority (host and optional port)
+         * of the target URI.
+         */
+        std::string_view authority;
+
+        /**
+         * This is the scheme of the target URI, such as "https".
+         */
+        std::string_view scheme;
+
+        /**
+         * This is the request target, as it appears
+         * in the request line.
+         */
+        std::string_view requestTarget;
+
+        /**
+         * This is the absolute path of the target URI.
+         */
+        std::string_view path;
+
+        /**
+         * This is the query of the target URI, including the
+         * leading question mark.  If it's left empty, the message
+         * is taken to have no query, which a signature may cover.
+         */
+        std::string_view query;
+
+        /**
+         * This is the three-digit status code of the response.
+         */
+        std::string_view status;
+    };
+
+    /**
+     * This is the type of function which receives the bytes of a
+     * signature base, in order, a piece at a time, usually to feed
+     * them to a hash or MAC.
+     */
+    typedef std::function< void(std::string_view piece) > SignatureBaseSink;
+
+    /**
+     * This function builds the signature base (RFC 9421 section 2.5)
+     * for the given signature parameters, and streams its exact bytes
+     * into the given sink, without building it in memory.
+     *
+     * Covered header fields are found by the hash of their names.
+     * The "sf", "key" and "bs" parameters of covered components are
+     * supported; "sf" normalizes the spacing between the members of
+     * a list or dictionary and between the items of inner lists, but
+     * otherwise passes the field on as it appears, rather than fully
+     * parsing and serializing it.  Query parameters are compared and
+     * passed on without percent-decoding.  The "req" and "tr"
+     * parameters are not supported.
+     *
+     * @param[in] headers
+     *     These are the headers of the message.
+     *
+     * @param[in] derivedComponents
+     *     These are the parts of the message from which
+     *     derived components take their values.
+     *
+     * @param[in] signatureParams
+     *     These are the signature parameters: the inner list of
+     *     covered components followed by its parameters, such as
+     *     ("@method" "content-type");created=1618884473;keyid="k1",
+     *     as found in the Signature-Input header.
+     *
+     * @param[in] sink
+     *     This is the function which receives the signature base.
+     *
+     * @return
+     *     An indication of whether or not the signature base could
+     *     be built is returned.  It can't if the signature parameters
+     *     are malformed or cover a component the message lacks.
+     *     In that case, whatever the sink received must be discarded.
+     */
+    bool BuildSignatureBase(
+        const MessageHeaders& headers,
+        const SignatureDerivedComponents& derivedComponents,
+        std::string_view signatureParams,
+        const SignatureBaseSink& sink
+    );
+
+} // namespace MessageHeaders
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef MESSAGE_HEADERS_STATIC_HEADERS_HPP
+#define MESSAGE_HEADERS_STATIC_HEADERS_HPP
+
+/**
+ * @file StaticHeaders.hpp
+ *
+ * This module declares the MessageHeaders::StaticHeaders class template
+ * and the MessageHeaders::StaticHeaderTable class, which hold constant
+ * header blocks parsed at compile time.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <array>
+#include <stddef.h>
+#include <stdexcept>
+#include <string_view>
+
+/**
+ * This parses the given raw header block, which must be a constant
+ * expression such as a string literal, at compile time.  Use it to
+ * initialize a constexpr variable:
+ *
+ *     constexpr auto SECURITY_HEADERS = MESSAGE_HEADERS_STATIC(
+ *         "X-Content-Type-Options: nosniff\r\n"
+ *         "X-Frame-Options: DENY\r\n"
+ *         "\r\n"
+ *     );
+ */
+#define MESSAGE_HEADERS_STATIC(rawHeaders) \
+    ::MessageHeaders::StaticHeaders< ::MessageHeaders::CountStaticHeaders(rawHeaders) >(rawHeaders)
+
+namespace MessageHeaders
+{
+    /**
+     * This represents a single header of a constant header block.
+     * Both parts refer to the raw header block.
+     */
+    struct StaticHeader {
+        /**
+         * This is the part of a header that comes before the colon.
+         */
+        std::string_view name;
+
+        /**
+         * This is the part of a header that comes after the colon,
+         * with the margin whitespace stripped.
+         */
+        std::string_view value;
+    };
+
+    /**
+     * This function recognizes the next header of a constant header block.
+     * It follows the same rules as HeaderParser, except that folded
+     * lines are not allowed, since the value of every header must
+     * be a single piece of the raw header block.
+     *
+     * When used in a constant expression, a bad header block
+     * is reported as a compile error.
+     *
+     * @param[in] rawHeaders
+     *     This is the raw header block, which must end with
+     *     the empty line that ends the headers, and nothing after it.
+     *
+     * @param[in,out] offset
+     *     This is the offset into the raw header block where the
+     *     next header begins.  It is advanced past the header.
+     *
+     * @param[out] header
+     *     This is where to store the header.
+     *
+     * @return
+     *     Whether or not there was another header is returned.
+     *
+     * @throws std::invalid_argument
+     *     This is thrown if the header block is bad.
+     */
+    constexpr bool NextStaticHeader(
+        std::string_view rawHeaders,
+        size_t& offset,
+        StaticHeader& header
+    ) {
+        const auto lineStart = offset;
+        const auto lineTerminator = rawHeaders.find("\r\n", lineStart);
+        if (lineTerminator == std::string_view::npos) {
+            throw std::invalid_argument("header block must end with an empty line");
+        }
+        if (lineTerminator == lineStart) {
+            if (lineTerminator + 2 != rawHeaders.length()) {
+                throw std::invalid_argument("nothing may follow the header block");
+            }
+            return false;
+        }
+
+        // Separate the header name from the header value.
+        const auto nameValueDelimiter = rawHeaders.find(':', lineStart);
+        if (nameValueDelimiter > lineTerminator) {
+            throw std::invalid_argument("header line must have a colon");
+        }
+        for (auto i = lineStart; i < nameValueDelimiter; ++i) {
+            if (
+                (rawHeaders[i] < 33)
+                || (rawHeaders[i] > 126)
+            ) {
+                throw std::invalid_argument("header name must be visible ASCII");
+            }
+        }
+
+        // Remove any whitespace that might be at the beginning
+        // or end of the header value.
+        auto valueStart = nameValueDelimiter + 1;
+        auto valueEnd = lineTerminator;
+        while (
+            (valueStart < valueEnd)
+            && ((rawHeaders[valueStart] == ' ') || (rawHeaders[valueStart] == '\t'))
+        ) {
+            ++valueStart;
+        }
+        while (
+            (valueEnd > valueStart)
+            && ((rawHeaders[valueEnd - 1] == ' ') || (rawHeaders[valueEnd - 1] == '\t'))
+        ) {
+            --valueEnd;
+        }
+
+        offset = lineTerminator + 2;
+        if (
+            (offset < rawHeaders.length())
+            && ((rawHeaders[offset] == ' ') || (rawHeaders[offset] == '\t'))
+        ) {
+            throw std::invalid_argument("folded header lines are not supported");
+        }
+        header.name = rawHeaders.substr(lineStart, nameValueDelimiter - lineStart);
+        header.value = rawHeaders.substr(valueStart, valueEnd - valueStart);
+        return true;
+    }
+
+    /**
+     * This function counts the headers of a constant header block.
+     *
+     * @param[in] rawHeaders
+     *     This is the raw header block, which must end with
+     *     the empty line that ends the headers, and nothing after it.
+     *
+     * @return
+     *     The number of headers in the block is returned.
+     *
+     * @throws std::invalid_argument
+     *     This is thrown if the header block is bad.
+     */
+    constexpr size_t CountStaticHeaders(std::string_view rawHeaders) {
+        size_t count = 0;
+        size_t offset = 0;
+        StaticHeader header;
+        while (NextStaticHeader(rawHeaders, offset, header)) {
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * This is a read-only view of a constant header block,
+     * whatever the number of headers in it.  It is what the rest
+     * of the library accepts in place of a StaticHeaders.
+     */
+    class StaticHeaderTable {
+        // Public Methods
+    public:
+        /**
+         * This constructs the view from the parts of a
+         * constant header block.
+         *
+         * @param[in] rawHeaders
+         *     This is the raw header block.
+         *
+         * @param[in] headers
+         *     These are the headers recognized in the block.
+         *
+         * @param[in] count
+         *     This is the number of headers recognized in the block.
+         */
+        constexpr StaticHeaderTable(
+            std::string_view rawHeaders,
+            const StaticHeader* headers,
+            size_t count
+        )
+            : rawHeaders_(rawHeaders)
+            , headers_(headers)
+            , count_(count)
+        {
+        }
+
+        /**
+         * This method returns the number of headers in the block.
+         *
+         * @return
+         *     The number of headers in the block is returned.
+         */
+        constexpr size_t size() const {
+            return count_;
+        }
+
+        /**
+         * This method returns the header at the given position.
+         *
+         * @param[in] index
+         *     This is the position of the header to return.
+         *
+         * @return
+         *     The header is returned.
+         */
+        constexpr const StaticHeader& operator[](size_t index) const {
+            return headers_[index];
+        }
+
+        /**
+         * These methods are used in range-for constructs.
+         */
+        constexpr const StaticHeader* begin() const {
+            return headers_;
+        }
+        constexpr const StaticHeader* end() const {
+            return headers_ + count_;
+        }
+
+        /**
+         * This method returns the raw header block.  Since it was
+         * checked when it was parsed, this is also its rendering.
+         *
+         * @return
+         *     The raw header block is returned.
+         */
+        constexpr std::string_view GenerateRawHeaders() const {
+            return rawHeaders_;
+        }
+
+        // Private properties
+    private:
+        /**
+         * This is the raw header block.
+         */
+        std::string_view rawHeaders_;
+
+        /**
+         * These are the headers recognized in the block.
+         */
+        const StaticHeader* headers_;
+
+        /**
+         * This is the number of headers recognized in the block.
+         */
+        size_t count_;
+    };
+
+    /**
+     * This holds a constant header block parsed at compile time.
+     * It is usually made with the MESSAGE_HEADERS_STATIC macro.
+     *
+     * @tparam N
+     *     This is the number of headers in the block.
+     */
+    template< size_t N > class StaticHeaders {
+        // Public Methods
+    public:
+        /**
+         * This constructs the object by parsing the given raw header
+         * block.  It's meant to run at compile time.
+         *
+         * @param[in] rawHeaders
+         *     This is the raw header block, which must end with
+         *     the empty line that ends the headers, and nothing after
+         *     it, and must hold exactly N headers.
+         *
+         * @throws std::invalid_argument
+         *     This is thrown if the header block is bad.
+         */
+        constexpr explicit StaticHeaders(std::string_view rawHeaders)
+            : rawHeaders_(rawHeaders)
+            , headers_()
+        {
+            size_t offset = 0;
+            for (size_t i = 0; i < N; ++i) {
+                if (!NextStaticHeader(rawHeaders, offset, headers_[i])) {
+                    throw std::invalid_argument("header block has too few headers");
+                }
+            }
+            StaticHeader extra;
+            if (NextStaticHeader(rawHeaders, offset, extra)) {
+                throw std::invalid_argument("header block has too many headers");
+            }
+        }
+
+        /**
+         * This method returns the number of headers in the block.
+         *
+         * @return
+         *     The number of headers in the block is returned.
+         */
+        constexpr size_t size() const {
+            return N;
+        }
+
+        /**
+         * This method returns the header at the given position.
+         *
+         * @param[in] index
+         *     This is the position of the header to return.
+         *
+         * @return
+         *     The header is returned.
+         */
+        constexpr const StaticHeader& operator[](size_t index) const {
+            return headers_[index];
+        }
+
+        /**
+         * These methods are used in range-for constructs.
+         */
+        constexpr const StaticHeader* begin() const {
+            return headers_.data();
+        }
+        constexpr const StaticHeader* end() const {
+            return headers_.data() + N;
+        }
+
+        /**
+         * This method returns the raw header block.  Since it was
+         * checked when it was parsed, this is also its rendering.
+         *
+         * @return
+         *     The raw header block is returned.
+         */
+        constexpr std::string_view GenerateRawHeaders() const {
+            return rawHeaders_;
+        }
+
+        /**
+         * This is the typecast operator to the view accepted
+         * by the rest of the library.
+         *
+         * @return
+         *     A view of the header block is returned.
+         */
+        constexpr operator StaticHeaderTable() const {
+            return StaticHeaderTable(rawHeaders_, headers_.data(), N);
+        }
+
+        // Private properties
+    private:
+        /**
+         * This is the raw header block.
+         */
+        std::string_view rawHeaders_;
+
+        /**
+         * These are the headers recognized in the block.
+         */
+        std::array< StaticHeader, N > headers_;
+    };
+
+} // namespace MessageHeaders
+
+#endif
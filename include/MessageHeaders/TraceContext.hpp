@@ -0,0 +1,419 @@
+#ifndef MESSAGE_HEADERS_TRACE_CONTEXT_HPP
+#define MESSAGE_HEADERS_TRACE_CONTEXT_HPP
+
+/**
+ * @file TraceContext.hpp
+ *
+ * This module declares the MessageHeaders::TraceContext class and
+ * related functions, which read and write the W3C Trace Context
+ * (traceparent, tracestate) and W3C Baggage (baggage) headers.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+namespace MessageHeaders
+{
+    /**
+     * This is the content of a traceparent header.
+     */
+    struct TraceParent {
+        /**
+         * This is the version of the header format.
+         */
+        uint8_t version = 0;
+
+        /**
+         * These are the upper and lower 64 bits of the trace ID.
+         */
+        uint64_t traceIdHigh = 0;
+        uint64_t traceIdLow = 0;
+
+        /**
+         * This is the ID of the caller's span (the parent-id).
+         */
+        uint64_t parentId = 0;
+
+        /**
+         * These are the trace flags.
+         */
+        uint8_t flags = 0;
+
+        /**
+         * This method determines whether or not the caller
+         * may have recorded the trace.
+         *
+         * @return
+         *     An indication of whether or not the sampled
+         *     flag is set is returned.
+         */
+        bool IsSampled() const {
+            return (flags & 0x01) != 0;
+        }
+    };
+
+    /**
+     * This function recognizes the value of a traceparent header.
+     * All fields are fixed-length lowercase hex, so they are read
+     * directly from their fixed positions.
+     *
+     * @param[in] value
+     *     This is the header value to recognize.
+     *
+     * @param[out] traceParent
+     *     This is where to store the content of the header.
+     *
+     * @return
+     *     An indication of whether or not the header value
+     *     is valid is returned.
+     */
+    bool ParseTraceParent(std::string_view value, TraceParent& traceParent);
+
+    /**
+     * This function renders the given traceparent header content
+     * and appends it to the given string.
+     *
+     * @param[in] traceParent
+     *     This is the content to render.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append the rendering.
+     */
+    void AppendTraceParent(const TraceParent& traceParent, std::string& output);
+
+    /**
+     * This is a view of a comma-separated list of key-value pairs,
+     * as found in tracestate and baggage headers.  Members are only
+     * recognized as the view is stepped through.  Everything returned
+     * refers to the list, which must outlive the view.
+     *
+     * A view of the headers with a given name covers every instance
+     * of the header, in order, as one combined list, which is how
+     * W3C says repeated tracestate and baggage headers are read.
+     * It's valid until the headers are next modified.
+     */
+    class TraceContextList {
+        // Public Methods
+    public:
+        /**
+         * This is a single member of the list.
+         */
+        struct Member {
+            /**
+             * This is the part of the member before the equals sign.
+             */
+            std::string_view key;
+
+            /**
+             * This is the part of the member after the equals sign,
+             * up to any properties.
+             */
+            std::string_view value;
+
+            /**
+             * These are any properties following the value, after
+             * the first semicolon (baggage only).
+             */
+            std::string_view properties;
+        };
+
+        /**
+         * This is used to step through the members of the list.
+         * Empty members are skipped.
+         */
+        class Iterator {
+            // Public Methods
+        public:
+            /**
+             * This constructs the iterator at the first member of
+             * the given remainder of a list.
+             *
+             * @param[in] rest
+             *     This is the part of the list not yet stepped through.
+             */
+            explicit Iterator(std::string_view rest);
+
+            /**
+             * This constructs the iterator at the first member of
+             * the given remainder of a list, carrying on through the
+             * values of the later headers with the given name.
+             *
+             * @param[in] headers
+             *     These are the headers holding the list.
+             *
+             * @param[in] name
+             *     This is the name of the headers holding the list.
+             *
+             * @param[in] index
+             *     This is the position of the header holding
+             *     the given remainder of the list.
+             *
+             * @param[in] rest
+             *     This is the part of the list not yet stepped through.
+             */
+            Iterator(
+                const MessageHeaders* headers,
+                std::string_view name,
+                size_t index,
+                std::string_view rest
+            );
+
+            /**
+             * This method returns the current member.
+             *
+             * @return
+             *     The current member is returned.
+             */
+            const Member& operator*() const;
+            const Member* operator->() const;
+
+            /**
+             * This method advances to the next member.
+             *
+             * @return
+             *     The iterator is returned.
+             */
+            Iterator& operator++();
+
+            /**
+             * These are the comparison operators for the class.
+             */
+            bool operator==(const Iterator& rhs) const;
+            bool operator!=(const Iterator& rhs) const;
+
+            // Private Methods
+        private:
+            /**
+             * This method recognizes the next non-empty member
+             * of the list, if there is one.
+             */
+            void Next();
+
+            // Private properties
+        private:
+            /**
+             * These are the headers holding the list, if it's
+             * spread over every header with a name.
+             */
+            const MessageHeaders* headers_ = nullptr;
+
+            /**
+             * This is the name of the headers holding the list.
+             */
+            std::string_view name_;
+
+            /**
+             * This is the position of the header holding
+             * the part of the list not yet stepped through.
+             */
+            size_t index_ = 0;
+
+            /**
+             * This is the part of the list not yet stepped through.
+             */
+            std::string_view rest_;
+
+            /**
+             * This is the current member.
+             */
+            Member member_;
+
+            /**
+             * This indicates whether or not the iterator
+             * is past the last member.
+             */
+            bool atEnd_ = false;
+        };
+
+        /**
+         * This constructs the view of the given list.
+         *
+         * @param[in] list
+         *     This is the value of a tracestate or baggage header.
+         */
+        explicit TraceContextList(std::string_view list = std::string_view());
+
+        /**
+         * This constructs the view of the list held by every header
+         * with the given name.
+         *
+         * @param[in] headers
+         *     These are the headers holding the list.
+         *
+         * @param[in] name
+         *     This is the name of the headers holding the list.
+         *     It must outlive the view.
+         *
+         * @param[in] startIndex
+         *     This is the position of the first header to look at.
+         */
+        TraceContextList(
+            const MessageHeaders& headers,
+            std::string_view name,
+            size_t startIndex = 0
+        );
+
+        /**
+         * These methods are used in range-for constructs.
+         */
+        Iterator begin() const;
+        Iterator end() const;
+
+        /**
+         * This method looks for the first member of the list
+         * with the given key.
+         *
+         * @param[in] key
+         *     This is the key of the member to look for.
+         *
+         * @param[out] value
+         *     This is where to store the value of the member.
+         *
+         * @return
+         *     An indication of whether or not the member
+         *     was found is returned.
+         */
+        bool Find(std::string_view key, std::string_view& value) const;
+
+        // Private properties
+    private:
+        /**
+         * These are the headers holding the list, if it's
+         * spread over every header with a name.
+         */
+        const MessageHeaders* headers_ = nullptr;
+
+        /**
+         * This is the name of the headers holding the list.
+         */
+        std::string_view name_;
+
+        /**
+         * This is the position of the first header holding the list.
+         */
+        size_t index_ = 0;
+
+        /**
+         * This is the list, or the value of the first
+         * header holding it.
+         */
+        std::string_view list_;
+    };
+
+    /**
+     * This is a view of the trace context headers of a message.
+     * The headers are located, in one pass over the message headers,
+     * when the view is made; each one is only recognized when asked
+     * for.  The view is valid until the headers are next modified.
+     *
+     * Only the first traceparent header is looked at.  Every
+     * tracestate or baggage header is looked at, as one combined
+     * list, however the headers were parsed or added.
+     */
+    class TraceContext {
+        // Public Methods
+    public:
+        /**
+         * This constructs the view of the trace context
+         * headers of the given message headers.
+         *
+         * @param[in] headers
+         *     These are the message headers.
+         */
+        explicit TraceContext(const MessageHeaders& headers);
+
+        /**
+         * This method recognizes the traceparent header.
+         *
+         * @param[out] traceParent
+         *     This is where to store the content of the header.
+         *
+         * @return
+         *     An indication of whether or not there is a valid
+         *     traceparent header is returned.
+         */
+        bool GetTraceParent(TraceParent& traceParent) const;
+
+        /**
+         * This method returns a view of the tracestate headers.
+         *
+         * @return
+         *     A view of the tracestate headers, which is empty
+         *     if there aren't any, is returned.
+         */
+        TraceContextList GetTraceState() const;
+
+        /**
+         * This method returns a view of the baggage headers.
+         *
+         * @return
+         *     A view of the baggage headers, which is empty
+         *     if there aren't any, is returned.
+         */
+        TraceContextList GetBaggage() const;
+
+        // Private properties
+    private:
+        /**
+         * These are the message headers.
+         */
+        const MessageHeaders* headers_;
+
+        /**
+         * This is the value of the traceparent header.
+         */
+        std::string_view traceParent_;
+
+        /**
+         * These are the positions of the first tracestate and
+         * baggage headers, or the number of headers if there
+         * aren't any.
+         */
+        size_t traceStateIndex_;
+        size_t baggageIndex_;
+    };
+
+    /**
+     * This function sets the traceparent header of the given message
+     * headers.  An existing header is overwritten in place; otherwise
+     * a new one is added.
+     *
+     * @param[in,out] headers
+     *     These are the message headers.
+     *
+     * @param[in] traceParent
+     *     This is the content of the header to set.
+     */
+    void SetTraceParent(MessageHeaders& headers, const TraceParent& traceParent);
+
+    /**
+     * This function rewrites, in place, the parent-id and sampled flag
+     * of the traceparent header of the given message headers, for
+     * forwarding the trace context on to the next hop.  A header
+     * of a later version than 00 is rewritten as version 00.
+     *
+     * @param[in,out] headers
+     *     These are the message headers.
+     *
+     * @param[in] parentId
+     *     This is the ID of the span making the next call.
+     *
+     * @param[in] sampled
+     *     This indicates whether or not the span making the
+     *     next call may be recorded.
+     *
+     * @return
+     *     An indication of whether or not there was a valid
+     *     traceparent header to rewrite is returned.
+     */
+    bool ForwardTraceParent(MessageHeaders& headers, uint64_t parentId, bool sampled);
+
+} // namespace MessageHeaders
+
+#endif
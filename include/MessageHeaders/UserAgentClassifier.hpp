@@ -0,0 +1,185 @@
+#ifndef MESSAGE_HEADERS_USER_AGENT_CLASSIFIER_HPP
+#define MESSAGE_HEADERS_USER_AGENT_CLASSIFIER_HPP
+
+/**
+ * @file UserAgentClassifier.hpp
+ *
+ * This module declares the MessageHeaders::UserAgentClassifier class.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <memory>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+namespace MessageHeaders
+{
+    /**
+     * These are the browsers told apart by UserAgentClassifier.
+     */
+    enum class UserAgentBrowser : uint8_t {
+        Unknown,
+        Chrome,
+        Edge,
+        Firefox,
+        InternetExplorer,
+        Opera,
+        Safari,
+    };
+
+    /**
+     * These are the operating systems told apart by UserAgentClassifier.
+     */
+    enum class UserAgentOs : uint8_t {
+        Unknown,
+        Android,
+        ChromeOs,
+        Ios,
+        Linux,
+        MacOs,
+        Windows,
+    };
+
+    /**
+     * These are the kinds of device told apart by UserAgentClassifier.
+     */
+    enum class UserAgentDevice : uint8_t {
+        Unknown,
+        Desktop,
+        Mobile,
+        Tablet,
+    };
+
+    /**
+     * This is what UserAgentClassifier makes of a User-Agent header.
+     */
+    struct UserAgentClass {
+        /**
+         * This is the browser making the request.
+         */
+        UserAgentBrowser browser = UserAgentBrowser::Unknown;
+
+        /**
+         * This is the operating system on which the browser runs.
+         */
+        UserAgentOs os = UserAgentOs::Unknown;
+
+        /**
+         * This is the kind of device on which the browser runs.
+         */
+        UserAgentDevice device = UserAgentDevice::Unknown;
+
+        /**
+         * This indicates whether or not the request was made by a
+         * crawler or other automated client, rather than a person.
+         */
+        bool isBot = false;
+    };
+
+    /**
+     * This classifies the User-Agent headers of requests by browser,
+     * operating system, device, and whether or not they come from bots.
+     *
+     * Since most traffic carries one of a few User-Agent values, the
+     * results are kept in a least-recently-used cache keyed by the hash
+     * of the value, split into shards, each with its own lock, so that
+     * many threads may classify at once.  On a miss, the value is
+     * scanned once by a matcher which finds every known token in it
+     * at the same time (Aho-Corasick, ignoring case), and a few checks
+     * of where the tokens were found settle the result.
+     */
+    class UserAgentClassifier {
+        // Lifecycle Management
+    public:
+        ~UserAgentClassifier();
+        UserAgentClassifier(const UserAgentClassifier&) = delete;
+        UserAgentClassifier(UserAgentClassifier&&);
+        UserAgentClassifier& operator=(const UserAgentClassifier&) = delete;
+        UserAgentClassifier& operator=(UserAgentClassifier&&);
+
+        // Public Methods
+    public:
+        /**
+         * This constructs the classifier.
+         *
+         * @param[in] cacheCapacity
+         *     This is the largest number of User-Agent values whose
+         *     results are kept, or zero to keep none.
+         */
+        explicit UserAgentClassifier(size_t cacheCapacity = 4096);
+
+        /**
+         * This method classifies the User-Agent header of the given
+         * request.  A request without one is classified as unknown.
+         *
+         * @param[in] requestHeaders
+         *     These are the headers of the request.
+         *
+         * @return
+         *     What was made of the User-Agent header is returned.
+         */
+        UserAgentClass Classify(const MessageHeaders& requestHeaders);
+
+        /**
+         * This method classifies the given User-Agent header value.
+         *
+         * @param[in] userAgent
+         *     This is the User-Agent header value to classify.
+         *
+         * @return
+         *     What was made of the User-Agent header is returned.
+         */
+        UserAgentClass Classify(std::string_view userAgent);
+
+        /**
+         * This method returns the number of times a result
+         * was found in the cache.
+         *
+         * @return
+         *     The number of cache hits is returned.
+         */
+        size_t GetCacheHitCount() const;
+
+        /**
+         * This method returns the number of times a User-Agent
+         * value had to be scanned.
+         *
+         * @return
+         *     The number of cache misses is returned.
+         */
+        size_t GetCacheMissCount() const;
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< struct Impl > impl_;
+    };
+
+    /**
+     * This function classifies the given User-Agent header value
+     * without caching the result.
+     *
+     * @param[in] userAgent
+     *     This is the User-Agent header value to classify.
+     *
+     * @return
+     *     What was made of the User-Agent header is returned.
+     */
+    UserAgentClass ClassifyUserAgent(std::string_view userAgent);
+
+} // namespace MessageHeaders
+
+#endif
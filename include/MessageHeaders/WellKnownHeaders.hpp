@@ -0,0 +1,186 @@
+#ifndef MESSAGE_HEADERS_WELL_KNOWN_HEADERS_HPP
+#define MESSAGE_HEADERS_WELL_KNOWN_HEADERS_HPP
+
+/**
+ * @file WellKnownHeaders.hpp
+ *
+ * This module declares the table of well-known header names.
+ *
+ * 2019 by YaMing Wu
+ *
+ */
+
+#include <MessageHeaders/DuplicatePolicy.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+namespace MessageHeaders
+{
+    /**
+     * These identify the header names the library knows about.
+     */
+    enum class WellKnownHeader : uint8_t {
+        Unknown,
+        Accept,
+        AcceptCharset,
+        AcceptEncoding,
+        AcceptLanguage,
+        AcceptRanges,
+        AccessControlAllowOrigin,
+        Age,
+        Allow,
+        Authorization,
+        Baggage,
+        CacheControl,
+        Cc,
+        Connection,
+        ContentDisposition,
+        ContentEncoding,
+        ContentLanguage,
+        ContentLength,
+        ContentLocation,
+        ContentRange,
+        ContentType,
+        Cookie,
+        Date,
+        ETag,
+        Expect,
+        Expires,
+        Forwarded,
+        From,
+        Host,
+        IfMatch,
+        IfModifiedSince,
+        IfNoneMatch,
+        IfRange,
+        IfUnmodifiedSince,
+        LastModified,
+        Link,
+        Location,
+        MaxForwards,
+        MessageId,
+        MimeVersion,
+        Origin,
+        Pragma,
+        ProxyAuthenticate,
+        ProxyAuthorization,
+        Range,
+        Received,
+        Referer,
+        ReplyTo,
+        RetryAfter,
+        Server,
+        SetCookie,
+        Subject,
+        Te,
+        To,
+        Traceparent,
+        Tracestate,
+        Trailer,
+        TransferEncoding,
+        Upgrade,
+        UserAgent,
+        Vary,
+        Via,
+        Warning,
+        WwwAuthenticate,
+        XForwardedFor,
+        XForwardedProto,
+        XRequestId,
+        Count
+    };
+
+    /**
+     * This is the number of entries in the well-known header table,
+     * including WellKnownHeader::Unknown.
+     */
+    constexpr size_t WELL_KNOWN_HEADER_COUNT = (size_t)WellKnownHeader::Count;
+
+    /**
+     * This is what the library knows about a well-known header name.
+     */
+    struct WellKnownHeaderInfo {
+        /**
+         * This is the usual spelling of the header name.
+         */
+        std::string_view name;
+
+        /**
+         * This is how repeated instances of the header are dealt
+         * with when default duplicate policies are in use
+         * (see MessageHeaders::UseDefaultDuplicatePolicies).
+         */
+        DuplicatePolicy duplicatePolicy;
+    };
+
+    /**
+     * This function computes a hash of the given header name which
+     * doesn't depend on the case of the letters in the name.
+     *
+     * @param[in] name
+     *     This is the header name to hash.
+     *
+     * @return
+     *     The hash of the header name is returned.
+     */
+    constexpr uint64_t HashHeaderName(std::string_view name) noexcept {
+        uint64_t hash = 14695981039346656037ULL;
+        for (auto c : name) {
+            if ((c >= 'A') && (c <= 'Z')) {
+                c += 'a' - 'A';
+            }
+            hash ^= (unsigned char)c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    /**
+     * This function looks up the given header name (case-insensitive)
+     * in the well-known header table.
+     *
+     * @param[in] name
+     *     This is the header name to look up.
+     *
+     * @return
+     *     The identifier of the header name is returned.
+     *
+     * @retval WellKnownHeader::Unknown
+     *     This is returned if the header name is not well known.
+     */
+    WellKnownHeader FindWellKnownHeader(std::string_view name) noexcept;
+
+    /**
+     * This function looks up the given header name (case-insensitive)
+     * in the well-known header table, when its hash is already known.
+     *
+     * @param[in] name
+     *     This is the header name to look up.
+     *
+     * @param[in] hash
+     *     This is the hash of the header name, from HashHeaderName.
+     *
+     * @return
+     *     The identifier of the header name is returned.
+     *
+     * @retval WellKnownHeader::Unknown
+     *     This is returned if the header name is not well known.
+     */
+    WellKnownHeader FindWellKnownHeader(std::string_view name, uint64_t hash) noexcept;
+
+    /**
+     * This function returns what the library knows about the
+     * given well-known header.
+     *
+     * @param[in] header
+     *     This identifies the well-known header.
+     *
+     * @return
+     *     The entry of the well-known header table is returned.
+     */
+    const WellKnownHeaderInfo& GetWellKnownHeaderInfo(WellKnownHeader header) noexcept;
+
+} // namespace MessageHeaders
+
+#endif
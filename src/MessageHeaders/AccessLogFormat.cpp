@@ -0,0 +1,320 @@
+/**
+ * @file AccessLogFormat.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::AccessLogFormat class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <MessageHeaders/AccessLogFormat.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+
+namespace {
+    /**
+     * This is the prefix of variables naming request headers.
+     */
+    constexpr std::string_view REQUEST_HEADER_PREFIX = "http_";
+
+    /**
+     * This is the prefix of variables naming response headers.
+     */
+    constexpr std::string_view RESPONSE_HEADER_PREFIX = "sent_http_";
+
+    /**
+     * This is written in place of a missing value.
+     */
+    constexpr std::string_view MISSING = "-";
+
+    /**
+     * These are the digits used to write characters in hexadecimal.
+     */
+    constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    /**
+     * This function determines whether or not the given character
+     * may appear in the name of a variable.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character may appear
+     *     in the name of a variable is returned.
+     */
+    bool IsVariableCharacter(char c) {
+        return (
+            ((c >= 'a') && (c <= 'z'))
+            || ((c >= 'A') && (c <= 'Z'))
+            || ((c >= '0') && (c <= '9'))
+            || (c == '_')
+        );
+    }
+
+    /**
+     * This function determines whether or not the given character
+     * must be escaped in the given way.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @param[in] escaping
+     *     This is how values are escaped.
+     *
+     * @return
+     *     An indication of whether or not the character
+     *     must be escaped is returned.
+     */
+    bool NeedsEscape(char c, MessageHeaders::AccessLogEscaping escaping) {
+        const auto u = (unsigned char)c;
+        switch (escaping) {
+            case MessageHeaders::AccessLogEscaping::Default: {
+                return (u < 0x20) || (u > 0x7E) || (c == '"') || (c == '\\');
+            }
+
+            case MessageHeaders::AccessLogEscaping::Json: {
+                return (u < 0x20) || (c == '"') || (c == '\\');
+            }
+
+            default: return false;
+        }
+    }
+
+    /**
+     * This function appends the escaped form of the given character,
+     * which needs escaping, to the given string.
+     *
+     * @param[in] c
+     *     This is the character to escape.
+     *
+     * @param[in] escaping
+     *     This is how values are escaped.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append the escaped character.
+     */
+    void AppendEscape(char c, MessageHeaders::AccessLogEscaping escaping, std::string& output) {
+        const auto u = (unsigned char)c;
+        if (escaping == MessageHeaders::AccessLogEscaping::Json) {
+            switch (c) {
+                case '"': output += "\\\""; return;
+                case '\\': output += "\\\\"; return;
+                case '\n': output += "\\n"; return;
+                case '\r': output += "\\r"; return;
+                case '\t': output += "\\t"; return;
+                default: break;
+            }
+            output += "\\u00";
+        } else {
+            output += "\\x";
+        }
+        output += HEX_DIGITS[u >> 4];
+        output += HEX_DIGITS[u & 0x0F];
+    }
+
+    /**
+     * This function appends the given value to the given string,
+     * escaping it in the given way.  Runs of characters which
+     * don't need escaping are copied all at once.
+     *
+     * @param[in] value
+     *     This is the value to append.
+     *
+     * @param[in] escaping
+     *     This is how values are escaped.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append the value.
+     */
+    void AppendEscaped(
+        std::string_view value,
+        MessageHeaders::AccessLogEscaping escaping,
+        std::string& output
+    ) {
+        size_t runStart = 0;
+        for (size_t i = 0; i < value.length(); ++i) {
+            if (NeedsEscape(value[i], escaping)) {
+                output.append(value.data() + runStart, i - runStart);
+                AppendEscape(value[i], escaping, output);
+                runStart = i + 1;
+            }
+        }
+        output.append(value.data() + runStart, value.length() - runStart);
+    }
+
+    /**
+     * This function appends the values of the headers with the given
+     * name, joined with commas, to the given string, escaping them in
+     * the given way.  If there are no such headers, "-" is appended.
+     *
+     * @param[in] headers
+     *     These are the message headers.
+     *
+     * @param[in] name
+     *     This is the name of the headers.
+     *
+     * @param[in] nameHash
+     *     This is the hash of the name of the headers.
+     *
+     * @param[in] escaping
+     *     This is how values are escaped.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append the values.
+     */
+    void AppendHeader(
+        const MessageHeaders::MessageHeaders& headers,
+        const std::string& name,
+        uint64_t nameHash,
+        MessageHeaders::AccessLogEscaping escaping,
+        std::string& output
+    ) {
+        bool found = false;
+        const auto count = headers.GetHeaderCount();
+        for (size_t index = 0; index < count; ++index) {
+            const auto& header = headers.GetHeader(index);
+            if (
+                (header.name.GetHash() != nameHash)
+                || !MessageHeaders::HeaderNamesEqual(static_cast< const std::string& >(header.name), name)
+            ) {
+                continue;
+            }
+            if (found) {
+                output += ',';
+            }
+            AppendEscaped(header.value, escaping, output);
+            found = true;
+        }
+        if (!found) {
+            output += MISSING;
+        }
+    }
+}
+
+namespace MessageHeaders {
+    AccessLogFormat::AccessLogFormat(
+        std::string_view format,
+        AccessLogEscaping escaping
+    )
+        : escaping_(escaping)
+    {
+        std::string literal;
+        size_t i = 0;
+        while (i < format.length()) {
+            // Pick out the name of the variable, if any, at this point.
+            std::string_view name;
+            size_t next = i + 1;
+            if (format[i] == '$') {
+                if (
+                    (next < format.length())
+                    && (format[next] == '{')
+                ) {
+                    const auto closingBrace = format.find('}', next);
+                    if (closingBrace != std::string_view::npos) {
+                        name = format.substr(next + 1, closingBrace - next - 1);
+                        next = closingBrace + 1;
+                    }
+                } else {
+                    while (
+                        (next < format.length())
+                        && IsVariableCharacter(format[next])
+                    ) {
+                        ++next;
+                    }
+                    name = format.substr(i + 1, next - i - 1);
+                }
+            }
+            if (name.empty()) {
+                literal += format[i++];
+                continue;
+            }
+            i = next;
+
+            // Turn the variable into a step of rendering.
+            if (!literal.empty()) {
+                Operation operation;
+                operation.kind = Operation::Kind::Literal;
+                operation.text = std::move(literal);
+                operations_.push_back(std::move(operation));
+                literal.clear();
+            }
+            Operation operation;
+            if (name.substr(0, RESPONSE_HEADER_PREFIX.length()) == RESPONSE_HEADER_PREFIX) {
+                operation.kind = Operation::Kind::ResponseHeader;
+                name.remove_prefix(RESPONSE_HEADER_PREFIX.length());
+            } else if (name.substr(0, REQUEST_HEADER_PREFIX.length()) == REQUEST_HEADER_PREFIX) {
+                operation.kind = Operation::Kind::RequestHeader;
+                name.remove_prefix(REQUEST_HEADER_PREFIX.length());
+            } else {
+                operation.kind = Operation::Kind::Variable;
+                const auto variable = std::find(variables_.begin(), variables_.end(), name);
+                operation.variable = (size_t)(variable - variables_.begin());
+                if (variable == variables_.end()) {
+                    variables_.emplace_back(name);
+                }
+                operations_.push_back(std::move(operation));
+                continue;
+            }
+            operation.text.assign(name.data(), name.length());
+            std::replace(operation.text.begin(), operation.text.end(), '_', '-');
+            operation.nameHash = HashHeaderName(operation.text);
+            operations_.push_back(std::move(operation));
+        }
+        if (!literal.empty()) {
+            Operation operation;
+            operation.kind = Operation::Kind::Literal;
+            operation.text = std::move(literal);
+            operations_.push_back(std::move(operation));
+        }
+    }
+
+    const std::vector< std::string >& AccessLogFormat::GetVariables() const {
+        return variables_;
+    }
+
+    void AccessLogFormat::Render(
+        const MessageHeaders& request,
+        const MessageHeaders& response,
+        const std::vector< std::string_view >& variables,
+        std::string& output
+    ) const {
+        output.clear();
+        for (const auto& operation : operations_) {
+            switch (operation.kind) {
+                case Operation::Kind::Literal: {
+                    output += operation.text;
+                } break;
+
+                case Operation::Kind::RequestHeader: {
+                    AppendHeader(request, operation.text, operation.nameHash, escaping_, output);
+                } break;
+
+                case Operation::Kind::ResponseHeader: {
+                    AppendHeader(response, operation.text, operation.nameHash, escaping_, output);
+                } break;
+
+                case Operation::Kind::Variable: {
+                    if (
+                        (operation.variable < variables.size())
+                        && !variables[operation.variable].empty()
+                    ) {
+                        AppendEscaped(variables[operation.variable], escaping_, output);
+                    } else {
+                        output += MISSING;
+                    }
+                } break;
+
+                default: break;
+            }
+        }
+    }
+
+    void AccessLogFormat::Render(
+        const MessageHeaders& request,
+        const MessageHeaders& response,
+        std::string& output
+    ) const {
+        Render(request, response, {}, output);
+    }
+}
@@ -0,0 +1,240 @@
+/**
+ * @file CanonicalHeaders.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::CanonicalHeaders class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <MessageHeaders/CanonicalHeaders.hpp>
+#include <stddef.h>
+#include <string>
+
+namespace {
+    /**
+     * This is the size of the scratch buffer used to lowercase
+     * header names on their way to the sink.
+     */
+    constexpr size_t SCRATCH_SIZE = 64;
+
+    /**
+     * This is the largest number of headers put in order with
+     * insertion sort, which beats the general sort for the few
+     * headers most requests carry.
+     */
+    constexpr size_t INSERTION_SORT_LIMIT = 16;
+
+    /**
+     * This function returns the lowercase form of the given character.
+     *
+     * @param[in] c
+     *     This is the character to convert.
+     *
+     * @return
+     *     The lowercase form of the character is returned.
+     */
+    char ToLower(char c) {
+        return ((c >= 'A') && (c <= 'Z')) ? (char)(c + ('a' - 'A')) : c;
+    }
+
+    /**
+     * This function determines whether or not one header name comes
+     * before another, comparing their lowercase forms.
+     *
+     * @param[in] lhs
+     *     This is the first header name.
+     *
+     * @param[in] rhs
+     *     This is the second header name.
+     *
+     * @return
+     *     An indication of whether or not the first header name
+     *     comes before the second is returned.
+     */
+    bool NameBefore(std::string_view lhs, std::string_view rhs) {
+        const auto length = std::min(lhs.length(), rhs.length());
+        for (size_t i = 0; i < length; ++i) {
+            const auto l = (unsigned char)ToLower(lhs[i]);
+            const auto r = (unsigned char)ToLower(rhs[i]);
+            if (l != r) {
+                return l < r;
+            }
+        }
+        return lhs.length() < rhs.length();
+    }
+
+    /**
+     * This function streams the given header name in lowercase.
+     *
+     * @param[in] name
+     *     This is the header name to stream.
+     *
+     * @param[in] sink
+     *     This is the function which receives the name.
+     */
+    void EmitLowercase(std::string_view name, const MessageHeaders::CanonicalHeaders::Sink& sink) {
+        char scratch[SCRATCH_SIZE];
+        while (!name.empty()) {
+            const auto length = std::min(name.length(), SCRATCH_SIZE);
+            for (size_t i = 0; i < length; ++i) {
+                scratch[i] = ToLower(name[i]);
+            }
+            sink(std::string_view(scratch, length));
+            name.remove_prefix(length);
+        }
+    }
+
+    /**
+     * This function streams the given header value with whitespace
+     * at either end removed and runs of spaces reduced to one space.
+     *
+     * @param[in] value
+     *     This is the header value to stream.
+     *
+     * @param[in] sink
+     *     This is the function which receives the value.
+     */
+    void EmitTrimmed(std::string_view value, const MessageHeaders::CanonicalHeaders::Sink& sink) {
+        size_t runStart = 0;
+        bool inSpaces = true;
+        bool emitted = false;
+        for (size_t i = 0; i <= value.length(); ++i) {
+            const bool isSpace = (
+                (i < value.length())
+                && ((value[i] == ' ') || (value[i] == '\t'))
+            );
+            if (isSpace || (i == value.length())) {
+                if (!inSpaces) {
+                    if (emitted) {
+                        sink(" ");
+                    }
+                    sink(value.substr(runStart, i - runStart));
+                    emitted = true;
+                    inSpaces = true;
+                }
+            } else if (inSpaces) {
+                runStart = i;
+                inSpaces = false;
+            }
+        }
+    }
+}
+
+namespace MessageHeaders {
+    CanonicalHeaders::CanonicalHeaders(const MessageHeaders& headers)
+        : headers_(headers)
+    {
+        const auto count = headers.GetHeaderCount();
+        order_.reserve(count);
+        for (size_t index = 0; index < count; ++index) {
+            order_.push_back((uint32_t)index);
+        }
+        Sort();
+    }
+
+    CanonicalHeaders::CanonicalHeaders(
+        const MessageHeaders& headers,
+        std::string_view signedHeaders
+    )
+        : headers_(headers)
+    {
+        const auto count = headers.GetHeaderCount();
+        while (!signedHeaders.empty()) {
+            const auto delimiter = signedHeaders.find(';');
+            const auto name = signedHeaders.substr(0, delimiter);
+            signedHeaders = (
+                (delimiter == std::string_view::npos)
+                ? std::string_view()
+                : signedHeaders.substr(delimiter + 1)
+            );
+            if (name.empty()) {
+                continue;
+            }
+            auto index = headers.FindHeader(name);
+            if (index == count) {
+                isValid_ = false;
+            }
+            for (; index < count; index = headers.FindHeader(name, index + 1)) {
+                order_.push_back((uint32_t)index);
+            }
+        }
+        Sort();
+
+        // A name listed twice would cover its headers twice.
+        order_.erase(std::unique(order_.begin(), order_.end()), order_.end());
+    }
+
+    bool CanonicalHeaders::IsValid() const {
+        return isValid_;
+    }
+
+    void CanonicalHeaders::Emit(const Sink& sink) const {
+        for (size_t i = 0; i < order_.size(); ++i) {
+            const auto& header = headers_.GetHeader(order_[i]);
+            const auto sameAsPrevious = (
+                (i > 0)
+                && (headers_.GetHeader(order_[i - 1]).name == header.name)
+            );
+            if (sameAsPrevious) {
+                sink(",");
+            } else {
+                if (i > 0) {
+                    sink("\n");
+                }
+                EmitLowercase(static_cast< const std::string& >(header.name), sink);
+                sink(":");
+            }
+            EmitTrimmed(header.value, sink);
+        }
+        if (!order_.empty()) {
+            sink("\n");
+        }
+    }
+
+    void CanonicalHeaders::EmitSignedHeaders(const Sink& sink) const {
+        for (size_t i = 0; i < order_.size(); ++i) {
+            const auto& name = headers_.GetHeader(order_[i]).name;
+            if (i > 0) {
+                if (headers_.GetHeader(order_[i - 1]).name == name) {
+                    continue;
+                }
+                sink(";");
+            }
+            EmitLowercase(static_cast< const std::string& >(name), sink);
+        }
+    }
+
+    void CanonicalHeaders::Sort() {
+        // Headers sharing a name stay in the order they appear, so
+        // their positions break ties between equal names.
+        const auto before = [this](uint32_t lhs, uint32_t rhs) {
+            const std::string& lhsName = headers_.GetHeader(lhs).name;
+            const std::string& rhsName = headers_.GetHeader(rhs).name;
+            if (NameBefore(lhsName, rhsName)) {
+                return true;
+            }
+            if (NameBefore(rhsName, lhsName)) {
+                return false;
+            }
+            return lhs < rhs;
+        };
+        if (order_.size() <= INSERTION_SORT_LIMIT) {
+            for (size_t i = 1; i < order_.size(); ++i) {
+                const auto index = order_[i];
+                auto j = i;
+                while (
+                    (j > 0)
+                    && before(index, order_[j - 1])
+                ) {
+                    order_[j] = order_[j - 1];
+                    --j;
+                }
+                order_[j] = index;
+            }
+        } else {
+            std::sort(order_.begin(), order_.end(), before);
+        }
+    }
+}
@@ -0,0 +1,619 @@
+/**
+ * @file CookieJar.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::CookieJar class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <MessageHeaders/CookieJar.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace {
+    /**
+     * This is the expiry time given to cookies which last
+     * until the end of the session.
+     */
+    constexpr int64_t SESSION_EXPIRY = INT64_MAX;
+
+    /**
+     * This marks a cookie which isn't in the expiry heap.
+     */
+    constexpr size_t NOT_IN_HEAP = SIZE_MAX;
+
+    struct DomainNode;
+
+    /**
+     * This is a cookie held in the jar.
+     */
+    struct StoredCookie {
+        /**
+         * This is the name of the cookie.
+         */
+        std::string name;
+
+        /**
+         * This is the value of the cookie.
+         */
+        std::string value;
+
+        /**
+         * This is when the cookie expires, in seconds since
+         * the UNIX epoch, or SESSION_EXPIRY if it doesn't.
+         */
+        int64_t expiry = SESSION_EXPIRY;
+
+        /**
+         * This orders the cookies by when they were first stored.
+         */
+        uint64_t creation = 0;
+
+        /**
+         * This is the node holding the cookie.
+         */
+        DomainNode* node = nullptr;
+
+        /**
+         * This is the path of the cookie, which is the key under
+         * which the node holds it.
+         */
+        const std::string* path = nullptr;
+
+        /**
+         * This is the position of the cookie in the expiry heap,
+         * or NOT_IN_HEAP if it doesn't expire.
+         */
+        size_t heapIndex = NOT_IN_HEAP;
+
+        /**
+         * This indicates whether or not the cookie is only sent
+         * to the host which set it, rather than its subdomains too.
+         */
+        bool hostOnly = true;
+
+        /**
+         * This indicates whether or not the cookie is only
+         * sent over secure channels.
+         */
+        bool secure = false;
+    };
+
+    /**
+     * This is a node of the tree of domain labels.  It holds the
+     * cookies whose domain is the one spelled by the labels on the way
+     * from the root of the tree down to the node, grouped by path.
+     */
+    struct DomainNode {
+        /**
+         * This is the node for the parent domain, or
+         * nullptr if this is the root of the tree.
+         */
+        DomainNode* parent = nullptr;
+
+        /**
+         * This is the label under which the parent holds the node.
+         */
+        std::string_view label;
+
+        /**
+         * These are the nodes for subdomains, by their leftmost label.
+         */
+        std::map< std::string, std::unique_ptr< DomainNode >, std::less<> > subdomains;
+
+        /**
+         * These are the cookies of the domain, by path.
+         */
+        std::map< std::string, std::vector< std::unique_ptr< StoredCookie > >, std::less<> > paths;
+    };
+
+    /**
+     * This function returns a lowercase copy of the given text.
+     *
+     * @param[in] s
+     *     This is the text to copy.
+     *
+     * @return
+     *     The lowercase copy is returned.
+     */
+    std::string ToLower(std::string_view s) {
+        std::string lower(s);
+        for (auto& c: lower) {
+            if ((c >= 'A') && (c <= 'Z')) {
+                c += 'a' - 'A';
+            }
+        }
+        return lower;
+    }
+
+    /**
+     * This function determines whether or not the given host
+     * is within the given domain (RFC 6265 section 5.1.3).
+     * Both must already be lowercase.
+     *
+     * @param[in] host
+     *     This is the host to check.
+     *
+     * @param[in] domain
+     *     This is the domain to check.
+     *
+     * @return
+     *     An indication of whether or not the host is within
+     *     the domain is returned.
+     */
+    bool DomainMatches(std::string_view host, std::string_view domain) {
+        if (host == domain) {
+            return true;
+        }
+        return (
+            (host.length() > domain.length())
+            && (host.substr(host.length() - domain.length()) == domain)
+            && (host[host.length() - domain.length() - 1] == '.')
+        );
+    }
+
+    /**
+     * This function returns the path a cookie is given when it
+     * doesn't have a Path attribute (RFC 6265 section 5.1.4).
+     *
+     * @param[in] requestPath
+     *     This is the path of the request which set the cookie.
+     *
+     * @return
+     *     The default path of the cookie is returned.
+     */
+    std::string_view DefaultPath(std::string_view requestPath) {
+        if (
+            requestPath.empty()
+            || (requestPath[0] != '/')
+        ) {
+            return "/";
+        }
+        const auto lastSlash = requestPath.rfind('/');
+        if (lastSlash == 0) {
+            return "/";
+        }
+        return requestPath.substr(0, lastSlash);
+    }
+}
+
+namespace MessageHeaders {
+    /**
+     * This contains the private properties of a CookieJar instance.
+     */
+    struct CookieJar::Impl {
+        /**
+         * This is the root of the tree of domain labels.
+         */
+        DomainNode root;
+
+        /**
+         * These are the cookies which expire, in a heap with the
+         * soonest expiry on top.  Each cookie knows its place in the
+         * heap, so that it can be moved or taken out when it's
+         * replaced or removed.
+         */
+        std::vector< StoredCookie* > expiryHeap;
+
+        /**
+         * This is the number of cookies held.
+         */
+        size_t cookieCount = 0;
+
+        /**
+         * This is the creation order to give the next cookie stored.
+         */
+        uint64_t nextCreation = 1;
+
+        /**
+         * This method finds the node of the tree for the given domain.
+         *
+         * @param[in] domain
+         *     This is the domain whose node should be found.
+         *     It must be lowercase.
+         *
+         * @param[in] create
+         *     This indicates whether or not to make any missing nodes.
+         *
+         * @return
+         *     The node for the domain is returned.
+         *
+         * @retval nullptr
+         *     This is returned if the node doesn't exist and
+         *     create is false.
+         */
+        DomainNode* FindNode(std::string_view domain, bool create) {
+            auto node = &root;
+            auto labelEnd = domain.length();
+            while (labelEnd > 0) {
+                const auto dot = domain.rfind('.', labelEnd - 1);
+                const auto labelStart = (dot == std::string_view::npos) ? 0 : (dot + 1);
+                const auto label = domain.substr(labelStart, labelEnd - labelStart);
+                auto subdomain = node->subdomains.find(label);
+                if (subdomain == node->subdomains.end()) {
+                    if (!create) {
+                        return nullptr;
+                    }
+                    subdomain = node->subdomains.emplace(
+                        std::string(label),
+                        std::make_unique< DomainNode >()
+                    ).first;
+                    subdomain->second->parent = node;
+                    subdomain->second->label = subdomain->first;
+                }
+                node = subdomain->second.get();
+                labelEnd = (dot == std::string_view::npos) ? 0 : dot;
+            }
+            return node;
+        }
+
+        /**
+         * This method swaps two cookies of the expiry heap.
+         *
+         * @param[in] i
+         *     This is the position of one cookie.
+         *
+         * @param[in] j
+         *     This is the position of the other cookie.
+         */
+        void SwapInHeap(size_t i, size_t j) {
+            std::swap(expiryHeap[i], expiryHeap[j]);
+            expiryHeap[i]->heapIndex = i;
+            expiryHeap[j]->heapIndex = j;
+        }
+
+        /**
+         * This method moves the cookie at the given position of the
+         * expiry heap up or down to where its expiry belongs.
+         *
+         * @param[in] index
+         *     This is the position of the cookie.
+         */
+        void PlaceInHeap(size_t index) {
+            while (
+                (index > 0)
+                && (expiryHeap[index]->expiry < expiryHeap[(index - 1) / 2]->expiry)
+            ) {
+                SwapInHeap(index, (index - 1) / 2);
+                index = (index - 1) / 2;
+            }
+            for (;;) {
+                auto soonest = index;
+                for (auto child = 2 * index + 1; child <= 2 * index + 2; ++child) {
+                    if (
+                        (child < expiryHeap.size())
+                        && (expiryHeap[child]->expiry < expiryHeap[soonest]->expiry)
+                    ) {
+                        soonest = child;
+                    }
+                }
+                if (soonest == index) {
+                    break;
+                }
+                SwapInHeap(index, soonest);
+                index = soonest;
+            }
+        }
+
+        /**
+         * This method puts the given cookie where it belongs in the
+         * expiry heap, after its expiry has been set, adding it to
+         * the heap or taking it out as needed.
+         *
+         * @param[in] cookie
+         *     This is the cookie to place.
+         */
+        void UpdateHeap(StoredCookie* cookie) {
+            if (cookie->expiry == SESSION_EXPIRY) {
+                RemoveFromHeap(cookie);
+                return;
+            }
+            if (cookie->heapIndex == NOT_IN_HEAP) {
+                cookie->heapIndex = expiryHeap.size();
+                expiryHeap.push_back(cookie);
+            }
+            PlaceInHeap(cookie->heapIndex);
+        }
+
+        /**
+         * This method takes the given cookie out of the
+         * expiry heap, if it's there.
+         *
+         * @param[in] cookie
+         *     This is the cookie to take out.
+         */
+        void RemoveFromHeap(StoredCookie* cookie) {
+            const auto index = cookie->heapIndex;
+            if (index == NOT_IN_HEAP) {
+                return;
+            }
+            const auto last = expiryHeap.size() - 1;
+            if (index != last) {
+                SwapInHeap(index, last);
+            }
+            expiryHeap.pop_back();
+            cookie->heapIndex = NOT_IN_HEAP;
+            if (index != last) {
+                PlaceInHeap(index);
+            }
+        }
+
+        /**
+         * This method removes nodes of the tree, starting with the
+         * given one and going up, which hold no cookies or subdomains.
+         *
+         * @param[in] node
+         *     This is the first node to consider removing.
+         */
+        void PruneNode(DomainNode* node) {
+            while (
+                (node->parent != nullptr)
+                && node->paths.empty()
+                && node->subdomains.empty()
+            ) {
+                const auto parent = node->parent;
+                parent->subdomains.erase(parent->subdomains.find(node->label));
+                node = parent;
+            }
+        }
+
+        /**
+         * This method removes the given cookie from the jar.
+         *
+         * @param[in] cookie
+         *     This is the cookie to remove.
+         */
+        void RemoveCookie(StoredCookie* cookie) {
+            RemoveFromHeap(cookie);
+            const auto node = cookie->node;
+            const auto cookies = node->paths.find(*cookie->path);
+            cookies->second.erase(
+                std::find_if(
+                    cookies->second.begin(),
+                    cookies->second.end(),
+                    [cookie](const std::unique_ptr< StoredCookie >& storedCookie) {
+                        return storedCookie.get() == cookie;
+                    }
+                )
+            );
+            if (cookies->second.empty()) {
+                node->paths.erase(cookies);
+            }
+            --cookieCount;
+            PruneNode(node);
+        }
+    };
+
+    CookieJar::~CookieJar() = default;
+    CookieJar::CookieJar(CookieJar&&) = default;
+    CookieJar& CookieJar::operator=(CookieJar&&) = default;
+
+    CookieJar::CookieJar()
+        : impl_(new Impl)
+    {
+    }
+
+    bool CookieJar::StoreCookie(
+        const SetCookie& cookie,
+        std::string_view requestHost,
+        std::string_view requestPath,
+        int64_t now
+    ) {
+        if (!cookie.IsValid()) {
+            return false;
+        }
+
+        // Work out when the cookie expires.  Max-Age takes
+        // precedence over Expires.
+        int64_t expiry = SESSION_EXPIRY;
+        int64_t maxAge;
+        if (cookie.GetMaxAge(maxAge)) {
+            expiry = (maxAge <= 0) ? INT64_MIN : (
+                (maxAge > SESSION_EXPIRY - 1 - now) ? (SESSION_EXPIRY - 1) : (now + maxAge)
+            );
+        } else if (!cookie.GetExpires(expiry)) {
+            expiry = SESSION_EXPIRY;
+        }
+
+        // Work out which domain and path the cookie belongs to.
+        const auto host = ToLower(requestHost);
+        auto domain = ToLower(cookie.GetDomain());
+        bool hostOnly = false;
+        if (domain.empty()) {
+            domain = host;
+            hostOnly = true;
+        } else if (
+            !DomainMatches(host, domain)
+            || (
+                (domain != host)
+                && (domain.find('.') == std::string::npos)
+            )
+        ) {
+            return false;
+        }
+        auto path = cookie.GetPath();
+        if (path.empty()) {
+            path = DefaultPath(requestPath);
+        }
+
+        // Find any cookie this one replaces.  An expired cookie
+        // only removes the one it replaces, so it makes no nodes.
+        const auto node = impl_->FindNode(domain, expiry > now);
+        if (node == nullptr) {
+            return true;
+        }
+        auto cookies = node->paths.find(path);
+        if (cookies == node->paths.end()) {
+            if (expiry <= now) {
+                return true;
+            }
+            cookies = node->paths.emplace(
+                std::string(path),
+                std::vector< std::unique_ptr< StoredCookie > >()
+            ).first;
+        }
+        const auto name = cookie.GetName();
+        const auto replaced = std::find_if(
+            cookies->second.begin(),
+            cookies->second.end(),
+            [name](const std::unique_ptr< StoredCookie >& storedCookie) {
+                return storedCookie->name == name;
+            }
+        );
+        if (expiry <= now) {
+            if (replaced != cookies->second.end()) {
+                impl_->RemoveCookie(replaced->get());
+            }
+            return true;
+        }
+        StoredCookie* storedCookie;
+        if (replaced == cookies->second.end()) {
+            cookies->second.push_back(std::make_unique< StoredCookie >());
+            storedCookie = cookies->second.back().get();
+            storedCookie->name = std::string(name);
+            storedCookie->creation = impl_->nextCreation++;
+            storedCookie->node = node;
+            storedCookie->path = &cookies->first;
+            ++impl_->cookieCount;
+        } else {
+            storedCookie = replaced->get();
+        }
+        storedCookie->value = std::string(cookie.GetValue());
+        storedCookie->expiry = expiry;
+        storedCookie->hostOnly = hostOnly;
+        storedCookie->secure = cookie.IsSecure();
+        impl_->UpdateHeap(storedCookie);
+        return true;
+    }
+
+    size_t CookieJar::StoreCookies(
+        const MessageHeaders& responseHeaders,
+        std::string_view requestHost,
+        std::string_view requestPath,
+        int64_t now
+    ) {
+        size_t accepted = 0;
+        for (const auto& cookie: SetCookies(responseHeaders)) {
+            if (StoreCookie(cookie, requestHost, requestPath, now)) {
+                ++accepted;
+            }
+        }
+        return accepted;
+    }
+
+    void CookieJar::RemoveExpiredCookies(int64_t now) {
+        const auto& heap = impl_->expiryHeap;
+        while (
+            !heap.empty()
+            && (heap.front()->expiry <= now)
+        ) {
+            impl_->RemoveCookie(heap.front());
+        }
+    }
+
+    size_t CookieJar::GetCookieCount() const {
+        return impl_->cookieCount;
+    }
+
+    bool CookieJar::AddCookieHeader(
+        MessageHeaders& requestHeaders,
+        std::string_view requestHost,
+        std::string_view requestPath,
+        bool secure,
+        int64_t now
+    ) {
+        RemoveExpiredCookies(now);
+        if (
+            requestPath.empty()
+            || (requestPath[0] != '/')
+        ) {
+            requestPath = "/";
+        }
+
+        // Walk down the tree along the labels of the host, from the
+        // top-level domain, collecting the cookies of each domain
+        // which has a path matching the request path.
+        const auto host = ToLower(requestHost);
+        std::vector< std::pair< size_t, const StoredCookie* > > matches;
+        auto node = &impl_->root;
+        auto labelEnd = host.length();
+        while (labelEnd > 0) {
+            const auto dot = host.rfind('.', labelEnd - 1);
+            const auto labelStart = (dot == std::string::npos) ? 0 : (dot + 1);
+            const auto subdomain = node->subdomains.find(
+                std::string_view(host).substr(labelStart, labelEnd - labelStart)
+            );
+            if (subdomain == node->subdomains.end()) {
+                break;
+            }
+            node = subdomain->second.get();
+            labelEnd = (dot == std::string::npos) ? 0 : dot;
+            const bool isHost = (labelEnd == 0);
+
+            // A cookie path matches if it's the request path, or a
+            // prefix of it ending at a slash or just before one
+            // (RFC 6265 section 5.1.4).
+            for (size_t prefixLength = 1; prefixLength <= requestPath.length(); ++prefixLength) {
+                if (
+                    (prefixLength < requestPath.length())
+                    && (requestPath[prefixLength - 1] != '/')
+                    && (requestPath[prefixLength] != '/')
+                ) {
+                    continue;
+                }
+                const auto cookies = node->paths.find(requestPath.substr(0, prefixLength));
+                if (cookies == node->paths.end()) {
+                    continue;
+                }
+                for (const auto& cookie: cookies->second) {
+                    if (
+                        (isHost || !cookie->hostOnly)
+                        && (secure || !cookie->secure)
+                    ) {
+                        matches.emplace_back(prefixLength, cookie.get());
+                    }
+                }
+            }
+        }
+        if (matches.empty()) {
+            return false;
+        }
+        std::sort(
+            matches.begin(),
+            matches.end(),
+            [](
+                const std::pair< size_t, const StoredCookie* >& lhs,
+                const std::pair< size_t, const StoredCookie* >& rhs
+            ) {
+                if (lhs.first != rhs.first) {
+                    return lhs.first > rhs.first;
+                }
+                return lhs.second->creation < rhs.second->creation;
+            }
+        );
+
+        // Write the cookies straight into the new header.
+        const auto index = requestHeaders.GetHeaderCount();
+        requestHeaders.AddHeader("Cookie", "");
+        requestHeaders.EditHeaderValue(
+            index,
+            [&matches](std::string& headerValue) {
+                for (const auto& match: matches) {
+                    if (!headerValue.empty()) {
+                        headerValue += "; ";
+                    }
+                    headerValue += match.second->name;
+                    headerValue += '=';
+                    headerValue += match.second->value;
+                }
+            }
+        );
+        return true;
+    }
+}
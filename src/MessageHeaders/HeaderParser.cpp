@@ -0,0 +1,599 @@
+/**
+ * @file HeaderParser.cpp
+ *
+ * This module contains the implementation of the MessageHeaders::HeaderParser class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <array>
+#include <MessageHeaders/HeaderParser.hpp>
+
+namespace {
+    /**
+     * These are the characters that are considered white space
+     * and should be stripped off the margins of header values.
+     */
+    constexpr std::string_view WSP = " \t";
+
+    /**
+     * This is the required line terminator for internet message header lines.
+     */
+    constexpr std::string_view CRLF = "\r\n";
+
+    /**
+     * This function returns a view of the given string with any
+     * whitespace at the beginning and end excluded.
+     *
+     * @param[in] s
+     *      This is the string to strip.
+     *
+     * @return
+     *      The stripped view is returned.
+     */
+    std::string_view StripMarginWhitespace(std::string_view s) {
+        const auto marginLeft = s.find_first_not_of(WSP);
+        if (marginLeft == std::string_view::npos) {
+            return {};
+        }
+        const auto marginRight = s.find_last_not_of(WSP);
+        return s.substr(marginLeft, marginRight - marginLeft + 1);
+    }
+
+    /**
+     * This function determines whether or not the given character
+     * is an invisible ASCII character (e.g. space or control character).
+     *
+     * @param[in] c
+     *     This is the character to test.
+     *
+     * @return
+     *     An indication of whether or not the given character is an
+     *     invisible ASCII character (e.g. space or control character)
+     *     is returned.
+     */
+    bool IsInvisibleAscii(char c) {
+        return (
+            (c < 33) ||
+            (c > 126)
+            );
+    }
+
+    /**
+     * This function takes a single header line of a raw internet
+     * message, determines where the name and value of the header
+     * are, and returns views of them.
+     *
+     * @param[in] line
+     *     This is the header line, without its line terminator.
+     *
+     * @param[out] name
+     *     This is where to store the header name.
+     *
+     * @param[out] value
+     *     This is where to store the header value.
+     *
+     * @return
+     *     An indication of whether or not the header name and
+     *     value were separated successfully is returned.
+     */
+    bool SeparateHeaderNameAndValue(
+        std::string_view line,
+        std::string_view& name,
+        std::string_view& value
+    ) {
+        const auto nameValueDelimiter = line.find(':');
+        if (nameValueDelimiter == std::string_view::npos) {
+            return false;
+        }
+
+        name = line.substr(0, nameValueDelimiter);
+        for (auto c : name) {
+            if (IsInvisibleAscii(c)) {
+                return false;
+            }
+        }
+
+        value = line.substr(nameValueDelimiter + 1);
+        return true;
+    }
+
+    /**
+     * This function looks ahead in a raw internet message,
+     * and for each line that begins with whitespace, it "unfolds"
+     * the line into the given header value.
+     *
+     * The value is only copied into the given buffer once the
+     * first folded line is seen; until then it stays a view
+     * of the raw message.
+     *
+     * The given offset and lineTerminator positions into
+     * the raw message are advanced past any unfolded lines.
+     *
+     * @param[in] rawMessage
+     *     This is the string containing the message.
+     *
+     * @param[in,out] offset
+     *     This is the current position into rawMessage where
+     *     we should look for lines to potentially unfold
+     *     into the given header value.
+     *
+     * @param[in,out] lineTerminator
+     *     This is the position of the end of the current line.
+     *
+     * @param[in,out] value
+     *     This is the last header value parsed from the message.
+     *     If any lines are unfolded, it is redirected to the buffer.
+     *
+     * @param[in,out] buffer
+     *     This is where to reassemble the value if it is folded.
+     *
+     * @return
+     *     An indication of whether or not the advancing
+     *     and unfolding were successful is returned.
+     */
+    bool AdvanceAndUnfold(
+        std::string_view rawMessage,
+        size_t& offset,
+        size_t& lineTerminator,
+        std::string_view& value,
+        std::string& buffer
+    ) {
+        bool unfolded = false;
+        for (;;) {
+            // Find where the next line begins.
+            const auto nextLineStart = lineTerminator + CRLF.length();
+
+            // Find where the next line ends.
+            const auto nextLineTerminator = rawMessage.find(CRLF, nextLineStart);
+            if (nextLineTerminator == std::string_view::npos) {
+                return false;
+            }
+
+            // Calculate the next line's length.
+            auto nextLineLength = nextLineTerminator - nextLineStart;
+
+            // If the next line begins with whitespace, unfold the line
+            if (
+                (nextLineLength > CRLF.length())
+                && (WSP.find(rawMessage[nextLineStart]) != std::string_view::npos)
+                ) {
+                if (!unfolded) {
+                    buffer.assign(value.data(), value.length());
+                    unfolded = true;
+                }
+
+                // Append a single space to the header value.
+                buffer += ' ';
+
+                // Remove leading whitespace from the next line.
+                const auto firstNonWhitespaceInNextLine = rawMessage.find_first_not_of(WSP, nextLineStart);
+                nextLineLength -= (firstNonWhitespaceInNextLine - nextLineStart);
+
+                // Concatenate the rest of the next line to the header value.
+                buffer.append(rawMessage.data() + firstNonWhitespaceInNextLine, nextLineLength);
+
+                // Move to the line following the next line.
+                offset = nextLineTerminator + CRLF.length();
+                lineTerminator = nextLineTerminator;
+            }
+            else {
+                break;
+            }
+        }
+        if (unfolded) {
+            value = buffer;
+        }
+        return true;
+    }
+
+    /**
+     * These are the classes into which the state machine
+     * sorts the bytes of a raw message.
+     */
+    enum ByteClass : unsigned char {
+        BC_CR,
+        BC_LF,
+        BC_COLON,
+        BC_WSP,
+        BC_VISIBLE,
+        BC_OTHER,
+        NUM_BYTE_CLASSES
+    };
+
+    /**
+     * These are the states of the state machine.
+     *
+     * The FOLD_* states cover a line that continues the previous
+     * header.  Such a line must hold at least three characters
+     * before its line terminator, so the first two are counted by
+     * the state (1, 2) along with whether they were all whitespace
+     * (L, "leading") or not (B, "body").  The *_CR states mean a
+     * carriage return was seen, which may or may not be followed by
+     * the line feed completing a line terminator.
+     */
+    enum State : unsigned char {
+        ST_LINE_START,
+        ST_BLANK_CR,
+        ST_NAME,
+        ST_VALUE,
+        ST_VALUE_CR,
+        ST_NEXT_LINE,
+        ST_FOLD_1,
+        ST_FOLD_1_CR,
+        ST_FOLD_2L,
+        ST_FOLD_2L_CR,
+        ST_FOLD_2B,
+        ST_FOLD_2B_CR,
+        ST_FOLD_LEAD,
+        ST_FOLD_LEAD_CR,
+        ST_FOLD_BODY,
+        ST_FOLD_BODY_CR,
+        ST_DONE,
+        ST_ERROR,
+        NUM_STATES
+    };
+
+    /**
+     * These are the kinds of bookkeeping which may be attached
+     * to a state machine transition.
+     */
+    enum Action : unsigned char {
+        AC_NONE,
+        AC_FAIL,
+        AC_BLANK_START,
+        AC_NAME_START,
+        AC_EMPTY_NAME,
+        AC_NAME_END,
+        AC_LINE_END,
+        AC_END,
+        AC_EMIT_BLANK_START,
+        AC_EMIT_NAME_START,
+        AC_EMIT_EMPTY_NAME,
+        AC_FOLD_CONTENT,
+        AC_FOLD_CONTENT_AT_CR,
+        AC_FOLD_END,
+        AC_FOLD_END_EMPTY,
+    };
+
+    /**
+     * This is a single entry of the state machine's transition table.
+     */
+    struct Transition {
+        /**
+         * This is the state to enter.
+         */
+        unsigned char next;
+
+        /**
+         * This is the bookkeeping to carry out on the way.
+         */
+        unsigned char action;
+    };
+
+    /**
+     * This function builds the table which sorts bytes into classes.
+     *
+     * @return
+     *     The table which sorts bytes into classes is returned.
+     */
+    constexpr std::array< unsigned char, 256 > MakeByteClasses() {
+        std::array< unsigned char, 256 > byteClasses{};
+        for (size_t i = 0; i < byteClasses.size(); ++i) {
+            if ((i >= 33) && (i <= 126)) {
+                byteClasses[i] = BC_VISIBLE;
+            }
+            else {
+                byteClasses[i] = BC_OTHER;
+            }
+        }
+        byteClasses['\r'] = BC_CR;
+        byteClasses['\n'] = BC_LF;
+        byteClasses[':'] = BC_COLON;
+        byteClasses[' '] = BC_WSP;
+        byteClasses['\t'] = BC_WSP;
+        return byteClasses;
+    }
+
+    /**
+     * This sorts bytes into the classes used by the state machine.
+     */
+    constexpr auto BYTE_CLASSES = MakeByteClasses();
+
+    /**
+     * These are shorthands used to keep the transition table legible.
+     */
+    constexpr Transition FAIL{ST_ERROR, AC_FAIL};
+    constexpr Transition GO(State next, Action action = AC_NONE) {
+        return {next, action};
+    }
+
+    /**
+     * This is the state machine's transition table, indexed by
+     * the current state and the class of the next byte.
+     */
+    constexpr Transition TRANSITIONS[NUM_STATES][NUM_BYTE_CLASSES] = {
+        //                  BC_CR                                      BC_LF                             BC_COLON                                BC_WSP                                   BC_VISIBLE                               BC_OTHER
+        /* LINE_START   */ {GO(ST_BLANK_CR, AC_BLANK_START),           FAIL,                             GO(ST_VALUE, AC_EMPTY_NAME),            FAIL,                                    GO(ST_NAME, AC_NAME_START),              FAIL},
+        /* BLANK_CR     */ {FAIL,                                      GO(ST_DONE, AC_END),              FAIL,                                   FAIL,                                    FAIL,                                    FAIL},
+        /* NAME         */ {FAIL,                                      FAIL,                             GO(ST_VALUE, AC_NAME_END),              FAIL,                                    GO(ST_NAME),                             FAIL},
+        /* VALUE        */ {GO(ST_VALUE_CR),                           GO(ST_VALUE),                     GO(ST_VALUE),                           GO(ST_VALUE),                            GO(ST_VALUE),                            GO(ST_VALUE)},
+        /* VALUE_CR     */ {GO(ST_VALUE_CR),                           GO(ST_NEXT_LINE, AC_LINE_END),    GO(ST_VALUE),                           GO(ST_VALUE),                            GO(ST_VALUE),                            GO(ST_VALUE)},
+        /* NEXT_LINE    */ {GO(ST_BLANK_CR, AC_EMIT_BLANK_START),      FAIL,                             GO(ST_VALUE, AC_EMIT_EMPTY_NAME),       GO(ST_FOLD_1),                           GO(ST_NAME, AC_EMIT_NAME_START),         FAIL},
+        /* FOLD_1       */ {GO(ST_FOLD_1_CR),                          GO(ST_FOLD_2B, AC_FOLD_CONTENT),  GO(ST_FOLD_2B, AC_FOLD_CONTENT),        GO(ST_FOLD_2L),                          GO(ST_FOLD_2B, AC_FOLD_CONTENT),         GO(ST_FOLD_2B, AC_FOLD_CONTENT)},
+        /* FOLD_1_CR    */ {GO(ST_FOLD_2B_CR, AC_FOLD_CONTENT_AT_CR),  FAIL,                             GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR)},
+        /* FOLD_2L      */ {GO(ST_FOLD_2L_CR),                         GO(ST_FOLD_BODY, AC_FOLD_CONTENT), GO(ST_FOLD_BODY, AC_FOLD_CONTENT),     GO(ST_FOLD_LEAD),                        GO(ST_FOLD_BODY, AC_FOLD_CONTENT),       GO(ST_FOLD_BODY, AC_FOLD_CONTENT)},
+        /* FOLD_2L_CR   */ {GO(ST_FOLD_BODY_CR, AC_FOLD_CONTENT_AT_CR), FAIL,                            GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR)},
+        /* FOLD_2B      */ {GO(ST_FOLD_2B_CR),                         GO(ST_FOLD_BODY),                 GO(ST_FOLD_BODY),                       GO(ST_FOLD_BODY),                        GO(ST_FOLD_BODY),                        GO(ST_FOLD_BODY)},
+        /* FOLD_2B_CR   */ {GO(ST_FOLD_BODY_CR),                       FAIL,                             GO(ST_FOLD_BODY),                       GO(ST_FOLD_BODY),                        GO(ST_FOLD_BODY),                        GO(ST_FOLD_BODY)},
+        /* FOLD_LEAD    */ {GO(ST_FOLD_LEAD_CR),                       GO(ST_FOLD_BODY, AC_FOLD_CONTENT), GO(ST_FOLD_BODY, AC_FOLD_CONTENT),     GO(ST_FOLD_LEAD),                        GO(ST_FOLD_BODY, AC_FOLD_CONTENT),       GO(ST_FOLD_BODY, AC_FOLD_CONTENT)},
+        /* FOLD_LEAD_CR */ {GO(ST_FOLD_BODY_CR, AC_FOLD_CONTENT_AT_CR), GO(ST_NEXT_LINE, AC_FOLD_END_EMPTY), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR), GO(ST_FOLD_BODY, AC_FOLD_CONTENT_AT_CR)},
+        /* FOLD_BODY    */ {GO(ST_FOLD_BODY_CR),                       GO(ST_FOLD_BODY),                 GO(ST_FOLD_BODY),                       GO(ST_FOLD_BODY),                        GO(ST_FOLD_BODY),                        GO(ST_FOLD_BODY)},
+        /* FOLD_BODY_CR */ {GO(ST_FOLD_BODY_CR),                       GO(ST_NEXT_LINE, AC_FOLD_END),    GO(ST_FOLD_BODY),                       GO(ST_FOLD_BODY),                        GO(ST_FOLD_BODY),                        GO(ST_FOLD_BODY)},
+        /* DONE         */ {GO(ST_DONE),                               GO(ST_DONE),                      GO(ST_DONE),                            GO(ST_DONE),                             GO(ST_DONE),                             GO(ST_DONE)},
+        /* ERROR        */ {GO(ST_ERROR),                              GO(ST_ERROR),                     GO(ST_ERROR),                           GO(ST_ERROR),                            GO(ST_ERROR),                            GO(ST_ERROR)},
+    };
+
+}
+
+namespace MessageHeaders {
+    void HeaderHandler::OnEnd(size_t /* bodyOffset */) {
+    }
+
+    void HeaderParser::SetLineLimit(size_t newLineLengthLimit) {
+        lineLengthLimit_ = newLineLengthLimit;
+    }
+
+    void HeaderParser::SetEngine(Engine newEngine) {
+        engine_ = newEngine;
+    }
+
+    bool HeaderParser::Parse(std::string_view rawMessage, HeaderHandler& handler) {
+        if (engine_ == Engine::Dfa) {
+            Reset();
+            return (Feed(rawMessage, handler) == Status::Complete);
+        }
+
+        size_t offset = 0;
+        while (offset < rawMessage.length()) {
+            // Find the end of the current line.
+            auto lineTerminator = rawMessage.find(CRLF, offset);
+            // No line terminator
+            if (lineTerminator == std::string_view::npos) {
+                break;
+            }
+
+            // Bail if the line is longer than the limit (if set).
+            if (lineLengthLimit_ > 0) {
+                if (lineTerminator + CRLF.length() - offset > lineLengthLimit_) {
+                    return false;
+                }
+            }
+
+            // Stop if empty line is found -- this is where
+            // the headers end and the body (which we don't parse,
+            // but leave up to the user to handle) begins.
+            if (lineTerminator == offset) {
+                offset += CRLF.length();
+                break;
+            }
+
+            // Separate the header name from the header value.
+            std::string_view name;
+            std::string_view value;
+            if (
+                !SeparateHeaderNameAndValue(
+                    rawMessage.substr(offset, lineTerminator - offset),
+                    name,
+                    value
+                )
+                ) {
+                return false;
+            }
+
+            // Look ahead in the raw message and perform
+            // line unfolding if we see any lines that begin with whitespace.
+            offset = lineTerminator + CRLF.length();
+            if (
+                !AdvanceAndUnfold(
+                    rawMessage,
+                    offset,
+                    lineTerminator,
+                    value,
+                    unfoldBuffer_
+                )
+                ) {
+                return false;
+            }
+
+            // Remove any whitespace that might be at the beginning
+            // or end of the header value, and then report the header.
+            if (!handler.OnHeader(name, StripMarginWhitespace(value))) {
+                return false;
+            }
+        }
+
+        /*
+            Empty string and a single truncated line were not being
+            detected as bad messages.  If there is at least one line,
+            it gets detected as a bad message because of the lack
+            of a "next line" when looking ahead to see if line unfolding
+            needs to be done.  Unfortunately, if there isn't even one
+            complete line, there was no unfolding check at all.
+
+            Solve this problem by checking at the end to see that at least
+            one line was parsed from the raw message.
+        */
+        if (offset == 0) {
+            return false;
+        }
+
+        handler.OnEnd(offset);
+        return true;
+    }
+
+    void HeaderParser::Reset() {
+        state_ = ST_LINE_START;
+        position_ = 0;
+        carried_.clear();
+        folds_.clear();
+    }
+
+    auto HeaderParser::Feed(std::string_view piece, HeaderHandler& handler) -> Status {
+        piece_ = piece;
+        pieceOffset_ = position_;
+        for (size_t i = 0; i < piece.length(); ++i) {
+            const auto& transition = TRANSITIONS[state_][BYTE_CLASSES[(unsigned char)piece[i]]];
+            state_ = transition.next;
+            if (transition.action != AC_NONE) {
+                if (!PerformAction(transition.action, pieceOffset_ + i, handler)) {
+                    state_ = ST_ERROR;
+                }
+                if (state_ >= ST_DONE) {
+                    position_ = pieceOffset_ + i + 1;
+                    carried_.clear();
+                    break;
+                }
+            }
+        }
+        if (state_ == ST_DONE) {
+            return Status::Complete;
+        }
+        if (state_ == ST_ERROR) {
+            return Status::Error;
+        }
+
+        // Keep the bytes of any header still being recognized,
+        // since the caller may discard this piece.
+        position_ = pieceOffset_ + piece.length();
+        if (
+            (state_ != ST_LINE_START)
+            && (state_ != ST_BLANK_CR)
+            ) {
+            if (headerStart_ >= pieceOffset_) {
+                carried_.assign(piece.substr(headerStart_ - pieceOffset_));
+            }
+            else {
+                carried_.append(piece.data(), piece.length());
+            }
+        }
+        return Status::Incomplete;
+    }
+
+    bool HeaderParser::PerformAction(
+        unsigned char action,
+        size_t position,
+        HeaderHandler& handler
+    ) {
+        switch (action) {
+            case AC_FAIL: {
+                return false;
+            }
+
+            case AC_EMIT_BLANK_START: {
+                if (!EmitHeader(position, handler)) {
+                    return false;
+                }
+            } // fall through
+            case AC_BLANK_START: {
+                lineStart_ = position;
+            } break;
+
+            case AC_EMIT_NAME_START: {
+                if (!EmitHeader(position, handler)) {
+                    return false;
+                }
+            } // fall through
+            case AC_NAME_START: {
+                lineStart_ = headerStart_ = position;
+            } break;
+
+            case AC_EMIT_EMPTY_NAME: {
+                if (!EmitHeader(position, handler)) {
+                    return false;
+                }
+            } // fall through
+            case AC_EMPTY_NAME: {
+                lineStart_ = headerStart_ = position;
+            } // fall through
+            case AC_NAME_END: {
+                nameEnd_ = position;
+                valueStart_ = position + 1;
+            } break;
+
+            case AC_LINE_END: {
+                valueEnd_ = position - 1;
+                if (
+                    (lineLengthLimit_ > 0)
+                    && (position + 1 - lineStart_ > lineLengthLimit_)
+                    ) {
+                    return false;
+                }
+            } break;
+
+            case AC_END: {
+                if (
+                    (lineLengthLimit_ > 0)
+                    && (position + 1 - lineStart_ > lineLengthLimit_)
+                    ) {
+                    return false;
+                }
+                handler.OnEnd(position + 1);
+            } break;
+
+            case AC_FOLD_CONTENT: {
+                foldStart_ = position;
+            } break;
+
+            case AC_FOLD_CONTENT_AT_CR: {
+                foldStart_ = position - 1;
+            } break;
+
+            case AC_FOLD_END: {
+                folds_.emplace_back(foldStart_, position - 1);
+            } break;
+
+            case AC_FOLD_END_EMPTY: {
+                folds_.emplace_back(position - 1, position - 1);
+            } break;
+
+            default: break;
+        }
+        return true;
+    }
+
+    bool HeaderParser::EmitHeader(size_t position, HeaderHandler& handler) {
+        // Find the bytes of the header, which may have begun
+        // in an earlier piece.
+        const char* headerBytes;
+        if (headerStart_ >= pieceOffset_) {
+            headerBytes = piece_.data() + (headerStart_ - pieceOffset_);
+        }
+        else {
+            carried_.append(piece_.data(), position - pieceOffset_);
+            headerBytes = carried_.data();
+        }
+        const auto bytesAt = [this, headerBytes](size_t start, size_t end) {
+            return std::string_view(headerBytes + (start - headerStart_), end - start);
+        };
+
+        // Unfold the value if it was continued on other lines.
+        auto value = bytesAt(valueStart_, valueEnd_);
+        if (!folds_.empty()) {
+            unfoldBuffer_.assign(value.data(), value.length());
+            for (const auto& fold : folds_) {
+                unfoldBuffer_ += ' ';
+                const auto foldBytes = bytesAt(fold.first, fold.second);
+                unfoldBuffer_.append(foldBytes.data(), foldBytes.length());
+            }
+            folds_.clear();
+            value = unfoldBuffer_;
+        }
+        const auto keepGoing = handler.OnHeader(
+            bytesAt(headerStart_, nameEnd_),
+            StripMarginWhitespace(value)
+        );
+        carried_.clear();
+        return keepGoing;
+    }
+}
@@ -0,0 +1,28 @@
+/**
+ * @file HeaderSchema.cpp
+ *
+ * This module contains the implementation of the header value
+ * conversions used by the MessageHeaders::HeaderSchema class template.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <MessageHeaders/HeaderSchema.hpp>
+
+namespace MessageHeaders {
+    bool ConvertHeaderValue(std::string_view text, std::string& value) {
+        value.assign(text.data(), text.length());
+        return true;
+    }
+
+    bool ConvertHeaderValue(std::string_view text, std::string_view& value) {
+        value = text;
+        return true;
+    }
+
+    bool CombineHeaderValue(std::string_view text, std::string& value) {
+        value += ',';
+        value.append(text.data(), text.length());
+        return true;
+    }
+}
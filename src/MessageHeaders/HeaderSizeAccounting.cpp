@@ -0,0 +1,489 @@
+/**
+ * @file HeaderSizeAccounting.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::HeaderSizeAccounting class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <MessageHeaders/HeaderSizeAccounting.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+#include <string.h>
+
+namespace {
+    /**
+     * This is the number of sets of counters
+     * among which recording threads are spread.
+     */
+    constexpr size_t SHARDS = 8;
+
+    /**
+     * This is the number of ways in which headers may pass through
+     * (see MessageHeaders::HeaderSizeDirection).
+     */
+    constexpr size_t DIRECTIONS = 2;
+
+    /**
+     * This is the longest part of a name which isn't well-known
+     * kept for reporting.
+     */
+    constexpr size_t MAX_NAME_LENGTH = 64;
+
+    /**
+     * This is the name reported for headers which didn't fit
+     * into the table of names.
+     */
+    constexpr std::string_view OTHER_NAMES = "(other)";
+
+    /**
+     * This is the place in the table of names where headers
+     * are counted which didn't fit anywhere else.  It's the place
+     * of WellKnownHeader::Unknown, which is never used otherwise.
+     */
+    constexpr size_t OTHER_NAMES_SLOT = (size_t)MessageHeaders::WellKnownHeader::Unknown;
+
+    /**
+     * This counts things by their sizes, and may be added to
+     * from many threads at once.
+     */
+    struct AtomicHistogram {
+        /**
+         * This is the number of things counted.
+         */
+        std::atomic< uint64_t > count{0};
+
+        /**
+         * This is the total size of the things counted, in bytes.
+         */
+        std::atomic< uint64_t > bytes{0};
+
+        /**
+         * These are the number of things counted of each size.
+         */
+        std::array< std::atomic< uint64_t >, MessageHeaders::HEADER_SIZE_BUCKETS > buckets{};
+
+        /**
+         * This method counts a thing of the given size.
+         *
+         * @param[in] size
+         *     This is the size of the thing, in bytes.
+         */
+        void Add(size_t size) {
+            count.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(size, std::memory_order_relaxed);
+            buckets[MessageHeaders::GetHeaderSizeBucket(size)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * This method adds the counts of the given histogram to these.
+         *
+         * @param[in] other
+         *     This is the histogram to add.
+         */
+        void Add(const AtomicHistogram& other) {
+            count.fetch_add(other.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            bytes.fetch_add(other.bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                buckets[i].fetch_add(other.buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * This method adds these counts to the given histogram.
+         *
+         * @param[in,out] histogram
+         *     This is the histogram to which to add the counts.
+         */
+        void AddTo(MessageHeaders::HeaderSizeHistogram& histogram) const {
+            histogram.count += count.load(std::memory_order_relaxed);
+            histogram.bytes += bytes.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                histogram.buckets[i] += buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * This method determines whether or not
+         * anything has been counted.
+         *
+         * @return
+         *     An indication of whether or not anything
+         *     has been counted is returned.
+         */
+        bool IsEmpty() const {
+            return count.load(std::memory_order_relaxed) == 0;
+        }
+    };
+
+    /**
+     * These are the counts of headers with one name.
+     */
+    struct NameCounters {
+        /**
+         * These are the counts of headers with the name,
+         * for each way in which they passed through.
+         */
+        AtomicHistogram directions[DIRECTIONS];
+    };
+
+    /**
+     * This is one set of counters, used by some of the threads
+     * recording headers.  It's aligned so that threads using
+     * different sets don't share cache lines.
+     */
+    struct alignas(64) Shard {
+        /**
+         * These are the counts of header blocks,
+         * for each way in which they passed through.
+         */
+        AtomicHistogram messages[DIRECTIONS];
+
+        /**
+         * These are the counts of headers, for each place in the
+         * table of names.  They're made when first needed.
+         */
+        std::atomic< NameCounters* > names{nullptr};
+
+        ~Shard() {
+            delete[] names.load();
+        }
+    };
+
+    /**
+     * This is a place in the table of names which aren't well-known.
+     */
+    struct NameSlot {
+        /**
+         * This is the hash of the name in this place,
+         * or zero if the place is free.
+         */
+        std::atomic< uint64_t > hash{0};
+
+        /**
+         * This indicates whether or not the name
+         * in this place has been written.
+         */
+        std::atomic< bool > ready{false};
+
+        /**
+         * This is the name in this place, as first seen,
+         * cut short if it's long.
+         */
+        char name[MAX_NAME_LENGTH];
+
+        /**
+         * This is the length of the name in this place.
+         */
+        size_t length = 0;
+    };
+}
+
+namespace MessageHeaders {
+    /**
+     * This contains the private properties of a
+     * HeaderSizeAccounting instance.
+     */
+    struct HeaderSizeAccounting::Impl {
+        /**
+         * This is the number of places for names
+         * which aren't well-known.
+         */
+        size_t otherNameCapacity = 0;
+
+        /**
+         * These are the places for names which aren't well-known.
+         * They come after the places of the well-known names.
+         */
+        std::unique_ptr< NameSlot[] > otherNames;
+
+        /**
+         * These are the sets of counters among which
+         * recording threads are spread.
+         */
+        std::array< Shard, SHARDS > shards;
+
+        /**
+         * This method returns the number of places
+         * in the table of names.
+         *
+         * @return
+         *     The number of places in the table of names is returned.
+         */
+        size_t GetSlotCount() const {
+            return WELL_KNOWN_HEADER_COUNT + otherNameCapacity;
+        }
+
+        /**
+         * This method returns the set of counters
+         * used by the calling thread.
+         *
+         * @return
+         *     The set of counters used by the calling thread is returned.
+         */
+        Shard& GetThreadShard() {
+            static std::atomic< size_t > nextShard{0};
+            thread_local const size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+            return shards[shard];
+        }
+
+        /**
+         * This method returns the counts of headers by name
+         * in the given set of counters, making them if needed.
+         *
+         * @param[in] shard
+         *     This is the set of counters.
+         *
+         * @return
+         *     The counts of headers by name are returned.
+         */
+        NameCounters* GetNameCounters(Shard& shard) {
+            auto names = shard.names.load(std::memory_order_acquire);
+            if (names == nullptr) {
+                const auto newNames = new NameCounters[GetSlotCount()]();
+                if (shard.names.compare_exchange_strong(names, newNames, std::memory_order_acq_rel)) {
+                    names = newNames;
+                } else {
+                    delete[] newNames;
+                }
+            }
+            return names;
+        }
+
+        /**
+         * This method finds the place for the given name which
+         * isn't well-known, taking a free one if it's new.
+         *
+         * @param[in] name
+         *     This is the name.
+         *
+         * @param[in] hash
+         *     This is the hash of the name.
+         *
+         * @return
+         *     The place for the name is returned.
+         */
+        size_t FindOtherSlot(std::string_view name, uint64_t hash) {
+            const auto key = (hash == 0) ? 1 : hash;
+            for (size_t probe = 0; probe < otherNameCapacity; ++probe) {
+                const auto index = (size_t)(key + probe) & (otherNameCapacity - 1);
+                auto& slot = otherNames[index];
+                auto slotKey = slot.hash.load(std::memory_order_acquire);
+                if (
+                    (slotKey == 0)
+                    && slot.hash.compare_exchange_strong(slotKey, key, std::memory_order_acq_rel)
+                ) {
+                    slot.length = std::min(name.length(), MAX_NAME_LENGTH);
+                    (void)memcpy(slot.name, name.data(), slot.length);
+                    slot.ready.store(true, std::memory_order_release);
+                    return WELL_KNOWN_HEADER_COUNT + index;
+                }
+                if (slotKey == key) {
+                    return WELL_KNOWN_HEADER_COUNT + index;
+                }
+            }
+            return OTHER_NAMES_SLOT;
+        }
+
+        /**
+         * This method finds the place for the given name.
+         *
+         * @param[in] name
+         *     This is the name.
+         *
+         * @return
+         *     The place for the name is returned.
+         */
+        size_t FindSlot(std::string_view name) {
+            const auto hash = HashHeaderName(name);
+            const auto wellKnown = FindWellKnownHeader(name, hash);
+            if (wellKnown != WellKnownHeader::Unknown) {
+                return (size_t)wellKnown;
+            }
+            return FindOtherSlot(name, hash);
+        }
+
+        /**
+         * This method returns the name in the given place,
+         * if it's been written.
+         *
+         * @param[in] slot
+         *     This is the place.
+         *
+         * @param[out] name
+         *     This is where to store the name.
+         *
+         * @return
+         *     An indication of whether or not the name
+         *     has been written is returned.
+         */
+        bool GetSlotName(size_t slot, std::string_view& name) const {
+            if (slot == OTHER_NAMES_SLOT) {
+                name = OTHER_NAMES;
+                return true;
+            }
+            if (slot < WELL_KNOWN_HEADER_COUNT) {
+                name = GetWellKnownHeaderInfo((WellKnownHeader)slot).name;
+                return true;
+            }
+            const auto& otherName = otherNames[slot - WELL_KNOWN_HEADER_COUNT];
+            if (!otherName.ready.load(std::memory_order_acquire)) {
+                return false;
+            }
+            name = std::string_view(otherName.name, otherName.length);
+            return true;
+        }
+    };
+
+    size_t GetHeaderSizeBucket(size_t bytes) {
+        size_t bucket = 0;
+        for (
+            size_t limit = 16;
+            (bytes >= limit) && (bucket + 1 < HEADER_SIZE_BUCKETS);
+            limit <<= 1
+        ) {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    size_t GetHeaderSizeBucketLimit(size_t bucket) {
+        if (bucket + 1 >= HEADER_SIZE_BUCKETS) {
+            return SIZE_MAX;
+        }
+        return (size_t)16 << bucket;
+    }
+
+    HeaderSizeAccounting::~HeaderSizeAccounting() = default;
+    HeaderSizeAccounting::HeaderSizeAccounting(HeaderSizeAccounting&&) = default;
+    HeaderSizeAccounting& HeaderSizeAccounting::operator=(HeaderSizeAccounting&&) = default;
+
+    HeaderSizeAccounting::HeaderSizeAccounting(size_t maxOtherNames)
+        : impl_(new Impl)
+    {
+        size_t capacity = (maxOtherNames == 0) ? 0 : 1;
+        while (capacity < maxOtherNames) {
+            capacity <<= 1;
+        }
+        impl_->otherNameCapacity = capacity;
+        impl_->otherNames.reset(new NameSlot[capacity]);
+    }
+
+    void HeaderSizeAccounting::RecordHeader(
+        HeaderSizeDirection direction,
+        std::string_view name,
+        size_t bytes
+    ) {
+        const auto slot = impl_->FindSlot(name);
+        auto names = impl_->GetNameCounters(impl_->GetThreadShard());
+        names[slot].directions[(size_t)direction].Add(bytes);
+    }
+
+    void HeaderSizeAccounting::RecordMessage(
+        HeaderSizeDirection direction,
+        size_t bytes
+    ) {
+        impl_->GetThreadShard().messages[(size_t)direction].Add(bytes);
+    }
+
+    void HeaderSizeAccounting::Merge(const HeaderSizeAccounting& other) {
+        if (&other == this) {
+            return;
+        }
+        auto& shard = impl_->GetThreadShard();
+        const auto names = impl_->GetNameCounters(shard);
+        for (const auto& otherShard : other.impl_->shards) {
+            for (size_t direction = 0; direction < DIRECTIONS; ++direction) {
+                shard.messages[direction].Add(otherShard.messages[direction]);
+            }
+            const auto otherNames = otherShard.names.load(std::memory_order_acquire);
+            if (otherNames == nullptr) {
+                continue;
+            }
+            const auto otherSlotCount = other.impl_->GetSlotCount();
+            for (size_t otherSlot = 0; otherSlot < otherSlotCount; ++otherSlot) {
+                const auto& otherCounters = otherNames[otherSlot];
+                if (
+                    otherCounters.directions[0].IsEmpty()
+                    && otherCounters.directions[1].IsEmpty()
+                ) {
+                    continue;
+                }
+                auto slot = otherSlot;
+                if (otherSlot >= WELL_KNOWN_HEADER_COUNT) {
+                    std::string_view name;
+                    slot = (
+                        other.impl_->GetSlotName(otherSlot, name)
+                        ? impl_->FindOtherSlot(
+                            name,
+                            other.impl_->otherNames[otherSlot - WELL_KNOWN_HEADER_COUNT].hash.load(std::memory_order_acquire)
+                        )
+                        : OTHER_NAMES_SLOT
+                    );
+                }
+                for (size_t direction = 0; direction < DIRECTIONS; ++direction) {
+                    names[slot].directions[direction].Add(otherCounters.directions[direction]);
+                }
+            }
+        }
+    }
+
+    HeaderSizeReport HeaderSizeAccounting::GetReport() const {
+        HeaderSizeReport report;
+        const auto slotCount = impl_->GetSlotCount();
+        std::vector< HeaderSizeRecord > records(slotCount);
+        for (const auto& shard : impl_->shards) {
+            shard.messages[(size_t)HeaderSizeDirection::Parsed].AddTo(report.parsedMessages);
+            shard.messages[(size_t)HeaderSizeDirection::Generated].AddTo(report.generatedMessages);
+            const auto names = shard.names.load(std::memory_order_acquire);
+            if (names == nullptr) {
+                continue;
+            }
+            for (size_t slot = 0; slot < slotCount; ++slot) {
+                names[slot].directions[(size_t)HeaderSizeDirection::Parsed].AddTo(records[slot].parsed);
+                names[slot].directions[(size_t)HeaderSizeDirection::Generated].AddTo(records[slot].generated);
+            }
+        }
+
+        // A name whose place was just taken may not have been written
+        // yet, in which case its headers are reported with the others.
+        for (size_t slot = 0; slot < slotCount; ++slot) {
+            auto& record = records[slot];
+            if ((record.parsed.count == 0) && (record.generated.count == 0)) {
+                continue;
+            }
+            std::string_view name;
+            if (impl_->GetSlotName(slot, name)) {
+                record.name = std::string(name);
+                report.names.push_back(std::move(record));
+                continue;
+            }
+            if (report.names.empty() || (report.names.front().name != OTHER_NAMES)) {
+                report.names.insert(report.names.begin(), HeaderSizeRecord{std::string(OTHER_NAMES), {}, {}});
+            }
+            auto& others = report.names.front();
+            for (auto direction : {&HeaderSizeRecord::parsed, &HeaderSizeRecord::generated}) {
+                (others.*direction).count += (record.*direction).count;
+                (others.*direction).bytes += (record.*direction).bytes;
+                for (size_t i = 0; i < HEADER_SIZE_BUCKETS; ++i) {
+                    (others.*direction).buckets[i] += (record.*direction).buckets[i];
+                }
+            }
+        }
+        std::sort(
+            report.names.begin(),
+            report.names.end(),
+            [](const HeaderSizeRecord& lhs, const HeaderSizeRecord& rhs) {
+                const auto lhsBytes = lhs.parsed.bytes + lhs.generated.bytes;
+                const auto rhsBytes = rhs.parsed.bytes + rhs.generated.bytes;
+                if (lhsBytes != rhsBytes) {
+                    return lhsBytes > rhsBytes;
+                }
+                return lhs.name < rhs.name;
+            }
+        );
+        return report;
+    }
+}
@@ -0,0 +1,615 @@
+/**
+ * @file HeaderStatistics.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::HeaderStatistics class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <MessageHeaders/HeaderStatistics.hpp>
+#include <MessageHeaders/RedactionPolicy.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    /**
+     * This is the number of rows in each count-min sketch.
+     */
+    constexpr size_t SKETCH_DEPTH = 4;
+
+    /**
+     * This is the number of counters in each row of each
+     * count-min sketch.  It must be a power of two.
+     */
+    constexpr size_t SKETCH_WIDTH = 1024;
+
+    /**
+     * These are mixed into keys to pick their counters
+     * in the different rows of a count-min sketch.
+     */
+    constexpr uint64_t ROW_SEEDS[SKETCH_DEPTH] = {
+        0x9E3779B97F4A7C15ULL,
+        0xC2B2AE3D27D4EB4FULL,
+        0x165667B19E3779F9ULL,
+        0x27D4EB2F165667C5ULL,
+    };
+
+    /**
+     * This is the number of independent sketches
+     * among which recording threads are spread.
+     */
+    constexpr size_t SHARDS = 16;
+
+    /**
+     * This is the longest part of a header value kept
+     * in the label of a common value, when values are
+     * shown as text.
+     */
+    constexpr size_t MAX_LABEL_VALUE_LENGTH = 64;
+
+    /**
+     * These are the digits used to write value hashes in hexadecimal.
+     */
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    /**
+     * This function scrambles the bits of the given number
+     * (the finalizer of SplitMix64).
+     *
+     * @param[in] x
+     *     This is the number to scramble.
+     *
+     * @return
+     *     The scrambled number is returned.
+     */
+    uint64_t Mix64(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    /**
+     * This estimates how many times each key was counted, using a
+     * fixed number of counters however many keys there are.  Each key
+     * adds to one counter in each row, and its estimate is the least
+     * of those counters.
+     */
+    class CountMinSketch {
+        // Public Methods
+    public:
+        /**
+         * This method counts the given key.
+         *
+         * @param[in] key
+         *     This is the key to count.
+         *
+         * @param[in] amount
+         *     This is how much to add to the count of the key.
+         *
+         * @return
+         *     The new estimate of the count of the key is returned.
+         */
+        uint64_t Add(uint64_t key, uint64_t amount) {
+            uint64_t estimate = UINT64_MAX;
+            for (size_t row = 0; row < SKETCH_DEPTH; ++row) {
+                auto& counter = counters_[row * SKETCH_WIDTH + Column(key, row)];
+                counter += amount;
+                estimate = std::min(estimate, counter);
+            }
+            return estimate;
+        }
+
+        /**
+         * This method estimates the count of the given key.
+         *
+         * @param[in] key
+         *     This is the key whose count to estimate.
+         *
+         * @return
+         *     The estimate of the count of the key is returned.
+         */
+        uint64_t Estimate(uint64_t key) const {
+            uint64_t estimate = UINT64_MAX;
+            for (size_t row = 0; row < SKETCH_DEPTH; ++row) {
+                estimate = std::min(estimate, counters_[row * SKETCH_WIDTH + Column(key, row)]);
+            }
+            return estimate;
+        }
+
+        /**
+         * This method adds the counts of the given sketch to these.
+         *
+         * @param[in] other
+         *     This is the sketch to add.
+         */
+        void Merge(const CountMinSketch& other) {
+            for (size_t i = 0; i < counters_.size(); ++i) {
+                counters_[i] += other.counters_[i];
+            }
+        }
+
+        /**
+         * This method forgets all counts.
+         */
+        void Clear() {
+            counters_.fill(0);
+        }
+
+        // Private Methods
+    private:
+        /**
+         * This method picks the counter of the given key
+         * in the given row.
+         *
+         * @param[in] key
+         *     This is the key.
+         *
+         * @param[in] row
+         *     This is the row.
+         *
+         * @return
+         *     The column of the counter is returned.
+         */
+        static size_t Column(uint64_t key, size_t row) {
+            return (size_t)(Mix64(key ^ ROW_SEEDS[row]) & (SKETCH_WIDTH - 1));
+        }
+
+        // Private properties
+    private:
+        /**
+         * These are the counters, row after row.
+         */
+        std::array< uint64_t, SKETCH_DEPTH * SKETCH_WIDTH > counters_{};
+    };
+
+    /**
+     * This tracks the keys with the highest estimated counts.
+     */
+    class TopKeys {
+        // Public Methods
+    public:
+        /**
+         * This is a key being tracked.
+         */
+        struct Entry {
+            uint64_t key;
+            uint64_t count;
+            std::string label;
+        };
+
+        /**
+         * This method sets the number of keys to track.
+         *
+         * @param[in] capacity
+         *     This is the number of keys to track.
+         */
+        void SetCapacity(size_t capacity) {
+            capacity_ = capacity;
+            entries_.reserve(capacity);
+        }
+
+        /**
+         * This method updates the estimated count of the given key,
+         * which starts being tracked if there's room, or if its count
+         * passes that of the least common key tracked, which it
+         * replaces.
+         *
+         * @param[in] key
+         *     This is the key.
+         *
+         * @param[in] count
+         *     This is the estimated count of the key.
+         *
+         * @param[in] makeLabel
+         *     This is called to make the label of the key,
+         *     only if it starts being tracked.
+         */
+        void Offer(
+            uint64_t key,
+            uint64_t count,
+            const std::function< std::string() >& makeLabel
+        ) {
+            size_t least = 0;
+            for (size_t i = 0; i < entries_.size(); ++i) {
+                if (entries_[i].key == key) {
+                    entries_[i].count = std::max(entries_[i].count, count);
+                    return;
+                }
+                if (entries_[i].count < entries_[least].count) {
+                    least = i;
+                }
+            }
+            if (entries_.size() < capacity_) {
+                entries_.push_back({key, count, makeLabel()});
+            } else if (
+                !entries_.empty()
+                && (count > entries_[least].count)
+            ) {
+                entries_[least] = {key, count, makeLabel()};
+            }
+        }
+
+        /**
+         * This method returns the keys being tracked.
+         *
+         * @return
+         *     The keys being tracked are returned.
+         */
+        const std::vector< Entry >& GetEntries() const {
+            return entries_;
+        }
+
+        /**
+         * This method stops tracking all keys.
+         */
+        void Clear() {
+            entries_.clear();
+        }
+
+        // Private properties
+    private:
+        /**
+         * These are the keys being tracked.
+         */
+        std::vector< Entry > entries_;
+
+        /**
+         * This is the number of keys to track.
+         */
+        size_t capacity_ = 0;
+    };
+
+    /**
+     * This holds the counts of headers recorded by some of the
+     * threads recording them.
+     */
+    struct Sketch {
+        /**
+         * This is held while the sketch is used.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * These are the counts of header names.
+         */
+        CountMinSketch names;
+
+        /**
+         * These are the counts of header names and values.
+         */
+        CountMinSketch values;
+
+        /**
+         * These are the most common header names.
+         */
+        TopKeys topNames;
+
+        /**
+         * These are the most common header names and values.
+         */
+        TopKeys topValues;
+
+        /**
+         * This is the number of messages recorded.
+         */
+        uint64_t messages = 0;
+
+        /**
+         * This is the number of messages to record before
+         * the next one whose values are counted.
+         */
+        size_t messagesUntilValueSample = 0;
+
+        /**
+         * This method forgets everything recorded.
+         */
+        void Clear() {
+            names.Clear();
+            values.Clear();
+            topNames.Clear();
+            topValues.Clear();
+            messages = 0;
+            messagesUntilValueSample = 0;
+        }
+    };
+
+    /**
+     * This function returns the key under which the given header
+     * value is counted.
+     *
+     * @param[in] nameHash
+     *     This is the hash of the header name.
+     *
+     * @param[in] value
+     *     This is the header value.
+     *
+     * @return
+     *     The key of the header value is returned.
+     */
+    uint64_t ValueKey(uint64_t nameHash, const std::string& value) {
+        return Mix64(nameHash ^ Mix64(MessageHeaders::HeaderStatistics::HashValue(value)));
+    }
+
+    /**
+     * This function returns the label of a common header value,
+     * which shows the hash of the value rather than the value.
+     *
+     * @param[in] name
+     *     This is the header name.
+     *
+     * @param[in] value
+     *     This is the header value.
+     *
+     * @return
+     *     The label of the header value is returned.
+     */
+    std::string HashedValueLabel(const std::string& name, const std::string& value) {
+        auto valueHash = MessageHeaders::HeaderStatistics::HashValue(value);
+        std::string label;
+        label.reserve(name.length() + 3 + 16);
+        label += name;
+        label += ": #";
+        label.resize(label.length() + 16);
+        for (size_t i = 1; i <= 16; ++i) {
+            label[label.length() - i] = HEX_DIGITS[valueHash & 0x0F];
+            valueHash >>= 4;
+        }
+        return label;
+    }
+
+    /**
+     * This function adds the candidates of the given tracked keys,
+     * with their labels, to the given collection.
+     *
+     * @param[in] topKeys
+     *     These are the tracked keys.
+     *
+     * @param[in,out] candidates
+     *     This is the collection of candidates, by key.
+     */
+    void AddCandidates(
+        const TopKeys& topKeys,
+        std::unordered_map< uint64_t, std::string >& candidates
+    ) {
+        for (const auto& entry : topKeys.GetEntries()) {
+            (void)candidates.emplace(entry.key, entry.label);
+        }
+    }
+
+    /**
+     * This function ranks the given candidates by their estimated
+     * counts and returns the most common ones.
+     *
+     * @param[in] candidates
+     *     These are the candidates, by key.
+     *
+     * @param[in] counts
+     *     These are the merged counts.
+     *
+     * @param[in] topCount
+     *     This is the number of entries to return.
+     *
+     * @return
+     *     The most common candidates are returned,
+     *     most common first.
+     */
+    std::vector< MessageHeaders::HeaderStatisticsEntry > Rank(
+        const std::unordered_map< uint64_t, std::string >& candidates,
+        const CountMinSketch& counts,
+        size_t topCount
+    ) {
+        std::vector< MessageHeaders::HeaderStatisticsEntry > entries;
+        entries.reserve(candidates.size());
+        for (const auto& candidate : candidates) {
+            MessageHeaders::HeaderStatisticsEntry entry;
+            entry.label = candidate.second;
+            entry.count = counts.Estimate(candidate.first);
+            entries.push_back(std::move(entry));
+        }
+        std::sort(
+            entries.begin(),
+            entries.end(),
+            [](
+                const MessageHeaders::HeaderStatisticsEntry& lhs,
+                const MessageHeaders::HeaderStatisticsEntry& rhs
+            ) {
+                if (lhs.count != rhs.count) {
+                    return lhs.count > rhs.count;
+                }
+                return lhs.label < rhs.label;
+            }
+        );
+        if (entries.size() > topCount) {
+            entries.resize(topCount);
+        }
+        return entries;
+    }
+}
+
+namespace MessageHeaders {
+    /**
+     * This contains the private properties of a
+     * HeaderStatistics instance.
+     */
+    struct HeaderStatistics::Impl {
+        /**
+         * These are the sketches among which
+         * recording threads are spread.
+         */
+        std::array< Sketch, SHARDS > sketches;
+
+        /**
+         * This is the number of the most common names,
+         * and of the most common values, to track.
+         */
+        size_t topCount = 0;
+
+        /**
+         * Values are counted for one in every this many messages,
+         * or not at all if this is zero.
+         */
+        size_t valueSampleInterval = 0;
+
+        /**
+         * If not null, common values are labelled with their text,
+         * except for headers this says are sensitive.
+         */
+        const RedactionPolicy* valueText = nullptr;
+
+        /**
+         * This method returns the sketch used
+         * by the calling thread.
+         *
+         * @return
+         *     The sketch used by the calling thread is returned.
+         */
+        Sketch& GetThreadSketch() {
+            const auto thread = std::hash< std::thread::id >()(std::this_thread::get_id());
+            return sketches[Mix64(thread) % SHARDS];
+        }
+    };
+
+    HeaderStatistics::~HeaderStatistics() = default;
+    HeaderStatistics::HeaderStatistics(HeaderStatistics&&) = default;
+    HeaderStatistics& HeaderStatistics::operator=(HeaderStatistics&&) = default;
+
+    HeaderStatistics::HeaderStatistics(
+        size_t topCount,
+        size_t valueSampleInterval,
+        const RedactionPolicy* valueText
+    )
+        : impl_(new Impl)
+    {
+        impl_->topCount = topCount;
+        impl_->valueSampleInterval = valueSampleInterval;
+        impl_->valueText = valueText;
+        for (auto& sketch : impl_->sketches) {
+            sketch.topNames.SetCapacity(topCount);
+            sketch.topValues.SetCapacity(topCount);
+        }
+    }
+
+    uint64_t HeaderStatistics::HashValue(std::string_view value) {
+        return (uint64_t)std::hash< std::string_view >()(value);
+    }
+
+    void HeaderStatistics::Record(const MessageHeaders& headers) {
+        auto& sketch = impl_->GetThreadSketch();
+        std::lock_guard< decltype(sketch.mutex) > lock(sketch.mutex);
+        ++sketch.messages;
+        bool sampleValues = false;
+        if (impl_->valueSampleInterval > 0) {
+            if (sketch.messagesUntilValueSample == 0) {
+                sampleValues = true;
+                sketch.messagesUntilValueSample = impl_->valueSampleInterval - 1;
+            } else {
+                --sketch.messagesUntilValueSample;
+            }
+        }
+        const auto count = headers.GetHeaderCount();
+        for (size_t index = 0; index < count; ++index) {
+            const auto& header = headers.GetHeader(index);
+            const auto nameHash = header.name.GetHash();
+            sketch.topNames.Offer(
+                nameHash,
+                sketch.names.Add(nameHash, 1),
+                [&header]{
+                    return static_cast< const std::string& >(header.name);
+                }
+            );
+            if (!sampleValues) {
+                continue;
+            }
+            const auto valueKey = ValueKey(nameHash, header.value);
+            sketch.topValues.Offer(
+                valueKey,
+                sketch.values.Add(valueKey, impl_->valueSampleInterval),
+                [this, &header]{
+                    const auto& name = static_cast< const std::string& >(header.name);
+                    if (
+                        (impl_->valueText == nullptr)
+                        || impl_->valueText->Covers(header.name)
+                    ) {
+                        return HashedValueLabel(name, header.value);
+                    }
+                    return name + ": " + header.value.substr(0, MAX_LABEL_VALUE_LENGTH);
+                }
+            );
+        }
+    }
+
+    void HeaderStatistics::Merge(const HeaderStatistics& other) {
+        if (&other == this) {
+            return;
+        }
+        for (size_t i = 0; i < SHARDS; ++i) {
+            auto& sketch = impl_->sketches[i];
+            const auto& otherSketch = other.impl_->sketches[i];
+            std::lock(sketch.mutex, otherSketch.mutex);
+            std::lock_guard< decltype(sketch.mutex) > lock(sketch.mutex, std::adopt_lock);
+            std::lock_guard< decltype(otherSketch.mutex) > otherLock(otherSketch.mutex, std::adopt_lock);
+            sketch.names.Merge(otherSketch.names);
+            sketch.values.Merge(otherSketch.values);
+            sketch.messages += otherSketch.messages;
+            for (const auto& entry : otherSketch.topNames.GetEntries()) {
+                sketch.topNames.Offer(
+                    entry.key,
+                    sketch.names.Estimate(entry.key),
+                    [&entry]{ return entry.label; }
+                );
+            }
+            for (const auto& entry : otherSketch.topValues.GetEntries()) {
+                sketch.topValues.Offer(
+                    entry.key,
+                    sketch.values.Estimate(entry.key),
+                    [&entry]{ return entry.label; }
+                );
+            }
+        }
+    }
+
+    uint64_t HeaderStatistics::EstimateNameCount(std::string_view name) const {
+        const auto nameHash = HashHeaderName(name);
+        uint64_t count = 0;
+        for (const auto& sketch : impl_->sketches) {
+            std::lock_guard< decltype(sketch.mutex) > lock(sketch.mutex);
+            count += sketch.names.Estimate(nameHash);
+        }
+        return count;
+    }
+
+    HeaderStatisticsSnapshot HeaderStatistics::GetSnapshot() const {
+        HeaderStatisticsSnapshot snapshot;
+        std::unique_ptr< CountMinSketch > names(new CountMinSketch());
+        std::unique_ptr< CountMinSketch > values(new CountMinSketch());
+        std::unordered_map< uint64_t, std::string > nameCandidates;
+        std::unordered_map< uint64_t, std::string > valueCandidates;
+        for (const auto& sketch : impl_->sketches) {
+            std::lock_guard< decltype(sketch.mutex) > lock(sketch.mutex);
+            snapshot.messages += sketch.messages;
+            names->Merge(sketch.names);
+            values->Merge(sketch.values);
+            AddCandidates(sketch.topNames, nameCandidates);
+            AddCandidates(sketch.topValues, valueCandidates);
+        }
+        snapshot.topNames = Rank(nameCandidates, *names, impl_->topCount);
+        snapshot.topValues = Rank(valueCandidates, *values, impl_->topCount);
+        return snapshot;
+    }
+
+    void HeaderStatistics::Reset() {
+        for (auto& sketch : impl_->sketches) {
+            std::lock_guard< decltype(sketch.mutex) > lock(sketch.mutex);
+            sketch.Clear();
+        }
+    }
+}
@@ -0,0 +1,517 @@
+/**
+ * @file HttpDate.cpp
+ *
+ * This module contains the implementation of the functions which
+ * convert between the date formats used in header values and
+ * points in time.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <MessageHeaders/HttpDate.hpp>
+
+namespace {
+    /**
+     * These are the earliest and latest points in time rendered as
+     * dates: the start of 1601, the earliest year cookie dates may
+     * have (RFC 6265 section 5.1.1), and the end of 9999, the latest
+     * year with four digits.
+     */
+    constexpr int64_t EARLIEST_RENDERED_TIME = -11644473600LL;
+    constexpr int64_t LATEST_RENDERED_TIME = 253402300799LL;
+
+    /**
+     * These are the abbreviated names of the days of the week,
+     * starting with Sunday.
+     */
+    constexpr const char* DAY_NAMES[] = {
+        "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+    };
+
+    /**
+     * These are the abbreviated names of the months of the year.
+     */
+    constexpr const char* MONTH_NAMES[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+
+    /**
+     * This is the length of an IMF-fixdate.
+     */
+    constexpr size_t IMF_FIXDATE_LENGTH = 29;
+
+    /**
+     * This function returns the number of days between the UNIX epoch
+     * and the given date of the proleptic Gregorian calendar.
+     *
+     * @param[in] year
+     *     This is the year of the date.
+     *
+     * @param[in] month
+     *     This is the month of the date, from 1 to 12.
+     *
+     * @param[in] day
+     *     This is the day of the month of the date, from 1 to 31.
+     *
+     * @return
+     *     The number of days since the epoch is returned.
+     */
+    int64_t DaysFromCivil(int64_t year, int month, int day) {
+        year -= (month <= 2) ? 1 : 0;
+        const int64_t era = ((year >= 0) ? year : (year - 399)) / 400;
+        const int64_t yearOfEra = year - era * 400;
+        const int64_t dayOfYear = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+        const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    /**
+     * This function returns the date of the proleptic Gregorian
+     * calendar which is the given number of days after the UNIX epoch.
+     *
+     * @param[in] days
+     *     This is the number of days since the epoch.
+     *
+     * @param[out] year
+     *     This is where to store the year of the date.
+     *
+     * @param[out] month
+     *     This is where to store the month of the date, from 1 to 12.
+     *
+     * @param[out] day
+     *     This is where to store the day of the month of the date.
+     */
+    void CivilFromDays(int64_t days, int64_t& year, int& month, int& day) {
+        days += 719468;
+        const int64_t era = ((days >= 0) ? days : (days - 146096)) / 146097;
+        const int64_t dayOfEra = days - era * 146097;
+        const int64_t yearOfEra = (
+            dayOfEra
+            - dayOfEra / 1460
+            + dayOfEra / 36524
+            - dayOfEra / 146096
+        ) / 365;
+        const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const int64_t monthPosition = (5 * dayOfYear + 2) / 153;
+        day = (int)(dayOfYear - (153 * monthPosition + 2) / 5 + 1);
+        month = (int)((monthPosition < 10) ? (monthPosition + 3) : (monthPosition - 9));
+        year = yearOfEra + era * 400 + ((month <= 2) ? 1 : 0);
+    }
+
+    /**
+     * This function returns the number of days in the given month.
+     *
+     * @param[in] year
+     *     This is the year containing the month.
+     *
+     * @param[in] month
+     *     This is the month, from 1 to 12.
+     *
+     * @return
+     *     The number of days in the month is returned.
+     */
+    int DaysInMonth(int64_t year, int month) {
+        static constexpr int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        if (
+            (month == 2)
+            && ((year % 4) == 0)
+            && (((year % 100) != 0) || ((year % 400) == 0))
+        ) {
+            return 29;
+        }
+        return DAYS[month - 1];
+    }
+
+    /**
+     * This function determines whether or not the given
+     * character is a decimal digit.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character
+     *     is a decimal digit is returned.
+     */
+    bool IsDigit(char c) {
+        return (c >= '0') && (c <= '9');
+    }
+
+    /**
+     * This function recognizes the abbreviated name of a month,
+     * ignoring case, at the beginning of the given text.
+     *
+     * @param[in] text
+     *     This is the text to check.
+     *
+     * @return
+     *     The month, from 1 to 12, is returned.
+     *
+     * @retval 0
+     *     This is returned if the text doesn't begin with a month name.
+     */
+    int FindMonth(std::string_view text) {
+        if (text.length() < 3) {
+            return 0;
+        }
+        const auto letters = (
+            (((unsigned)text[0] | 0x20) << 16)
+            | (((unsigned)text[1] | 0x20) << 8)
+            | ((unsigned)text[2] | 0x20)
+        );
+        for (int month = 0; month < 12; ++month) {
+            const auto name = MONTH_NAMES[month];
+            const auto nameLetters = (
+                (((unsigned)name[0] | 0x20) << 16)
+                | (((unsigned)name[1] | 0x20) << 8)
+                | ((unsigned)name[2] | 0x20)
+            );
+            if (letters == nameLetters) {
+                return month + 1;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * This function computes the point in time of the given date
+     * and time of day, after checking that they are valid.
+     *
+     * @param[in] year
+     *     This is the year of the date.
+     *
+     * @param[in] month
+     *     This is the month of the date, from 1 to 12.
+     *
+     * @param[in] day
+     *     This is the day of the month of the date.
+     *
+     * @param[in] hour
+     *     This is the hour of the time of day.
+     *
+     * @param[in] minute
+     *     This is the minute of the time of day.
+     *
+     * @param[in] second
+     *     This is the second of the time of day.
+     *
+     * @param[out] secondsSinceEpoch
+     *     This is where to store the point in time.
+     *
+     * @return
+     *     An indication of whether or not the date and time
+     *     of day are valid is returned.
+     */
+    bool MakeTime(
+        int64_t year,
+        int month,
+        int day,
+        int hour,
+        int minute,
+        int second,
+        int64_t& secondsSinceEpoch
+    ) {
+        if (
+            (month < 1)
+            || (month > 12)
+            || (day < 1)
+            || (day > DaysInMonth(year, month))
+            || (hour > 23)
+            || (minute > 59)
+            || (second > 59)
+        ) {
+            return false;
+        }
+        secondsSinceEpoch = (
+            DaysFromCivil(year, month, day) * 86400
+            + hour * 3600
+            + minute * 60
+            + second
+        );
+        return true;
+    }
+
+    /**
+     * This function recognizes an IMF-fixdate, such as
+     * "Sun, 06 Nov 1994 08:49:37 GMT", by looking at fixed positions.
+     *
+     * @param[in] date
+     *     This is the date to recognize.
+     *
+     * @param[out] secondsSinceEpoch
+     *     This is where to store the point in time of the date.
+     *
+     * @return
+     *     An indication of whether or not the date was
+     *     recognized is returned.
+     */
+    bool ParseImfFixdate(std::string_view date, int64_t& secondsSinceEpoch) {
+        if (
+            (date.length() != IMF_FIXDATE_LENGTH)
+            || (date[3] != ',')
+            || (date[4] != ' ')
+            || (date[7] != ' ')
+            || (date[11] != ' ')
+            || (date[16] != ' ')
+            || (date[19] != ':')
+            || (date[22] != ':')
+            || (date.substr(25) != " GMT")
+        ) {
+            return false;
+        }
+        static constexpr size_t DIGIT_POSITIONS[] = {5, 6, 12, 13, 14, 15, 17, 18, 20, 21, 23, 24};
+        for (auto position: DIGIT_POSITIONS) {
+            if (!IsDigit(date[position])) {
+                return false;
+            }
+        }
+        const auto TwoDigits = [date](size_t position) {
+            return (date[position] - '0') * 10 + (date[position + 1] - '0');
+        };
+        return MakeTime(
+            TwoDigits(12) * 100 + TwoDigits(14),
+            FindMonth(date.substr(8, 3)),
+            TwoDigits(5),
+            TwoDigits(17),
+            TwoDigits(20),
+            TwoDigits(23),
+            secondsSinceEpoch
+        );
+    }
+
+    /**
+     * This function determines whether or not the given character
+     * separates the tokens of a cookie date (RFC 6265 section 5.1.1).
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character
+     *     is a delimiter is returned.
+     */
+    bool IsCookieDateDelimiter(char c) {
+        return (
+            (c == '\t')
+            || ((c >= 0x20) && (c <= 0x2F))
+            || ((c >= 0x3B) && (c <= 0x40))
+            || ((c >= 0x5B) && (c <= 0x60))
+            || ((c >= 0x7B) && (c <= 0x7E))
+        );
+    }
+
+    /**
+     * This function reads a number, made of no fewer and no more
+     * than the given numbers of digits, from the given token.
+     *
+     * @param[in] token
+     *     This is the token from which to read the number.
+     *
+     * @param[in,out] offset
+     *     This is where to start reading.  It is advanced
+     *     past the digits.
+     *
+     * @param[in] minDigits
+     *     This is the least number of digits to accept.
+     *
+     * @param[in] maxDigits
+     *     This is the greatest number of digits to accept.
+     *
+     * @param[out] number
+     *     This is where to store the number.
+     *
+     * @return
+     *     An indication of whether or not a number was read is returned.
+     */
+    bool ReadDigits(
+        std::string_view token,
+        size_t& offset,
+        size_t minDigits,
+        size_t maxDigits,
+        int& number
+    ) {
+        number = 0;
+        size_t digits = 0;
+        while (
+            (offset < token.length())
+            && IsDigit(token[offset])
+        ) {
+            if (++digits > maxDigits) {
+                return false;
+            }
+            number = number * 10 + (token[offset++] - '0');
+        }
+        return (digits >= minDigits);
+    }
+
+    /**
+     * This function recognizes a date with the lenient algorithm
+     * for cookie dates in RFC 6265 section 5.1.1.
+     *
+     * @param[in] date
+     *     This is the date to recognize.
+     *
+     * @param[out] secondsSinceEpoch
+     *     This is where to store the point in time of the date.
+     *
+     * @return
+     *     An indication of whether or not the date was
+     *     recognized is returned.
+     */
+    bool ParseCookieDate(std::string_view date, int64_t& secondsSinceEpoch) {
+        bool foundTime = false;
+        bool foundDayOfMonth = false;
+        bool foundMonth = false;
+        bool foundYear = false;
+        int hour = 0, minute = 0, second = 0;
+        int dayOfMonth = 0, month = 0, year = 0;
+        size_t offset = 0;
+        while (offset < date.length()) {
+            while (
+                (offset < date.length())
+                && IsCookieDateDelimiter(date[offset])
+            ) {
+                ++offset;
+            }
+            const auto tokenStart = offset;
+            while (
+                (offset < date.length())
+                && !IsCookieDateDelimiter(date[offset])
+            ) {
+                ++offset;
+            }
+            const auto token = date.substr(tokenStart, offset - tokenStart);
+            if (token.empty()) {
+                break;
+            }
+            size_t position = 0;
+            int number = 0;
+            if (
+                !foundTime
+                && ReadDigits(token, position, 1, 2, hour)
+                && (position < token.length()) && (token[position++] == ':')
+                && ReadDigits(token, position, 1, 2, minute)
+                && (position < token.length()) && (token[position++] == ':')
+                && ReadDigits(token, position, 1, 2, second)
+            ) {
+                foundTime = true;
+                continue;
+            }
+            position = 0;
+            if (
+                !foundDayOfMonth
+                && ReadDigits(token, position, 1, 2, number)
+            ) {
+                foundDayOfMonth = true;
+                dayOfMonth = number;
+                continue;
+            }
+            if (!foundMonth) {
+                month = FindMonth(token);
+                if (month != 0) {
+                    foundMonth = true;
+                    continue;
+                }
+            }
+            position = 0;
+            if (
+                !foundYear
+                && ReadDigits(token, position, 2, 4, number)
+            ) {
+                foundYear = true;
+                year = number;
+                continue;
+            }
+        }
+        if (
+            !foundTime
+            || !foundDayOfMonth
+            || !foundMonth
+            || !foundYear
+        ) {
+            return false;
+        }
+        if ((year >= 70) && (year <= 99)) {
+            year += 1900;
+        } else if (year <= 69) {
+            year += 2000;
+        }
+        if (year < 1601) {
+            return false;
+        }
+        return MakeTime(year, month, dayOfMonth, hour, minute, second, secondsSinceEpoch);
+    }
+
+    /**
+     * This function appends the given number to the given string,
+     * padded with zeroes to the given number of digits.
+     *
+     * @param[in] number
+     *     This is the number to append.
+     *
+     * @param[in] digits
+     *     This is the number of digits to append.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append the number.
+     */
+    void AppendDigits(int64_t number, size_t digits, std::string& output) {
+        output.resize(output.length() + digits);
+        for (size_t i = 1; i <= digits; ++i) {
+            output[output.length() - i] = (char)('0' + number % 10);
+            number /= 10;
+        }
+    }
+}
+
+namespace MessageHeaders {
+    bool ParseHttpDate(std::string_view date, int64_t& secondsSinceEpoch) {
+        return (
+            ParseImfFixdate(date, secondsSinceEpoch)
+            || ParseCookieDate(date, secondsSinceEpoch)
+        );
+    }
+
+    void AppendHttpDate(int64_t secondsSinceEpoch, std::string& output) {
+        if (secondsSinceEpoch < EARLIEST_RENDERED_TIME) {
+            secondsSinceEpoch = EARLIEST_RENDERED_TIME;
+        } else if (secondsSinceEpoch > LATEST_RENDERED_TIME) {
+            secondsSinceEpoch = LATEST_RENDERED_TIME;
+        }
+        auto days = secondsSinceEpoch / 86400;
+        auto secondOfDay = secondsSinceEpoch % 86400;
+        if (secondOfDay < 0) {
+            secondOfDay += 86400;
+            --days;
+        }
+        int64_t year;
+        int month, day;
+        CivilFromDays(days, year, month, day);
+        auto weekday = (days + 4) % 7;
+        if (weekday < 0) {
+            weekday += 7;
+        }
+        output.reserve(output.length() + IMF_FIXDATE_LENGTH);
+        output += DAY_NAMES[weekday];
+        output += ", ";
+        AppendDigits(day, 2, output);
+        output += ' ';
+        output += MONTH_NAMES[month - 1];
+        output += ' ';
+        AppendDigits(year, 4, output);
+        output += ' ';
+        AppendDigits(secondOfDay / 3600, 2, output);
+        output += ':';
+        AppendDigits(secondOfDay / 60 % 60, 2, output);
+        output += ':';
+        AppendDigits(secondOfDay % 60, 2, output);
+        output += " GMT";
+    }
+
+    std::string FormatHttpDate(int64_t secondsSinceEpoch) {
+        std::string output;
+        AppendHttpDate(secondsSinceEpoch, output);
+        return output;
+    }
+}
@@ -0,0 +1,223 @@
+/**
+ * @file Json.cpp
+ *
+ * This module contains the implementation of the helper
+ * functions used to export message headers as JSON.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <MessageHeaders/Json.hpp>
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define MESSAGE_HEADERS_JSON_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    /**
+     * These are the digits used to write characters in hexadecimal.
+     */
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    /**
+     * This function determines whether or not the given character
+     * must be escaped within a JSON string.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character
+     *     must be escaped is returned.
+     */
+    bool NeedsEscape(char c) {
+        return (
+            ((unsigned char)c < 0x20)
+            || (c == '"')
+            || (c == '\\')
+        );
+    }
+
+    /**
+     * This function determines whether or not the given character
+     * isn't ASCII, and so must be checked to be part of a valid
+     * UTF-8 sequence.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character
+     *     isn't ASCII is returned.
+     */
+    bool IsNonAscii(char c) {
+        return ((unsigned char)c >= 0x80);
+    }
+
+    /**
+     * This function finds the first character in the given text
+     * which must be escaped within a JSON string, or which isn't
+     * ASCII.
+     *
+     * @param[in] text
+     *     This is the text to search.
+     *
+     * @return
+     *     The position of the first character which must be
+     *     escaped or isn't ASCII, or the length of the text if
+     *     there is none, is returned.
+     */
+    size_t FindEscape(std::string_view text) {
+        size_t i = 0;
+#ifdef MESSAGE_HEADERS_JSON_SSE2
+        const auto highestControl = _mm_set1_epi8(0x1F);
+        const auto quote = _mm_set1_epi8('"');
+        const auto backslash = _mm_set1_epi8('\\');
+        for (; i + sizeof(__m128i) <= text.length(); i += sizeof(__m128i)) {
+            const auto chunk = _mm_loadu_si128((const __m128i*)(text.data() + i));
+
+            // A byte is a control character if the unsigned maximum
+            // of it and 0x1F is 0x1F.
+            const auto isControl = _mm_cmpeq_epi8(_mm_max_epu8(chunk, highestControl), highestControl);
+            const auto needsEscape = _mm_or_si128(
+                isControl,
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, quote),
+                    _mm_cmpeq_epi8(chunk, backslash)
+                )
+            );
+            // The sign bits of the bytes mark those which aren't ASCII.
+            const auto mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(needsEscape, chunk));
+            if (mask != 0) {
+                unsigned int offset = 0;
+                while ((mask & (1u << offset)) == 0) {
+                    ++offset;
+                }
+                return i + offset;
+            }
+        }
+#endif
+        for (; i < text.length(); ++i) {
+            if (
+                NeedsEscape(text[i])
+                || IsNonAscii(text[i])
+            ) {
+                break;
+            }
+        }
+        return i;
+    }
+
+    /**
+     * This function measures the valid UTF-8 sequence, if any,
+     * at the start of the given text, which starts with a
+     * character that isn't ASCII.  Overlong forms, surrogates,
+     * and code points past U+10FFFF aren't valid.
+     *
+     * @param[in] text
+     *     This is the text to check.
+     *
+     * @return
+     *     The length of the valid sequence at the start of the
+     *     text, or zero if there isn't one, is returned.
+     */
+    size_t GetUtf8SequenceLength(std::string_view text) {
+        const auto lead = (unsigned char)text[0];
+        size_t length;
+        unsigned char secondMin = 0x80;
+        unsigned char secondMax = 0xBF;
+        if ((lead >= 0xC2) && (lead <= 0xDF)) {
+            length = 2;
+        } else if ((lead >= 0xE0) && (lead <= 0xEF)) {
+            length = 3;
+            if (lead == 0xE0) {
+                secondMin = 0xA0;
+            } else if (lead == 0xED) {
+                secondMax = 0x9F;
+            }
+        } else if ((lead >= 0xF0) && (lead <= 0xF4)) {
+            length = 4;
+            if (lead == 0xF0) {
+                secondMin = 0x90;
+            } else if (lead == 0xF4) {
+                secondMax = 0x8F;
+            }
+        } else {
+            return 0;
+        }
+        if (text.length() < length) {
+            return 0;
+        }
+        const auto second = (unsigned char)text[1];
+        if (
+            (second < secondMin)
+            || (second > secondMax)
+        ) {
+            return 0;
+        }
+        for (size_t i = 2; i < length; ++i) {
+            const auto continuation = (unsigned char)text[i];
+            if (
+                (continuation < 0x80)
+                || (continuation > 0xBF)
+            ) {
+                return 0;
+            }
+        }
+        return length;
+    }
+
+    /**
+     * This function appends the escaped form of the given character,
+     * which needs escaping, to the given string.
+     *
+     * @param[in] c
+     *     This is the character to escape.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append the escaped character.
+     */
+    void AppendEscape(char c, std::string& output) {
+        switch (c) {
+            case '"': output += "\\\""; return;
+            case '\\': output += "\\\\"; return;
+            case '\b': output += "\\b"; return;
+            case '\f': output += "\\f"; return;
+            case '\n': output += "\\n"; return;
+            case '\r': output += "\\r"; return;
+            case '\t': output += "\\t"; return;
+            default: break;
+        }
+        output += "\\u00";
+        output += HEX_DIGITS[(unsigned char)c >> 4];
+        output += HEX_DIGITS[(unsigned char)c & 0x0F];
+    }
+}
+
+namespace MessageHeaders {
+    void AppendJsonEscaped(std::string_view text, std::string& output) {
+        while (!text.empty()) {
+            const auto run = FindEscape(text);
+            output.append(text.data(), run);
+            if (run == text.length()) {
+                break;
+            }
+            text.remove_prefix(run);
+            if (IsNonAscii(text[0])) {
+                const auto sequenceLength = GetUtf8SequenceLength(text);
+                if (sequenceLength == 0) {
+                    output += "\\ufffd";
+                    text.remove_prefix(1);
+                } else {
+                    output.append(text.data(), sequenceLength);
+                    text.remove_prefix(sequenceLength);
+                }
+            } else {
+                AppendEscape(text[0], output);
+                text.remove_prefix(1);
+            }
+        }
+    }
+}
@@ -0,0 +1,264 @@
+/**
+ * @file KeyExtractor.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::KeyExtractor class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <array>
+#include <MessageHeaders/KeyExtractor.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+#include <string.h>
+#include <string_view>
+
+namespace {
+    /**
+     * This is fed to the hash in place of the value of
+     * a header which the message lacks.
+     */
+    constexpr char ABSENT = 0;
+
+    /**
+     * This is fed to the hash ahead of the value of
+     * a header which the message has.
+     */
+    constexpr char PRESENT = 1;
+
+    /**
+     * This function scrambles the bits of the given number
+     * (the finalizer of SplitMix64).
+     *
+     * @param[in] x
+     *     This is the number to scramble.
+     *
+     * @return
+     *     The scrambled number is returned.
+     */
+    uint64_t Mix64(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    /**
+     * This computes a hash of bytes fed to it a piece at a time,
+     * gathering them into words, eight bytes at a time.
+     */
+    class IncrementalHash {
+        // Public Methods
+    public:
+        /**
+         * This method feeds the given bytes to the hash.
+         *
+         * @param[in] bytes
+         *     These are the bytes to feed.
+         *
+         * @param[in] lowercase
+         *     This indicates whether or not to feed uppercase
+         *     letters as lowercase.
+         */
+        void Feed(std::string_view bytes, bool lowercase) {
+            for (auto c : bytes) {
+                if (
+                    lowercase
+                    && (c >= 'A')
+                    && (c <= 'Z')
+                ) {
+                    c += 'a' - 'A';
+                }
+                word_[filled_++] = c;
+                if (filled_ == word_.size()) {
+                    Flush();
+                }
+            }
+            length_ += bytes.length();
+        }
+
+        /**
+         * This method finishes the hash.
+         *
+         * @return
+         *     The hash of the bytes fed is returned.
+         */
+        uint64_t Finish() {
+            if (filled_ > 0) {
+                Flush();
+            }
+            return Mix64(state_ ^ length_);
+        }
+
+        // Private Methods
+    private:
+        /**
+         * This method mixes the gathered bytes into the hash.
+         */
+        void Flush() {
+            uint64_t word = 0;
+            (void)memcpy(&word, word_.data(), filled_);
+            state_ = Mix64(state_ ^ word);
+            filled_ = 0;
+        }
+
+        // Private properties
+    private:
+        /**
+         * This is the hash of the words mixed in so far.
+         */
+        uint64_t state_ = 0x9E3779B97F4A7C15ULL;
+
+        /**
+         * These are the bytes gathered but not yet mixed in.
+         */
+        std::array< char, sizeof(uint64_t) > word_;
+
+        /**
+         * This is the number of bytes gathered but not yet mixed in.
+         */
+        size_t filled_ = 0;
+
+        /**
+         * This is the number of bytes fed so far.
+         */
+        uint64_t length_ = 0;
+    };
+
+    /**
+     * This function removes whitespace from either end
+     * of the given string.
+     *
+     * @param[in] s
+     *     This is the string to trim.
+     *
+     * @return
+     *     The trimmed string is returned.
+     */
+    std::string_view Trim(std::string_view s) {
+        while (
+            !s.empty()
+            && ((s.front() == ' ') || (s.front() == '\t'))
+        ) {
+            s.remove_prefix(1);
+        }
+        while (
+            !s.empty()
+            && ((s.back() == ' ') || (s.back() == '\t'))
+        ) {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    /**
+     * This function normalizes the given header value as
+     * directed by the given key component.
+     *
+     * @param[in] value
+     *     This is the header value to normalize.
+     *
+     * @param[in] component
+     *     This describes how to normalize the value.
+     *
+     * @return
+     *     The normalized value, apart from any change of case,
+     *     is returned.
+     */
+    std::string_view Normalize(
+        std::string_view value,
+        const MessageHeaders::KeyComponent& component
+    ) {
+        if (component.firstMember) {
+            value = value.substr(0, value.find(','));
+        }
+        value = Trim(value);
+        if (component.credentialsOnly) {
+            const auto delimiter = value.find(' ');
+            if (delimiter != std::string_view::npos) {
+                value = Trim(value.substr(delimiter + 1));
+            }
+        }
+        return value;
+    }
+}
+
+namespace MessageHeaders {
+    KeyExtractor::KeyExtractor(const std::vector< KeyComponent >& components)
+        : components_(components)
+    {
+        nameHashes_.reserve(components_.size());
+        for (const auto& component : components_) {
+            nameHashes_.push_back(HashHeaderName(component.name));
+        }
+    }
+
+    bool KeyExtractor::IsValid() const {
+        return (
+            !components_.empty()
+            && (components_.size() <= MAX_COMPONENTS)
+        );
+    }
+
+    uint64_t KeyExtractor::GetKey(const MessageHeaders& headers) const {
+        // Find the first instance of each header in one pass.
+        const auto count = headers.GetHeaderCount();
+        const auto componentCount = std::min(components_.size(), MAX_COMPONENTS);
+        std::array< size_t, MAX_COMPONENTS > indexes;
+        indexes.fill(count);
+        size_t remaining = componentCount;
+        for (size_t index = 0; (index < count) && (remaining > 0); ++index) {
+            const auto& name = headers.GetHeader(index).name;
+            const auto nameHash = name.GetHash();
+            for (size_t i = 0; i < componentCount; ++i) {
+                if (
+                    (indexes[i] == count)
+                    && (nameHashes_[i] == nameHash)
+                    && HeaderNamesEqual(static_cast< const std::string& >(name), components_[i].name)
+                ) {
+                    indexes[i] = index;
+                    --remaining;
+                }
+            }
+        }
+
+        // Feed the normalized values to the hash, each preceded by
+        // its length so that values can't run into each other.
+        IncrementalHash hash;
+        for (size_t i = 0; i < componentCount; ++i) {
+            if (indexes[i] == count) {
+                hash.Feed(std::string_view(&ABSENT, 1), false);
+                continue;
+            }
+            const auto value = Normalize(headers.GetHeader(indexes[i]).value, components_[i]);
+            const uint64_t length = value.length();
+            char lengthBytes[sizeof(length)];
+            (void)memcpy(lengthBytes, &length, sizeof(length));
+            hash.Feed(std::string_view(&PRESENT, 1), false);
+            hash.Feed(std::string_view(lengthBytes, sizeof(lengthBytes)), false);
+            hash.Feed(value, components_[i].lowercase);
+        }
+        return hash.Finish();
+    }
+
+    uint32_t KeyExtractor::GetShard(const MessageHeaders& headers, uint32_t shardCount) const {
+        return JumpConsistentHash(GetKey(headers), shardCount);
+    }
+
+    uint32_t JumpConsistentHash(uint64_t key, uint32_t bucketCount) {
+        int64_t bucket = -1;
+        int64_t next = 0;
+        while (next < (int64_t)bucketCount) {
+            bucket = next;
+            key = key * 2862933555777941757ULL + 1;
+            next = (int64_t)(
+                (double)(bucket + 1)
+                * ((double)(1LL << 31) / (double)((key >> 33) + 1))
+            );
+        }
+        return (uint32_t)bucket;
+    }
+}
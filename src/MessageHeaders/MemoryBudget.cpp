@@ -0,0 +1,254 @@
+/**
+ * @file MemoryBudget.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::MemoryBudget class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <MessageHeaders/MemoryBudget.hpp>
+#include <vector>
+
+namespace {
+    /**
+     * This is the identifier to give the next budget made.
+     * Identifiers are never reused, unlike addresses, so a thread
+     * can't mistake a new budget for an old one.
+     */
+    std::atomic< uint64_t > nextBudgetId{1};
+
+    /**
+     * This is what a thread has taken from one budget
+     * but not yet charged.
+     */
+    struct ThreadCredit {
+        /**
+         * This identifies the budget.
+         */
+        uint64_t budgetId = 0;
+
+        /**
+         * This is the number of bytes taken from the budget.  It's
+         * shared with the budget, so that credit can be given back
+         * even if the thread outlives the budget.
+         */
+        std::shared_ptr< std::atomic< size_t > > used;
+
+        /**
+         * This is the number of bytes the thread has taken from
+         * the budget but not yet charged.
+         */
+        size_t credit = 0;
+    };
+
+    /**
+     * These are what a thread has taken from budgets but not yet
+     * charged.  When the thread exits, the credit goes back to the
+     * budgets, so that no other thread is kept from using it.
+     */
+    struct ThreadCredits {
+        /**
+         * These are the credits, one per budget the thread has used.
+         */
+        std::vector< ThreadCredit > credits;
+
+        /**
+         * This is the position of the credit last used.
+         */
+        size_t lastIndex = 0;
+
+        ~ThreadCredits() {
+            for (const auto& credit : credits) {
+                credit.used->fetch_sub(credit.credit, std::memory_order_relaxed);
+            }
+        }
+    };
+}
+
+namespace MessageHeaders {
+    /**
+     * This contains the private properties of a
+     * MemoryBudget instance.
+     */
+    struct MemoryBudget::Impl {
+        /**
+         * This identifies the budget.
+         */
+        uint64_t id = nextBudgetId.fetch_add(1, std::memory_order_relaxed);
+
+        /**
+         * This is the number of bytes in the budget.
+         */
+        size_t limit = 0;
+
+        /**
+         * This is the number of bytes each thread takes
+         * from the budget at a time.
+         */
+        size_t chunkSize = 0;
+
+        /**
+         * This is the number of bytes taken from the budget,
+         * including credit held by threads.
+         */
+        std::shared_ptr< std::atomic< size_t > > used = std::make_shared< std::atomic< size_t > >(0);
+
+        /**
+         * This is the number of charges refused.
+         */
+        std::atomic< uint64_t > refused{0};
+
+        /**
+         * This method returns the number of bytes the calling thread
+         * has taken from the budget but not yet charged.
+         *
+         * @return
+         *     The calling thread's credit is returned.
+         */
+        size_t& GetThreadCredit() {
+            thread_local ThreadCredits threadCredits;
+            auto& credits = threadCredits.credits;
+            if (
+                (threadCredits.lastIndex < credits.size())
+                && (credits[threadCredits.lastIndex].budgetId == id)
+            ) {
+                return credits[threadCredits.lastIndex].credit;
+            }
+            for (size_t i = 0; i < credits.size(); ++i) {
+                if (credits[i].budgetId == id) {
+                    threadCredits.lastIndex = i;
+                    return credits[i].credit;
+                }
+            }
+
+            // Forget budgets which are gone before
+            // remembering this one.
+            credits.erase(
+                std::remove_if(
+                    credits.begin(),
+                    credits.end(),
+                    [](const ThreadCredit& credit) {
+                        return credit.used.use_count() == 1;
+                    }
+                ),
+                credits.end()
+            );
+            ThreadCredit credit;
+            credit.budgetId = id;
+            credit.used = used;
+            credits.push_back(std::move(credit));
+            threadCredits.lastIndex = credits.size() - 1;
+            return credits.back().credit;
+        }
+
+        /**
+         * This method takes the given number of bytes from the
+         * budget, unless that would go over it.
+         *
+         * @param[in] bytes
+         *     This is the number of bytes to take.
+         *
+         * @return
+         *     An indication of whether or not the bytes
+         *     were taken is returned.
+         */
+        bool Take(size_t bytes) {
+            auto current = used->load(std::memory_order_relaxed);
+            do {
+                if (
+                    (bytes > limit)
+                    || (current > limit - bytes)
+                ) {
+                    return false;
+                }
+            } while (
+                !used->compare_exchange_weak(
+                    current,
+                    current + bytes,
+                    std::memory_order_relaxed
+                )
+            );
+            return true;
+        }
+    };
+
+    MemoryBudget::~MemoryBudget() = default;
+    MemoryBudget::MemoryBudget(MemoryBudget&&) = default;
+    MemoryBudget& MemoryBudget::operator=(MemoryBudget&&) = default;
+
+    MemoryBudget::MemoryBudget(size_t limit, size_t chunkSize)
+        : impl_(new Impl)
+    {
+        impl_->limit = limit;
+        impl_->chunkSize = chunkSize;
+    }
+
+    bool MemoryBudget::TryCharge(size_t bytes) {
+        if (impl_->chunkSize == 0) {
+            if (impl_->Take(bytes)) {
+                return true;
+            }
+            impl_->refused.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        auto& credit = impl_->GetThreadCredit();
+        if (credit >= bytes) {
+            credit -= bytes;
+            return true;
+        }
+        const auto needed = bytes - credit;
+        const auto chunk = std::max(needed, impl_->chunkSize);
+        if (impl_->Take(chunk)) {
+            credit = chunk - needed;
+            return true;
+        }
+        if (impl_->Take(needed)) {
+            credit = 0;
+            return true;
+        }
+        impl_->refused.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void MemoryBudget::Charge(size_t bytes) {
+        if (impl_->chunkSize == 0) {
+            impl_->used->fetch_add(bytes, std::memory_order_relaxed);
+            return;
+        }
+        auto& credit = impl_->GetThreadCredit();
+        if (credit >= bytes) {
+            credit -= bytes;
+        } else {
+            impl_->used->fetch_add(bytes - credit, std::memory_order_relaxed);
+            credit = 0;
+        }
+    }
+
+    void MemoryBudget::Release(size_t bytes) {
+        if (impl_->chunkSize == 0) {
+            impl_->used->fetch_sub(bytes, std::memory_order_relaxed);
+            return;
+        }
+        auto& credit = impl_->GetThreadCredit();
+        credit += bytes;
+        if (credit > 2 * impl_->chunkSize) {
+            impl_->used->fetch_sub(credit - impl_->chunkSize, std::memory_order_relaxed);
+            credit = impl_->chunkSize;
+        }
+    }
+
+    size_t MemoryBudget::GetLimit() const {
+        return impl_->limit;
+    }
+
+    size_t MemoryBudget::GetUsed() const {
+        return impl_->used->load(std::memory_order_relaxed);
+    }
+
+    uint64_t MemoryBudget::GetRefusedCount() const {
+        return impl_->refused.load(std::memory_order_relaxed);
+    }
+}
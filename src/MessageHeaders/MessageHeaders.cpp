@@ -6,10 +6,24 @@
  * 2019 by YaMing Wu
  */
 
+#include <algorithm>
+#include <array>
 #include <ctype.h>
+#include <exception>
 #include <functional>
+#include <MessageHeaders/HeaderSizeAccounting.hpp>
+#include <MessageHeaders/HeaderStatistics.hpp>
+#include <MessageHeaders/MemoryBudget.hpp>
 #include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/RedactionPolicy.hpp>
+#include <MessageHeaders/SamplingProfiler.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+#include "Probes.hpp"
 #include <sstream>
+#include <string.h>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 
 namespace {
     /**
@@ -24,24 +38,234 @@ namespace {
     const std::string CRLF = "\r\n";
 
     /**
-     * This function returns a copy of the given string with any
-     * whitespace at the beginning and end stripped off.
+     * These are the odd constants with which the name hash and
+     * ordinal of a header are spread out before they're combined
+     * into the header's part of the semantic hash.
+     */
+    constexpr uint64_t SEMANTIC_NAME_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+    constexpr uint64_t SEMANTIC_ORDINAL_MULTIPLIER = 0xC2B2AE3D27D4EB4FULL;
+
+    /**
+     * This is the largest number of headers for which the semantic
+     * hash is computed by comparing every pair of headers, rather
+     * than by sorting them by name.
+     */
+    constexpr size_t SEMANTIC_HASH_PAIRWISE_LIMIT = 32;
+
+    /**
+     * This is the largest number of headers grouped by name on the
+     * stack, without allocating, when exported as JSON.
+     */
+    constexpr size_t JSON_STACK_GROUPING_LIMIT = 64;
+
+    /**
+     * This is the odd constant by which a fingerprint is multiplied
+     * before the next header is added to it.
+     */
+    constexpr uint64_t FINGERPRINT_MULTIPLIER = 0x100000001B3ULL;
+
+    /**
+     * These are the ways in which a header name may be capitalized,
+     * as recorded in a fingerprint.
+     */
+    enum class NameCasing : uint64_t {
+        Lower,
+        Canonical,
+        Upper,
+        Mixed,
+    };
+
+    /**
+     * This function scrambles the bits of the given number
+     * (the finalizer of SplitMix64).
      *
-     * @param[in] s
-     *      This is the string to strip.
+     * @param[in] x
+     *     This is the number to scramble.
+     *
+     * @return
+     *     The scrambled number is returned.
+     */
+    uint64_t Mix64(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    /**
+     * This function computes a hash of the given header value,
+     * eight bytes at a time.
+     *
+     * @param[in] value
+     *     This is the header value to hash.
      *
      * @return
-     *      The stripped string is returned.
+     *     The hash of the header value is returned.
      */
-    std::string StripMarginWhitespace(const std::string& s) {
-        const auto marginLeft = s.find_first_not_of(WSP);
-        const auto marginRight = s.find_last_not_of(WSP);
-        if (marginLeft == std::string::npos) {
-            return "";
+    uint64_t HashHeaderValue(const std::string& value) {
+        uint64_t hash = Mix64(value.length());
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= value.length(); i += sizeof(uint64_t)) {
+            uint64_t word;
+            (void)memcpy(&word, value.data() + i, sizeof(word));
+            hash = Mix64(hash ^ word);
         }
-        else {
-            return s.substr(marginLeft, marginRight - marginLeft + 1);
+        if (i < value.length()) {
+            uint64_t word = 0;
+            (void)memcpy(&word, value.data() + i, value.length() - i);
+            hash = Mix64(hash ^ word);
+        }
+        return hash;
+    }
+
+    /**
+     * This function returns the positions of the given headers,
+     * sorted by name hash, then by name (ignoring case) should
+     * different names share a hash, then by position.  Headers
+     * sharing a name are thus together, in the order they appear,
+     * so the position of each within its group is its ordinal.
+     *
+     * @param[in] headers
+     *     These are the headers to sort.
+     *
+     * @return
+     *     The positions of the headers, sorted, are returned.
+     */
+    std::vector< size_t > SortHeadersByName(const MessageHeaders::MessageHeaders& headers) {
+        std::vector< size_t > order(headers.GetHeaderCount());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(
+            order.begin(),
+            order.end(),
+            [&headers](size_t lhs, size_t rhs) {
+                const auto& lhsName = headers.GetHeader(lhs).name;
+                const auto& rhsName = headers.GetHeader(rhs).name;
+                if (lhsName.GetHash() != rhsName.GetHash()) {
+                    return (lhsName.GetHash() < rhsName.GetHash());
+                }
+                const auto& lhsText = static_cast< const std::string& >(lhsName);
+                const auto& rhsText = static_cast< const std::string& >(rhsName);
+                const auto lexical = std::lexicographical_compare(
+                    lhsText.begin(), lhsText.end(),
+                    rhsText.begin(), rhsText.end(),
+                    [](char a, char b) {
+                        return (tolower(a) < tolower(b));
+                    }
+                );
+                if (lexical) {
+                    return true;
+                }
+                if (!(lhsName == rhsName)) {
+                    return false;
+                }
+                return (lhs < rhs);
+            }
+        );
+        return order;
+    }
+
+    /**
+     * This function computes the part of a fingerprint contributed
+     * by a header with the given name.  The name is hashed in the
+     * same pass which recognizes its capitalization.
+     *
+     * @param[in] name
+     *     This is the name of the header, as it appeared.
+     *
+     * @return
+     *     The part of a fingerprint contributed by the header
+     *     is returned.
+     */
+    uint64_t FingerprintHeaderName(std::string_view name) {
+        uint64_t hash = MessageHeaders::HashHeaderName("");
+        bool sawLower = false;
+        bool sawUpper = false;
+        bool canonical = true;
+        bool wordStart = true;
+        for (auto c : name) {
+            if ((c >= 'A') && (c <= 'Z')) {
+                sawUpper = true;
+                canonical = canonical && wordStart;
+                c += 'a' - 'A';
+            } else if ((c >= 'a') && (c <= 'z')) {
+                sawLower = true;
+                canonical = canonical && !wordStart;
+            }
+            wordStart = (c == '-');
+            hash ^= (unsigned char)c;
+            hash *= 1099511628211ULL;
         }
+        NameCasing casing;
+        if (!sawUpper) {
+            casing = NameCasing::Lower;
+        } else if (canonical) {
+            casing = NameCasing::Canonical;
+        } else if (!sawLower) {
+            casing = NameCasing::Upper;
+        } else {
+            casing = NameCasing::Mixed;
+        }
+        const auto wellKnownHeader = MessageHeaders::FindWellKnownHeader(name, hash);
+        const uint64_t identity = (
+            (wellKnownHeader == MessageHeaders::WellKnownHeader::Unknown)
+            ? hash
+            : (uint64_t)wellKnownHeader
+        );
+        return Mix64((identity << 2) | (uint64_t)casing);
+    }
+
+    /**
+     * This function raises the fingerprint multiplier
+     * to the given power.
+     *
+     * @param[in] exponent
+     *     This is the power to which to raise the multiplier.
+     *
+     * @return
+     *     The multiplier raised to the given power is returned.
+     */
+    uint64_t FingerprintScale(size_t exponent) {
+        uint64_t result = 1;
+        uint64_t base = FINGERPRINT_MULTIPLIER;
+        while (exponent > 0) {
+            if ((exponent & 1) != 0) {
+                result *= base;
+            }
+            base *= base;
+            exponent >>= 1;
+        }
+        return result;
+    }
+
+    /**
+     * This function computes the part of the semantic hash
+     * contributed by a single header.  The parts of all the
+     * headers are added up, so that the order of the headers
+     * doesn't matter, except as captured by their ordinals.
+     *
+     * @param[in] nameHash
+     *     This is the hash of the name of the header.
+     *
+     * @param[in] value
+     *     This is the value of the header.
+     *
+     * @param[in] ordinal
+     *     This is the number of headers with the same name
+     *     which come before the header.
+     *
+     * @return
+     *     The part of the semantic hash contributed
+     *     by the header is returned.
+     */
+    uint64_t SemanticTerm(uint64_t nameHash, const std::string& value, size_t ordinal) {
+        return Mix64(
+            nameHash * SEMANTIC_NAME_MULTIPLIER
+            + Mix64(HashHeaderValue(value) + (ordinal + 1) * SEMANTIC_ORDINAL_MULTIPLIER)
+        );
     }
 
     /**
@@ -97,25 +321,6 @@ namespace {
         return composite;
     }
 
-    /**
-     * This function determines whether or not the given character
-     * is an invisible ASCII character (e.g. space or control character).
-     *
-     * @param[in] c
-     *     This is the character to test.
-     *
-     * @return
-     *     An indication of whether or not the given character is an
-     *     invisible ASCII character (e.g. space or control character)
-     *     is returned.
-     */
-    bool IsInvisibleAscii(char c) {
-        return (
-            (c < 33) ||
-            (c > 126)
-            );
-    }
-
     /**
      * This is the type of function that is used as the strategy to
      * determine where to break a long string into two smaller strings.
@@ -206,178 +411,1058 @@ namespace {
     }
 
     /**
-     * This method takes a substring in a raw internet message
-     * corresponding to a single header line, determines where
-     * the name and value of the header are, and extracts them.
-     *
-     * @param[in] rawMessage
-     *     This is the string containing the header line.
+     * This function returns the number of bytes charged to a memory
+     * budget for storing a header with a name and value of the
+     * given lengths.
      *
-     * @paraam[in] lineStart
-     *     This is the offset into rawMessage where the header
-     *     line begins.
+     * @param[in] nameLength
+     *     This is the length of the header name.
      *
-     * @param[in] lineEnd
-     *     This is the offset into rawMessage where the header
-     *     line ends.
-     *
-     * @param[out] name
-     *     This is where to store the extracted header name.
-     *
-     * @param[out] value
-     *     This is where to store the extracted header value.
+     * @param[in] valueLength
+     *     This is the length of the header value.
      *
      * @return
-     *     An indication of whether or not the header name and
-     *     value were extracted successfully is returned.
+     *     The number of bytes to charge is returned.
      */
-    bool SeparateHeaderNameAndValue(
-        const std::string& rawMessage,
-        size_t lineStart,
-        size_t lineEnd,
-        MessageHeaders::MessageHeaders::HeaderName& name,
-        MessageHeaders::MessageHeaders::HeaderValue& value
-    ) {
-        auto nameValueDelimiter = rawMessage.find(':', lineStart);
-        if (nameValueDelimiter == std::string::npos) {
-            return false;
-        }
+    size_t HeaderStorageCost(size_t nameLength, size_t valueLength) {
+        return sizeof(MessageHeaders::MessageHeaders::Header) + nameLength + valueLength;
+    }
 
-        name = rawMessage.substr(lineStart, nameValueDelimiter - lineStart);
-        for (auto c : name) {
-            if (IsInvisibleAscii(c)) {
-                return false;
-            }
-        }
+}
+
+namespace MessageHeaders {
+    MessageHeaders::HeaderName::HeaderName(const std::string& s)
+        : name_(s)
+        , hash_(HashHeaderName(name_))
+    {
+    }
 
-        value = rawMessage.substr(
-            nameValueDelimiter + 1,
-            lineEnd - nameValueDelimiter - 1
+    bool MessageHeaders::HeaderName::operator==(const HeaderName& rhs) const noexcept {
+        return (
+            (hash_ == rhs.hash_)
+            && HeaderNamesEqual(name_, rhs.name_)
         );
+    }
+
+    MessageHeaders::HeaderName::operator const std::string&() const noexcept {
+        return name_;
+    }
+
+    uint64_t MessageHeaders::HeaderName::GetHash() const noexcept {
+        return hash_;
+    }
+
+    std::string::const_iterator MessageHeaders::HeaderName::begin() const {
+        return name_.begin();
+    }
+
+    std::string::const_iterator MessageHeaders::HeaderName::end() const {
+        return name_.end();
+    }
+
+    MessageHeaders::Header::Header(
+        const HeaderName& newName,
+        const HeaderValue& newValue
+    ) : name(newName), value(newValue)
+    {
 
-        return true;
     }
 
     /**
-     * This function looks ahead in a raw internet message,
-     * and for each line that begins with whitespace, it "unfolds"
-     * the line and given header value, combining them.
-     *
-     * The given offset and lineTerminator positions into
-     * the raw message are advanced past any unfolded lines.
-     *
-     * @param[in] rawMessage
-     *     This is the string containing the message.
-     *
-     * @paraam[in] offset
-     *     This is the current position into rawMessage where
-     *     we should look for lines to potentially unfold
-     *     into the given header value.
-     *
-     * @param[in] lineTerminator
-     *     This is the position of the end of the current line.
-     *
-     * @param[in,out] value
-     *     This is the last header value parsed from the message.
-     *     If any lines are unfolded, they are added to this value.
-     *
-     * @return
-     *     An indication of whether or not the advancing
-     *     and unfolding were successful is returned.
+     * This contains the private properties of a MessageHeaders instance.
      */
-    bool AdvanceAndUnfold(
-        const std::string& rawMessage,
-        size_t& offset,
-        size_t& lineTerminator,
-        MessageHeaders::MessageHeaders::HeaderValue& value
-    ) {
-        for (;;) {
-            // Find where the next line begins.
-            const auto nextLineStart = lineTerminator + CRLF.length();
+    struct MessageHeaders::Impl {
+        Headers headers;
+        size_t lineLengthLimit = 0;
 
-            // Find where the next line ends.
-            auto nextLineTerminator = rawMessage.find(CRLF, nextLineStart);
-            if (nextLineTerminator == std::string::npos) {
-                return false;
+        /**
+         * This marks a well-known header of which none is stored.
+         */
+        static constexpr size_t NOT_STORED = SIZE_MAX;
+
+        /**
+         * These are the positions of the first header stored with each
+         * well-known name, or NOT_STORED, indexed by WellKnownHeader.
+         * They're kept up to date as headers are stored, so that
+         * singleton headers are found without searching.
+         */
+        std::array< size_t, WELL_KNOWN_HEADER_COUNT > firstWellKnown;
+
+        /**
+         * These indicate whether or not more than one header is
+         * stored with each well-known name, indexed by WellKnownHeader.
+         */
+        std::array< bool, WELL_KNOWN_HEADER_COUNT > wellKnownRepeated;
+
+        /**
+         * This is the number of headers, from the start, which
+         * have been entered into the well-known header index.
+         */
+        size_t indexedHeaders = 0;
+
+        /**
+         * This is used to recognize headers in ParseRawMessage.
+         * It is kept so that its scratch buffers are reused.
+         */
+        HeaderParser parser;
+
+        /**
+         * This is the smallest header block, in bytes, which
+         * ParseRawMessage splits up and parses on several threads,
+         * or zero if header blocks are never split up.
+         */
+        size_t parallelParseThreshold = 0;
+
+        /**
+         * This is the largest number of threads ParseRawMessage
+         * uses to parse a single header block.
+         */
+        size_t parallelParseThreads = 1;
+
+        /**
+         * This indicates whether or not ParseRawMessage applies
+         * duplicate policies.  If not, every header is kept separately.
+         */
+        bool usingDuplicatePolicies = false;
+
+        /**
+         * These are the duplicate policies for the well-known headers,
+         * indexed by WellKnownHeader.
+         */
+        std::array< DuplicatePolicy, WELL_KNOWN_HEADER_COUNT > wellKnownDuplicatePolicies{};
+
+        /**
+         * These are the duplicate policies for other headers.
+         */
+        std::vector< std::pair< std::string, DuplicatePolicy > > otherDuplicatePolicies;
+
+        /**
+         * This is the semantic hash of the headers, which is kept
+         * up to date as they're modified.
+         *
+         * Headers count as sharing a name, for the purpose of their
+         * ordinals, if the hashes of their names are equal.
+         */
+        uint64_t semanticHash = 0;
+
+        /**
+         * This indicates whether or not ParseRawMessage
+         * computes a fingerprint of the headers it parses.
+         */
+        bool fingerprinting = false;
+
+        /**
+         * This is the fingerprint of the headers of the last
+         * message parsed, if fingerprinting is on.
+         */
+        uint64_t fingerprint = 0;
+
+        /**
+         * If not null, these are the statistics into which
+         * ParseRawMessage records the headers it parses.
+         */
+        HeaderStatistics* statistics = nullptr;
+
+        /**
+         * If not null, this is the accounting into which
+         * ParseRawMessage and GenerateRawHeaders count header sizes.
+         */
+        HeaderSizeAccounting* sizeAccounting = nullptr;
+
+        /**
+         * This is why the last call to ParseRawMessage failed.
+         */
+        ParseError lastParseError = ParseError::None;
+
+        /**
+         * If not null, this is the profiler into which some calls
+         * are timed.
+         */
+        SamplingProfiler* profiler = nullptr;
+
+        /**
+         * If not null, this is the budget charged for the
+         * headers stored.
+         */
+        MemoryBudget* memoryBudget = nullptr;
+
+        /**
+         * This is the number of bytes charged to the memory budget.
+         */
+        size_t chargedBytes = 0;
+
+        Impl() {
+            ResetWellKnownIndex();
+        }
+
+        ~Impl() {
+            if (memoryBudget != nullptr) {
+                memoryBudget->Release(chargedBytes);
+            }
+        }
+
+        /**
+         * This method empties the well-known header index, so that it
+         * can be rebuilt after headers are removed.
+         */
+        void ResetWellKnownIndex() {
+            firstWellKnown.fill(NOT_STORED);
+            wellKnownRepeated.fill(false);
+            indexedHeaders = 0;
+        }
+
+        /**
+         * This method enters into the well-known header index
+         * any headers stored since it was last brought up to date.
+         */
+        void UpdateWellKnownIndex() {
+            for (; indexedHeaders < headers.size(); ++indexedHeaders) {
+                const auto& name = headers[indexedHeaders].name;
+                const auto wellKnownHeader = (size_t)FindWellKnownHeader(
+                    static_cast< const std::string& >(name),
+                    name.GetHash()
+                );
+                if (wellKnownHeader == (size_t)WellKnownHeader::Unknown) {
+                    continue;
+                }
+                if (firstWellKnown[wellKnownHeader] == NOT_STORED) {
+                    firstWellKnown[wellKnownHeader] = indexedHeaders;
+                }
+                else {
+                    wellKnownRepeated[wellKnownHeader] = true;
+                }
             }
+        }
 
-            // Calculate the next line's length.
-            auto nextLineLength = nextLineTerminator - nextLineStart;
+        /**
+         * This method rebuilds the well-known header index,
+         * after headers are removed.
+         */
+        void RebuildWellKnownIndex() {
+            ResetWellKnownIndex();
+            UpdateWellKnownIndex();
+        }
 
-            // If the next line begins with whitespace, unfold the line
+        /**
+         * This method charges the memory budget, if any, for storing
+         * headers, even if that goes over it.
+         *
+         * @param[in] bytes
+         *     This is the number of bytes to charge.
+         */
+        void Charge(size_t bytes) {
+            if (memoryBudget == nullptr) {
+                return;
+            }
+            memoryBudget->Charge(bytes);
+            chargedBytes += bytes;
+        }
+
+        /**
+         * This method gives back to the memory budget, if any, bytes
+         * charged for storing headers which are no longer stored.
+         *
+         * @param[in] bytes
+         *     This is the number of bytes to give back.
+         */
+        void Release(size_t bytes) {
+            if (memoryBudget == nullptr) {
+                return;
+            }
+            bytes = std::min(bytes, chargedBytes);
+            memoryBudget->Release(bytes);
+            chargedBytes -= bytes;
+        }
+
+        /**
+         * This method charges or gives back to the memory budget,
+         * if any, the change in storage when a header value
+         * changes length.
+         *
+         * @param[in] oldLength
+         *     This is the length of the value before it changed.
+         *
+         * @param[in] newLength
+         *     This is the length of the value after it changed.
+         */
+        void ChargeResize(size_t oldLength, size_t newLength) {
+            if (newLength > oldLength) {
+                Charge(newLength - oldLength);
+            }
+            else {
+                Release(oldLength - newLength);
+            }
+        }
+
+        /**
+         * This method gives back to the memory budget, if any,
+         * the bytes charged for storing the given header.
+         *
+         * @param[in] header
+         *     This is the header no longer stored.
+         */
+        void ReleaseHeader(const Header& header) {
+            Release(
+                HeaderStorageCost(
+                    static_cast< const std::string& >(header.name).length(),
+                    header.value.length()
+                )
+            );
+        }
+
+        /**
+         * This method decides whether or not to time a call,
+         * and if so, notes when it started.
+         *
+         * @param[out] start
+         *     This is where to store when the call started,
+         *     if it's timed.
+         *
+         * @return
+         *     An indication of whether or not the call
+         *     is timed is returned.
+         */
+        bool StartSample(SamplingProfiler::Clock::time_point& start) const {
             if (
-                (nextLineLength > CRLF.length())
-                && (WSP.find(rawMessage[nextLineStart]) != std::string::npos)
+                (profiler == nullptr)
+                || !profiler->ShouldSample()
+            ) {
+                return false;
+            }
+            start = SamplingProfiler::Clock::now();
+            return true;
+        }
+
+        /**
+         * This method records how long a call took,
+         * if it was timed.
+         *
+         * @param[in] sampled
+         *     This indicates whether or not the call was timed.
+         *
+         * @param[in] start
+         *     This is when the call started.
+         *
+         * @param[in] operation
+         *     This is what the call did.
+         *
+         * @param[in] bytes
+         *     This is the number of bytes the call took in or gave out.
+         */
+        void FinishSample(
+            bool sampled,
+            SamplingProfiler::Clock::time_point start,
+            ProfiledOperation operation,
+            size_t bytes
+        ) const {
+            if (!sampled) {
+                return;
+            }
+            const auto end = SamplingProfiler::Clock::now();
+            ProfileSample sample;
+            sample.operation = operation;
+            sample.startTime = (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+                start.time_since_epoch()
+            ).count();
+            sample.duration = (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+                end - start
+            ).count();
+            sample.bytes = bytes;
+            sample.headers = headers.size();
+            profiler->Record(sample);
+        }
+
+        /**
+         * This is the header handler used by ParseRawMessage
+         * to store each header reported by the parser.
+         */
+        struct StoringHandler
+            : public HeaderHandler
+        {
+            Headers& headers;
+            Impl* impl;
+            size_t bodyOffset = 0;
+            bool fingerprinting = false;
+            uint64_t fingerprint = 0;
+            size_t fingerprintedHeaders = 0;
+            HeaderSizeAccounting* sizeAccounting = nullptr;
+            MemoryBudget* memoryBudget = nullptr;
+            size_t chargedBytes = 0;
+            bool budgetExhausted = false;
+
+            /**
+             * This constructs the handler.
+             *
+             * @param[in] newHeaders
+             *     This is where to store the headers.
+             *
+             * @param[in] newImpl
+             *     If not null, this is the instance whose duplicate
+             *     policies to apply while storing the headers.
+             */
+            StoringHandler(Headers& newHeaders, Impl* newImpl)
+                : headers(newHeaders)
+                , impl(newImpl)
+            {
+            }
+
+            bool OnHeader(std::string_view name, std::string_view value) override {
+                if (memoryBudget != nullptr) {
+                    const auto cost = HeaderStorageCost(name.length(), value.length());
+                    if (!memoryBudget->TryCharge(cost)) {
+                        budgetExhausted = true;
+                        return false;
+                    }
+                    if (impl != nullptr) {
+                        impl->chargedBytes += cost;
+                    }
+                    else {
+                        chargedBytes += cost;
+                    }
+                }
+                if (fingerprinting) {
+                    fingerprint = (
+                        fingerprint * FINGERPRINT_MULTIPLIER
+                        + FingerprintHeaderName(name)
+                    );
+                    ++fingerprintedHeaders;
+                }
+                if (sizeAccounting != nullptr) {
+                    sizeAccounting->RecordHeader(
+                        HeaderSizeDirection::Parsed,
+                        name,
+                        name.length() + value.length() + 2 + CRLF.length()
+                    );
+                }
+                if (impl != nullptr) {
+                    return impl->StoreHeader(name, value);
+                }
+                headers.emplace_back(std::string(name), std::string(value));
+                return true;
+            }
+
+            void OnEnd(size_t newBodyOffset) override {
+                bodyOffset = newBodyOffset;
+            }
+        };
+
+        /**
+         * This method parses the given header block by splitting it
+         * into pieces which each hold whole headers, parsing the pieces
+         * on separate threads, and then storing the headers of all
+         * the pieces, in order.  If any piece is bad, or a duplicate would
+         * be rejected, no headers are stored.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message to parse.
+         *
+         * @param[in] headersEnd
+         *     This is the offset into the raw message just past the
+         *     empty line which ends the headers.
+         *
+         * @param[out] bodyOffset
+         *     This is where to store the offset into the given
+         *     raw message where the headers ended and the body,
+         *     if any, begins.
+         *
+         * @return
+         *     An indication of whether or not the headers were
+         *     parsed successfully is returned.
+         */
+        bool ParseInParallel(
+            std::string_view rawMessage,
+            size_t headersEnd,
+            size_t& bodyOffset
+        ) {
+            // Pick where to split up the header block.  Pieces may only
+            // begin where a line begins which doesn't continue
+            // the previous one.
+            std::vector< size_t > pieceStarts{0};
+            const auto pieceLength = headersEnd / parallelParseThreads;
+            while (pieceStarts.size() < parallelParseThreads) {
+                auto lineTerminator = rawMessage.find(
+                    CRLF,
+                    std::max(pieceStarts.back() + 1, pieceStarts.size() * pieceLength)
+                );
+                while (
+                    (lineTerminator < headersEnd - 2 * CRLF.length())
+                    && (WSP.find(rawMessage[lineTerminator + CRLF.length()]) != std::string::npos)
                 ) {
-                // Append a single space to the header value.
-                value += ' ';
+                    lineTerminator = rawMessage.find(CRLF, lineTerminator + CRLF.length());
+                }
+                if (lineTerminator >= headersEnd - 2 * CRLF.length()) {
+                    break;
+                }
+                pieceStarts.push_back(lineTerminator + CRLF.length());
+            }
+            pieceStarts.push_back(headersEnd);
+
+            // Parse the pieces.  Each piece but the last lacks the empty
+            // line ending the headers, so one is fed to it separately.
+            const auto numPieces = pieceStarts.size() - 1;
+            std::vector< Headers > pieceHeaders(numPieces);
+            std::vector< char > pieceParsed(numPieces, 0);
+            std::vector< std::pair< uint64_t, size_t > > pieceFingerprints(numPieces);
+            std::vector< size_t > pieceCharges(numPieces, 0);
+            std::vector< std::exception_ptr > pieceErrors(numPieces);
+            const auto parsePiece = [&](size_t i) {
+                StoringHandler handler(pieceHeaders[i], nullptr);
+                try {
+                    HeaderParser pieceParser;
+                    pieceParser.SetLineLimit(lineLengthLimit);
+                    handler.fingerprinting = fingerprinting;
+                    handler.memoryBudget = memoryBudget;
+                    const auto status = pieceParser.Feed(
+                        rawMessage.substr(pieceStarts[i], pieceStarts[i + 1] - pieceStarts[i]),
+                        handler
+                    );
+                    if (i + 1 == numPieces) {
+                        pieceParsed[i] = (status == HeaderParser::Status::Complete);
+                    }
+                    else {
+                        pieceParsed[i] = (
+                            (status == HeaderParser::Status::Incomplete)
+                            && (pieceParser.Feed(CRLF, handler) == HeaderParser::Status::Complete)
+                        );
+                    }
+                }
+                catch (...) {
+                    pieceErrors[i] = std::current_exception();
+                }
+                pieceFingerprints[i] = {handler.fingerprint, handler.fingerprintedHeaders};
+                pieceCharges[i] = handler.chargedBytes;
+            };
+
+            // Pieces for which no thread can be started are parsed
+            // on the calling thread instead.
+            std::vector< std::thread > workers;
+            workers.reserve(numPieces - 1);
+            for (size_t i = 1; i < numPieces; ++i) {
+                try {
+                    workers.emplace_back(parsePiece, i);
+                }
+                catch (const std::system_error&) {
+                    parsePiece(i);
+                }
+            }
+            parsePiece(0);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            size_t charged = 0;
+            for (const auto pieceCharge : pieceCharges) {
+                charged += pieceCharge;
+            }
+            const auto discard = [this, charged]{
+                if (memoryBudget != nullptr) {
+                    memoryBudget->Release(charged);
+                }
+            };
+            for (const auto& pieceError : pieceErrors) {
+                if (pieceError) {
+                    discard();
+                    std::rethrow_exception(pieceError);
+                }
+            }
 
-                // Remove leading whitespace from the next line.
-                const auto firstNonWhitespaceInNextLine = rawMessage.find_first_not_of(WSP, nextLineStart);
-                nextLineLength -= (firstNonWhitespaceInNextLine - nextLineStart);
+            // If any piece is bad, or a duplicate would be rejected,
+            // nothing is stored.
+            const auto fail = [&]{
+                discard();
+                DiagnoseFailure(rawMessage);
+                return false;
+            };
+            for (size_t i = 0; i < numPieces; ++i) {
+                if (!pieceParsed[i]) {
+                    return fail();
+                }
+            }
+            if (usingDuplicatePolicies) {
+                std::vector< std::string_view > rejectableNames;
+                for (const auto& piece : pieceHeaders) {
+                    for (const auto& header : piece) {
+                        const auto& name = static_cast< const std::string& >(header.name);
+                        if (GetDuplicatePolicy(name) != DuplicatePolicy::Reject) {
+                            continue;
+                        }
+                        const auto seen = std::find_if(
+                            rejectableNames.begin(),
+                            rejectableNames.end(),
+                            [&name](std::string_view seenName) {
+                                return HeaderNamesEqual(seenName, name);
+                            }
+                        );
+                        if (
+                            (seen != rejectableNames.end())
+                            || (FindStoredHeader(name) != nullptr)
+                        ) {
+                            return fail();
+                        }
+                        rejectableNames.push_back(name);
+                    }
+                }
+            }
 
-                // Concatenate the rest of the next line to the header value.
-                value += rawMessage.substr(firstNonWhitespaceInNextLine, nextLineLength);
+            // Stitch the headers of the pieces together.
+            chargedBytes += charged;
+            for (auto& piece : pieceHeaders) {
+                for (auto& header : piece) {
+                    if (sizeAccounting != nullptr) {
+                        const auto& name = static_cast< const std::string& >(header.name);
+                        sizeAccounting->RecordHeader(
+                            HeaderSizeDirection::Parsed,
+                            name,
+                            name.length() + header.value.length() + 2 + CRLF.length()
+                        );
+                    }
+                    if (usingDuplicatePolicies) {
+                        (void)StoreHeader(static_cast< const std::string& >(header.name), header.value);
+                    }
+                    else {
+                        headers.push_back(std::move(header));
+                    }
+                }
+            }
+            for (const auto& pieceFingerprint : pieceFingerprints) {
+                fingerprint = (
+                    fingerprint * FingerprintScale(pieceFingerprint.second)
+                    + pieceFingerprint.first
+                );
+            }
+            bodyOffset = headersEnd;
+            return true;
+        }
 
-                // Move to the line following the next line.
-                offset = nextLineTerminator + CRLF.length();
-                lineTerminator = nextLineTerminator;
+        /**
+         * This method finds out why the given header block, which
+         * failed to parse in pieces, fails, by parsing it again in one
+         * go, and then puts everything back as it was.  Engines differ
+         * in how far they get through a bad line before giving up, so
+         * only parsing the block as ParseRawMessage otherwise would
+         * tells whether a rejected duplicate or a bad line comes first.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message which failed
+         *     to parse.
+         */
+        void DiagnoseFailure(std::string_view rawMessage) {
+            auto savedHeaders = headers;
+            const auto savedFirstWellKnown = firstWellKnown;
+            const auto savedWellKnownRepeated = wellKnownRepeated;
+            const auto savedIndexedHeaders = indexedHeaders;
+            const auto savedChargedBytes = chargedBytes;
+            const auto savedFingerprint = fingerprint;
+            const auto savedSizeAccounting = sizeAccounting;
+            const auto restore = [&]{
+                if (chargedBytes > savedChargedBytes) {
+                    Release(chargedBytes - savedChargedBytes);
+                }
+                else {
+                    Charge(savedChargedBytes - chargedBytes);
+                }
+                headers = std::move(savedHeaders);
+                firstWellKnown = savedFirstWellKnown;
+                wellKnownRepeated = savedWellKnownRepeated;
+                indexedHeaders = savedIndexedHeaders;
+                fingerprint = savedFingerprint;
+                sizeAccounting = savedSizeAccounting;
+            };
+            sizeAccounting = nullptr;
+            bool parsed;
+            try {
+                size_t bodyOffset;
+                parsed = ParseSerially(rawMessage, bodyOffset);
+            }
+            catch (...) {
+                restore();
+                throw;
+            }
+            restore();
+
+            // Should the block parse in one go after all, the
+            // pieces failing still means the block is bad.
+            if (parsed) {
+                lastParseError = ParseError::Malformed;
+            }
+        }
+
+        /**
+         * This method parses the headers of the given raw message,
+         * adding them to the stored headers, on several threads if
+         * it's large enough.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message to parse.
+         *
+         * @param[out] bodyOffset
+         *     This is where to store the offset into the given
+         *     raw message where the headers ended and the body,
+         *     if any, begins.
+         *
+         * @return
+         *     An indication of whether or not the headers were
+         *     parsed successfully is returned.
+         */
+        bool Parse(const std::string& rawMessage, size_t& bodyOffset) {
+            if (
+                (parallelParseThreshold > 0)
+                && (parallelParseThreads > 1)
+                && (rawMessage.length() >= parallelParseThreshold)
+                && (rawMessage.compare(0, CRLF.length(), CRLF) != 0)
+            ) {
+                const auto headersEnd = rawMessage.find(CRLF + CRLF);
+                if (
+                    (headersEnd != std::string::npos)
+                    && (headersEnd + 2 * CRLF.length() >= parallelParseThreshold)
+                ) {
+                    return ParseInParallel(
+                        rawMessage,
+                        headersEnd + 2 * CRLF.length(),
+                        bodyOffset
+                    );
+                }
+            }
+            return ParseSerially(rawMessage, bodyOffset);
+        }
+
+        /**
+         * This method parses the headers of the given raw message
+         * in one go on the calling thread, adding them to the
+         * stored headers.
+         *
+         * @param[in] rawMessage
+         *     This is the string rendering of the message to parse.
+         *
+         * @param[out] bodyOffset
+         *     This is where to store the offset into the given
+         *     raw message where the headers ended and the body,
+         *     if any, begins.
+         *
+         * @return
+         *     An indication of whether or not the headers were
+         *     parsed successfully is returned.
+         */
+        bool ParseSerially(std::string_view rawMessage, size_t& bodyOffset) {
+            StoringHandler handler(
+                headers,
+                usingDuplicatePolicies ? this : nullptr
+            );
+            handler.fingerprinting = fingerprinting;
+            handler.sizeAccounting = sizeAccounting;
+            handler.memoryBudget = memoryBudget;
+            const auto parsed = parser.Parse(rawMessage, handler);
+            chargedBytes += handler.chargedBytes;
+            if (!parsed) {
+                if (handler.budgetExhausted) {
+                    lastParseError = ParseError::BudgetExhausted;
+                }
+                return false;
+            }
+            fingerprint = handler.fingerprint;
+            bodyOffset = handler.bodyOffset;
+            return true;
+        }
+
+        /**
+         * This method returns the number of headers with the same
+         * name as the header at the given position which come before it.
+         * The well-known header index answers without a scan for the
+         * first instance of a well-known header, and for the header
+         * just added after at most one other instance; headers with
+         * other names are counted one by one.
+         *
+         * @param[in] index
+         *     This is the position of the header.
+         *
+         * @return
+         *     The ordinal of the header is returned.
+         */
+        size_t GetOrdinal(size_t index) const {
+            const auto nameHash = headers[index].name.GetHash();
+            if (index <= indexedHeaders) {
+                const auto wellKnownHeader = (size_t)FindWellKnownHeader(
+                    static_cast< const std::string& >(headers[index].name),
+                    nameHash
+                );
+                if (wellKnownHeader != (size_t)WellKnownHeader::Unknown) {
+                    const auto first = firstWellKnown[wellKnownHeader];
+                    if (index < indexedHeaders) {
+                        if (first == index) {
+                            return 0;
+                        }
+                    }
+                    else if (first == NOT_STORED) {
+                        return 0;
+                    }
+                    else if (!wellKnownRepeated[wellKnownHeader]) {
+                        return 1;
+                    }
+                }
             }
-            else {
-                break;
+            size_t ordinal = 0;
+            for (size_t i = 0; i < index; ++i) {
+                if (headers[i].name.GetHash() == nameHash) {
+                    ++ordinal;
+                }
             }
+            return ordinal;
         }
-        return true;
-    }
-
-}
 
-namespace MessageHeaders {
-    MessageHeaders::HeaderName::HeaderName(const std::string& s)
-        : name_(s)
-    {
-    }
+        /**
+         * This method adds up the parts of the semantic hash
+         * contributed by the headers with the given name.
+         *
+         * @param[in] nameHash
+         *     This is the hash of the name of the headers.
+         *
+         * @return
+         *     The sum of the parts of the semantic hash contributed
+         *     by the headers with the given name is returned.
+         */
+        uint64_t GetNameSemanticTerms(uint64_t nameHash) const {
+            uint64_t terms = 0;
+            size_t ordinal = 0;
+            for (const auto& header : headers) {
+                if (header.name.GetHash() == nameHash) {
+                    terms += SemanticTerm(nameHash, header.value, ordinal++);
+                }
+            }
+            return terms;
+        }
 
-    bool MessageHeaders::HeaderName::operator==(const HeaderName& rhs) const noexcept {
-        if (name_.length() != rhs.name_.length()) {
-            return false;
+        /**
+         * This method adds the part of the semantic hash
+         * contributed by the last header.
+         */
+        void HashLastHeader() {
+            const auto index = headers.size() - 1;
+            semanticHash += SemanticTerm(
+                headers[index].name.GetHash(),
+                headers[index].value,
+                GetOrdinal(index)
+            );
         }
 
-        for (size_t i = 0; i < name_.length(); ++i) {
-            if (tolower(name_[i]) != tolower(rhs.name_[i])) {
-                return false;
+        /**
+         * This method computes the semantic hash from scratch.
+         * Few headers are compared pairwise; otherwise they're
+         * sorted by name to find their ordinals.
+         *
+         * @return
+         *     The semantic hash of the headers is returned.
+         */
+        uint64_t ComputeSemanticHash() const {
+            uint64_t hash = 0;
+            if (headers.size() <= SEMANTIC_HASH_PAIRWISE_LIMIT) {
+                for (size_t index = 0; index < headers.size(); ++index) {
+                    hash += SemanticTerm(
+                        headers[index].name.GetHash(),
+                        headers[index].value,
+                        GetOrdinal(index)
+                    );
+                }
+                return hash;
+            }
+            std::vector< std::pair< uint64_t, size_t > > byName;
+            byName.reserve(headers.size());
+            for (size_t index = 0; index < headers.size(); ++index) {
+                byName.emplace_back(headers[index].name.GetHash(), index);
             }
+            std::sort(byName.begin(), byName.end());
+            size_t ordinal = 0;
+            for (size_t i = 0; i < byName.size(); ++i) {
+                if (
+                    (i > 0)
+                    && (byName[i].first == byName[i - 1].first)
+                ) {
+                    ++ordinal;
+                }
+                else {
+                    ordinal = 0;
+                }
+                hash += SemanticTerm(
+                    byName[i].first,
+                    headers[byName[i].second].value,
+                    ordinal
+                );
+            }
+            return hash;
         }
 
-        return true;
-    }
+        /**
+         * This method returns the duplicate policy
+         * that applies to the given header name.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @return
+         *     The duplicate policy for the header is returned.
+         */
+        DuplicatePolicy GetDuplicatePolicy(std::string_view name) const {
+            const auto wellKnownHeader = FindWellKnownHeader(name);
+            if (wellKnownHeader != WellKnownHeader::Unknown) {
+                return wellKnownDuplicatePolicies[(size_t)wellKnownHeader];
+            }
+            for (const auto& otherDuplicatePolicy : otherDuplicatePolicies) {
+                if (HeaderNamesEqual(otherDuplicatePolicy.first, name)) {
+                    return otherDuplicatePolicy.second;
+                }
+            }
+            return DuplicatePolicy::KeepSeparate;
+        }
 
-    MessageHeaders::HeaderName::operator const std::string&() const noexcept {
-        return name_;
-    }
+        /**
+         * This method finds the first header stored with the given name.
+         *
+         * @param[in] name
+         *     This is the name of the header to find.
+         *
+         * @return
+         *     The first header stored with the name is returned.
+         *
+         * @retval nullptr
+         *     This is returned if no header has the name.
+         */
+        Header* FindStoredHeader(std::string_view name) {
+            const auto wellKnownHeader = FindWellKnownHeader(name);
+            if (wellKnownHeader != WellKnownHeader::Unknown) {
+                const auto first = firstWellKnown[(size_t)wellKnownHeader];
+                return (first == NOT_STORED) ? nullptr : &headers[first];
+            }
+            for (auto& header : headers) {
+                if (HeaderNamesEqual(static_cast< const std::string& >(header.name), name)) {
+                    return &header;
+                }
+            }
+            return nullptr;
+        }
 
-    std::string::const_iterator MessageHeaders::HeaderName::begin() const {
-        return name_.begin();
-    }
+        /**
+         * This method stores a parsed header, applying the
+         * duplicate policy for its name.
+         *
+         * @param[in] name
+         *     This is the name of the header.
+         *
+         * @param[in] value
+         *     This is the value of the header.
+         *
+         * @return
+         *     An indication of whether or not the header was acceptable
+         *     is returned.  It is not if its duplicate policy is
+         *     DuplicatePolicy::Reject and it was already stored.
+         */
+        bool StoreHeader(std::string_view name, std::string_view value) {
+            const auto duplicatePolicy = GetDuplicatePolicy(name);
+            if (duplicatePolicy != DuplicatePolicy::KeepSeparate) {
+                const auto stored = FindStoredHeader(name);
+                if (stored != nullptr) {
+                    auto& header = *stored;
+
+                    // The header was charged as if stored separately,
+                    // so only what's actually kept stays charged.
+                    Release(HeaderStorageCost(name.length(), value.length()));
+                    switch (duplicatePolicy) {
+                        case DuplicatePolicy::Combine: {
+                            header.value += ',';
+                            header.value.append(value.data(), value.length());
+                            Charge(value.length() + 1);
+                        } break;
+
+                        case DuplicatePolicy::Reject: {
+                            lastParseError = ParseError::DuplicateRejected;
+                            return false;
+                        }
 
-    std::string::const_iterator MessageHeaders::HeaderName::end() const {
-        return name_.end();
-    }
+                        case DuplicatePolicy::LastWins: {
+                            ChargeResize(header.value.length(), value.length());
+                            header.value.assign(value.data(), value.length());
+                        } break;
 
-    MessageHeaders::Header::Header(
-        const HeaderName& newName,
-        const HeaderValue& newValue
-    ) : name(newName), value(newValue)
-    {
+                        default: break;
+                    }
+                    return true;
+                }
+            }
+            headers.emplace_back(std::string(name), std::string(value));
+            UpdateWellKnownIndex();
+            return true;
+        }
 
-    }
+        /**
+         * This method constructs and returns the raw string headers,
+         * hiding the values of sensitive headers if a redaction
+         * policy is given.
+         *
+         * @param[in] redaction
+         *     If not null, this says which headers are sensitive
+         *     and how to hide their values.
+         *
+         * @return
+         *     The raw string internet message based on the
+         *     headers is returned.
+         */
+        std::string GenerateRawHeaders(const RedactionPolicy* redaction) {
+            MESSAGE_HEADERS_PROBE1(generate__start, headers.size());
+            SamplingProfiler::Clock::time_point sampleStart;
+            const auto sampled = StartSample(sampleStart);
+            std::ostringstream rawMessage;
+            for (const auto& header : headers) {
+                const auto lineStart = rawMessage.tellp();
+                std::ostringstream lineBuffer;
+                lineBuffer << header.name << ": ";
+                const auto redacted = (
+                    (redaction != nullptr)
+                    && redaction->Redact(
+                        header.name,
+                        header.value,
+                        [&lineBuffer](std::string_view piece) {
+                            lineBuffer << piece;
+                        }
+                    )
+                );
+                if (!redacted) {
+                    lineBuffer << header.value;
+                }
+                lineBuffer << CRLF;
+                if (lineLengthLimit > 0) {
+                    bool firstPart = true;
+                    for (
+                        const auto& part : SplitLine(
+                            lineBuffer.str(),
+                            CRLF,
+                            " ",
+                            MakeHeaderLineFoldingStrategy()
+                        )
+                        ) {
+                        rawMessage << part;
+                    }
+                }
+                else {
+                    rawMessage << lineBuffer.str();
+                }
+                if (sizeAccounting != nullptr) {
+                    sizeAccounting->RecordHeader(
+                        HeaderSizeDirection::Generated,
+                        static_cast< const std::string& >(header.name),
+                        (size_t)(rawMessage.tellp() - lineStart)
+                    );
+                }
+            }
 
-    /**
-     * This contains the private properties of a MessageHeaders instance.
-     */
-    struct MessageHeaders::Impl {
-        Headers headers;
-        size_t lineLengthLimit = 0;
+            rawMessage << CRLF;
+            if (sizeAccounting != nullptr) {
+                sizeAccounting->RecordMessage(
+                    HeaderSizeDirection::Generated,
+                    (size_t)rawMessage.tellp()
+                );
+            }
+            auto rawHeaders = rawMessage.str();
+            MESSAGE_HEADERS_PROBE2(generate__done, rawHeaders.length(), headers.size());
+            FinishSample(sampled, sampleStart, ProfiledOperation::Generate, rawHeaders.length());
+            return rawHeaders;
+        }
 
         /**
          * This function returns a string splitting strategy
@@ -428,87 +1513,107 @@ namespace MessageHeaders {
 
     void MessageHeaders::SetLineLimit(size_t newLineLengthLimit) {
         impl_->lineLengthLimit = newLineLengthLimit;
+        impl_->parser.SetLineLimit(newLineLengthLimit);
     }
 
-    bool MessageHeaders::ParseRawMessage(const std::string& rawMessage, size_t& bodyOffset) {
-        size_t offset = 0;
-        while (offset < rawMessage.length()) {
-            // Find the end of the current line.
-            auto lineTerminator = rawMessage.find(CRLF, offset);
-            // No line terminator
-            if (lineTerminator == std::string::npos) {
-                break;
-            }
-
-            // Bail if the line is longer than the limit (if set).
-            if (impl_->lineLengthLimit > 0) {
-                if (lineTerminator + CRLF.length() - offset> impl_->lineLengthLimit) {
-                    return false;
-                }
-            }
+    void MessageHeaders::SetParseEngine(HeaderParser::Engine engine) {
+        impl_->parser.SetEngine(engine);
+    }
 
-            // Stop if empty line is found -- this is where
-            // the headers end and the body (which we don't parse,
-            // but leave up to the user to handle) begins.
-            if (lineTerminator == offset) {
-                offset += 2;
-                break;
+    void MessageHeaders::SetDuplicatePolicy(const HeaderName& name, DuplicatePolicy duplicatePolicy) {
+        impl_->usingDuplicatePolicies = true;
+        const auto& nameString = static_cast< const std::string& >(name);
+        const auto wellKnownHeader = FindWellKnownHeader(nameString);
+        if (wellKnownHeader != WellKnownHeader::Unknown) {
+            impl_->wellKnownDuplicatePolicies[(size_t)wellKnownHeader] = duplicatePolicy;
+            return;
+        }
+        for (auto& otherDuplicatePolicy : impl_->otherDuplicatePolicies) {
+            if (HeaderNamesEqual(otherDuplicatePolicy.first, nameString)) {
+                otherDuplicatePolicy.second = duplicatePolicy;
+                return;
             }
+        }
+        impl_->otherDuplicatePolicies.emplace_back(nameString, duplicatePolicy);
+    }
 
-            // Separate the header name from the header value.
-            HeaderName name;
-            HeaderValue value;
+    void MessageHeaders::UseDefaultDuplicatePolicies() {
+        for (size_t i = 0; i < WELL_KNOWN_HEADER_COUNT; ++i) {
+            impl_->wellKnownDuplicatePolicies[i] = GetWellKnownHeaderInfo((WellKnownHeader)i).duplicatePolicy;
+        }
+        impl_->usingDuplicatePolicies = true;
+    }
 
-            if (
-                !SeparateHeaderNameAndValue(
-                    rawMessage,
-                    offset,
-                    lineTerminator,
-                    name,
-                    value
-                )
-                ) {
-                return false;
-            }
+    void MessageHeaders::SetParallelParsing(size_t threshold, size_t maxThreads) {
+        impl_->parallelParseThreshold = threshold;
+        impl_->parallelParseThreads = std::max< size_t >(maxThreads, 1);
+    }
 
-            // Look ahead in the raw message and perform
-            // line unfolding if we see any lines that begin with whitespace.
-            offset = lineTerminator + CRLF.length();
+    void MessageHeaders::SetFingerprinting(bool fingerprinting) {
+        impl_->fingerprinting = fingerprinting;
+    }
 
-            if (
-                !AdvanceAndUnfold(
-                    rawMessage,
-                    offset,
-                    lineTerminator,
-                    value
-                )
-                ) {
-                return false;
-            }
+    uint64_t MessageHeaders::GetFingerprint() const {
+        return impl_->fingerprint;
+    }
 
-            // Remove any whitespace that might be at the beginning
-            // or end of the header value, and then store the header.
-            value = StripMarginWhitespace(value);
-            impl_->headers.emplace_back(name, value);
-        }
+    void MessageHeaders::SetStatistics(HeaderStatistics* statistics) {
+        impl_->statistics = statistics;
+    }
 
-        /*
-            Empty string and a single truncated line were not being
-            detected as bad messages.  If there is at least one line,
-            it gets detected as a bad message because of the lack
-            of a "next line" when looking ahead to see if line unfolding
-            needs to be done.  Unfortunately, if there isn't even one
-            complete line, there was no unfolding check at all.
+    void MessageHeaders::SetSizeAccounting(HeaderSizeAccounting* accounting) {
+        impl_->sizeAccounting = accounting;
+    }
 
-            Solve this problem by checking at the end to see that at least
-            one line was parsed from the raw message.
-        */
-        if (offset == 0) {
-            return false;
+    void MessageHeaders::SetProfiler(SamplingProfiler* profiler) {
+        impl_->profiler = profiler;
+    }
+
+    void MessageHeaders::SetMemoryBudget(MemoryBudget* budget) {
+        if (impl_->memoryBudget != nullptr) {
+            impl_->memoryBudget->Release(impl_->chargedBytes);
+        }
+        impl_->chargedBytes = 0;
+        impl_->memoryBudget = budget;
+        for (const auto& header : impl_->headers) {
+            impl_->Charge(
+                HeaderStorageCost(
+                    static_cast< const std::string& >(header.name).length(),
+                    header.value.length()
+                )
+            );
         }
+    }
 
-        bodyOffset = offset;
-        return true;
+    bool MessageHeaders::ParseRawMessage(const std::string& rawMessage, size_t& bodyOffset) {
+        // Parsing may combine values of headers already stored, and
+        // stores whatever it recognized even on failure, so the
+        // semantic hash is worked out again afterwards.
+        MESSAGE_HEADERS_PROBE1(parse__start, rawMessage.length());
+        SamplingProfiler::Clock::time_point sampleStart;
+        const auto sampled = impl_->StartSample(sampleStart);
+        impl_->fingerprint = 0;
+        impl_->lastParseError = ParseError::None;
+        const auto parsed = impl_->Parse(rawMessage, bodyOffset);
+        impl_->UpdateWellKnownIndex();
+        impl_->semanticHash = impl_->ComputeSemanticHash();
+        if (!parsed && (impl_->lastParseError == ParseError::None)) {
+            impl_->lastParseError = ParseError::Malformed;
+        }
+        MESSAGE_HEADERS_PROBE3(
+            parse__done,
+            parsed ? bodyOffset : 0,
+            impl_->headers.size(),
+            (int)impl_->lastParseError
+        );
+        impl_->FinishSample(sampled, sampleStart, ProfiledOperation::Parse, rawMessage.length());
+        if (parsed && (impl_->sizeAccounting != nullptr)) {
+            impl_->sizeAccounting->RecordMessage(HeaderSizeDirection::Parsed, bodyOffset);
+        }
+        if (parsed && (impl_->statistics != nullptr)) {
+            impl_->statistics->Record(*this);
+        }
+        return parsed;
     }
 
     bool MessageHeaders::ParseRawMessage(const std::string& rawMessage) {
@@ -516,6 +1621,10 @@ namespace MessageHeaders {
         return ParseRawMessage(rawMessage, bodyOffset);
     }
 
+    auto MessageHeaders::GetLastParseError() const -> ParseError {
+        return impl_->lastParseError;
+    }
+
     /**
      * This is the Long Header Fields (2.2.3)
      * specified in RFC 2822 (https://tools.ietf.org/html/rfc2822).
@@ -540,37 +1649,217 @@ namespace MessageHeaders {
      * us to realize the requirement.
      */
     std::string MessageHeaders::GenerateRawHeaders() const {
-        std::ostringstream rawMessage;
-        for (const auto& header : impl_->headers) {
-            std::ostringstream lineBuffer;
-            lineBuffer << header.name << ": " << header.value << CRLF;
-            if (impl_->lineLengthLimit > 0) {
-                bool firstPart = true;
-                for (
-                    const auto& part : SplitLine(
-                        lineBuffer.str(),
-                        CRLF,
-                        " ",
-                        impl_->MakeHeaderLineFoldingStrategy()
-                    )
+        return impl_->GenerateRawHeaders(nullptr);
+    }
+
+    std::string MessageHeaders::GenerateRawHeaders(const RedactionPolicy& redaction) const {
+        return impl_->GenerateRawHeaders(&redaction);
+    }
+
+    void MessageHeaders::ToJson(
+        std::string& output,
+        const JsonOptions& options
+    ) const {
+        const auto& headers = impl_->headers;
+        size_t expectedLength = 2;
+        for (const auto& header : headers) {
+            expectedLength += static_cast< const std::string& >(header.name).length() + header.value.length() + 6;
+        }
+        output.reserve(output.length() + expectedLength);
+        // Group the headers by name in one pass, linking each header
+        // to the next with the same name.  Names are compared only
+        // when their hashes match.  Few headers are grouped in arrays
+        // on the stack, looking through the names seen so far;
+        // otherwise names are looked up in a table by hash.
+        constexpr size_t NO_HEADER = SIZE_MAX;
+        std::array< size_t, JSON_STACK_GROUPING_LIMIT > stackNextSameName;
+        std::array< size_t, JSON_STACK_GROUPING_LIMIT > stackLastSameName;
+        std::array< size_t, JSON_STACK_GROUPING_LIMIT > stackSameNameCount;
+        std::vector< size_t > heapLinks;
+        size_t* nextSameName = stackNextSameName.data();
+        size_t* lastSameName = stackLastSameName.data();
+        size_t* sameNameCount = stackSameNameCount.data();
+        const auto link = [&](size_t first, size_t i) {
+            if (first == NO_HEADER) {
+                lastSameName[i] = i;
+                sameNameCount[i] = 1;
+            } else {
+                nextSameName[lastSameName[first]] = i;
+                lastSameName[first] = i;
+                ++sameNameCount[first];
+            }
+        };
+        if (headers.size() <= JSON_STACK_GROUPING_LIMIT) {
+            for (size_t i = 0; i < headers.size(); ++i) {
+                nextSameName[i] = NO_HEADER;
+                sameNameCount[i] = 0;
+                auto first = NO_HEADER;
+                for (size_t j = 0; j < i; ++j) {
+                    if (
+                        (sameNameCount[j] > 0)
+                        && (headers[j].name.GetHash() == headers[i].name.GetHash())
+                        && (headers[j].name == headers[i].name)
                     ) {
-                    rawMessage << part;
+                        first = j;
+                        break;
+                    }
                 }
+                link(first, i);
             }
-            else {
-                rawMessage << lineBuffer.str();
+        } else {
+            heapLinks.resize(3 * headers.size());
+            nextSameName = heapLinks.data();
+            lastSameName = heapLinks.data() + headers.size();
+            sameNameCount = heapLinks.data() + 2 * headers.size();
+            std::fill(nextSameName, lastSameName, NO_HEADER);
+            std::fill(sameNameCount, sameNameCount + headers.size(), 0);
+            std::unordered_multimap< uint64_t, size_t > firstByHash;
+            firstByHash.reserve(headers.size());
+            for (size_t i = 0; i < headers.size(); ++i) {
+                const auto hash = headers[i].name.GetHash();
+                auto first = NO_HEADER;
+                const auto candidates = firstByHash.equal_range(hash);
+                for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+                    if (headers[candidate->second].name == headers[i].name) {
+                        first = candidate->second;
+                        break;
+                    }
+                }
+                if (first == NO_HEADER) {
+                    (void)firstByHash.emplace(hash, i);
+                }
+                link(first, i);
             }
         }
-
-        rawMessage << CRLF;
-        return rawMessage.str();
+        output += '{';
+        bool firstMember = true;
+        for (size_t i = 0; i < headers.size(); ++i) {
+            if (sameNameCount[i] == 0) {
+                continue;
+            }
+            const auto& name = headers[i].name;
+            if (!firstMember) {
+                output += ',';
+            }
+            firstMember = false;
+            output += '"';
+            const auto nameStart = output.length();
+            AppendJsonEscaped(static_cast< const std::string& >(name), output);
+            if (options.lowercaseNames) {
+                for (auto c = output.begin() + nameStart; c != output.end(); ++c) {
+                    if ((*c >= 'A') && (*c <= 'Z')) {
+                        *c += 'a' - 'A';
+                    }
+                }
+            }
+            output += "\":";
+            const auto asArray = (
+                (sameNameCount[i] > 1)
+                && (options.duplicates == JsonDuplicates::Array)
+            );
+            if (asArray) {
+                output += '[';
+            }
+            output += '"';
+            for (auto j = i; j != NO_HEADER; j = nextSameName[j]) {
+                if (j != i) {
+                    output += (asArray ? "\",\"" : ",");
+                }
+                const auto redacted = (
+                    (options.redaction != nullptr)
+                    && options.redaction->Redact(
+                        headers[j].name,
+                        headers[j].value,
+                        [&output](std::string_view piece) {
+                            AppendJsonEscaped(piece, output);
+                        }
+                    )
+                );
+                if (!redacted) {
+                    AppendJsonEscaped(headers[j].value, output);
+                }
+            }
+            output += '"';
+            if (asArray) {
+                output += ']';
+            }
+        }
+        output += '}';
     }
 
     auto MessageHeaders::GetAll() const -> Headers {
         return impl_->headers;
     }
 
+    size_t MessageHeaders::GetHeaderCount() const {
+        return impl_->headers.size();
+    }
+
+    auto MessageHeaders::GetHeader(size_t index) const -> const Header& {
+        return impl_->headers[index];
+    }
+
+    void MessageHeaders::EditHeaderValue(
+        size_t index,
+        const std::function< void(HeaderValue& value) >& editor
+    ) {
+        auto& header = impl_->headers[index];
+        const auto nameHash = header.name.GetHash();
+        const auto ordinal = impl_->GetOrdinal(index);
+        impl_->semanticHash -= SemanticTerm(nameHash, header.value, ordinal);
+        const auto oldLength = header.value.length();
+        try {
+            editor(header.value);
+        }
+        catch (...) {
+            impl_->semanticHash += SemanticTerm(nameHash, header.value, ordinal);
+            impl_->ChargeResize(oldLength, header.value.length());
+            throw;
+        }
+        impl_->semanticHash += SemanticTerm(nameHash, header.value, ordinal);
+        impl_->ChargeResize(oldLength, header.value.length());
+    }
+
+    uint64_t MessageHeaders::SemanticHash() const {
+        return impl_->semanticHash;
+    }
+
+    size_t MessageHeaders::FindHeader(std::string_view name, size_t startIndex) const {
+        const auto hash = HashHeaderName(name);
+        const auto count = impl_->headers.size();
+        const auto wellKnownHeader = (size_t)FindWellKnownHeader(name, hash);
+        if (wellKnownHeader != (size_t)WellKnownHeader::Unknown) {
+            const auto first = impl_->firstWellKnown[wellKnownHeader];
+            if (first == Impl::NOT_STORED) {
+                return count;
+            }
+            if (startIndex <= first) {
+                return first;
+            }
+            if (!impl_->wellKnownRepeated[wellKnownHeader]) {
+                return count;
+            }
+        }
+        for (auto index = startIndex; index < count; ++index) {
+            const auto& headerName = impl_->headers[index].name;
+            if (
+                (headerName.GetHash() == hash)
+                && HeaderNamesEqual(static_cast< const std::string& >(headerName), name)
+            ) {
+                return index;
+            }
+        }
+        return count;
+    }
+
     bool MessageHeaders::HasHeader(const HeaderName& name) const {
+        const auto wellKnownHeader = (size_t)FindWellKnownHeader(
+            static_cast< const std::string& >(name),
+            name.GetHash()
+        );
+        if (wellKnownHeader != (size_t)WellKnownHeader::Unknown) {
+            return impl_->firstWellKnown[wellKnownHeader] != Impl::NOT_STORED;
+        }
         for (const auto& header : impl_->headers) {
             if (header.name == name) {
                 return true;
@@ -580,23 +1869,51 @@ namespace MessageHeaders {
     }
 
     auto MessageHeaders::GetHeaderValue(const HeaderName& name) const -> HeaderValue {
+        MESSAGE_HEADERS_PROBE1(lookup__start, static_cast< const std::string& >(name).c_str());
+        SamplingProfiler::Clock::time_point sampleStart;
+        const auto sampled = impl_->StartSample(sampleStart);
         std::string compositeValue;
         bool isFirstValue = true;
-        for (const auto& header : impl_->headers) {
-            if (header.name == name) {
-                if (isFirstValue) {
-                    isFirstValue = false;
-                }
-                else {
-                    compositeValue += ',';
+        size_t matches = 0;
+        const auto wellKnownHeader = (size_t)FindWellKnownHeader(
+            static_cast< const std::string& >(name),
+            name.GetHash()
+        );
+        if (
+            (wellKnownHeader != (size_t)WellKnownHeader::Unknown)
+            && !impl_->wellKnownRepeated[wellKnownHeader]
+        ) {
+            // There's at most one header with the name, so
+            // it's taken straight from the index.
+            const auto first = impl_->firstWellKnown[wellKnownHeader];
+            if (first != Impl::NOT_STORED) {
+                ++matches;
+                compositeValue = impl_->headers[first].value;
+            }
+        }
+        else {
+            for (const auto& header : impl_->headers) {
+                if (header.name == name) {
+                    ++matches;
+                    if (isFirstValue) {
+                        isFirstValue = false;
+                    }
+                    else {
+                        compositeValue += ',';
+                    }
+                    compositeValue += header.value;
                 }
-                compositeValue += header.value;
             }
         }
+        MESSAGE_HEADERS_PROBE2(lookup__done, static_cast< const std::string& >(name).c_str(), matches);
+        impl_->FinishSample(sampled, sampleStart, ProfiledOperation::Lookup, compositeValue.length());
         return compositeValue;
     }
 
     auto MessageHeaders::GetHeaderMultiValue(const HeaderName& name) const -> std::vector<HeaderValue> {
+        MESSAGE_HEADERS_PROBE1(lookup__start, static_cast< const std::string& >(name).c_str());
+        SamplingProfiler::Clock::time_point sampleStart;
+        const auto sampled = impl_->StartSample(sampleStart);
         std::vector<HeaderValue> values;
         bool isFirstValue = true;
         for (const auto& header : impl_->headers) {
@@ -604,18 +1921,30 @@ namespace MessageHeaders {
                 values.push_back(header.value);
             }
         }
+        MESSAGE_HEADERS_PROBE2(lookup__done, static_cast< const std::string& >(name).c_str(), values.size());
+        if (sampled) {
+            size_t bytes = 0;
+            for (const auto& value : values) {
+                bytes += value.length();
+            }
+            impl_->FinishSample(sampled, sampleStart, ProfiledOperation::Lookup, bytes);
+        }
         return values;
     }
 
     // erase existing header, set new value or add a header if header not existing
     void MessageHeaders::SetHeader(const HeaderName& name, const HeaderValue& value) {
+        MESSAGE_HEADERS_PROBE1(set__start, static_cast< const std::string& >(name).c_str());
+        impl_->semanticHash -= impl_->GetNameSemanticTerms(name.GetHash());
         bool haveSetValues = false;
         for (auto header = impl_->headers.begin(); header != impl_->headers.end();) {
             if (header->name == name) {
                 if (haveSetValues) {
+                    impl_->ReleaseHeader(*header);
                     header = impl_->headers.erase(header);
                 }
                 else {
+                    impl_->ChargeResize(header->value.length(), value.length());
                     header->value = value;
                     ++header;
                     haveSetValues = true;
@@ -626,9 +1955,14 @@ namespace MessageHeaders {
             }
         }
 
-        if (!haveSetValues) {
+        if (haveSetValues) {
+            impl_->semanticHash += impl_->GetNameSemanticTerms(name.GetHash());
+            impl_->RebuildWellKnownIndex();
+        }
+        else {
             AddHeader(name, value);
         }
+        MESSAGE_HEADERS_PROBE2(set__done, static_cast< const std::string& >(name).c_str(), impl_->headers.size());
     }
 
     void MessageHeaders::SetHeader(
@@ -661,7 +1995,12 @@ namespace MessageHeaders {
         const HeaderName& name,
         const HeaderValue& value
     ) {
+        MESSAGE_HEADERS_PROBE1(add__start, static_cast< const std::string& >(name).c_str());
         impl_->headers.emplace_back(name, value);
+        impl_->HashLastHeader();
+        impl_->UpdateWellKnownIndex();
+        impl_->Charge(HeaderStorageCost(static_cast< const std::string& >(name).length(), value.length()));
+        MESSAGE_HEADERS_PROBE2(add__done, static_cast< const std::string& >(name).c_str(), impl_->headers.size());
     }
 
     void MessageHeaders::AddHeader(
@@ -683,15 +2022,37 @@ namespace MessageHeaders {
         }
     }
 
+    void MessageHeaders::AddHeaders(const StaticHeaderTable& headers) {
+        impl_->headers.reserve(impl_->headers.size() + headers.size());
+        for (const auto& header : headers) {
+            impl_->headers.emplace_back(std::string(header.name), std::string(header.value));
+            impl_->HashLastHeader();
+            impl_->UpdateWellKnownIndex();
+            impl_->Charge(HeaderStorageCost(header.name.length(), header.value.length()));
+        }
+    }
+
+    void MessageHeaders::SetHeaders(const StaticHeaderTable& headers) {
+        for (const auto& header : headers) {
+            RemoveHeader(std::string(header.name));
+        }
+        AddHeaders(headers);
+    }
+
     void MessageHeaders::RemoveHeader(const HeaderName& name) {
+        MESSAGE_HEADERS_PROBE1(remove__start, static_cast< const std::string& >(name).c_str());
+        impl_->semanticHash -= impl_->GetNameSemanticTerms(name.GetHash());
         for (auto header = impl_->headers.begin(); header != impl_->headers.end();) {
             if (header->name == name) {
+                impl_->ReleaseHeader(*header);
                 header = impl_->headers.erase(header);
             }
             else {
                 ++header;
             }
         }
+        impl_->RebuildWellKnownIndex();
+        MESSAGE_HEADERS_PROBE2(remove__done, static_cast< const std::string& >(name).c_str(), impl_->headers.size());
     }
 
     std::ostream& operator<<(
@@ -708,6 +2069,79 @@ namespace MessageHeaders {
         return rhs == lhs;
     }
 
+    bool HeaderNamesEqual(std::string_view lhs, std::string_view rhs) noexcept {
+        if (lhs.length() != rhs.length()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < lhs.length(); ++i) {
+            if (tolower(lhs[i]) != tolower(rhs[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool Equivalent(
+        const MessageHeaders& lhs,
+        const MessageHeaders& rhs
+    ) {
+        const auto count = lhs.GetHeaderCount();
+        if (
+            (lhs.SemanticHash() != rhs.SemanticHash())
+            || (rhs.GetHeaderCount() != count)
+        ) {
+            return false;
+        }
+
+        // Few headers are matched pairwise, each on the left with the
+        // header on the right having the same name and ordinal.
+        if (count <= SEMANTIC_HASH_PAIRWISE_LIMIT) {
+            for (size_t i = 0; i < count; ++i) {
+                const auto& header = lhs.GetHeader(i);
+                size_t ordinal = 0;
+                for (size_t j = 0; j < i; ++j) {
+                    if (lhs.GetHeader(j).name == header.name) {
+                        ++ordinal;
+                    }
+                }
+                bool matched = false;
+                for (size_t j = 0; j < count; ++j) {
+                    const auto& other = rhs.GetHeader(j);
+                    if (!(other.name == header.name)) {
+                        continue;
+                    }
+                    if (ordinal-- == 0) {
+                        matched = (other.value == header.value);
+                        break;
+                    }
+                }
+                if (!matched) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Otherwise both sides are sorted by (name, ordinal), and
+        // the values are compared in that order.
+        const auto lhsOrder = SortHeadersByName(lhs);
+        const auto rhsOrder = SortHeadersByName(rhs);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& header = lhs.GetHeader(lhsOrder[i]);
+            const auto& other = rhs.GetHeader(rhsOrder[i]);
+            if (
+                (header.name.GetHash() != other.name.GetHash())
+                || !(header.name == other.name)
+                || (header.value != other.value)
+            ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     void PrintTo(
         const MessageHeaders::HeaderName& name,
         std::ostream* os
@@ -0,0 +1,73 @@
+#ifndef MESSAGE_HEADERS_PROBES_HPP
+#define MESSAGE_HEADERS_PROBES_HPP
+
+/**
+ * @file Probes.hpp
+ *
+ * This module declares the static tracepoints placed in the
+ * MessageHeaders library, for tracing it live with tools such as
+ * bpftrace, perf or SystemTap.
+ *
+ * Where <sys/sdt.h> (from SystemTap) is available, each tracepoint is
+ * a single no-op instruction plus a note in the binary saying where it
+ * is and where to find its arguments, so it costs next to nothing
+ * unless a tracer attaches to it.  Otherwise, and if
+ * MESSAGE_HEADERS_NO_PROBES is defined, tracepoints compile to nothing,
+ * and their arguments aren't evaluated.
+ *
+ * All tracepoints belong to the "message_headers" provider.  Where
+ * they're in place, their arguments are evaluated even when no tracer
+ * is attached, so they're kept to values already at hand.  Names are
+ * passed as C strings.
+ *
+ *     parse__start(length)
+ *     parse__done(bodyOffset, headerCount, error)
+ *     generate__start(headerCount)
+ *     generate__done(length, headerCount)
+ *     lookup__start(name)
+ *     lookup__done(name, values)
+ *     set__start(name)
+ *     set__done(name, headerCount)
+ *     add__start(name)
+ *     add__done(name, headerCount)
+ *     remove__start(name)
+ *     remove__done(name, headerCount)
+ *
+ * The error of parse__done is a MessageHeaders::ParseError value, and
+ * its bodyOffset is zero unless the parse succeeded.  The lookup
+ * tracepoints surround GetHeaderValue and GetHeaderMultiValue, with
+ * the number of values found; the set, add and remove tracepoints
+ * surround SetHeader, AddHeader and RemoveHeader, with the number of
+ * headers afterwards.  For example:
+ *
+ *     bpftrace -e 'usdt:./app:message_headers:parse__start { @t[tid] = nsecs; }
+ *         usdt:./app:message_headers:parse__done /@t[tid]/ {
+ *             @ns[arg2] = hist(nsecs - @t[tid]); delete(@t[tid]); }'
+ *
+ * 2019 by YaMing Wu
+ */
+
+#if !defined(MESSAGE_HEADERS_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define MESSAGE_HEADERS_PROBES_ENABLED
+#endif
+#endif
+
+#ifdef MESSAGE_HEADERS_PROBES_ENABLED
+#define MESSAGE_HEADERS_PROBE1(name, arg1) \
+    DTRACE_PROBE1(message_headers, name, arg1)
+#define MESSAGE_HEADERS_PROBE2(name, arg1, arg2) \
+    DTRACE_PROBE2(message_headers, name, arg1, arg2)
+#define MESSAGE_HEADERS_PROBE3(name, arg1, arg2, arg3) \
+    DTRACE_PROBE3(message_headers, name, arg1, arg2, arg3)
+#else
+#define MESSAGE_HEADERS_PROBE1(name, arg1) \
+    do { (void)sizeof(arg1); } while (0)
+#define MESSAGE_HEADERS_PROBE2(name, arg1, arg2) \
+    do { (void)sizeof(arg1); (void)sizeof(arg2); } while (0)
+#define MESSAGE_HEADERS_PROBE3(name, arg1, arg2, arg3) \
+    do { (void)sizeof(arg1); (void)sizeof(arg2); (void)sizeof(arg3); } while (0)
+#endif
+
+#endif
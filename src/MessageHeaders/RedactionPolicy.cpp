@@ -0,0 +1,152 @@
+/**
+ * @file RedactionPolicy.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::RedactionPolicy class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <MessageHeaders/RedactionPolicy.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+
+namespace {
+    /**
+     * This function streams the given list of name=value pairs,
+     * separated by semicolons, with the values hidden.
+     *
+     * @param[in] value
+     *     This is the list to stream.
+     *
+     * @param[in] sink
+     *     This is the function which receives the hidden list.
+     */
+    void RedactCookieValues(
+        std::string_view value,
+        const MessageHeaders::RedactionPolicy::Sink& sink
+    ) {
+        bool first = true;
+        while (!value.empty()) {
+            const auto delimiter = value.find(';');
+            auto member = value.substr(0, delimiter);
+            value = (
+                (delimiter == std::string_view::npos)
+                ? std::string_view()
+                : value.substr(delimiter + 1)
+            );
+            while (
+                !member.empty()
+                && ((member.front() == ' ') || (member.front() == '\t'))
+            ) {
+                member.remove_prefix(1);
+            }
+            if (!first) {
+                sink("; ");
+            }
+            first = false;
+            const auto equals = member.find('=');
+            if (equals == std::string_view::npos) {
+                sink(member);
+            } else {
+                sink(member.substr(0, equals + 1));
+                sink(MessageHeaders::RedactionPolicy::MASK);
+            }
+        }
+    }
+}
+
+namespace MessageHeaders {
+    void RedactionPolicy::UseDefaultNames() {
+        AddName("Authorization", RedactionMode::KeepScheme);
+        AddName("Proxy-Authorization", RedactionMode::KeepScheme);
+        AddName("Cookie", RedactionMode::KeepCookieNames);
+        AddName("Set-Cookie", RedactionMode::KeepCookieNames);
+        AddName("X-Api-Key");
+        AddName("X-Auth-Token");
+        AddName("X-Csrf-Token");
+    }
+
+    void RedactionPolicy::AddName(
+        std::string_view name,
+        RedactionMode mode,
+        size_t keepCharacters
+    ) {
+        const auto existing = FindRule(std::string(name));
+        if (existing != nullptr) {
+            auto& rule = rules_[(size_t)(existing - rules_.data())];
+            rule.mode = mode;
+            rule.keepCharacters = keepCharacters;
+            return;
+        }
+        Rule rule{HashHeaderName(name), std::string(name), mode, keepCharacters};
+        const auto position = std::upper_bound(
+            rules_.begin(),
+            rules_.end(),
+            rule.nameHash,
+            [](uint64_t nameHash, const Rule& other) {
+                return nameHash < other.nameHash;
+            }
+        );
+        rules_.insert(position, std::move(rule));
+    }
+
+    bool RedactionPolicy::Covers(const MessageHeaders::HeaderName& name) const {
+        return FindRule(name) != nullptr;
+    }
+
+    bool RedactionPolicy::Redact(
+        const MessageHeaders::HeaderName& name,
+        std::string_view value,
+        const Sink& sink
+    ) const {
+        const auto rule = FindRule(name);
+        if (rule == nullptr) {
+            return false;
+        }
+        switch (rule->mode) {
+            case RedactionMode::KeepScheme: {
+                const auto delimiter = value.find(' ');
+                if (delimiter != std::string_view::npos) {
+                    sink(value.substr(0, delimiter + 1));
+                }
+                sink(MASK);
+            } break;
+
+            case RedactionMode::KeepCookieNames: {
+                RedactCookieValues(value, sink);
+            } break;
+
+            case RedactionMode::KeepTail: {
+                sink(MASK);
+                if (value.length() > rule->keepCharacters) {
+                    sink(value.substr(value.length() - rule->keepCharacters));
+                }
+            } break;
+
+            case RedactionMode::Full:
+            default: {
+                sink(MASK);
+            } break;
+        }
+        return true;
+    }
+
+    auto RedactionPolicy::FindRule(const MessageHeaders::HeaderName& name) const -> const Rule* {
+        const auto nameHash = name.GetHash();
+        auto rule = std::lower_bound(
+            rules_.begin(),
+            rules_.end(),
+            nameHash,
+            [](const Rule& other, uint64_t nameHash) {
+                return other.nameHash < nameHash;
+            }
+        );
+        for (; (rule != rules_.end()) && (rule->nameHash == nameHash); ++rule) {
+            if (HeaderNamesEqual(rule->name, static_cast< const std::string& >(name))) {
+                return &*rule;
+            }
+        }
+        return nullptr;
+    }
+}
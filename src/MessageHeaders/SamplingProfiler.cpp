@@ -0,0 +1,200 @@
+/**
+ * @file SamplingProfiler.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::SamplingProfiler class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <atomic>
+#include <MessageHeaders/SamplingProfiler.hpp>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    /**
+     * This is the identifier to give the next profiler made.
+     * Identifiers are never reused, unlike addresses, so a thread
+     * can't mistake a new profiler for an old one.
+     */
+    std::atomic< uint64_t > nextProfilerId{1};
+
+    /**
+     * This holds the samples taken by one thread for one profiler,
+     * until they're drained.  Only that thread adds samples, and only
+     * one thread at a time takes them out.
+     */
+    struct Buffer {
+        /**
+         * These are the places for samples.
+         */
+        std::unique_ptr< MessageHeaders::ProfileSample[] > samples;
+
+        /**
+         * This is one less than the number of places for samples,
+         * which is a power of two.
+         */
+        size_t mask = 0;
+
+        /**
+         * This is the number of samples ever put into the buffer.
+         */
+        alignas(64) std::atomic< size_t > head{0};
+
+        /**
+         * This is the number of samples ever taken out of the buffer.
+         */
+        alignas(64) std::atomic< size_t > tail{0};
+
+        /**
+         * This is the number of operations of the thread
+         * to pass by before timing the next one.
+         */
+        size_t countdown = 0;
+    };
+
+    /**
+     * This remembers the buffer a thread last used, so that it's
+     * usually found without locking.
+     */
+    struct ThreadBufferCache {
+        /**
+         * This identifies the profiler owning the buffer.
+         */
+        uint64_t profilerId = 0;
+
+        /**
+         * This is the buffer.
+         */
+        Buffer* buffer = nullptr;
+    };
+}
+
+namespace MessageHeaders {
+    /**
+     * This contains the private properties of a
+     * SamplingProfiler instance.
+     */
+    struct SamplingProfiler::Impl {
+        /**
+         * This identifies the profiler.
+         */
+        uint64_t id = nextProfilerId.fetch_add(1, std::memory_order_relaxed);
+
+        /**
+         * One in every this many operations on each thread is timed,
+         * or none if this is zero.
+         */
+        size_t sampleInterval = 0;
+
+        /**
+         * This is the number of samples each thread's buffer holds.
+         */
+        size_t bufferCapacity = 0;
+
+        /**
+         * This is held while buffers are added or drained.
+         */
+        std::mutex mutex;
+
+        /**
+         * These are the buffers of the threads which have
+         * used the profiler.
+         */
+        std::unordered_map< std::thread::id, std::unique_ptr< Buffer > > buffers;
+
+        /**
+         * This is the number of samples dropped
+         * because a buffer was full.
+         */
+        std::atomic< uint64_t > dropped{0};
+
+        /**
+         * This method returns the buffer of the calling thread,
+         * making it if needed.
+         *
+         * @return
+         *     The buffer of the calling thread is returned.
+         */
+        Buffer& GetThreadBuffer() {
+            thread_local ThreadBufferCache cache;
+            if (cache.profilerId == id) {
+                return *cache.buffer;
+            }
+            std::lock_guard< decltype(mutex) > lock(mutex);
+            auto& buffer = buffers[std::this_thread::get_id()];
+            if (buffer == nullptr) {
+                buffer.reset(new Buffer());
+                buffer->samples.reset(new ProfileSample[bufferCapacity]);
+                buffer->mask = bufferCapacity - 1;
+            }
+            cache.profilerId = id;
+            cache.buffer = buffer.get();
+            return *buffer;
+        }
+    };
+
+    SamplingProfiler::~SamplingProfiler() = default;
+    SamplingProfiler::SamplingProfiler(SamplingProfiler&&) = default;
+    SamplingProfiler& SamplingProfiler::operator=(SamplingProfiler&&) = default;
+
+    SamplingProfiler::SamplingProfiler(
+        size_t sampleInterval,
+        size_t bufferCapacity
+    )
+        : impl_(new Impl)
+    {
+        impl_->sampleInterval = sampleInterval;
+        size_t capacity = 1;
+        while (capacity < bufferCapacity) {
+            capacity <<= 1;
+        }
+        impl_->bufferCapacity = capacity;
+    }
+
+    bool SamplingProfiler::ShouldSample() {
+        if (impl_->sampleInterval == 0) {
+            return false;
+        }
+        auto& buffer = impl_->GetThreadBuffer();
+        if (buffer.countdown > 0) {
+            --buffer.countdown;
+            return false;
+        }
+        buffer.countdown = impl_->sampleInterval - 1;
+        return true;
+    }
+
+    void SamplingProfiler::Record(const ProfileSample& sample) {
+        auto& buffer = impl_->GetThreadBuffer();
+        const auto head = buffer.head.load(std::memory_order_relaxed);
+        if (head - buffer.tail.load(std::memory_order_acquire) > buffer.mask) {
+            impl_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.samples[head & buffer.mask] = sample;
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    size_t SamplingProfiler::Drain(std::vector< ProfileSample >& samples) {
+        std::lock_guard< decltype(impl_->mutex) > lock(impl_->mutex);
+        size_t drained = 0;
+        for (auto& threadBuffer : impl_->buffers) {
+            auto& buffer = *threadBuffer.second;
+            const auto tail = buffer.tail.load(std::memory_order_relaxed);
+            const auto head = buffer.head.load(std::memory_order_acquire);
+            for (auto i = tail; i != head; ++i) {
+                samples.push_back(buffer.samples[i & buffer.mask]);
+            }
+            buffer.tail.store(head, std::memory_order_release);
+            drained += head - tail;
+        }
+        return drained;
+    }
+
+    uint64_t SamplingProfiler::GetDroppedCount() const {
+        return impl_->dropped.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,357 @@
+/**
+ * @file SetCookie.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::SetCookie, MessageHeaders::SetCookies and
+ * MessageHeaders::SetCookieBuilder classes.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <charconv>
+#include <MessageHeaders/HttpDate.hpp>
+#include <MessageHeaders/SetCookie.hpp>
+#include <string>
+
+namespace {
+    /**
+     * This is the name of the header which sets a cookie.
+     */
+    constexpr std::string_view SET_COOKIE = "Set-Cookie";
+
+    /**
+     * This function returns the part of the given text
+     * without any whitespace at either end.
+     *
+     * @param[in] s
+     *     This is the text to strip.
+     *
+     * @return
+     *     The stripped text is returned.
+     */
+    std::string_view StripWhitespace(std::string_view s) {
+        while (
+            !s.empty()
+            && ((s.front() == ' ') || (s.front() == '\t'))
+        ) {
+            s.remove_prefix(1);
+        }
+        while (
+            !s.empty()
+            && ((s.back() == ' ') || (s.back() == '\t'))
+        ) {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    /**
+     * This function determines whether or not the given
+     * header is a Set-Cookie header.
+     *
+     * @param[in] header
+     *     This is the header to check.
+     *
+     * @return
+     *     An indication of whether or not the given
+     *     header is a Set-Cookie header is returned.
+     */
+    bool IsSetCookie(const MessageHeaders::MessageHeaders::Header& header) {
+        return MessageHeaders::HeaderNamesEqual(
+            (const std::string&)header.name,
+            SET_COOKIE
+        );
+    }
+}
+
+namespace MessageHeaders {
+    SetCookie::SetCookie(std::string_view headerValue) {
+        const auto attributesDelimiter = headerValue.find(';');
+        const auto nameValuePair = headerValue.substr(0, attributesDelimiter);
+        if (attributesDelimiter != std::string_view::npos) {
+            attributes_ = headerValue.substr(attributesDelimiter + 1);
+        }
+        const auto nameValueDelimiter = nameValuePair.find('=');
+        if (nameValueDelimiter == std::string_view::npos) {
+            return;
+        }
+        name_ = StripWhitespace(nameValuePair.substr(0, nameValueDelimiter));
+        value_ = StripWhitespace(nameValuePair.substr(nameValueDelimiter + 1));
+        isValid_ = !name_.empty();
+    }
+
+    bool SetCookie::IsValid() const {
+        return isValid_;
+    }
+
+    std::string_view SetCookie::GetName() const {
+        return name_;
+    }
+
+    std::string_view SetCookie::GetValue() const {
+        return value_;
+    }
+
+    bool SetCookie::FindAttribute(std::string_view name, std::string_view& value) const {
+        bool found = false;
+        auto attributes = attributes_;
+        while (!attributes.empty()) {
+            const auto attributeDelimiter = attributes.find(';');
+            const auto attribute = attributes.substr(0, attributeDelimiter);
+            if (attributeDelimiter == std::string_view::npos) {
+                attributes = std::string_view();
+            } else {
+                attributes.remove_prefix(attributeDelimiter + 1);
+            }
+            const auto nameValueDelimiter = attribute.find('=');
+            if (!HeaderNamesEqual(StripWhitespace(attribute.substr(0, nameValueDelimiter)), name)) {
+                continue;
+            }
+            found = true;
+            if (nameValueDelimiter == std::string_view::npos) {
+                value = std::string_view();
+            } else {
+                value = StripWhitespace(attribute.substr(nameValueDelimiter + 1));
+            }
+        }
+        return found;
+    }
+
+    bool SetCookie::GetExpires(int64_t& secondsSinceEpoch) const {
+        std::string_view expires;
+        return (
+            FindAttribute("Expires", expires)
+            && ParseHttpDate(expires, secondsSinceEpoch)
+        );
+    }
+
+    bool SetCookie::GetMaxAge(int64_t& seconds) const {
+        std::string_view maxAge;
+        if (
+            !FindAttribute("Max-Age", maxAge)
+            || maxAge.empty()
+        ) {
+            return false;
+        }
+        const bool negative = (maxAge[0] == '-');
+        if (negative) {
+            maxAge.remove_prefix(1);
+            if (maxAge.empty()) {
+                return false;
+            }
+        }
+        int64_t magnitude = 0;
+        for (auto c: maxAge) {
+            if ((c < '0') || (c > '9')) {
+                return false;
+            }
+            const auto digit = (int64_t)(c - '0');
+            if (magnitude > (INT64_MAX - digit) / 10) {
+                magnitude = INT64_MAX;
+            } else {
+                magnitude = magnitude * 10 + digit;
+            }
+        }
+        seconds = negative ? -magnitude : magnitude;
+        return true;
+    }
+
+    std::string_view SetCookie::GetDomain() const {
+        std::string_view domain;
+        if (!FindAttribute("Domain", domain)) {
+            return std::string_view();
+        }
+        if (
+            !domain.empty()
+            && (domain[0] == '.')
+        ) {
+            domain.remove_prefix(1);
+        }
+        return domain;
+    }
+
+    std::string_view SetCookie::GetPath() const {
+        std::string_view path;
+        if (
+            !FindAttribute("Path", path)
+            || path.empty()
+            || (path[0] != '/')
+        ) {
+            return std::string_view();
+        }
+        return path;
+    }
+
+    SameSite SetCookie::GetSameSite() const {
+        std::string_view sameSite;
+        if (!FindAttribute("SameSite", sameSite)) {
+            return SameSite::Unspecified;
+        }
+        if (HeaderNamesEqual(sameSite, "Strict")) {
+            return SameSite::Strict;
+        } else if (HeaderNamesEqual(sameSite, "Lax")) {
+            return SameSite::Lax;
+        } else if (HeaderNamesEqual(sameSite, "None")) {
+            return SameSite::None;
+        } else {
+            return SameSite::Unspecified;
+        }
+    }
+
+    bool SetCookie::IsSecure() const {
+        std::string_view value;
+        return FindAttribute("Secure", value);
+    }
+
+    bool SetCookie::IsHttpOnly() const {
+        std::string_view value;
+        return FindAttribute("HttpOnly", value);
+    }
+
+    SetCookies::Iterator::Iterator(const MessageHeaders& headers, size_t index)
+        : headers_(&headers)
+        , index_(index)
+    {
+        SkipOtherHeaders();
+    }
+
+    SetCookie SetCookies::Iterator::operator*() const {
+        return SetCookie(headers_->GetHeader(index_).value);
+    }
+
+    auto SetCookies::Iterator::operator++() -> Iterator& {
+        ++index_;
+        SkipOtherHeaders();
+        return *this;
+    }
+
+    bool SetCookies::Iterator::operator==(const Iterator& rhs) const {
+        return (
+            (headers_ == rhs.headers_)
+            && (index_ == rhs.index_)
+        );
+    }
+
+    bool SetCookies::Iterator::operator!=(const Iterator& rhs) const {
+        return !(*this == rhs);
+    }
+
+    void SetCookies::Iterator::SkipOtherHeaders() {
+        const auto count = headers_->GetHeaderCount();
+        while (
+            (index_ < count)
+            && !IsSetCookie(headers_->GetHeader(index_))
+        ) {
+            ++index_;
+        }
+    }
+
+    SetCookies::SetCookies(const MessageHeaders& headers)
+        : headers_(headers)
+    {
+    }
+
+    auto SetCookies::begin() const -> Iterator {
+        return Iterator(headers_, 0);
+    }
+
+    auto SetCookies::end() const -> Iterator {
+        return Iterator(headers_, headers_.GetHeaderCount());
+    }
+
+    SetCookieBuilder::SetCookieBuilder(
+        MessageHeaders& headers,
+        std::string_view name,
+        std::string_view value
+    )
+        : headers_(headers)
+        , index_(headers.GetHeaderCount())
+    {
+        headers_.AddHeader(std::string(SET_COOKIE), std::string());
+        headers_.EditHeaderValue(
+            index_,
+            [name, value](std::string& headerValue) {
+                headerValue.reserve(name.length() + value.length() + 1);
+                headerValue += name;
+                headerValue += '=';
+                headerValue += value;
+            }
+        );
+    }
+
+    SetCookieBuilder& SetCookieBuilder::SetExpires(int64_t secondsSinceEpoch) {
+        headers_.EditHeaderValue(
+            index_,
+            [secondsSinceEpoch](std::string& headerValue) {
+                headerValue += "; Expires=";
+                AppendHttpDate(secondsSinceEpoch, headerValue);
+            }
+        );
+        return *this;
+    }
+
+    SetCookieBuilder& SetCookieBuilder::SetMaxAge(int64_t seconds) {
+        headers_.EditHeaderValue(
+            index_,
+            [seconds](std::string& headerValue) {
+                char digits[24];
+                const auto result = std::to_chars(digits, digits + sizeof(digits), seconds);
+                headerValue += "; Max-Age=";
+                headerValue.append(digits, result.ptr);
+            }
+        );
+        return *this;
+    }
+
+    SetCookieBuilder& SetCookieBuilder::SetDomain(std::string_view domain) {
+        AppendAttribute("; Domain=", domain);
+        return *this;
+    }
+
+    SetCookieBuilder& SetCookieBuilder::SetPath(std::string_view path) {
+        AppendAttribute("; Path=", path);
+        return *this;
+    }
+
+    SetCookieBuilder& SetCookieBuilder::SetSameSite(SameSite sameSite) {
+        switch (sameSite) {
+            case SameSite::Strict: {
+                AppendAttribute("; SameSite=Strict");
+            } break;
+
+            case SameSite::Lax: {
+                AppendAttribute("; SameSite=Lax");
+            } break;
+
+            case SameSite::None: {
+                AppendAttribute("; SameSite=None");
+            } break;
+
+            default: break;
+        }
+        return *this;
+    }
+
+    SetCookieBuilder& SetCookieBuilder::SetSecure() {
+        AppendAttribute("; Secure");
+        return *this;
+    }
+
+    SetCookieBuilder& SetCookieBuilder::SetHttpOnly() {
+        AppendAttribute("; HttpOnly");
+        return *this;
+    }
+
+    void SetCookieBuilder::AppendAttribute(
+        std::string_view attribute,
+        std::string_view value
+    ) {
+        headers_.EditHeaderValue(
+            index_,
+            [attribute, value](std::string& headerValue) {
+                headerValue += attribute;
+                headerValue += value;
+            }
+        );
+    }
+}
@@ -0,0 +1,296 @@
+/**
+ * @file SharedHeaders.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::SharedHeaders class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <MessageHeaders/SharedHeaders.hpp>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    /**
+     * This is the identifier to give the next set made.
+     * Identifiers are never reused, unlike addresses, so a thread
+     * can't mistake a new set for an old one.
+     */
+    std::atomic< uint64_t > nextSetId{1};
+
+    /**
+     * This is one version of the headers published.
+     */
+    struct Version {
+        /**
+         * This is the rendering of the headers, which the
+         * headers below refer to.
+         */
+        std::string rawHeaders;
+
+        /**
+         * These are the headers.
+         */
+        std::vector< MessageHeaders::StaticHeader > headers;
+
+        /**
+         * This is the table through which readers see the headers.
+         * Until the headers are filled in, it shows an empty block.
+         */
+        MessageHeaders::StaticHeaderTable table{"\r\n", nullptr, 0};
+    };
+
+    /**
+     * This is a version replaced but not yet destroyed.
+     */
+    struct RetiredVersion {
+        /**
+         * This is the version replaced.
+         */
+        std::unique_ptr< Version > version;
+
+        /**
+         * This is the epoch which began when the version was
+         * replaced.  Readers which started reading in this epoch
+         * or later can't be using the version.
+         */
+        uint64_t epoch = 0;
+    };
+}
+
+namespace MessageHeaders {
+    /**
+     * This is where a thread marks the epoch in which it
+     * started reading.
+     */
+    struct SharedHeaders::ReaderSlot {
+        /**
+         * This is the epoch in which the thread started reading,
+         * or zero if the thread isn't reading.
+         */
+        std::atomic< uint64_t > epoch{0};
+
+        /**
+         * This is the number of reads the thread has
+         * nested.  It's only touched by its thread.
+         */
+        size_t depth = 0;
+    };
+
+    namespace {
+        /**
+         * This remembers the set a thread last read, and where
+         * the thread marks its reads of that set.
+         */
+        struct ThreadReaderSlotCache {
+            /**
+             * This identifies the set.
+             */
+            uint64_t setId = 0;
+
+            /**
+             * This is where the thread marks its reads of the set.
+             */
+            SharedHeaders::ReaderSlot* slot = nullptr;
+        };
+    }
+
+    /**
+     * This contains the private properties of a
+     * SharedHeaders instance.
+     */
+    struct SharedHeaders::Impl {
+        /**
+         * This identifies the set.
+         */
+        uint64_t id = nextSetId.fetch_add(1, std::memory_order_relaxed);
+
+        /**
+         * This is the current version of the headers.
+         */
+        std::atomic< Version* > current{new Version()};
+
+        /**
+         * This is the current epoch, which goes up
+         * every time the headers are replaced.
+         */
+        std::atomic< uint64_t > epoch{1};
+
+        /**
+         * This is held while a thread is given a slot.
+         */
+        std::mutex slotsMutex;
+
+        /**
+         * These are where each thread marks its reads.
+         */
+        std::unordered_map< std::thread::id, std::unique_ptr< ReaderSlot > > slots;
+
+        /**
+         * This is held while the headers are replaced
+         * or versions replaced are destroyed.
+         */
+        std::mutex publishMutex;
+
+        /**
+         * These are the versions replaced but not yet destroyed.
+         */
+        std::vector< RetiredVersion > retired;
+
+        ~Impl() {
+            delete current.load();
+        }
+
+        /**
+         * This method returns where the calling thread
+         * marks its reads.
+         *
+         * @return
+         *     The calling thread's slot is returned.
+         */
+        ReaderSlot& GetThreadSlot() {
+            thread_local ThreadReaderSlotCache cache;
+            if (cache.setId == id) {
+                return *cache.slot;
+            }
+            std::lock_guard< decltype(slotsMutex) > lock(slotsMutex);
+            auto& slot = slots[std::this_thread::get_id()];
+            if (slot == nullptr) {
+                slot.reset(new ReaderSlot());
+            }
+            cache.setId = id;
+            cache.slot = slot.get();
+            return *slot;
+        }
+
+        /**
+         * This method destroys any versions replaced which no reader
+         * can still be using.  The publish mutex must be held.
+         */
+        void ReclaimLocked() {
+            auto oldestReading = std::numeric_limits< uint64_t >::max();
+            {
+                std::lock_guard< decltype(slotsMutex) > lock(slotsMutex);
+                for (const auto& slot : slots) {
+                    const auto slotEpoch = slot.second->epoch.load();
+                    if (slotEpoch != 0) {
+                        oldestReading = std::min(oldestReading, slotEpoch);
+                    }
+                }
+            }
+            retired.erase(
+                std::remove_if(
+                    retired.begin(),
+                    retired.end(),
+                    [oldestReading](const RetiredVersion& retiredVersion) {
+                        return retiredVersion.epoch <= oldestReading;
+                    }
+                ),
+                retired.end()
+            );
+        }
+    };
+
+    SharedHeaders::ReadGuard::~ReadGuard() {
+        if (
+            (slot_ != nullptr)
+            && (--slot_->depth == 0)
+        ) {
+            slot_->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    SharedHeaders::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+        : slot_(other.slot_)
+        , headers_(other.headers_)
+    {
+        other.slot_ = nullptr;
+    }
+
+    SharedHeaders::ReadGuard::ReadGuard(ReaderSlot* slot, const StaticHeaderTable* headers)
+        : slot_(slot)
+        , headers_(headers)
+    {
+    }
+
+    const StaticHeaderTable& SharedHeaders::ReadGuard::GetHeaders() const {
+        return *headers_;
+    }
+
+    SharedHeaders::~SharedHeaders() = default;
+    SharedHeaders::SharedHeaders(SharedHeaders&&) = default;
+    SharedHeaders& SharedHeaders::operator=(SharedHeaders&&) = default;
+
+    SharedHeaders::SharedHeaders()
+        : impl_(new Impl)
+    {
+    }
+
+    void SharedHeaders::Publish(const MessageHeaders& headers) {
+        // Render the headers first, so that the views of them
+        // made afterwards aren't moved by the string growing.
+        std::unique_ptr< Version > version(new Version());
+        const auto count = headers.GetHeaderCount();
+        size_t length = 2;
+        for (size_t i = 0; i < count; ++i) {
+            const auto& header = headers.GetHeader(i);
+            length += static_cast< const std::string& >(header.name).length() + header.value.length() + 4;
+        }
+        version->rawHeaders.reserve(length);
+        std::vector< size_t > valueOffsets;
+        valueOffsets.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& header = headers.GetHeader(i);
+            version->rawHeaders += static_cast< const std::string& >(header.name);
+            version->rawHeaders += ": ";
+            valueOffsets.push_back(version->rawHeaders.length());
+            version->rawHeaders += header.value;
+            version->rawHeaders += "\r\n";
+        }
+        version->rawHeaders += "\r\n";
+        const std::string_view rawHeaders(version->rawHeaders);
+        version->headers.reserve(count);
+        size_t lineStart = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto& header = headers.GetHeader(i);
+            const auto nameLength = static_cast< const std::string& >(header.name).length();
+            version->headers.push_back({
+                rawHeaders.substr(lineStart, nameLength),
+                rawHeaders.substr(valueOffsets[i], header.value.length())
+            });
+            lineStart = valueOffsets[i] + header.value.length() + 2;
+        }
+        version->table = StaticHeaderTable(rawHeaders, version->headers.data(), count);
+
+        // Swap in the new version, and retire the old one as of the
+        // epoch which begins now; readers which started earlier
+        // might still be using it.
+        std::lock_guard< decltype(impl_->publishMutex) > lock(impl_->publishMutex);
+        RetiredVersion retiredVersion;
+        retiredVersion.version.reset(impl_->current.exchange(version.release()));
+        retiredVersion.epoch = impl_->epoch.fetch_add(1) + 1;
+        impl_->retired.push_back(std::move(retiredVersion));
+        impl_->ReclaimLocked();
+    }
+
+    auto SharedHeaders::Read() const -> ReadGuard {
+        auto& slot = impl_->GetThreadSlot();
+        if (slot.depth++ == 0) {
+            slot.epoch.store(impl_->epoch.load());
+        }
+        return ReadGuard(&slot, &impl_->current.load()->table);
+    }
+
+    size_t SharedHeaders::Reclaim() {
+        std::lock_guard< decltype(impl_->publishMutex) > lock(impl_->publishMutex);
+        impl_->ReclaimLocked();
+        return impl_->retired.size();
+    }
+}
@@ -0,0 +1,655 @@
+/**
+ * @file SignatureBase.cpp
+ *
+ * This module contains the implementation of the functions which
+ * build the signature base of HTTP Message Signatures (RFC 9421).
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <MessageHeaders/SignatureBase.hpp>
+#include <stddef.h>
+#include <vector>
+
+namespace {
+    /**
+     * This is the size of the scratch buffers used to transform
+     * pieces of the signature base on their way to the sink.
+     */
+    constexpr size_t SCRATCH_SIZE = 96;
+
+    /**
+     * These are the base64 digits, by value.
+     */
+    constexpr char BASE64_DIGITS[] = (
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
+    );
+
+    /**
+     * This holds what was recognized of a single
+     * component identifier of the signature parameters.
+     */
+    struct ComponentIdentifier {
+        /**
+         * This is the identifier as it appears in the signature
+         * parameters, including quotes and parameters.
+         */
+        std::string_view text;
+
+        /**
+         * This is the component name.
+         */
+        std::string_view name;
+
+        /**
+         * These indicate which flag parameters were given.
+         */
+        bool sf = false;
+        bool bs = false;
+
+        /**
+         * This indicates whether or not the "key" parameter was
+         * given, and its value.
+         */
+        bool hasKey = false;
+        std::string_view key;
+
+        /**
+         * This indicates whether or not the "name" parameter was
+         * given, and its value.
+         */
+        bool hasName = false;
+        std::string_view nameParameter;
+    };
+
+    /**
+     * This function returns the part of the given text
+     * without any whitespace at either end.
+     *
+     * @param[in] s
+     *     This is the text to strip.
+     *
+     * @return
+     *     The stripped text is returned.
+     */
+    std::string_view StripWhitespace(std::string_view s) {
+        while (
+            !s.empty()
+            && ((s.front() == ' ') || (s.front() == '\t'))
+        ) {
+            s.remove_prefix(1);
+        }
+        while (
+            !s.empty()
+            && ((s.back() == ' ') || (s.back() == '\t'))
+        ) {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    /**
+     * This function determines whether or not the given character
+     * may appear in the key of a structured field parameter.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character may
+     *     appear in a key is returned.
+     */
+    bool IsKeyCharacter(char c) {
+        return (
+            ((c >= 'a') && (c <= 'z'))
+            || ((c >= '0') && (c <= '9'))
+            || (c == '_')
+            || (c == '-')
+            || (c == '.')
+            || (c == '*')
+        );
+    }
+
+    /**
+     * This function reads a structured field string, without
+     * escapes, from the given position, which must be at
+     * the opening quote.
+     *
+     * @param[in] s
+     *     This is the text holding the string.
+     *
+     * @param[in,out] offset
+     *     This is the position of the opening quote.  It is
+     *     advanced past the closing quote.
+     *
+     * @param[out] value
+     *     This is where to store the content of the string.
+     *
+     * @return
+     *     An indication of whether or not a string was read is returned.
+     */
+    bool ReadString(std::string_view s, size_t& offset, std::string_view& value) {
+        if (
+            (offset >= s.length())
+            || (s[offset] != '"')
+        ) {
+            return false;
+        }
+        const auto closingQuote = s.find('"', offset + 1);
+        if (closingQuote == std::string_view::npos) {
+            return false;
+        }
+        value = s.substr(offset + 1, closingQuote - offset - 1);
+        if (value.find('\\') != std::string_view::npos) {
+            return false;
+        }
+        offset = closingQuote + 1;
+        return true;
+    }
+
+    /**
+     * This function reads the next component identifier from the
+     * inner list of the signature parameters.
+     *
+     * @param[in] params
+     *     These are the signature parameters.
+     *
+     * @param[in,out] offset
+     *     This is the position of the identifier.  It is advanced
+     *     past the identifier.
+     *
+     * @param[out] identifier
+     *     This is where to store what was recognized
+     *     of the identifier.
+     *
+     * @return
+     *     An indication of whether or not the identifier
+     *     was well-formed is returned.
+     */
+    bool ReadComponentIdentifier(
+        std::string_view params,
+        size_t& offset,
+        ComponentIdentifier& identifier
+    ) {
+        const auto start = offset;
+        identifier = ComponentIdentifier();
+        if (
+            !ReadString(params, offset, identifier.name)
+            || identifier.name.empty()
+        ) {
+            return false;
+        }
+        for (auto c: identifier.name) {
+            if ((c >= 'A') && (c <= 'Z')) {
+                return false;
+            }
+        }
+        while (
+            (offset < params.length())
+            && (params[offset] == ';')
+        ) {
+            ++offset;
+            const auto keyStart = offset;
+            while (
+                (offset < params.length())
+                && IsKeyCharacter(params[offset])
+            ) {
+                ++offset;
+            }
+            const auto key = params.substr(keyStart, offset - keyStart);
+            std::string_view value;
+            bool hasValue = false;
+            if (
+                (offset < params.length())
+                && (params[offset] == '=')
+            ) {
+                ++offset;
+                if (!ReadString(params, offset, value)) {
+                    return false;
+                }
+                hasValue = true;
+            }
+            if (key == "sf" && !hasValue) {
+                identifier.sf = true;
+            } else if (key == "bs" && !hasValue) {
+                identifier.bs = true;
+            } else if (key == "key" && hasValue) {
+                identifier.hasKey = true;
+                identifier.key = value;
+            } else if (key == "name" && hasValue) {
+                identifier.hasName = true;
+                identifier.nameParameter = value;
+            } else {
+                return false;
+            }
+        }
+        identifier.text = params.substr(start, offset - start);
+        return (
+            (identifier.sf ? 1 : 0)
+            + (identifier.bs ? 1 : 0)
+            + (identifier.hasKey ? 1 : 0)
+        ) <= 1;
+    }
+
+    /**
+     * This function sends the given text to the sink in lowercase.
+     *
+     * @param[in] s
+     *     This is the text to send.
+     *
+     * @param[in] sink
+     *     This is the function which receives the text.
+     */
+    void SendLowercase(std::string_view s, const MessageHeaders::SignatureBaseSink& sink) {
+        char scratch[SCRATCH_SIZE];
+        while (!s.empty()) {
+            const auto length = std::min(s.length(), SCRATCH_SIZE);
+            for (size_t i = 0; i < length; ++i) {
+                const auto c = s[i];
+                scratch[i] = ((c >= 'A') && (c <= 'Z')) ? (char)(c + ('a' - 'A')) : c;
+            }
+            sink(std::string_view(scratch, length));
+            s.remove_prefix(length);
+        }
+    }
+
+    /**
+     * This function sends the given bytes to the sink
+     * as a structured field byte sequence (base64, between colons).
+     *
+     * @param[in] s
+     *     These are the bytes to send.
+     *
+     * @param[in] sink
+     *     This is the function which receives the byte sequence.
+     */
+    void SendByteSequence(std::string_view s, const MessageHeaders::SignatureBaseSink& sink) {
+        char scratch[SCRATCH_SIZE];
+        size_t length = 0;
+        scratch[length++] = ':';
+        for (size_t i = 0; i < s.length(); i += 3) {
+            if (length + 4 > SCRATCH_SIZE) {
+                sink(std::string_view(scratch, length));
+                length = 0;
+            }
+            const auto remaining = s.length() - i;
+            const uint32_t group = (
+                ((uint32_t)(uint8_t)s[i] << 16)
+                | ((remaining > 1) ? ((uint32_t)(uint8_t)s[i + 1] << 8) : 0)
+                | ((remaining > 2) ? (uint32_t)(uint8_t)s[i + 2] : 0)
+            );
+            scratch[length++] = BASE64_DIGITS[(group >> 18) & 0x3F];
+            scratch[length++] = BASE64_DIGITS[(group >> 12) & 0x3F];
+            scratch[length++] = (remaining > 1) ? BASE64_DIGITS[(group >> 6) & 0x3F] : '=';
+            scratch[length++] = (remaining > 2) ? BASE64_DIGITS[group & 0x3F] : '=';
+        }
+        if (length + 1 > SCRATCH_SIZE) {
+            sink(std::string_view(scratch, length));
+            length = 0;
+        }
+        scratch[length++] = ':';
+        sink(std::string_view(scratch, length));
+    }
+
+    /**
+     * This function calls the given function for each top-level
+     * member of the given structured field list or dictionary,
+     * with whitespace around the member removed.  Commas inside
+     * strings and inner lists don't separate members.
+     *
+     * @param[in] value
+     *     This is the structured field value.
+     *
+     * @param[in] visitor
+     *     This is the function to call for each member.
+     */
+    template< typename Visitor > void ForEachMember(std::string_view value, Visitor visitor) {
+        size_t memberStart = 0;
+        bool inString = false;
+        size_t depth = 0;
+        for (size_t i = 0; i <= value.length(); ++i) {
+            if (i == value.length()) {
+                visitor(StripWhitespace(value.substr(memberStart)));
+                break;
+            }
+            const auto c = value[i];
+            if (inString) {
+                if (c == '\\') {
+                    ++i;
+                } else if (c == '"') {
+                    inString = false;
+                }
+            } else if (c == '"') {
+                inString = true;
+            } else if (c == '(') {
+                ++depth;
+            } else if ((c == ')') && (depth > 0)) {
+                --depth;
+            } else if ((c == ',') && (depth == 0)) {
+                visitor(StripWhitespace(value.substr(memberStart, i - memberStart)));
+                memberStart = i + 1;
+            }
+        }
+    }
+
+    /**
+     * This function sends the given top-level member of a structured
+     * field list or dictionary to the sink, with the whitespace in
+     * any inner lists reduced to single spaces between items.
+     *
+     * @param[in] member
+     *     This is the member to send.
+     *
+     * @param[in] sink
+     *     This is the function which receives the member.
+     */
+    void SendStructuredMember(std::string_view member, const MessageHeaders::SignatureBaseSink& sink) {
+        size_t runStart = 0;
+        bool inString = false;
+        size_t depth = 0;
+        for (size_t i = 0; i < member.length(); ++i) {
+            const auto c = member[i];
+            if (inString) {
+                if (c == '\\') {
+                    ++i;
+                } else if (c == '"') {
+                    inString = false;
+                }
+                continue;
+            }
+            if (c == '"') {
+                inString = true;
+            } else if (c == '(') {
+                ++depth;
+            } else if ((c == ')') && (depth > 0)) {
+                --depth;
+            } else if ((c == ' ') && (depth > 0)) {
+                auto spacesEnd = i;
+                while (
+                    (spacesEnd < member.length())
+                    && (member[spacesEnd] == ' ')
+                ) {
+                    ++spacesEnd;
+                }
+                sink(member.substr(runStart, i - runStart));
+                if (
+                    (member[i - 1] != '(')
+                    && (spacesEnd < member.length())
+                    && (member[spacesEnd] != ')')
+                ) {
+                    sink(" ");
+                }
+                runStart = spacesEnd;
+                i = spacesEnd - 1;
+            }
+        }
+        sink(member.substr(runStart));
+    }
+
+    /**
+     * This function sends the value of the covered header field
+     * with the given identifier to the sink.
+     *
+     * @param[in] headers
+     *     These are the headers of the message.
+     *
+     * @param[in] identifier
+     *     This is the identifier of the covered header field.
+     *
+     * @param[in] sink
+     *     This is the function which receives the value.
+     *
+     * @return
+     *     An indication of whether or not the message has the
+     *     header field, in the form required, is returned.
+     */
+    bool SendHeaderField(
+        const MessageHeaders::MessageHeaders& headers,
+        const ComponentIdentifier& identifier,
+        const MessageHeaders::SignatureBaseSink& sink
+    ) {
+        if (identifier.hasName) {
+            return false;
+        }
+        const auto count = headers.GetHeaderCount();
+        auto index = headers.FindHeader(identifier.name);
+        if (index == count) {
+            return false;
+        }
+        sink(identifier.text);
+        sink(": ");
+
+        // Dictionary members are looked for in every instance of the
+        // field; the last one with the key is the one that counts.
+        if (identifier.hasKey) {
+            std::string_view lastMember;
+            bool found = false;
+            for (; index < count; index = headers.FindHeader(identifier.name, index + 1)) {
+                ForEachMember(
+                    headers.GetHeader(index).value,
+                    [&](std::string_view member) {
+                        const auto keyEnd = member.find_first_of("=;");
+                        if (member.substr(0, keyEnd) == identifier.key) {
+                            lastMember = member;
+                            found = true;
+                        }
+                    }
+                );
+            }
+            if (!found) {
+                return false;
+            }
+            const auto keyEnd = identifier.key.length();
+            if (
+                (keyEnd < lastMember.length())
+                && (lastMember[keyEnd] == '=')
+            ) {
+                SendStructuredMember(StripWhitespace(lastMember.substr(keyEnd + 1)), sink);
+            } else {
+                sink("?1");
+                sink(lastMember.substr(keyEnd));
+            }
+            return true;
+        }
+
+        // Otherwise every instance of the field is sent,
+        // separated by commas.
+        bool first = true;
+        for (; index < count; index = headers.FindHeader(identifier.name, index + 1)) {
+            const auto value = StripWhitespace(headers.GetHeader(index).value);
+            if (identifier.sf) {
+                ForEachMember(
+                    value,
+                    [&](std::string_view member) {
+                        if (member.empty()) {
+                            return;
+                        }
+                        if (!first) {
+                            sink(", ");
+                        }
+                        first = false;
+                        SendStructuredMember(member, sink);
+                    }
+                );
+                continue;
+            }
+            if (!first) {
+                sink(", ");
+            }
+            first = false;
+            if (identifier.bs) {
+                SendByteSequence(value, sink);
+            } else {
+                sink(value);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * This function sends the line or lines of the covered derived
+     * component with the given identifier to the sink.
+     *
+     * @param[in] derivedComponents
+     *     These are the parts of the message from which
+     *     derived components take their values.
+     *
+     * @param[in] identifier
+     *     This is the identifier of the covered derived component.
+     *
+     * @param[in] sink
+     *     This is the function which receives the lines.
+     *
+     * @return
+     *     An indication of whether or not the message has the
+     *     derived component is returned.
+     */
+    bool SendDerivedComponent(
+        const MessageHeaders::SignatureDerivedComponents& derivedComponents,
+        const ComponentIdentifier& identifier,
+        const MessageHeaders::SignatureBaseSink& sink
+    ) {
+        if (
+            identifier.sf
+            || identifier.bs
+            || identifier.hasKey
+            || (identifier.hasName != (identifier.name == "@query-param"))
+        ) {
+            return false;
+        }
+        const auto& name = identifier.name;
+
+        // Every query parameter with the name gets its own line.
+        if (name == "@query-param") {
+            auto query = derivedComponents.query;
+            if (
+                !query.empty()
+                && (query[0] == '?')
+            ) {
+                query.remove_prefix(1);
+            }
+            bool found = false;
+            while (!query.empty()) {
+                const auto parameterEnd = query.find('&');
+                const auto parameter = query.substr(0, parameterEnd);
+                query = (
+                    (parameterEnd == std::string_view::npos)
+                    ? std::string_view()
+                    : query.substr(parameterEnd + 1)
+                );
+                const auto nameEnd = parameter.find('=');
+                if (parameter.substr(0, nameEnd) != identifier.nameParameter) {
+                    continue;
+                }
+                if (found) {
+                    sink("\n");
+                }
+                found = true;
+                sink(identifier.text);
+                sink(": ");
+                if (nameEnd != std::string_view::npos) {
+                    sink(parameter.substr(nameEnd + 1));
+                }
+            }
+            return found;
+        }
+
+        std::string_view value;
+        bool lowercase = false;
+        if (name == "@method") {
+            value = derivedComponents.method;
+        } else if (name == "@target-uri") {
+            value = derivedComponents.targetUri;
+        } else if (name == "@authority") {
+            value = derivedComponents.authority;
+            lowercase = true;
+        } else if (name == "@scheme") {
+            value = derivedComponents.scheme;
+            lowercase = true;
+        } else if (name == "@request-target") {
+            value = derivedComponents.requestTarget;
+        } else if (name == "@path") {
+            value = derivedComponents.path;
+        } else if (name == "@query") {
+            value = derivedComponents.query.empty() ? "?" : derivedComponents.query;
+        } else if (name == "@status") {
+            value = derivedComponents.status;
+        } else {
+            return false;
+        }
+        if (value.empty()) {
+            return false;
+        }
+        sink(identifier.text);
+        sink(": ");
+        if (lowercase) {
+            SendLowercase(value, sink);
+        } else {
+            sink(value);
+        }
+        return true;
+    }
+}
+
+namespace MessageHeaders {
+    bool BuildSignatureBase(
+        const MessageHeaders& headers,
+        const SignatureDerivedComponents& derivedComponents,
+        std::string_view signatureParams,
+        const SignatureBaseSink& sink
+    ) {
+        signatureParams = StripWhitespace(signatureParams);
+        if (
+            signatureParams.empty()
+            || (signatureParams[0] != '(')
+        ) {
+            return false;
+        }
+        std::vector< std::string_view > covered;
+        size_t offset = 1;
+        while (true) {
+            while (
+                (offset < signatureParams.length())
+                && (signatureParams[offset] == ' ')
+            ) {
+                ++offset;
+            }
+            if (offset >= signatureParams.length()) {
+                return false;
+            }
+            if (signatureParams[offset] == ')') {
+                break;
+            }
+            ComponentIdentifier identifier;
+            if (
+                !ReadComponentIdentifier(signatureParams, offset, identifier)
+                || (
+                    (offset < signatureParams.length())
+                    && (signatureParams[offset] != ' ')
+                    && (signatureParams[offset] != ')')
+                )
+                || (identifier.name == "@signature-params")
+            ) {
+                return false;
+            }
+            for (const auto& previous: covered) {
+                if (previous == identifier.text) {
+                    return false;
+                }
+            }
+            covered.push_back(identifier.text);
+            if (identifier.name[0] == '@') {
+                if (!SendDerivedComponent(derivedComponents, identifier, sink)) {
+                    return false;
+                }
+            } else if (!SendHeaderField(headers, identifier, sink)) {
+                return false;
+            }
+            sink("\n");
+        }
+        sink("\"@signature-params\": ");
+        sink(signatureParams);
+        return true;
+    }
+}
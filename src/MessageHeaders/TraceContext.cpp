@@ -0,0 +1,433 @@
+/**
+ * @file TraceContext.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::TraceContext class and related functions.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <array>
+#include <MessageHeaders/TraceContext.hpp>
+
+namespace {
+    /**
+     * These are the names of the trace context headers.
+     */
+    constexpr std::string_view TRACEPARENT = "traceparent";
+    constexpr std::string_view TRACESTATE = "tracestate";
+    constexpr std::string_view BAGGAGE = "baggage";
+
+    /**
+     * These are the positions of the fields of a traceparent
+     * header, and the length of a version 00 header.
+     */
+    constexpr size_t VERSION_POSITION = 0;
+    constexpr size_t TRACE_ID_POSITION = 3;
+    constexpr size_t PARENT_ID_POSITION = 36;
+    constexpr size_t FLAGS_POSITION = 53;
+    constexpr size_t TRACEPARENT_LENGTH = 55;
+
+    /**
+     * This is the value in the hex digit table for characters
+     * which aren't lowercase hex digits.
+     */
+    constexpr uint8_t NOT_HEX = 0xFF;
+
+    /**
+     * This function builds the table giving the value of each
+     * lowercase hex digit, and NOT_HEX for every other character.
+     *
+     * @return
+     *     The hex digit table is returned.
+     */
+    constexpr std::array< uint8_t, 256 > MakeHexDigits() {
+        std::array< uint8_t, 256 > digits{};
+        for (size_t i = 0; i < digits.size(); ++i) {
+            digits[i] = NOT_HEX;
+        }
+        for (uint8_t i = 0; i < 10; ++i) {
+            digits['0' + i] = i;
+        }
+        for (uint8_t i = 0; i < 6; ++i) {
+            digits['a' + i] = 10 + i;
+        }
+        return digits;
+    }
+
+    /**
+     * This is the hex digit table.
+     */
+    constexpr auto HEX_DIGITS = MakeHexDigits();
+
+    /**
+     * These are the lowercase hex digits, by value.
+     */
+    constexpr char HEX_CHARACTERS[] = "0123456789abcdef";
+
+    /**
+     * This function reads a fixed number of lowercase
+     * hex digits from the given position.
+     *
+     * @param[in] s
+     *     This is the text from which to read the digits.
+     *
+     * @param[in] position
+     *     This is the position of the first digit.
+     *
+     * @param[in] digits
+     *     This is the number of digits to read, at most 16.
+     *
+     * @param[out] number
+     *     This is where to store the number read.
+     *
+     * @return
+     *     An indication of whether or not all the characters
+     *     read were lowercase hex digits is returned.
+     */
+    bool ReadHex(std::string_view s, size_t position, size_t digits, uint64_t& number) {
+        uint64_t result = 0;
+        uint8_t check = 0;
+        for (size_t i = 0; i < digits; ++i) {
+            const auto digit = HEX_DIGITS[(uint8_t)s[position + i]];
+            check |= digit;
+            result = (result << 4) | (digit & 0x0F);
+        }
+        if (check == NOT_HEX) {
+            return false;
+        }
+        number = result;
+        return true;
+    }
+
+    /**
+     * This function writes the given number as a fixed number
+     * of lowercase hex digits, over the characters at the
+     * given position.
+     *
+     * @param[in] number
+     *     This is the number to write.
+     *
+     * @param[in] digits
+     *     This is the number of digits to write, at most 16.
+     *
+     * @param[in,out] s
+     *     This is where to write the digits.
+     *
+     * @param[in] position
+     *     This is the position of the first digit.
+     */
+    void WriteHex(uint64_t number, size_t digits, std::string& s, size_t position) {
+        for (size_t i = digits; i > 0; --i) {
+            s[position + i - 1] = HEX_CHARACTERS[number & 0x0F];
+            number >>= 4;
+        }
+    }
+
+    /**
+     * This function returns the part of the given text
+     * without any whitespace at either end.
+     *
+     * @param[in] s
+     *     This is the text to strip.
+     *
+     * @return
+     *     The stripped text is returned.
+     */
+    std::string_view StripWhitespace(std::string_view s) {
+        while (
+            !s.empty()
+            && ((s.front() == ' ') || (s.front() == '\t'))
+        ) {
+            s.remove_prefix(1);
+        }
+        while (
+            !s.empty()
+            && ((s.back() == ' ') || (s.back() == '\t'))
+        ) {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+}
+
+namespace MessageHeaders {
+    bool ParseTraceParent(std::string_view value, TraceParent& traceParent) {
+        if (
+            (value.length() < TRACEPARENT_LENGTH)
+            || (value[TRACE_ID_POSITION - 1] != '-')
+            || (value[PARENT_ID_POSITION - 1] != '-')
+            || (value[FLAGS_POSITION - 1] != '-')
+        ) {
+            return false;
+        }
+        uint64_t version, traceIdHigh, traceIdLow, parentId, flags;
+        if (
+            !ReadHex(value, VERSION_POSITION, 2, version)
+            || !ReadHex(value, TRACE_ID_POSITION, 16, traceIdHigh)
+            || !ReadHex(value, TRACE_ID_POSITION + 16, 16, traceIdLow)
+            || !ReadHex(value, PARENT_ID_POSITION, 16, parentId)
+            || !ReadHex(value, FLAGS_POSITION, 2, flags)
+        ) {
+            return false;
+        }
+
+        // Version ff is forbidden, version 00 has nothing after the
+        // flags, and later versions may only add fields after them.
+        if (
+            (version == 0xFF)
+            || (
+                (value.length() > TRACEPARENT_LENGTH)
+                && (
+                    (version == 0)
+                    || (value[TRACEPARENT_LENGTH] != '-')
+                )
+            )
+            || ((traceIdHigh | traceIdLow) == 0)
+            || (parentId == 0)
+        ) {
+            return false;
+        }
+        traceParent.version = (uint8_t)version;
+        traceParent.traceIdHigh = traceIdHigh;
+        traceParent.traceIdLow = traceIdLow;
+        traceParent.parentId = parentId;
+        traceParent.flags = (uint8_t)flags;
+        return true;
+    }
+
+    void AppendTraceParent(const TraceParent& traceParent, std::string& output) {
+        const auto start = output.length();
+        output.resize(start + TRACEPARENT_LENGTH, '-');
+        WriteHex(traceParent.version, 2, output, start + VERSION_POSITION);
+        WriteHex(traceParent.traceIdHigh, 16, output, start + TRACE_ID_POSITION);
+        WriteHex(traceParent.traceIdLow, 16, output, start + TRACE_ID_POSITION + 16);
+        WriteHex(traceParent.parentId, 16, output, start + PARENT_ID_POSITION);
+        WriteHex(traceParent.flags, 2, output, start + FLAGS_POSITION);
+    }
+
+    TraceContextList::Iterator::Iterator(std::string_view rest)
+        : rest_(rest)
+    {
+        Next();
+    }
+
+    TraceContextList::Iterator::Iterator(
+        const MessageHeaders* headers,
+        std::string_view name,
+        size_t index,
+        std::string_view rest
+    )
+        : headers_(headers)
+        , name_(name)
+        , index_(index)
+        , rest_(rest)
+    {
+        Next();
+    }
+
+    auto TraceContextList::Iterator::operator*() const -> const Member& {
+        return member_;
+    }
+
+    auto TraceContextList::Iterator::operator->() const -> const Member* {
+        return &member_;
+    }
+
+    auto TraceContextList::Iterator::operator++() -> Iterator& {
+        Next();
+        return *this;
+    }
+
+    bool TraceContextList::Iterator::operator==(const Iterator& rhs) const {
+        if (atEnd_ || rhs.atEnd_) {
+            return atEnd_ == rhs.atEnd_;
+        }
+        return (
+            (index_ == rhs.index_)
+            && (rest_.data() == rhs.rest_.data())
+            && (rest_.length() == rhs.rest_.length())
+        );
+    }
+
+    bool TraceContextList::Iterator::operator!=(const Iterator& rhs) const {
+        return !(*this == rhs);
+    }
+
+    void TraceContextList::Iterator::Next() {
+        for (;;) {
+            // Carry on with the next header holding the list, if
+            // the list is spread over more than one.
+            if (rest_.empty()) {
+                if (
+                    (headers_ == nullptr)
+                    || (index_ >= headers_->GetHeaderCount())
+                ) {
+                    break;
+                }
+                index_ = headers_->FindHeader(name_, index_ + 1);
+                if (index_ == headers_->GetHeaderCount()) {
+                    break;
+                }
+                rest_ = headers_->GetHeader(index_).value;
+                continue;
+            }
+            const auto memberDelimiter = rest_.find(',');
+            const auto member = StripWhitespace(rest_.substr(0, memberDelimiter));
+            if (memberDelimiter == std::string_view::npos) {
+                rest_ = std::string_view();
+            } else {
+                rest_.remove_prefix(memberDelimiter + 1);
+            }
+            if (member.empty()) {
+                continue;
+            }
+            const auto propertiesDelimiter = member.find(';');
+            const auto pair = member.substr(0, propertiesDelimiter);
+            if (propertiesDelimiter == std::string_view::npos) {
+                member_.properties = std::string_view();
+            } else {
+                member_.properties = StripWhitespace(member.substr(propertiesDelimiter + 1));
+            }
+            const auto keyValueDelimiter = pair.find('=');
+            member_.key = StripWhitespace(pair.substr(0, keyValueDelimiter));
+            if (keyValueDelimiter == std::string_view::npos) {
+                member_.value = std::string_view();
+            } else {
+                member_.value = StripWhitespace(pair.substr(keyValueDelimiter + 1));
+            }
+            return;
+        }
+        atEnd_ = true;
+    }
+
+    TraceContextList::TraceContextList(std::string_view list)
+        : list_(list)
+    {
+    }
+
+    TraceContextList::TraceContextList(
+        const MessageHeaders& headers,
+        std::string_view name,
+        size_t startIndex
+    )
+        : headers_(&headers)
+        , name_(name)
+        , index_(headers.FindHeader(name, startIndex))
+    {
+        if (index_ < headers.GetHeaderCount()) {
+            list_ = headers.GetHeader(index_).value;
+        }
+    }
+
+    auto TraceContextList::begin() const -> Iterator {
+        if (headers_ == nullptr) {
+            return Iterator(list_);
+        }
+        return Iterator(headers_, name_, index_, list_);
+    }
+
+    auto TraceContextList::end() const -> Iterator {
+        return Iterator(std::string_view());
+    }
+
+    bool TraceContextList::Find(std::string_view key, std::string_view& value) const {
+        for (const auto& member: *this) {
+            if (member.key == key) {
+                value = member.value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    TraceContext::TraceContext(const MessageHeaders& headers)
+        : headers_(&headers)
+        , traceStateIndex_(headers.GetHeaderCount())
+        , baggageIndex_(headers.GetHeaderCount())
+    {
+        bool haveTraceParent = false;
+        bool haveTraceState = false;
+        bool haveBaggage = false;
+        const auto count = headers.GetHeaderCount();
+        for (size_t index = 0; index < count; ++index) {
+            const auto& header = headers.GetHeader(index);
+            const std::string& name = header.name;
+            if (
+                !haveTraceParent
+                && HeaderNamesEqual(name, TRACEPARENT)
+            ) {
+                traceParent_ = header.value;
+                haveTraceParent = true;
+            } else if (
+                !haveTraceState
+                && HeaderNamesEqual(name, TRACESTATE)
+            ) {
+                traceStateIndex_ = index;
+                haveTraceState = true;
+            } else if (
+                !haveBaggage
+                && HeaderNamesEqual(name, BAGGAGE)
+            ) {
+                baggageIndex_ = index;
+                haveBaggage = true;
+            }
+        }
+    }
+
+    bool TraceContext::GetTraceParent(TraceParent& traceParent) const {
+        return ParseTraceParent(traceParent_, traceParent);
+    }
+
+    TraceContextList TraceContext::GetTraceState() const {
+        return TraceContextList(*headers_, TRACESTATE, traceStateIndex_);
+    }
+
+    TraceContextList TraceContext::GetBaggage() const {
+        return TraceContextList(*headers_, BAGGAGE, baggageIndex_);
+    }
+
+    void SetTraceParent(MessageHeaders& headers, const TraceParent& traceParent) {
+        const auto index = headers.FindHeader(TRACEPARENT);
+        if (index == headers.GetHeaderCount()) {
+            headers.AddHeader(std::string(TRACEPARENT), std::string());
+        }
+        headers.EditHeaderValue(
+            index,
+            [&traceParent](std::string& value) {
+                value.clear();
+                AppendTraceParent(traceParent, value);
+            }
+        );
+    }
+
+    bool ForwardTraceParent(MessageHeaders& headers, uint64_t parentId, bool sampled) {
+        const auto index = headers.FindHeader(TRACEPARENT);
+        if (index == headers.GetHeaderCount()) {
+            return false;
+        }
+        TraceParent traceParent;
+        if (!ParseTraceParent(headers.GetHeader(index).value, traceParent)) {
+            return false;
+        }
+        const uint8_t flags = (traceParent.flags & ~0x01) | (sampled ? 0x01 : 0x00);
+        headers.EditHeaderValue(
+            index,
+            [&traceParent, parentId, flags](std::string& value) {
+                // Headers of later versions are passed on as version 00,
+                // since that's the only version we know how to produce.
+                if (traceParent.version != 0) {
+                    traceParent.version = 0;
+                    traceParent.parentId = parentId;
+                    traceParent.flags = flags;
+                    value.clear();
+                    AppendTraceParent(traceParent, value);
+                    return;
+                }
+                WriteHex(parentId, 16, value, PARENT_ID_POSITION);
+                WriteHex(flags, 2, value, FLAGS_POSITION);
+            }
+        );
+        return true;
+    }
+}
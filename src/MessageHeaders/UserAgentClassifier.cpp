@@ -0,0 +1,629 @@
+/**
+ * @file UserAgentClassifier.cpp
+ *
+ * This module contains the implementation of the
+ * MessageHeaders::UserAgentClassifier class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <MessageHeaders/UserAgentClassifier.hpp>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    /**
+     * These are the tokens looked for in User-Agent header values.
+     * They're listed in the same order in TOKENS.
+     */
+    enum Token {
+        TOKEN_EDG,
+        TOKEN_EDGE,
+        TOKEN_EDGA,
+        TOKEN_EDGIOS,
+        TOKEN_OPR,
+        TOKEN_OPERA,
+        TOKEN_MSIE,
+        TOKEN_TRIDENT,
+        TOKEN_FIREFOX,
+        TOKEN_FXIOS,
+        TOKEN_CHROME,
+        TOKEN_CRIOS,
+        TOKEN_SAFARI,
+        TOKEN_WINDOWS,
+        TOKEN_ANDROID,
+        TOKEN_IPHONE,
+        TOKEN_IPAD,
+        TOKEN_IPOD,
+        TOKEN_MAC_OS_X,
+        TOKEN_CROS,
+        TOKEN_LINUX,
+        TOKEN_MOBILE,
+        TOKEN_TABLET,
+        TOKEN_BOT,
+        TOKEN_SPIDER,
+        TOKEN_CRAWL,
+        TOKEN_SLURP,
+        TOKEN_HEADLESS,
+        TOKEN_INFO_URL,
+        TOKEN_CURL,
+        TOKEN_WGET,
+        TOKEN_PYTHON,
+        TOKEN_GO_HTTP_CLIENT,
+        TOKEN_JAVA,
+        TOKEN_OKHTTP,
+        TOKEN_LIBWWW,
+        TOKEN_COUNT
+    };
+
+    /**
+     * These are the tokens looked for in User-Agent header values,
+     * in lowercase, since case is ignored.
+     */
+    constexpr const char* TOKENS[TOKEN_COUNT] = {
+        "edg/",
+        "edge/",
+        "edga/",
+        "edgios/",
+        "opr/",
+        "opera",
+        "msie ",
+        "trident/",
+        "firefox/",
+        "fxios/",
+        "chrome/",
+        "crios/",
+        "safari/",
+        "windows",
+        "android",
+        "iphone",
+        "ipad",
+        "ipod",
+        "mac os x",
+        "cros",
+        "linux",
+        "mobile",
+        "tablet",
+        "bot",
+        "spider",
+        "crawl",
+        "slurp",
+        "headless",
+        "+http",
+        "curl/",
+        "wget/",
+        "python-",
+        "go-http-client",
+        "java/",
+        "okhttp",
+        "libwww",
+    };
+
+    static_assert(TOKEN_COUNT <= 64, "tokens must fit in a 64-bit mask");
+
+    /**
+     * This function returns the mask with the bit
+     * for the given token set.
+     *
+     * @param[in] token
+     *     This is the token whose bit to set.
+     *
+     * @return
+     *     The mask with the bit for the token set is returned.
+     */
+    constexpr uint64_t Bit(Token token) {
+        return (uint64_t)1 << token;
+    }
+
+    /**
+     * These are the tokens which mark automated clients
+     * wherever they're found.
+     */
+    constexpr uint64_t BOT_TOKENS = (
+        Bit(TOKEN_BOT)
+        | Bit(TOKEN_SPIDER)
+        | Bit(TOKEN_CRAWL)
+        | Bit(TOKEN_SLURP)
+        | Bit(TOKEN_HEADLESS)
+        | Bit(TOKEN_INFO_URL)
+    );
+
+    /**
+     * These are the tokens which mark automated clients
+     * only when the header value begins with them.
+     */
+    constexpr uint64_t TOOL_TOKENS = (
+        Bit(TOKEN_CURL)
+        | Bit(TOKEN_WGET)
+        | Bit(TOKEN_PYTHON)
+        | Bit(TOKEN_GO_HTTP_CLIENT)
+        | Bit(TOKEN_JAVA)
+        | Bit(TOKEN_OKHTTP)
+        | Bit(TOKEN_LIBWWW)
+    );
+
+    /**
+     * These are the tokens which only count when they end a
+     * product name: when followed by '/', '-', ';', ')', or the end
+     * of the value.  So "Googlebot/2.1", "DuckDuckBot-Https" and
+     * "YandexBot)" have the bot token, but device names such as
+     * "CUBOT X19" and "CUBOT_X19" don't.
+     */
+    constexpr uint64_t PRODUCT_END_TOKENS = (
+        Bit(TOKEN_BOT)
+    );
+
+    /**
+     * These are the tokens which only count when they end a word.
+     */
+    constexpr uint64_t WORD_END_TOKENS = (
+        Bit(TOKEN_CROS)
+    );
+
+    /**
+     * These are the tokens which only count when they begin a word,
+     * so "CrOS" is found in "X11; CrOS x86_64" but not in "Microsoft".
+     */
+    constexpr uint64_t WORD_START_TOKENS = (
+        Bit(TOKEN_CROS)
+    );
+
+    /**
+     * This function determines whether or not the given
+     * character may be part of a word.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character
+     *     may be part of a word is returned.
+     */
+    bool IsWordCharacter(char c) {
+        return (
+            ((c >= 'a') && (c <= 'z'))
+            || ((c >= 'A') && (c <= 'Z'))
+            || ((c >= '0') && (c <= '9'))
+            || (c == '_')
+        );
+    }
+
+    /**
+     * This function determines whether or not the given
+     * character may end a product name.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character
+     *     may end a product name is returned.
+     */
+    bool IsProductEnd(char c) {
+        return (
+            (c == '/')
+            || (c == '-')
+            || (c == ';')
+            || (c == ')')
+        );
+    }
+
+    /**
+     * This is the number of shards into which the cache is split.
+     */
+    constexpr size_t CACHE_SHARDS = 16;
+
+    /**
+     * This is the automaton which finds every token in a
+     * User-Agent header value in one pass (Aho-Corasick).  Every
+     * transition is worked out ahead of time, so each character
+     * costs one table lookup.  Characters are first mapped to
+     * classes, one per character appearing in any token plus one
+     * for all others, to keep the table small.
+     */
+    class TokenMatcher {
+        // Public Methods
+    public:
+        /**
+         * This is the result of scanning a header value.
+         */
+        struct Matches {
+            /**
+             * These are the tokens found anywhere in the value.
+             */
+            uint64_t anywhere = 0;
+
+            /**
+             * These are the tokens found at the start of the value.
+             */
+            uint64_t atStart = 0;
+        };
+
+        /**
+         * This builds the automaton for the tokens.
+         */
+        TokenMatcher() {
+            // Give each character used in a token its own class.
+            size_t classCount = 1;
+            for (const auto token : TOKENS) {
+                for (auto c = token; *c != '\0'; ++c) {
+                    auto& characterClass = classes_[(unsigned char)*c];
+                    if (characterClass == 0) {
+                        characterClass = (uint8_t)classCount++;
+                    }
+                }
+            }
+            for (int c = 'A'; c <= 'Z'; ++c) {
+                classes_[c] = classes_[c + ('a' - 'A')];
+            }
+            classCount_ = classCount;
+
+            // Build the tree of token prefixes.
+            AddState(0);
+            for (size_t token = 0; token < TOKEN_COUNT; ++token) {
+                size_t state = 0;
+                for (auto c = TOKENS[token]; *c != '\0'; ++c) {
+                    const auto transition = state * classCount_ + classes_[(unsigned char)*c];
+                    if (transitions_[transition] == 0) {
+                        const auto next = AddState(depths_[state] + 1);
+                        transitions_[transition] = (uint16_t)next;
+                    }
+                    state = transitions_[transition];
+                }
+                outputs_[state] |= Bit((Token)token);
+                ownTokens_[state] = Bit((Token)token);
+                lengths_[token] = depths_[state];
+            }
+
+            // Fill in the remaining transitions, breadth first, from
+            // those of the longest proper suffix of each prefix.
+            std::vector< uint16_t > fallbacks(depths_.size(), 0);
+            std::queue< size_t > pending;
+            for (size_t characterClass = 0; characterClass < classCount_; ++characterClass) {
+                const auto next = transitions_[characterClass];
+                if (next != 0) {
+                    pending.push(next);
+                }
+            }
+            while (!pending.empty()) {
+                const auto state = pending.front();
+                pending.pop();
+                outputs_[state] |= outputs_[fallbacks[state]];
+                for (size_t characterClass = 0; characterClass < classCount_; ++characterClass) {
+                    auto& next = transitions_[state * classCount_ + characterClass];
+                    const auto fallbackNext = transitions_[fallbacks[state] * classCount_ + characterClass];
+                    if (next == 0) {
+                        next = fallbackNext;
+                    } else {
+                        fallbacks[next] = fallbackNext;
+                        pending.push(next);
+                    }
+                }
+            }
+        }
+
+        /**
+         * This method finds the tokens in the given header value.
+         *
+         * @param[in] value
+         *     This is the header value to scan.
+         *
+         * @return
+         *     The tokens found are returned.
+         */
+        Matches Scan(std::string_view value) const {
+            Matches matches;
+            size_t state = 0;
+            for (size_t i = 0; i < value.length(); ++i) {
+                state = transitions_[state * classCount_ + classes_[(unsigned char)value[i]]];
+                auto found = outputs_[state];
+                if (
+                    ((found & PRODUCT_END_TOKENS) != 0)
+                    && (i + 1 < value.length())
+                    && !IsProductEnd(value[i + 1])
+                ) {
+                    found &= ~PRODUCT_END_TOKENS;
+                }
+                if (
+                    ((found & WORD_END_TOKENS) != 0)
+                    && (i + 1 < value.length())
+                    && IsWordCharacter(value[i + 1])
+                ) {
+                    found &= ~WORD_END_TOKENS;
+                }
+                if ((found & WORD_START_TOKENS) != 0) {
+                    for (size_t token = 0; token < TOKEN_COUNT; ++token) {
+                        if (
+                            ((found & WORD_START_TOKENS & Bit((Token)token)) != 0)
+                            && (lengths_[token] <= i)
+                            && IsWordCharacter(value[i - lengths_[token]])
+                        ) {
+                            found &= ~Bit((Token)token);
+                        }
+                    }
+                }
+                matches.anywhere |= found;
+                if (depths_[state] == i + 1) {
+                    matches.atStart |= ownTokens_[state];
+                }
+            }
+            return matches;
+        }
+
+        // Private Methods
+    private:
+        /**
+         * This method adds a state to the automaton.
+         *
+         * @param[in] depth
+         *     This is the length of the prefix the state stands for.
+         *
+         * @return
+         *     The number of the new state is returned.
+         */
+        size_t AddState(size_t depth) {
+            transitions_.resize(transitions_.size() + classCount_, 0);
+            outputs_.push_back(0);
+            ownTokens_.push_back(0);
+            depths_.push_back(depth);
+            return depths_.size() - 1;
+        }
+
+        // Private properties
+    private:
+        /**
+         * This maps each character to its class.
+         */
+        std::array< uint8_t, 256 > classes_{};
+
+        /**
+         * This is the number of character classes.
+         */
+        size_t classCount_ = 0;
+
+        /**
+         * This is the next state for each state and character class.
+         */
+        std::vector< uint16_t > transitions_;
+
+        /**
+         * These are the tokens found on reaching each state.
+         */
+        std::vector< uint64_t > outputs_;
+
+        /**
+         * This is the token, if any, spelled out by
+         * the whole prefix each state stands for.
+         */
+        std::vector< uint64_t > ownTokens_;
+
+        /**
+         * This is the length of the prefix each state stands for.
+         */
+        std::vector< size_t > depths_;
+
+        /**
+         * This is the length of each token.
+         */
+        std::array< size_t, TOKEN_COUNT > lengths_{};
+    };
+
+    /**
+     * This function returns the automaton for the tokens,
+     * building it the first time it's needed.
+     *
+     * @return
+     *     The automaton for the tokens is returned.
+     */
+    const TokenMatcher& GetTokenMatcher() {
+        static const TokenMatcher matcher;
+        return matcher;
+    }
+
+    /**
+     * This is a User-Agent header value whose result is cached.
+     */
+    struct CacheEntry {
+        /**
+         * This is the hash of the header value.
+         */
+        size_t hash;
+
+        /**
+         * This is the header value, kept to rule out
+         * two values sharing a hash.
+         */
+        std::string userAgent;
+
+        /**
+         * This is what was made of the header value.
+         */
+        MessageHeaders::UserAgentClass result;
+    };
+
+    /**
+     * This is one shard of the cache, holding its entries with
+     * the most recently used first.
+     */
+    struct CacheShard {
+        /**
+         * This is held while the shard is used.
+         */
+        std::mutex mutex;
+
+        /**
+         * These are the entries, most recently used first.
+         */
+        std::list< CacheEntry > entries;
+
+        /**
+         * This finds entries by the hash of their header values.
+         */
+        std::unordered_map< size_t, std::list< CacheEntry >::iterator > index;
+    };
+}
+
+namespace MessageHeaders {
+    /**
+     * This contains the private properties of a
+     * UserAgentClassifier instance.
+     */
+    struct UserAgentClassifier::Impl {
+        /**
+         * These are the shards of the cache.
+         */
+        std::array< CacheShard, CACHE_SHARDS > shards;
+
+        /**
+         * This is the largest number of entries each shard may hold.
+         */
+        size_t shardCapacity = 0;
+
+        /**
+         * These count the cache hits and misses.
+         */
+        std::atomic< size_t > hits{0};
+        std::atomic< size_t > misses{0};
+    };
+
+    UserAgentClassifier::~UserAgentClassifier() = default;
+    UserAgentClassifier::UserAgentClassifier(UserAgentClassifier&&) = default;
+    UserAgentClassifier& UserAgentClassifier::operator=(UserAgentClassifier&&) = default;
+
+    UserAgentClassifier::UserAgentClassifier(size_t cacheCapacity)
+        : impl_(new Impl)
+    {
+        impl_->shardCapacity = (cacheCapacity + CACHE_SHARDS - 1) / CACHE_SHARDS;
+        (void)GetTokenMatcher();
+    }
+
+    UserAgentClass UserAgentClassifier::Classify(const MessageHeaders& requestHeaders) {
+        const auto index = requestHeaders.FindHeader("User-Agent");
+        if (index == requestHeaders.GetHeaderCount()) {
+            return UserAgentClass();
+        }
+        return Classify(requestHeaders.GetHeader(index).value);
+    }
+
+    UserAgentClass UserAgentClassifier::Classify(std::string_view userAgent) {
+        if (impl_->shardCapacity == 0) {
+            ++impl_->misses;
+            return ClassifyUserAgent(userAgent);
+        }
+        const auto hash = std::hash< std::string_view >()(userAgent);
+        auto& shard = impl_->shards[hash % CACHE_SHARDS];
+        {
+            std::lock_guard< decltype(shard.mutex) > lock(shard.mutex);
+            const auto entry = shard.index.find(hash);
+            if (
+                (entry != shard.index.end())
+                && (entry->second->userAgent == userAgent)
+            ) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, entry->second);
+                ++impl_->hits;
+                return entry->second->result;
+            }
+        }
+
+        // Scan the header value without holding the lock, so that
+        // other threads may use the shard in the meantime.
+        ++impl_->misses;
+        const auto result = ClassifyUserAgent(userAgent);
+        std::lock_guard< decltype(shard.mutex) > lock(shard.mutex);
+        const auto entry = shard.index.find(hash);
+        if (entry != shard.index.end()) {
+            entry->second->userAgent.assign(userAgent.data(), userAgent.length());
+            entry->second->result = result;
+            shard.entries.splice(shard.entries.begin(), shard.entries, entry->second);
+            return result;
+        }
+        shard.entries.push_front({hash, std::string(userAgent), result});
+        shard.index[hash] = shard.entries.begin();
+        if (shard.entries.size() > impl_->shardCapacity) {
+            shard.index.erase(shard.entries.back().hash);
+            shard.entries.pop_back();
+        }
+        return result;
+    }
+
+    size_t UserAgentClassifier::GetCacheHitCount() const {
+        return impl_->hits;
+    }
+
+    size_t UserAgentClassifier::GetCacheMissCount() const {
+        return impl_->misses;
+    }
+
+    UserAgentClass ClassifyUserAgent(std::string_view userAgent) {
+        const auto matches = GetTokenMatcher().Scan(userAgent);
+        const auto found = [&matches](Token token) {
+            return (matches.anywhere & Bit(token)) != 0;
+        };
+        UserAgentClass result;
+
+        // Browsers name the browsers they're based on as well as
+        // themselves, so the most specific one found wins.
+        if (
+            found(TOKEN_EDG)
+            || found(TOKEN_EDGE)
+            || found(TOKEN_EDGA)
+            || found(TOKEN_EDGIOS)
+        ) {
+            result.browser = UserAgentBrowser::Edge;
+        } else if (found(TOKEN_OPR) || found(TOKEN_OPERA)) {
+            result.browser = UserAgentBrowser::Opera;
+        } else if (found(TOKEN_MSIE) || found(TOKEN_TRIDENT)) {
+            result.browser = UserAgentBrowser::InternetExplorer;
+        } else if (found(TOKEN_FIREFOX) || found(TOKEN_FXIOS)) {
+            result.browser = UserAgentBrowser::Firefox;
+        } else if (found(TOKEN_CHROME) || found(TOKEN_CRIOS)) {
+            result.browser = UserAgentBrowser::Chrome;
+        } else if (found(TOKEN_SAFARI)) {
+            result.browser = UserAgentBrowser::Safari;
+        }
+
+        // Mobile systems also claim to be like the desktop
+        // systems they descend from, so they're checked first.
+        if (found(TOKEN_IPAD)) {
+            result.os = UserAgentOs::Ios;
+            result.device = UserAgentDevice::Tablet;
+        } else if (found(TOKEN_IPHONE) || found(TOKEN_IPOD)) {
+            result.os = UserAgentOs::Ios;
+            result.device = UserAgentDevice::Mobile;
+        } else if (found(TOKEN_ANDROID)) {
+            result.os = UserAgentOs::Android;
+            result.device = (
+                (found(TOKEN_MOBILE) && !found(TOKEN_TABLET))
+                ? UserAgentDevice::Mobile
+                : UserAgentDevice::Tablet
+            );
+        } else if (found(TOKEN_WINDOWS)) {
+            result.os = UserAgentOs::Windows;
+            result.device = UserAgentDevice::Desktop;
+        } else if (found(TOKEN_MAC_OS_X)) {
+            result.os = UserAgentOs::MacOs;
+            result.device = UserAgentDevice::Desktop;
+        } else if (found(TOKEN_CROS)) {
+            result.os = UserAgentOs::ChromeOs;
+            result.device = UserAgentDevice::Desktop;
+        } else if (found(TOKEN_LINUX)) {
+            result.os = UserAgentOs::Linux;
+            result.device = UserAgentDevice::Desktop;
+        }
+
+        // Libraries and command-line tools name themselves first,
+        // while browsers may mention them further on.
+        result.isBot = (
+            ((matches.anywhere & BOT_TOKENS) != 0)
+            || ((matches.atStart & TOOL_TOKENS) != 0)
+        );
+        return result;
+    }
+}
@@ -0,0 +1,150 @@
+/**
+ * @file WellKnownHeaders.cpp
+ *
+ * This module contains the table of well-known header names.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <array>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+
+namespace {
+    using MessageHeaders::DuplicatePolicy;
+    using MessageHeaders::WellKnownHeaderInfo;
+
+    /**
+     * This is the well-known header table, in the same order as
+     * the MessageHeaders::WellKnownHeader enumeration.
+     *
+     * Headers defined as comma-separated lists are combined, headers
+     * which can't be combined that way are kept separate, and headers
+     * which may only appear once are either rejected (where a second
+     * instance is a known attack, such as request smuggling) or
+     * reduced to their first instance.
+     */
+    constexpr WellKnownHeaderInfo WELL_KNOWN_HEADERS[] = {
+        {"",                            DuplicatePolicy::KeepSeparate},
+        {"Accept",                      DuplicatePolicy::Combine},
+        {"Accept-Charset",              DuplicatePolicy::Combine},
+        {"Accept-Encoding",             DuplicatePolicy::Combine},
+        {"Accept-Language",             DuplicatePolicy::Combine},
+        {"Accept-Ranges",               DuplicatePolicy::Combine},
+        {"Access-Control-Allow-Origin", DuplicatePolicy::Reject},
+        {"Age",                         DuplicatePolicy::FirstWins},
+        {"Allow",                       DuplicatePolicy::Combine},
+        {"Authorization",               DuplicatePolicy::Reject},
+        {"baggage",                     DuplicatePolicy::Combine},
+        {"Cache-Control",               DuplicatePolicy::Combine},
+        {"Cc",                          DuplicatePolicy::Combine},
+        {"Connection",                  DuplicatePolicy::Combine},
+        {"Content-Disposition",         DuplicatePolicy::FirstWins},
+        {"Content-Encoding",            DuplicatePolicy::Combine},
+        {"Content-Language",            DuplicatePolicy::Combine},
+        {"Content-Length",              DuplicatePolicy::Reject},
+        {"Content-Location",            DuplicatePolicy::FirstWins},
+        {"Content-Range",               DuplicatePolicy::FirstWins},
+        {"Content-Type",                DuplicatePolicy::Reject},
+        {"Cookie",                      DuplicatePolicy::KeepSeparate},
+        {"Date",                        DuplicatePolicy::FirstWins},
+        {"ETag",                        DuplicatePolicy::FirstWins},
+        {"Expect",                      DuplicatePolicy::Combine},
+        {"Expires",                     DuplicatePolicy::FirstWins},
+        {"Forwarded",                   DuplicatePolicy::Combine},
+        {"From",                        DuplicatePolicy::FirstWins},
+        {"Host",                        DuplicatePolicy::Reject},
+        {"If-Match",                    DuplicatePolicy::Combine},
+        {"If-Modified-Since",           DuplicatePolicy::FirstWins},
+        {"If-None-Match",               DuplicatePolicy::Combine},
+        {"If-Range",                    DuplicatePolicy::FirstWins},
+        {"If-Unmodified-Since",         DuplicatePolicy::FirstWins},
+        {"Last-Modified",               DuplicatePolicy::FirstWins},
+        {"Link",                        DuplicatePolicy::Combine},
+        {"Location",                    DuplicatePolicy::FirstWins},
+        {"Max-Forwards",                DuplicatePolicy::FirstWins},
+        {"Message-ID",                  DuplicatePolicy::FirstWins},
+        {"MIME-Version",                DuplicatePolicy::FirstWins},
+        {"Origin",                      DuplicatePolicy::FirstWins},
+        {"Pragma",                      DuplicatePolicy::Combine},
+        {"Proxy-Authenticate",          DuplicatePolicy::KeepSeparate},
+        {"Proxy-Authorization",         DuplicatePolicy::Reject},
+        {"Range",                       DuplicatePolicy::FirstWins},
+        {"Received",                    DuplicatePolicy::KeepSeparate},
+        {"Referer",                     DuplicatePolicy::FirstWins},
+        {"Reply-To",                    DuplicatePolicy::Combine},
+        {"Retry-After",                 DuplicatePolicy::FirstWins},
+        {"Server",                      DuplicatePolicy::FirstWins},
+        {"Set-Cookie",                  DuplicatePolicy::KeepSeparate},
+        {"Subject",                     DuplicatePolicy::FirstWins},
+        {"TE",                          DuplicatePolicy::Combine},
+        {"To",                          DuplicatePolicy::Combine},
+        {"traceparent",                 DuplicatePolicy::Reject},
+        {"tracestate",                  DuplicatePolicy::Combine},
+        {"Trailer",                     DuplicatePolicy::Combine},
+        {"Transfer-Encoding",           DuplicatePolicy::Combine},
+        {"Upgrade",                     DuplicatePolicy::Combine},
+        {"User-Agent",                  DuplicatePolicy::FirstWins},
+        {"Vary",                        DuplicatePolicy::Combine},
+        {"Via",                         DuplicatePolicy::Combine},
+        {"Warning",                     DuplicatePolicy::Combine},
+        {"WWW-Authenticate",            DuplicatePolicy::KeepSeparate},
+        {"X-Forwarded-For",             DuplicatePolicy::Combine},
+        {"X-Forwarded-Proto",           DuplicatePolicy::FirstWins},
+        {"X-Request-ID",                DuplicatePolicy::FirstWins},
+    };
+    static_assert(
+        sizeof(WELL_KNOWN_HEADERS) / sizeof(WELL_KNOWN_HEADERS[0]) == MessageHeaders::WELL_KNOWN_HEADER_COUNT,
+        "well-known header table must match the WellKnownHeader enumeration"
+    );
+
+    /**
+     * This is the number of slots in the hash table used to
+     * look up well-known header names.  It must be a power of two.
+     */
+    constexpr size_t NUM_SLOTS = 256;
+
+    /**
+     * This function builds the open-addressing hash table used to
+     * look up well-known header names.  Each slot holds the identifier
+     * of a well-known header, or zero (Unknown) if the slot is free.
+     *
+     * @return
+     *     The hash table is returned.
+     */
+    constexpr std::array< uint8_t, NUM_SLOTS > MakeSlots() {
+        std::array< uint8_t, NUM_SLOTS > slots{};
+        for (size_t i = 1; i < MessageHeaders::WELL_KNOWN_HEADER_COUNT; ++i) {
+            auto slot = MessageHeaders::HashHeaderName(WELL_KNOWN_HEADERS[i].name) & (NUM_SLOTS - 1);
+            while (slots[slot] != 0) {
+                slot = (slot + 1) & (NUM_SLOTS - 1);
+            }
+            slots[slot] = (uint8_t)i;
+        }
+        return slots;
+    }
+
+    /**
+     * This is the hash table used to look up well-known header names.
+     */
+    constexpr auto SLOTS = MakeSlots();
+}
+
+namespace MessageHeaders {
+    WellKnownHeader FindWellKnownHeader(std::string_view name) noexcept {
+        return FindWellKnownHeader(name, HashHeaderName(name));
+    }
+
+    WellKnownHeader FindWellKnownHeader(std::string_view name, uint64_t hash) noexcept {
+        for (auto slot = hash & (NUM_SLOTS - 1); SLOTS[slot] != 0; slot = (slot + 1) & (NUM_SLOTS - 1)) {
+            if (HeaderNamesEqual(WELL_KNOWN_HEADERS[SLOTS[slot]].name, name)) {
+                return (WellKnownHeader)SLOTS[slot];
+            }
+        }
+        return WellKnownHeader::Unknown;
+    }
+
+    const WellKnownHeaderInfo& GetWellKnownHeaderInfo(WellKnownHeader header) noexcept {
+        return WELL_KNOWN_HEADERS[(size_t)header];
+    }
+}
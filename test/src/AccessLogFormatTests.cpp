@@ -0,0 +1,129 @@
+/**
+ * @file AccessLogFormatTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::AccessLogFormat class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/AccessLogFormat.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    /**
+     * This function returns message headers parsed
+     * from the given raw headers.
+     *
+     * @param[in] rawHeaders
+     *     These are the headers to parse.
+     *
+     * @return
+     *     The parsed headers are returned.
+     */
+    MessageHeaders::MessageHeaders Parse(const std::string& rawHeaders) {
+        MessageHeaders::MessageHeaders headers;
+        EXPECT_TRUE(headers.ParseRawMessage(rawHeaders));
+        return headers;
+    }
+}
+
+TEST(AccessLogFormatTests, RequestAndResponseHeaders) {
+    const MessageHeaders::AccessLogFormat format(
+        "$remote_addr [$time_local] \"$http_user_agent\" $sent_http_content_type ${http_host}x $remote_addr"
+    );
+    ASSERT_EQ(
+        (std::vector< std::string >{"remote_addr", "time_local"}),
+        format.GetVariables()
+    );
+    const auto request = Parse(
+        "Host: www.example.com\r\n"
+        "User-Agent: curl/7.64.1\r\n"
+        "\r\n"
+    );
+    const auto response = Parse(
+        "Content-Type: text/html\r\n"
+        "\r\n"
+    );
+    std::string line;
+    format.Render(request, response, {"203.0.113.7", "10/Oct/2019:13:55:36 -0700"}, line);
+    ASSERT_EQ(
+        "203.0.113.7 [10/Oct/2019:13:55:36 -0700] \"curl/7.64.1\" text/html www.example.comx 203.0.113.7",
+        line
+    );
+}
+
+TEST(AccessLogFormatTests, MissingValues) {
+    const MessageHeaders::AccessLogFormat format("$status $http_referer $sent_http_x_cache");
+    MessageHeaders::MessageHeaders request, response;
+    std::string line;
+    format.Render(request, response, line);
+    ASSERT_EQ("- - -", line);
+}
+
+TEST(AccessLogFormatTests, UnderscoresStandForDashesAndCaseIgnored) {
+    const MessageHeaders::AccessLogFormat format("$http_x_forwarded_for");
+    const auto request = Parse("x-FORWARDED-for: 203.0.113.7\r\n\r\n");
+    std::string line;
+    format.Render(request, MessageHeaders::MessageHeaders(), line);
+    ASSERT_EQ("203.0.113.7", line);
+}
+
+TEST(AccessLogFormatTests, SeveralHeadersJoined) {
+    const MessageHeaders::AccessLogFormat format("$http_via");
+    const auto request = Parse("Via: A\r\nHost: example.com\r\nVia: B\r\n\r\n");
+    std::string line;
+    format.Render(request, MessageHeaders::MessageHeaders(), line);
+    ASSERT_EQ("A,B", line);
+}
+
+TEST(AccessLogFormatTests, DollarSignsWithoutNames) {
+    const MessageHeaders::AccessLogFormat format("$ 5$ ${unclosed");
+    ASSERT_TRUE(format.GetVariables().empty());
+    std::string line;
+    format.Render(MessageHeaders::MessageHeaders(), MessageHeaders::MessageHeaders(), line);
+    ASSERT_EQ("$ 5$ ${unclosed", line);
+}
+
+TEST(AccessLogFormatTests, DefaultEscaping) {
+    const MessageHeaders::AccessLogFormat format("\"$http_user_agent\"");
+    MessageHeaders::MessageHeaders request;
+    request.AddHeader("User-Agent", "a\"b\\c\x01\xE9");
+    std::string line;
+    format.Render(request, MessageHeaders::MessageHeaders(), line);
+    ASSERT_EQ("\"a\\x22b\\x5Cc\\x01\\xE9\"", line);
+}
+
+TEST(AccessLogFormatTests, JsonEscaping) {
+    const MessageHeaders::AccessLogFormat format(
+        "{\"ua\":\"$http_user_agent\"}",
+        MessageHeaders::AccessLogEscaping::Json
+    );
+    MessageHeaders::MessageHeaders request;
+    request.AddHeader("User-Agent", "a\"b\\c\t\x01\xC3\xA9");
+    std::string line;
+    format.Render(request, MessageHeaders::MessageHeaders(), line);
+    ASSERT_EQ("{\"ua\":\"a\\\"b\\\\c\\t\\u0001\xC3\xA9\"}", line);
+}
+
+TEST(AccessLogFormatTests, NoEscaping) {
+    const MessageHeaders::AccessLogFormat format(
+        "$http_user_agent",
+        MessageHeaders::AccessLogEscaping::None
+    );
+    MessageHeaders::MessageHeaders request;
+    request.AddHeader("User-Agent", "a\"b");
+    std::string line;
+    format.Render(request, MessageHeaders::MessageHeaders(), line);
+    ASSERT_EQ("a\"b", line);
+}
+
+TEST(AccessLogFormatTests, BufferReused) {
+    const MessageHeaders::AccessLogFormat format("$http_host");
+    const auto request = Parse("Host: www.example.com\r\n\r\n");
+    std::string line = "left over from before";
+    format.Render(request, MessageHeaders::MessageHeaders(), line);
+    ASSERT_EQ("www.example.com", line);
+}
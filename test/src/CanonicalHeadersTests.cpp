@@ -0,0 +1,101 @@
+/**
+ * @file CanonicalHeadersTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::CanonicalHeaders class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <MessageHeaders/CanonicalHeaders.hpp>
+#include <string>
+
+namespace {
+    /**
+     * This function returns a sink which appends
+     * what it receives to the given string.
+     *
+     * @param[in,out] output
+     *     This is the string to which to append.
+     *
+     * @return
+     *     The sink is returned.
+     */
+    MessageHeaders::CanonicalHeaders::Sink AppendTo(std::string& output) {
+        return [&output](std::string_view piece) {
+            output.append(piece.data(), piece.length());
+        };
+    }
+}
+
+TEST(CanonicalHeadersTests, AllHeaders) {
+    MessageHeaders::MessageHeaders headers;
+    headers.AddHeader("Host", "iam.amazonaws.com");
+    headers.AddHeader("Content-Type", "application/x-www-form-urlencoded; charset=utf-8");
+    headers.AddHeader("My-header1", "    a   b   c  ");
+    headers.AddHeader("X-Amz-Date", "20150830T123600Z");
+    headers.AddHeader("My-Header2", "    \"a   b   c\"  ");
+    headers.AddHeader("my-header1", "d\t e");
+    const MessageHeaders::CanonicalHeaders canonicalHeaders(headers);
+    ASSERT_TRUE(canonicalHeaders.IsValid());
+    std::string output;
+    canonicalHeaders.Emit(AppendTo(output));
+    ASSERT_EQ(
+        "content-type:application/x-www-form-urlencoded; charset=utf-8\n"
+        "host:iam.amazonaws.com\n"
+        "my-header1:a b c,d e\n"
+        "my-header2:\"a b c\"\n"
+        "x-amz-date:20150830T123600Z\n",
+        output
+    );
+    output.clear();
+    canonicalHeaders.EmitSignedHeaders(AppendTo(output));
+    ASSERT_EQ("content-type;host;my-header1;my-header2;x-amz-date", output);
+}
+
+TEST(CanonicalHeadersTests, SignedHeadersOnly) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Host: examplebucket.s3.amazonaws.com\r\n"
+            "User-Agent: curl/7.58.0\r\n"
+            "x-amz-content-sha256: UNSIGNED-PAYLOAD\r\n"
+            "Range: bytes=0-9\r\n"
+            "X-Amz-Date: 20130524T000000Z\r\n"
+            "\r\n"
+        )
+    );
+    const MessageHeaders::CanonicalHeaders canonicalHeaders(
+        headers,
+        "host;range;x-amz-content-sha256;x-amz-date"
+    );
+    ASSERT_TRUE(canonicalHeaders.IsValid());
+    std::string output;
+    canonicalHeaders.Emit(AppendTo(output));
+    ASSERT_EQ(
+        "host:examplebucket.s3.amazonaws.com\n"
+        "range:bytes=0-9\n"
+        "x-amz-content-sha256:UNSIGNED-PAYLOAD\n"
+        "x-amz-date:20130524T000000Z\n",
+        output
+    );
+    output.clear();
+    canonicalHeaders.EmitSignedHeaders(AppendTo(output));
+    ASSERT_EQ("host;range;x-amz-content-sha256;x-amz-date", output);
+
+    ASSERT_FALSE(MessageHeaders::CanonicalHeaders(headers, "host;x-amz-security-token").IsValid());
+}
+
+TEST(CanonicalHeadersTests, ManyHeadersKeepOrderOfDuplicates) {
+    MessageHeaders::MessageHeaders headers;
+    for (int i = 40; i > 0; --i) {
+        headers.AddHeader("X-Header-" + std::to_string(i % 20), std::to_string(i));
+    }
+    const MessageHeaders::CanonicalHeaders canonicalHeaders(headers);
+    std::string output;
+    canonicalHeaders.Emit(AppendTo(output));
+    ASSERT_EQ(0, output.find("x-header-0:40,20\nx-header-1:21,1\nx-header-10:30,10\nx-header-11:31,11\n"));
+    ASSERT_EQ(20, std::count(output.begin(), output.end(), '\n'));
+}
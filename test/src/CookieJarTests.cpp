@@ -0,0 +1,189 @@
+/**
+ * @file CookieJarTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::CookieJar class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/CookieJar.hpp>
+#include <string>
+
+namespace {
+    /**
+     * This is the time used as "now" by the tests.
+     */
+    constexpr int64_t NOW = 784111777;
+
+    /**
+     * This function returns the Cookie header the given jar
+     * writes for the given request.
+     *
+     * @param[in,out] jar
+     *     This is the cookie jar to use.
+     *
+     * @param[in] host
+     *     This is the host to which the request is made.
+     *
+     * @param[in] path
+     *     This is the path of the request.
+     *
+     * @param[in] secure
+     *     This indicates whether or not the request is secure.
+     *
+     * @param[in] now
+     *     This is the time of the request.
+     *
+     * @return
+     *     The value of the Cookie header is returned.
+     */
+    std::string CookieHeaderFor(
+        MessageHeaders::CookieJar& jar,
+        const std::string& host,
+        const std::string& path,
+        bool secure = false,
+        int64_t now = NOW
+    ) {
+        MessageHeaders::MessageHeaders request;
+        if (!jar.AddCookieHeader(request, host, path, secure, now)) {
+            EXPECT_FALSE(request.HasHeader("Cookie"));
+            return "";
+        }
+        EXPECT_EQ(1, request.GetHeaderCount());
+        return request.GetHeaderValue("Cookie");
+    }
+}
+
+TEST(CookieJarTests, DomainMatching) {
+    MessageHeaders::CookieJar jar;
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("host=1"), "www.Example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("domain=2; Domain=example.com"), "www.example.com", "/", NOW));
+    ASSERT_FALSE(jar.StoreCookie(MessageHeaders::SetCookie("other=3; Domain=example.org"), "www.example.com", "/", NOW));
+    ASSERT_FALSE(jar.StoreCookie(MessageHeaders::SetCookie("tld=4; Domain=com"), "www.example.com", "/", NOW));
+    ASSERT_FALSE(jar.StoreCookie(MessageHeaders::SetCookie("invalid"), "www.example.com", "/", NOW));
+    ASSERT_EQ(2, jar.GetCookieCount());
+    ASSERT_EQ("host=1; domain=2", CookieHeaderFor(jar, "WWW.example.com", "/"));
+    ASSERT_EQ("domain=2", CookieHeaderFor(jar, "example.com", "/"));
+    ASSERT_EQ("domain=2", CookieHeaderFor(jar, "api.www.example.com", "/"));
+    ASSERT_EQ("", CookieHeaderFor(jar, "badexample.com", "/"));
+    ASSERT_EQ("", CookieHeaderFor(jar, "example.org", "/"));
+}
+
+TEST(CookieJarTests, PathMatchingAndOrder) {
+    MessageHeaders::CookieJar jar;
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("root=1; Path=/"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("docs=2; Path=/docs"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("web=3; Path=/docs/web/"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("default=4"), "example.com", "/docs/index.html", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("early=5; Path=/"), "example.com", "/", NOW));
+    ASSERT_EQ("web=3; docs=2; default=4; root=1; early=5", CookieHeaderFor(jar, "example.com", "/docs/web/page"));
+    ASSERT_EQ("docs=2; default=4; root=1; early=5", CookieHeaderFor(jar, "example.com", "/docs"));
+    ASSERT_EQ("root=1; early=5", CookieHeaderFor(jar, "example.com", "/docsets"));
+    ASSERT_EQ("root=1; early=5", CookieHeaderFor(jar, "example.com", ""));
+}
+
+TEST(CookieJarTests, ReplaceAndRemove) {
+    MessageHeaders::CookieJar jar;
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("a=1"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("b=2"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("a=3"), "example.com", "/", NOW));
+    ASSERT_EQ(2, jar.GetCookieCount());
+    ASSERT_EQ("a=3; b=2", CookieHeaderFor(jar, "example.com", "/"));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("a=; Max-Age=0"), "example.com", "/", NOW));
+    ASSERT_EQ(1, jar.GetCookieCount());
+    ASSERT_EQ("b=2", CookieHeaderFor(jar, "example.com", "/"));
+}
+
+TEST(CookieJarTests, Expiry) {
+    MessageHeaders::CookieJar jar;
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("short=1; Max-Age=10"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("long=2; Expires=Sun, 06 Nov 1994 09:49:37 GMT"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("session=3"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("past=4; Expires=Sat, 05 Nov 1994 08:49:37 GMT"), "example.com", "/", NOW));
+    ASSERT_EQ(3, jar.GetCookieCount());
+    ASSERT_EQ("short=1; long=2; session=3", CookieHeaderFor(jar, "example.com", "/", false, NOW + 9));
+    ASSERT_EQ("long=2; session=3", CookieHeaderFor(jar, "example.com", "/", false, NOW + 10));
+    ASSERT_EQ(2, jar.GetCookieCount());
+
+    // A replaced cookie keeps only its latest expiry.
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("session=5; Max-Age=100"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("session=6"), "example.com", "/", NOW));
+    jar.RemoveExpiredCookies(NOW + 7200);
+    ASSERT_EQ(1, jar.GetCookieCount());
+    ASSERT_EQ("session=6", CookieHeaderFor(jar, "example.com", "/", false, NOW + 7200));
+}
+
+TEST(CookieJarTests, RefreshedCookiesExpireInOrder) {
+    MessageHeaders::CookieJar jar;
+    for (int64_t refresh = 0; refresh < 1000; ++refresh) {
+        for (int i = 0; i < 10; ++i) {
+            const auto maxAge = 100 + (i * 37 + refresh) % 50;
+            ASSERT_TRUE(
+                jar.StoreCookie(
+                    MessageHeaders::SetCookie(
+                        "c" + std::to_string(i) + "=" + std::to_string(refresh)
+                        + "; Max-Age=" + std::to_string(maxAge)
+                    ),
+                    "www.example.com",
+                    "/",
+                    NOW + refresh
+                )
+            );
+        }
+        jar.RemoveExpiredCookies(NOW + refresh);
+        ASSERT_EQ(10, jar.GetCookieCount());
+    }
+
+    // The cookies now expire in the order of their last Max-Age.
+    const int64_t lastStored = NOW + 999;
+    size_t remaining = 10;
+    for (int64_t age = 100; age < 150; ++age) {
+        jar.RemoveExpiredCookies(lastStored + age);
+        for (int i = 0; i < 10; ++i) {
+            if (100 + (i * 37 + 999) % 50 == age) {
+                --remaining;
+            }
+        }
+        ASSERT_EQ(remaining, jar.GetCookieCount());
+    }
+    ASSERT_EQ(0, jar.GetCookieCount());
+
+    // Domains emptied by removal can be filled again.
+    ASSERT_EQ("", CookieHeaderFor(jar, "www.example.com", "/", false, lastStored + 150));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("x=1"), "www.example.com", "/", lastStored));
+    ASSERT_EQ("x=1", CookieHeaderFor(jar, "www.example.com", "/", false, lastStored + 150));
+}
+
+TEST(CookieJarTests, SecureCookies) {
+    MessageHeaders::CookieJar jar;
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("plain=1"), "example.com", "/", NOW));
+    ASSERT_TRUE(jar.StoreCookie(MessageHeaders::SetCookie("secret=2; Secure"), "example.com", "/", NOW));
+    ASSERT_EQ("plain=1", CookieHeaderFor(jar, "example.com", "/", false));
+    ASSERT_EQ("plain=1; secret=2", CookieHeaderFor(jar, "example.com", "/", true));
+}
+
+TEST(CookieJarTests, StoreCookiesFromResponse) {
+    MessageHeaders::MessageHeaders response;
+    ASSERT_TRUE(
+        response.ParseRawMessage(
+            "Set-Cookie: sid=31d4d96e407aad42; Path=/; Secure; HttpOnly\r\n"
+            "Content-Type: text/html\r\n"
+            "Set-Cookie: lang=en-US; Path=/; Domain=example.com\r\n"
+            "Set-Cookie: bad; Path=/\r\n"
+            "\r\n"
+        )
+    );
+    MessageHeaders::CookieJar jar;
+    ASSERT_EQ(2, jar.StoreCookies(response, "www.example.com", "/login", NOW));
+    MessageHeaders::MessageHeaders request;
+    request.AddHeader("Host", "www.example.com");
+    ASSERT_TRUE(jar.AddCookieHeader(request, "www.example.com", "/account", true, NOW));
+    ASSERT_EQ(
+        "Host: www.example.com\r\n"
+        "Cookie: sid=31d4d96e407aad42; lang=en-US\r\n"
+        "\r\n",
+        request.GenerateRawHeaders()
+    );
+}
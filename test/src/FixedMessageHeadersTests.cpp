@@ -0,0 +1,222 @@
+/**
+ * @file FixedMessageHeadersTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::FixedMessageHeaders class template.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/FixedMessageHeaders.hpp>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <string>
+
+TEST(FixedMessageHeadersTests, ParseAndLookUp) {
+    MessageHeaders::FixedMessageHeaders< 8, 256 > headers;
+    const std::string rawMessage = (
+        "Host: www.example.com\r\n"
+        "Accept: text/html\r\n"
+        "accept:  text/plain \r\n"
+        "\r\n"
+        "Hello"
+    );
+    size_t bodyOffset;
+    ASSERT_TRUE(headers.ParseRawMessage(rawMessage, bodyOffset));
+    EXPECT_EQ(rawMessage.length() - 5, bodyOffset);
+    ASSERT_EQ(3, headers.GetHeaderCount());
+    EXPECT_EQ("Host", headers.GetHeader(0).name);
+    EXPECT_EQ("www.example.com", headers.GetHeader(0).value);
+    EXPECT_EQ("text/plain", headers.GetHeader(2).value);
+    EXPECT_TRUE(headers.HasHeader("HOST"));
+    EXPECT_FALSE(headers.HasHeader("Cookie"));
+    EXPECT_EQ("text/html", headers.GetHeaderValue("Accept"));
+    EXPECT_EQ("", headers.GetHeaderValue("Cookie"));
+    EXPECT_EQ(1, headers.FindHeader("Accept"));
+    EXPECT_EQ(2, headers.FindHeader("Accept", 2));
+    EXPECT_EQ(3, headers.FindHeader("Accept", 3));
+}
+
+TEST(FixedMessageHeadersTests, ParseFoldedValue) {
+    MessageHeaders::FixedMessageHeaders< 4, 64 > headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "X-Folded: first\r\n"
+            "  second \r\n"
+            "\tthird\r\n"
+            "Host: example.com\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_EQ(2, headers.GetHeaderCount());
+    EXPECT_EQ("first second  third", headers.GetHeaderValue("X-Folded"));
+    EXPECT_EQ("example.com", headers.GetHeaderValue("Host"));
+}
+
+TEST(FixedMessageHeadersTests, ParseMalformed) {
+    MessageHeaders::FixedMessageHeaders< 4, 64 > headers;
+    EXPECT_FALSE(headers.ParseRawMessage("Host www.example.com\r\n\r\n"));
+    EXPECT_EQ(MessageHeaders::FixedHeadersError::Malformed, headers.GetLastError());
+    EXPECT_FALSE(headers.ParseRawMessage("Ho st: www.example.com\r\n\r\n"));
+    EXPECT_FALSE(headers.ParseRawMessage("Host: www.example.com\r\n"));
+    headers.SetLineLimit(10);
+    EXPECT_FALSE(headers.ParseRawMessage("Host: www.example.com\r\n\r\n"));
+    EXPECT_EQ(0, headers.GetHeaderCount());
+    EXPECT_TRUE(headers.ParseRawMessage("Host: a\r\n\r\n"));
+    EXPECT_EQ(MessageHeaders::FixedHeadersError::None, headers.GetLastError());
+}
+
+TEST(FixedMessageHeadersTests, ParseTooManyHeaders) {
+    MessageHeaders::FixedMessageHeaders< 2, 256 > headers;
+    ASSERT_TRUE(headers.ParseRawMessage("Host: example.com\r\n\r\n"));
+    EXPECT_FALSE(
+        headers.ParseRawMessage(
+            "Accept: */*\r\n"
+            "Cookie: a=b\r\n"
+            "\r\n"
+        )
+    );
+    EXPECT_EQ(MessageHeaders::FixedHeadersError::TooManyHeaders, headers.GetLastError());
+
+    // Nothing from the failed parse is kept.
+    ASSERT_EQ(1, headers.GetHeaderCount());
+    EXPECT_EQ(15, headers.GetBytesUsed());
+}
+
+TEST(FixedMessageHeadersTests, ParseOutOfSpace) {
+    MessageHeaders::FixedMessageHeaders< 8, 16 > headers;
+    EXPECT_FALSE(headers.ParseRawMessage("Host: www.example.com\r\n\r\n"));
+    EXPECT_EQ(MessageHeaders::FixedHeadersError::OutOfSpace, headers.GetLastError());
+    EXPECT_EQ(0, headers.GetHeaderCount());
+    EXPECT_EQ(0, headers.GetBytesUsed());
+
+    // Whitespace around the value must fit while the line is
+    // read, but isn't kept.
+    EXPECT_TRUE(headers.ParseRawMessage("Host: example.com\r\n\r\n"));
+    EXPECT_EQ(15, headers.GetBytesUsed());
+}
+
+TEST(FixedMessageHeadersTests, AddSetAndRemove) {
+    MessageHeaders::FixedMessageHeaders< 4, 46 > headers;
+    ASSERT_TRUE(headers.AddHeader("Via", "a"));
+    ASSERT_TRUE(headers.AddHeader("Host", "example.com"));
+    ASSERT_TRUE(headers.AddHeader("Via", "b"));
+    ASSERT_TRUE(headers.AddHeader("Accept", "*/*"));
+    EXPECT_FALSE(headers.AddHeader("Cookie", "x"));
+    EXPECT_EQ(MessageHeaders::FixedHeadersError::TooManyHeaders, headers.GetLastError());
+
+    // Setting keeps the first header with the name and removes the rest.
+    ASSERT_TRUE(headers.SetHeader("via", "a much longer value"));
+    ASSERT_EQ(3, headers.GetHeaderCount());
+    EXPECT_EQ("Via", headers.GetHeader(0).name);
+    EXPECT_EQ("a much longer value", headers.GetHeader(0).value);
+    EXPECT_EQ("example.com", headers.GetHeaderValue("Host"));
+    EXPECT_EQ("*/*", headers.GetHeaderValue("Accept"));
+    EXPECT_EQ(46, headers.GetBytesUsed());
+
+    // A value which doesn't fit changes nothing.
+    EXPECT_FALSE(headers.SetHeader("Host", "example.com.longer"));
+    EXPECT_EQ(MessageHeaders::FixedHeadersError::OutOfSpace, headers.GetLastError());
+    EXPECT_EQ("example.com", headers.GetHeaderValue("Host"));
+    ASSERT_TRUE(headers.SetHeader("Via", "c"));
+    EXPECT_EQ(28, headers.GetBytesUsed());
+    ASSERT_TRUE(headers.SetHeader("Host", "example.com.longer"));
+    EXPECT_EQ("*/*", headers.GetHeaderValue("Accept"));
+
+    // Removing gives back the room at once.
+    headers.RemoveHeader("HOST");
+    ASSERT_EQ(2, headers.GetHeaderCount());
+    EXPECT_EQ(13, headers.GetBytesUsed());
+    EXPECT_EQ("c", headers.GetHeaderValue("Via"));
+    EXPECT_EQ("*/*", headers.GetHeaderValue("Accept"));
+    ASSERT_TRUE(headers.SetHeader("Cookie", "x"));
+    EXPECT_EQ(3, headers.GetHeaderCount());
+    headers.Clear();
+    EXPECT_EQ(0, headers.GetHeaderCount());
+    EXPECT_EQ(0, headers.GetBytesUsed());
+}
+
+TEST(FixedMessageHeadersTests, GenerateMatchesMessageHeaders) {
+    const std::string rawHeaders = (
+        "Host: www.example.com\r\n"
+        "Accept: text/html\r\n"
+        "X-Empty: \r\n"
+        "\r\n"
+    );
+    MessageHeaders::FixedMessageHeaders< 8, 128 > headers;
+    ASSERT_TRUE(headers.ParseRawMessage(rawHeaders));
+    ASSERT_EQ(rawHeaders.length(), headers.GetRawHeadersLength());
+    char output[128];
+    size_t length;
+    EXPECT_FALSE(headers.GenerateRawHeaders(output, 10, length));
+    EXPECT_EQ(rawHeaders.length(), length);
+    ASSERT_TRUE(headers.GenerateRawHeaders(output, sizeof(output), length));
+    EXPECT_EQ(rawHeaders, std::string(output, length));
+    MessageHeaders::MessageHeaders reference;
+    ASSERT_TRUE(reference.ParseRawMessage(rawHeaders));
+    EXPECT_EQ(reference.GenerateRawHeaders(), std::string(output, length));
+}
+
+TEST(FixedMessageHeadersTests, CopiesAreIndependent) {
+    MessageHeaders::FixedMessageHeaders< 4, 64 > original;
+    ASSERT_TRUE(original.AddHeader("Host", "example.com"));
+    auto copy = original;
+    ASSERT_TRUE(copy.SetHeader("Host", "example.org"));
+    EXPECT_EQ("example.com", original.GetHeaderValue("Host"));
+    EXPECT_EQ("example.org", copy.GetHeaderValue("Host"));
+}
+
+TEST(FixedMessageHeadersTests, SetFromOwnStorage) {
+    MessageHeaders::FixedMessageHeaders< 8, 64 > headers;
+    ASSERT_TRUE(headers.AddHeader("A", "aaaa"));
+    ASSERT_TRUE(headers.AddHeader("B", "hello"));
+    ASSERT_TRUE(headers.AddHeader("A", "zz"));
+    ASSERT_TRUE(headers.SetHeader("A", headers.GetHeaderValue("B")));
+    EXPECT_EQ("hello", headers.GetHeaderValue("A"));
+    EXPECT_EQ("hello", headers.GetHeaderValue("B"));
+
+    // The value may come from a header being removed, and the
+    // name from a header being changed.
+    ASSERT_TRUE(headers.AddHeader("A", "world"));
+    ASSERT_TRUE(headers.SetHeader(headers.GetHeader(0).name, headers.GetHeader(2).value));
+    ASSERT_EQ(2, headers.GetHeaderCount());
+    EXPECT_EQ("world", headers.GetHeaderValue("A"));
+    ASSERT_TRUE(headers.AddHeader(headers.GetHeader(1).name, headers.GetHeader(0).value));
+    EXPECT_EQ("world", headers.GetHeader(2).value);
+    headers.RemoveHeader(headers.GetHeader(1).name);
+    ASSERT_EQ(1, headers.GetHeaderCount());
+    EXPECT_EQ("world", headers.GetHeaderValue("A"));
+}
+
+TEST(FixedMessageHeadersTests, SetFromOwnStorageWhenNearlyFull) {
+    // The value is rotated into place when there's no room to copy it.
+    MessageHeaders::FixedMessageHeaders< 8, 16 > headers;
+    ASSERT_TRUE(headers.AddHeader("A", "aaaa"));
+    ASSERT_TRUE(headers.AddHeader("B", "xy"));
+    ASSERT_TRUE(headers.AddHeader("A", "helloo"));
+    ASSERT_TRUE(headers.SetHeader("A", headers.GetHeader(2).value));
+    ASSERT_EQ(2, headers.GetHeaderCount());
+    EXPECT_EQ("helloo", headers.GetHeaderValue("A"));
+    EXPECT_EQ("xy", headers.GetHeaderValue("B"));
+    EXPECT_EQ(10, headers.GetBytesUsed());
+    ASSERT_TRUE(headers.SetHeader("A", headers.GetHeaderValue("A").substr(1, 3)));
+    EXPECT_EQ("ell", headers.GetHeaderValue("A"));
+    EXPECT_EQ("xy", headers.GetHeaderValue("B"));
+
+    // The value is copied when it comes from a header which stays.
+    MessageHeaders::FixedMessageHeaders< 8, 12 > full;
+    ASSERT_TRUE(full.AddHeader("A", "aaaa"));
+    ASSERT_TRUE(full.AddHeader("B", "hello"));
+    ASSERT_TRUE(full.SetHeader("A", full.GetHeaderValue("B")));
+    EXPECT_EQ("hello", full.GetHeaderValue("A"));
+    EXPECT_EQ("hello", full.GetHeaderValue("B"));
+    EXPECT_EQ(12, full.GetBytesUsed());
+
+    // A value spanning more than one name or value needs room for a copy.
+    ASSERT_TRUE(full.SetHeader("A", "aaaa"));
+    const auto spanning = std::string_view(full.GetHeaderValue("A").data() + 2, 4);
+    EXPECT_FALSE(full.SetHeader("A", spanning));
+    EXPECT_EQ(MessageHeaders::FixedHeadersError::OutOfSpace, full.GetLastError());
+    EXPECT_EQ("aaaa", full.GetHeaderValue("A"));
+    EXPECT_EQ("hello", full.GetHeaderValue("B"));
+}
@@ -0,0 +1,250 @@
+/**
+ * @file HeaderParserTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::HeaderParser class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/HeaderParser.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    /**
+     * This is a header handler which records everything it is told,
+     * so that tests can check what the parser reported.
+     */
+    struct RecordingHandler
+        : public MessageHeaders::HeaderHandler
+    {
+        std::vector< std::pair< std::string, std::string > > headers;
+        std::vector< const char* > valuePointers;
+        size_t bodyOffset = 0;
+        bool ended = false;
+        size_t stopAfter = 0;
+
+        bool OnHeader(std::string_view name, std::string_view value) override {
+            headers.emplace_back(std::string(name), std::string(value));
+            valuePointers.push_back(value.data());
+            return ((stopAfter == 0) || (headers.size() < stopAfter));
+        }
+
+        void OnEnd(size_t newBodyOffset) override {
+            bodyOffset = newBodyOffset;
+            ended = true;
+        }
+    };
+}
+
+TEST(HeaderParserTests, ReportsEachHeaderInOrder) {
+    const std::string rawHeaders = (
+        "User-Agent: curl/7.16.3 libcurl/7.16.3 OpenSSL/0.9.7l zlib/1.2.3\r\n"
+        "Host: www.example.com\r\n"
+        "Accept-Language: en, mi\r\n"
+        "\r\n"
+    );
+    const std::string rawMessage = rawHeaders + "Hello!\r\n";
+    MessageHeaders::HeaderParser parser;
+    RecordingHandler handler;
+    ASSERT_TRUE(parser.Parse(rawMessage, handler));
+    ASSERT_EQ(
+        (std::vector< std::pair< std::string, std::string > >{
+            {"User-Agent", "curl/7.16.3 libcurl/7.16.3 OpenSSL/0.9.7l zlib/1.2.3"},
+            {"Host", "www.example.com"},
+            {"Accept-Language", "en, mi"},
+        }),
+        handler.headers
+    );
+    ASSERT_TRUE(handler.ended);
+    ASSERT_EQ(rawHeaders.length(), handler.bodyOffset);
+}
+
+TEST(HeaderParserTests, UnfoldedValuesReferToRawMessage) {
+    const std::string rawMessage = (
+        "Host: www.example.com\r\n"
+        "\r\n"
+    );
+    MessageHeaders::HeaderParser parser;
+    RecordingHandler handler;
+    ASSERT_TRUE(parser.Parse(rawMessage, handler));
+    ASSERT_EQ(1, handler.valuePointers.size());
+    ASSERT_EQ(rawMessage.data() + 6, handler.valuePointers[0]);
+}
+
+TEST(HeaderParserTests, FoldedValuesAreUnfolded) {
+    const std::string rawMessage = (
+        "Subject: This\r\n"
+        "   is a test\r\n"
+        "To: Bob\r\n"
+        "\r\n"
+    );
+    MessageHeaders::HeaderParser parser;
+    RecordingHandler handler;
+    ASSERT_TRUE(parser.Parse(rawMessage, handler));
+    ASSERT_EQ(
+        (std::vector< std::pair< std::string, std::string > >{
+            {"Subject", "This is a test"},
+            {"To", "Bob"},
+        }),
+        handler.headers
+    );
+}
+
+TEST(HeaderParserTests, BadMessages) {
+    const std::vector< std::string > badMessages{
+        "",
+        "User-Agent: curl",
+        "Host: www.example.com\r\n",
+        "Feels Bad Man: LUL\r\n\r\n",
+        "NoColon\r\n\r\n",
+    };
+    size_t index = 0;
+    for (const auto& badMessage : badMessages) {
+        MessageHeaders::HeaderParser parser;
+        RecordingHandler handler;
+        ASSERT_FALSE(parser.Parse(badMessage, handler)) << index;
+        ASSERT_FALSE(handler.ended) << index;
+        ++index;
+    }
+}
+
+TEST(HeaderParserTests, LineLimit) {
+    const std::string rawMessage = (
+        "X: 12345\r\n"
+        "\r\n"
+    );
+    MessageHeaders::HeaderParser parser;
+    RecordingHandler handler;
+    parser.SetLineLimit(10);
+    ASSERT_TRUE(parser.Parse(rawMessage, handler));
+    parser.SetLineLimit(9);
+    ASSERT_FALSE(parser.Parse(rawMessage, handler));
+}
+
+TEST(HeaderParserTests, HandlerCanStopParsing) {
+    const std::string rawMessage = (
+        "A: 1\r\n"
+        "B: 2\r\n"
+        "C: 3\r\n"
+        "\r\n"
+    );
+    MessageHeaders::HeaderParser parser;
+    RecordingHandler handler;
+    handler.stopAfter = 2;
+    ASSERT_FALSE(parser.Parse(rawMessage, handler));
+    ASSERT_EQ(2, handler.headers.size());
+    ASSERT_FALSE(handler.ended);
+}
+
+TEST(HeaderParserTests, DfaEngineMatchesScanEngine) {
+    const std::vector< std::string > rawMessages{
+        "User-Agent: curl/7.16.3 libcurl/7.16.3 OpenSSL/0.9.7l zlib/1.2.3\r\n"
+        "Host: www.example.com\r\n"
+        "Accept-Language: en, mi\r\n"
+        "\r\n"
+        "Hello!",
+        "Via: SIP/2.0/UDP server10.biloxi.com\r\n"
+        "    ;branch=z9hG4bKnashds8;received=192.0.2.3\r\n"
+        "Subject: This\r\n"
+        "\tis\r\n"
+        " a test  \r\n"
+        "   \r\n"
+        "To: Bob <sip:bob@biloxi.com>;tag=a6c85cf\r\n"
+        "\r\n",
+        "X:\r\n"
+        ":empty name\r\n"
+        "Y: bare\rcarriage\nreturn\r\r\n"
+        "Z: \r\n"
+        " \rfold\r\n"
+        "\r\n",
+        "\r\n",
+        "",
+        "User-Agent: curl",
+        "Host: www.example.com\r\n",
+        "Feels Bad Man: LUL\r\n\r\n",
+        "NoColon\r\n\r\n",
+        "Subject: This\r\n"
+        "  \r\n"
+        "\r\n",
+        " Host: www.example.com\r\n\r\n",
+        "Host: www.example.com\r\n\r",
+        "Host: www.example.com\r\n\rX\n",
+    };
+    size_t index = 0;
+    for (const auto& rawMessage : rawMessages) {
+        for (size_t lineLimit: {0, 12}) {
+            MessageHeaders::HeaderParser scanParser;
+            scanParser.SetLineLimit(lineLimit);
+            RecordingHandler scanHandler;
+            const auto scanResult = scanParser.Parse(rawMessage, scanHandler);
+
+            MessageHeaders::HeaderParser dfaParser;
+            dfaParser.SetLineLimit(lineLimit);
+            dfaParser.SetEngine(MessageHeaders::HeaderParser::Engine::Dfa);
+            RecordingHandler dfaHandler;
+            ASSERT_EQ(scanResult, dfaParser.Parse(rawMessage, dfaHandler)) << index;
+            if (scanResult) {
+                ASSERT_EQ(scanHandler.headers, dfaHandler.headers) << index;
+                ASSERT_EQ(scanHandler.bodyOffset, dfaHandler.bodyOffset) << index;
+            }
+        }
+        ++index;
+    }
+}
+
+TEST(HeaderParserTests, FeedPiecesSplitAnywhere) {
+    const std::string rawHeaders = (
+        "Via: SIP/2.0/UDP server10.biloxi.com\r\n"
+        "    ;branch=z9hG4bKnashds8;received=192.0.2.3\r\n"
+        "Subject: This\r\n"
+        "\tis a test\r\n"
+        "To: Bob <sip:bob@biloxi.com>;tag=a6c85cf\r\n"
+        "\r\n"
+    );
+    const std::string rawMessage = rawHeaders + "Hello!";
+    const std::vector< std::pair< std::string, std::string > > expectedHeaders{
+        {"Via", "SIP/2.0/UDP server10.biloxi.com ;branch=z9hG4bKnashds8;received=192.0.2.3"},
+        {"Subject", "This is a test"},
+        {"To", "Bob <sip:bob@biloxi.com>;tag=a6c85cf"},
+    };
+    for (size_t pieceLength = 1; pieceLength <= rawMessage.length(); ++pieceLength) {
+        MessageHeaders::HeaderParser parser;
+        RecordingHandler handler;
+        auto status = MessageHeaders::HeaderParser::Status::Incomplete;
+        for (size_t offset = 0; offset < rawMessage.length(); offset += pieceLength) {
+            // Feed a copy, which is gone before the next piece, to make
+            // sure the parser doesn't hold on to earlier pieces.
+            const std::string piece = rawMessage.substr(offset, pieceLength);
+            status = parser.Feed(piece, handler);
+            if (status != MessageHeaders::HeaderParser::Status::Incomplete) {
+                break;
+            }
+        }
+        ASSERT_EQ(MessageHeaders::HeaderParser::Status::Complete, status) << pieceLength;
+        ASSERT_EQ(expectedHeaders, handler.headers) << pieceLength;
+        ASSERT_EQ(rawHeaders.length(), handler.bodyOffset) << pieceLength;
+    }
+}
+
+TEST(HeaderParserTests, FeedReportsErrors) {
+    MessageHeaders::HeaderParser parser;
+    RecordingHandler handler;
+    ASSERT_EQ(
+        MessageHeaders::HeaderParser::Status::Incomplete,
+        parser.Feed("Host: www.example.com\r\n", handler)
+    );
+    ASSERT_EQ(
+        MessageHeaders::HeaderParser::Status::Error,
+        parser.Feed("Feels Bad Man: LUL\r\n", handler)
+    );
+    parser.Reset();
+    handler = RecordingHandler();
+    ASSERT_EQ(
+        MessageHeaders::HeaderParser::Status::Complete,
+        parser.Feed("Host: www.example.com\r\n\r\n", handler)
+    );
+    ASSERT_EQ(1, handler.headers.size());
+}
@@ -0,0 +1,97 @@
+/**
+ * @file HeaderSchemaTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::HeaderSchema class template.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/HeaderSchema.hpp>
+#include <stdint.h>
+
+namespace {
+    /**
+     * This is the structure into which the tests bind headers.
+     */
+    struct Request {
+        std::string_view host;
+        uint64_t contentLength = 0;
+        std::optional< std::string > accept;
+        std::vector< std::string_view > via;
+        std::string subject;
+    };
+
+    constexpr auto REQUEST_SCHEMA = MessageHeaders::MakeHeaderSchema< Request >(
+        MessageHeaders::MakeHeaderField("Host", &Request::host),
+        MessageHeaders::MakeHeaderField("Content-Length", &Request::contentLength),
+        MessageHeaders::MakeHeaderField("Accept", &Request::accept, MessageHeaders::DuplicatePolicy::Combine),
+        MessageHeaders::MakeHeaderField("Via", &Request::via),
+        MessageHeaders::MakeHeaderField("Subject", &Request::subject, MessageHeaders::DuplicatePolicy::LastWins)
+    );
+}
+
+TEST(HeaderSchemaTests, ParseRawMessageIntoStructure) {
+    const std::string rawHeaders = (
+        "host: www.example.com\r\n"
+        "Via: SIP/2.0/UDP server10.biloxi.com\r\n"
+        "Accept: text/html\r\n"
+        "Content-Length: 51\r\n"
+        "X-Ignored: whatever\r\n"
+        "Via: SIP/2.0/UDP pc33.atlanta.com\r\n"
+        "ACCEPT: text/plain\r\n"
+        "Subject: First\r\n"
+        "Subject: This\r\n"
+        " is a test\r\n"
+        "\r\n"
+    );
+    const std::string rawMessage = rawHeaders + "Hello!";
+    Request request;
+    size_t bodyOffset;
+    ASSERT_TRUE(REQUEST_SCHEMA.Parse(rawMessage, request, bodyOffset));
+    ASSERT_EQ(rawHeaders.length(), bodyOffset);
+    ASSERT_EQ("www.example.com", request.host);
+    ASSERT_EQ(rawMessage.data() + 6, request.host.data());
+    ASSERT_EQ(51, request.contentLength);
+    ASSERT_EQ("text/html,text/plain", request.accept);
+    ASSERT_EQ(
+        (std::vector< std::string_view >{
+            "SIP/2.0/UDP server10.biloxi.com",
+            "SIP/2.0/UDP pc33.atlanta.com",
+        }),
+        request.via
+    );
+    ASSERT_EQ("This is a test", request.subject);
+}
+
+TEST(HeaderSchemaTests, BadHeaderValues) {
+    const std::vector< std::string > badMessages{
+        "Content-Length: fifty\r\n\r\n",
+        "Content-Length: -1\r\n\r\n",
+        "Content-Length: 51 \r\n 2\r\n\r\n",
+        "Host: a\r\nHost: b\r\n\r\n",
+        "Host: www.\r\n example.com\r\n\r\n",
+    };
+    size_t index = 0;
+    for (const auto& badMessage : badMessages) {
+        Request request;
+        ASSERT_FALSE(REQUEST_SCHEMA.Parse(badMessage, request)) << index;
+        ++index;
+    }
+}
+
+TEST(HeaderSchemaTests, BindMessageHeaders) {
+    MessageHeaders::MessageHeaders headers;
+    headers.SetHeader("Host", "www.example.com");
+    headers.AddHeader("Content-Length", "1234");
+    headers.AddHeader("Via", "A");
+    headers.AddHeader("Via", "B");
+    Request request;
+    ASSERT_TRUE(REQUEST_SCHEMA.Bind(headers, request));
+    ASSERT_EQ("www.example.com", request.host);
+    ASSERT_EQ(1234, request.contentLength);
+    ASSERT_FALSE(request.accept.has_value());
+    ASSERT_EQ((std::vector< std::string_view >{"A", "B"}), request.via);
+    ASSERT_TRUE(request.subject.empty());
+}
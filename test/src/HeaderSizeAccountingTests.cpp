@@ -0,0 +1,181 @@
+/**
+ * @file HeaderSizeAccountingTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::HeaderSizeAccounting class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/HeaderSizeAccounting.hpp>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/RedactionPolicy.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    /**
+     * This function returns the record of the given header name
+     * in the given report.
+     *
+     * @param[in] report
+     *     This is the report to search.
+     *
+     * @param[in] name
+     *     This is the header name whose record to find.
+     *
+     * @return
+     *     The record of the name is returned, or an empty record
+     *     if the name isn't in the report.
+     */
+    MessageHeaders::HeaderSizeRecord FindRecord(
+        const MessageHeaders::HeaderSizeReport& report,
+        const std::string& name
+    ) {
+        for (const auto& record : report.names) {
+            if (record.name == name) {
+                return record;
+            }
+        }
+        return {};
+    }
+}
+
+TEST(HeaderSizeAccountingTests, Buckets) {
+    EXPECT_EQ(0, MessageHeaders::GetHeaderSizeBucket(0));
+    EXPECT_EQ(0, MessageHeaders::GetHeaderSizeBucket(15));
+    EXPECT_EQ(1, MessageHeaders::GetHeaderSizeBucket(16));
+    EXPECT_EQ(2, MessageHeaders::GetHeaderSizeBucket(63));
+    EXPECT_EQ(3, MessageHeaders::GetHeaderSizeBucket(64));
+    EXPECT_EQ(
+        MessageHeaders::HEADER_SIZE_BUCKETS - 1,
+        MessageHeaders::GetHeaderSizeBucket(10000000)
+    );
+    EXPECT_EQ(16, MessageHeaders::GetHeaderSizeBucketLimit(0));
+    EXPECT_EQ(128, MessageHeaders::GetHeaderSizeBucketLimit(3));
+    EXPECT_EQ(
+        SIZE_MAX,
+        MessageHeaders::GetHeaderSizeBucketLimit(MessageHeaders::HEADER_SIZE_BUCKETS - 1)
+    );
+}
+
+TEST(HeaderSizeAccountingTests, RecordHeadersByName) {
+    MessageHeaders::HeaderSizeAccounting accounting;
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "Cookie", 1000);
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "cookie", 3000);
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "X-Custom", 20);
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Generated, "x-custom", 30);
+    accounting.RecordMessage(MessageHeaders::HeaderSizeDirection::Parsed, 4100);
+    const auto report = accounting.GetReport();
+    EXPECT_EQ(1, report.parsedMessages.count);
+    EXPECT_EQ(4100, report.parsedMessages.bytes);
+    EXPECT_EQ(0, report.generatedMessages.count);
+    ASSERT_EQ(2, report.names.size());
+    EXPECT_EQ("Cookie", report.names[0].name);
+    EXPECT_EQ(2, report.names[0].parsed.count);
+    EXPECT_EQ(4000, report.names[0].parsed.bytes);
+    EXPECT_EQ(1, report.names[0].parsed.buckets[MessageHeaders::GetHeaderSizeBucket(1000)]);
+    EXPECT_EQ(1, report.names[0].parsed.buckets[MessageHeaders::GetHeaderSizeBucket(3000)]);
+    EXPECT_EQ("X-Custom", report.names[1].name);
+    EXPECT_EQ(20, report.names[1].parsed.bytes);
+    EXPECT_EQ(1, report.names[1].generated.count);
+    EXPECT_EQ(30, report.names[1].generated.bytes);
+}
+
+TEST(HeaderSizeAccountingTests, OtherNamesWhenTableFull) {
+    MessageHeaders::HeaderSizeAccounting accounting(2);
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "X-A", 10);
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "X-B", 10);
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "X-C", 10);
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "X-D", 10);
+    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "Host", 10);
+    const auto report = accounting.GetReport();
+    EXPECT_EQ(1, FindRecord(report, "Host").parsed.count);
+    EXPECT_EQ(
+        4,
+        FindRecord(report, "X-A").parsed.count
+        + FindRecord(report, "X-B").parsed.count
+        + FindRecord(report, "X-C").parsed.count
+        + FindRecord(report, "X-D").parsed.count
+        + FindRecord(report, "(other)").parsed.count
+    );
+    EXPECT_EQ(2, FindRecord(report, "(other)").parsed.count);
+}
+
+TEST(HeaderSizeAccountingTests, Merge) {
+    MessageHeaders::HeaderSizeAccounting first;
+    MessageHeaders::HeaderSizeAccounting second;
+    first.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "X-Trace", 100);
+    second.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "x-trace", 200);
+    second.RecordHeader(MessageHeaders::HeaderSizeDirection::Generated, "Host", 20);
+    second.RecordMessage(MessageHeaders::HeaderSizeDirection::Generated, 22);
+    first.Merge(second);
+    const auto report = first.GetReport();
+    EXPECT_EQ(1, report.generatedMessages.count);
+    EXPECT_EQ(22, report.generatedMessages.bytes);
+    EXPECT_EQ(2, FindRecord(report, "X-Trace").parsed.count);
+    EXPECT_EQ(300, FindRecord(report, "X-Trace").parsed.bytes);
+    EXPECT_EQ(20, FindRecord(report, "Host").generated.bytes);
+
+    // The other accounting is left as it was, and keeps its own spelling.
+    EXPECT_EQ(200, FindRecord(second.GetReport(), "x-trace").parsed.bytes);
+}
+
+TEST(HeaderSizeAccountingTests, RecordFromSeveralThreads) {
+    MessageHeaders::HeaderSizeAccounting accounting;
+    std::vector< std::thread > workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back(
+            [&accounting, t]{
+                for (size_t i = 0; i < 1000; ++i) {
+                    accounting.RecordHeader(MessageHeaders::HeaderSizeDirection::Parsed, "Host", 10);
+                    accounting.RecordHeader(
+                        MessageHeaders::HeaderSizeDirection::Parsed,
+                        "X-Thread-" + std::to_string(t),
+                        1
+                    );
+                }
+            }
+        );
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const auto report = accounting.GetReport();
+    EXPECT_EQ(4000, FindRecord(report, "Host").parsed.count);
+    EXPECT_EQ(40000, FindRecord(report, "Host").parsed.bytes);
+    for (size_t t = 0; t < 4; ++t) {
+        EXPECT_EQ(1000, FindRecord(report, "X-Thread-" + std::to_string(t)).parsed.count);
+    }
+}
+
+TEST(HeaderSizeAccountingTests, CountedWhileParsingAndGenerating) {
+    MessageHeaders::HeaderSizeAccounting accounting;
+    MessageHeaders::MessageHeaders headers;
+    headers.SetSizeAccounting(&accounting);
+    const std::string rawHeaders = (
+        "Host: www.example.com\r\n"
+        "Cookie: id=12345\r\n"
+        "\r\n"
+    );
+    ASSERT_TRUE(headers.ParseRawMessage(rawHeaders));
+    MessageHeaders::RedactionPolicy redaction;
+    redaction.UseDefaultNames();
+    ASSERT_EQ(
+        "Host: www.example.com\r\n"
+        "Cookie: id=[REDACTED]\r\n"
+        "\r\n",
+        headers.GenerateRawHeaders(redaction)
+    );
+    const auto report = accounting.GetReport();
+    EXPECT_EQ(1, report.parsedMessages.count);
+    EXPECT_EQ(rawHeaders.length(), report.parsedMessages.bytes);
+    EXPECT_EQ(1, report.generatedMessages.count);
+    EXPECT_EQ(48, report.generatedMessages.bytes);
+    EXPECT_EQ(23, FindRecord(report, "Host").parsed.bytes);
+    EXPECT_EQ(18, FindRecord(report, "Cookie").parsed.bytes);
+    EXPECT_EQ(23, FindRecord(report, "Host").generated.bytes);
+    EXPECT_EQ(23, FindRecord(report, "Cookie").generated.bytes);
+}
@@ -0,0 +1,239 @@
+/**
+ * @file HeaderStatisticsTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::HeaderStatistics class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <inttypes.h>
+#include <MessageHeaders/HeaderStatistics.hpp>
+#include <MessageHeaders/RedactionPolicy.hpp>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    /**
+     * This function returns headers parsed from the given raw headers.
+     *
+     * @param[in] rawHeaders
+     *     These are the raw headers, ending in an empty line.
+     *
+     * @return
+     *     The parsed headers are returned.
+     */
+    MessageHeaders::MessageHeaders Parse(const std::string& rawHeaders) {
+        MessageHeaders::MessageHeaders headers;
+        EXPECT_TRUE(headers.ParseRawMessage(rawHeaders));
+        return headers;
+    }
+
+    /**
+     * This function returns the label of a common header value
+     * shown by its hash.
+     *
+     * @param[in] name
+     *     This is the header name.
+     *
+     * @param[in] value
+     *     This is the header value.
+     *
+     * @return
+     *     The label of the header value is returned.
+     */
+    std::string HashedLabel(const std::string& name, const std::string& value) {
+        char hash[17];
+        (void)snprintf(hash, sizeof(hash), "%016" PRIx64, MessageHeaders::HeaderStatistics::HashValue(value));
+        return name + ": #" + hash;
+    }
+
+    /**
+     * This function returns the count of the entry with the given
+     * label, or zero if there is no such entry.
+     *
+     * @param[in] entries
+     *     These are the entries to search.
+     *
+     * @param[in] label
+     *     This is the label of the entry to find.
+     *
+     * @return
+     *     The count of the entry is returned.
+     */
+    uint64_t FindCount(
+        const std::vector< MessageHeaders::HeaderStatisticsEntry >& entries,
+        const std::string& label
+    ) {
+        for (const auto& entry : entries) {
+            if (entry.label == label) {
+                return entry.count;
+            }
+        }
+        return 0;
+    }
+}
+
+TEST(HeaderStatisticsTests, TopNamesMostCommonFirst) {
+    MessageHeaders::HeaderStatistics statistics(2, 0);
+    const auto common = Parse("Host: a\r\nAccept: */*\r\nX-Rare: 1\r\n\r\n");
+    const auto lessCommon = Parse("Host: b\r\nAccept: */*\r\n\r\n");
+    const auto hostOnly = Parse("Host: c\r\n\r\n");
+    statistics.Record(common);
+    statistics.Record(lessCommon);
+    statistics.Record(hostOnly);
+    const auto snapshot = statistics.GetSnapshot();
+    EXPECT_EQ(3, snapshot.messages);
+    ASSERT_EQ(2, snapshot.topNames.size());
+    EXPECT_EQ("Host", snapshot.topNames[0].label);
+    EXPECT_EQ(3, snapshot.topNames[0].count);
+    EXPECT_EQ("Accept", snapshot.topNames[1].label);
+    EXPECT_EQ(2, snapshot.topNames[1].count);
+    EXPECT_TRUE(snapshot.topValues.empty());
+}
+
+TEST(HeaderStatisticsTests, EstimateNameCountNeverLow) {
+    MessageHeaders::HeaderStatistics statistics(4, 0);
+    for (size_t i = 0; i < 500; ++i) {
+        MessageHeaders::MessageHeaders headers;
+        headers.AddHeader("X-Name-" + std::to_string(i), "v");
+        headers.AddHeader("Host", "example.com");
+        statistics.Record(headers);
+    }
+    EXPECT_GE(statistics.EstimateNameCount("host"), 500);
+    EXPECT_GE(statistics.EstimateNameCount("X-Name-7"), 1);
+    const auto snapshot = statistics.GetSnapshot();
+    ASSERT_FALSE(snapshot.topNames.empty());
+    EXPECT_EQ("Host", snapshot.topNames[0].label);
+}
+
+TEST(HeaderStatisticsTests, TopValues) {
+    MessageHeaders::HeaderStatistics statistics(4, 1);
+    for (size_t i = 0; i < 10; ++i) {
+        MessageHeaders::MessageHeaders headers;
+        headers.AddHeader("Accept-Encoding", "gzip");
+        headers.AddHeader("User-Agent", (i < 7) ? "curl/7.64.1" : "Wget/1.20");
+        statistics.Record(headers);
+    }
+    const auto snapshot = statistics.GetSnapshot();
+    ASSERT_EQ(3, snapshot.topValues.size());
+    EXPECT_EQ(HashedLabel("Accept-Encoding", "gzip"), snapshot.topValues[0].label);
+    EXPECT_EQ(10, snapshot.topValues[0].count);
+    EXPECT_EQ(7, FindCount(snapshot.topValues, HashedLabel("User-Agent", "curl/7.64.1")));
+    EXPECT_EQ(3, FindCount(snapshot.topValues, HashedLabel("User-Agent", "Wget/1.20")));
+}
+
+TEST(HeaderStatisticsTests, SampledValuesAreScaled) {
+    MessageHeaders::HeaderStatistics statistics(4, 4);
+    for (size_t i = 0; i < 8; ++i) {
+        MessageHeaders::MessageHeaders headers;
+        headers.AddHeader("Accept", "*/*");
+        statistics.Record(headers);
+    }
+    const auto snapshot = statistics.GetSnapshot();
+    EXPECT_EQ(8, FindCount(snapshot.topNames, "Accept"));
+    EXPECT_EQ(8, FindCount(snapshot.topValues, HashedLabel("Accept", "*/*")));
+}
+
+TEST(HeaderStatisticsTests, LongValuesCutShortInLabels) {
+    MessageHeaders::RedactionPolicy redaction;
+    MessageHeaders::HeaderStatistics statistics(4, 1, &redaction);
+    MessageHeaders::MessageHeaders headers;
+    headers.AddHeader("X-Long", std::string(100, 'a'));
+    statistics.Record(headers);
+    const auto snapshot = statistics.GetSnapshot();
+    ASSERT_EQ(1, snapshot.topValues.size());
+    EXPECT_EQ("X-Long: " + std::string(64, 'a'), snapshot.topValues[0].label);
+}
+
+TEST(HeaderStatisticsTests, SensitiveValuesNeverKept) {
+    MessageHeaders::RedactionPolicy redaction;
+    redaction.UseDefaultNames();
+    MessageHeaders::HeaderStatistics hashed(8, 1);
+    MessageHeaders::HeaderStatistics shown(8, 1, &redaction);
+    const auto headers = Parse(
+        "Authorization: Bearer s3cr3t-t0ken\r\n"
+        "Cookie: sid=s3cr3t-s1d\r\n"
+        "X-Api-Key: s3cr3t-k3y\r\n"
+        "Accept: text/html\r\n"
+        "\r\n"
+    );
+    hashed.Record(headers);
+    shown.Record(headers);
+    for (const auto& snapshot : {hashed.GetSnapshot(), shown.GetSnapshot()}) {
+        ASSERT_EQ(4, snapshot.topValues.size());
+        for (const auto& entry : snapshot.topValues) {
+            EXPECT_EQ(std::string::npos, entry.label.find("s3cr3t")) << entry.label;
+        }
+        EXPECT_EQ(1, FindCount(snapshot.topValues, HashedLabel("Authorization", "Bearer s3cr3t-t0ken")));
+    }
+    EXPECT_EQ(1, FindCount(hashed.GetSnapshot().topValues, HashedLabel("Accept", "text/html")));
+    EXPECT_EQ(1, FindCount(shown.GetSnapshot().topValues, "Accept: text/html"));
+}
+
+TEST(HeaderStatisticsTests, Merge) {
+    MessageHeaders::HeaderStatistics first(4, 1);
+    MessageHeaders::HeaderStatistics second(4, 1);
+    const auto headers = Parse("Host: example.com\r\n\r\n");
+    first.Record(headers);
+    second.Record(headers);
+    second.Record(headers);
+    first.Merge(second);
+    const auto snapshot = first.GetSnapshot();
+    EXPECT_EQ(3, snapshot.messages);
+    EXPECT_EQ(3, FindCount(snapshot.topNames, "Host"));
+    EXPECT_EQ(3, FindCount(snapshot.topValues, HashedLabel("Host", "example.com")));
+
+    // The other statistics are left as they were.
+    EXPECT_EQ(2, second.GetSnapshot().messages);
+}
+
+TEST(HeaderStatisticsTests, Reset) {
+    MessageHeaders::HeaderStatistics statistics;
+    statistics.Record(Parse("Host: example.com\r\n\r\n"));
+    statistics.Reset();
+    const auto snapshot = statistics.GetSnapshot();
+    EXPECT_EQ(0, snapshot.messages);
+    EXPECT_TRUE(snapshot.topNames.empty());
+    EXPECT_TRUE(snapshot.topValues.empty());
+    EXPECT_EQ(0, statistics.EstimateNameCount("Host"));
+}
+
+TEST(HeaderStatisticsTests, RecordFromSeveralThreads) {
+    MessageHeaders::HeaderStatistics statistics(4, 1);
+    const auto headers = Parse("Host: example.com\r\nAccept: */*\r\n\r\n");
+    std::vector< std::thread > workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back(
+            [&statistics, &headers]{
+                for (size_t i = 0; i < 1000; ++i) {
+                    statistics.Record(headers);
+                }
+            }
+        );
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const auto snapshot = statistics.GetSnapshot();
+    EXPECT_EQ(4000, snapshot.messages);
+    EXPECT_EQ(4000, FindCount(snapshot.topNames, "Host"));
+    EXPECT_EQ(4000, FindCount(snapshot.topNames, "Accept"));
+    EXPECT_EQ(4000, FindCount(snapshot.topValues, HashedLabel("Accept", "*/*")));
+}
+
+TEST(HeaderStatisticsTests, RecordedWhileParsing) {
+    MessageHeaders::HeaderStatistics statistics(4, 1);
+    MessageHeaders::MessageHeaders headers;
+    headers.SetStatistics(&statistics);
+    ASSERT_TRUE(headers.ParseRawMessage("Host: example.com\r\n\r\n"));
+    ASSERT_FALSE(headers.ParseRawMessage("Host example.com\r\n\r\n"));
+    headers.SetStatistics(nullptr);
+    ASSERT_TRUE(headers.ParseRawMessage("Host: example.com\r\n\r\n"));
+    const auto snapshot = statistics.GetSnapshot();
+    EXPECT_EQ(1, snapshot.messages);
+    EXPECT_EQ(1, FindCount(snapshot.topNames, "Host"));
+}
@@ -0,0 +1,71 @@
+/**
+ * @file HttpDateTests.cpp
+ *
+ * This module contains the unit tests of the
+ * HTTP date functions.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/HttpDate.hpp>
+
+TEST(HttpDateTests, ParseImfFixdate) {
+    int64_t time = 0;
+    ASSERT_TRUE(MessageHeaders::ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT", time));
+    ASSERT_EQ(784111777, time);
+    ASSERT_TRUE(MessageHeaders::ParseHttpDate("Thu, 01 Jan 1970 00:00:00 GMT", time));
+    ASSERT_EQ(0, time);
+    ASSERT_TRUE(MessageHeaders::ParseHttpDate("Tue, 29 Feb 2000 23:59:59 GMT", time));
+    ASSERT_EQ(951868799, time);
+}
+
+TEST(HttpDateTests, ParseObsoleteFormats) {
+    int64_t time = 0;
+    ASSERT_TRUE(MessageHeaders::ParseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT", time));
+    ASSERT_EQ(784111777, time);
+    ASSERT_TRUE(MessageHeaders::ParseHttpDate("Sun Nov  6 08:49:37 1994", time));
+    ASSERT_EQ(784111777, time);
+    ASSERT_TRUE(MessageHeaders::ParseHttpDate("Sun, 06-Nov-1994 08:49:37 GMT", time));
+    ASSERT_EQ(784111777, time);
+}
+
+TEST(HttpDateTests, ParseBadDates) {
+    int64_t time = 0;
+    for (const auto date: {
+        "",
+        "yesterday",
+        "Sun, 06 Nov 1994 GMT",
+        "Sun, 31 Feb 1994 08:49:37 GMT",
+        "Sun, 06 Nov 1994 24:49:37 GMT",
+        "06 Nov 1600 08:49:37",
+        "Sun, 06 Xyz 1994 08:49:37 GMT",
+    }) {
+        ASSERT_FALSE(MessageHeaders::ParseHttpDate(date, time)) << date;
+    }
+}
+
+TEST(HttpDateTests, FormatHttpDate) {
+    ASSERT_EQ("Sun, 06 Nov 1994 08:49:37 GMT", MessageHeaders::FormatHttpDate(784111777));
+    ASSERT_EQ("Thu, 01 Jan 1970 00:00:00 GMT", MessageHeaders::FormatHttpDate(0));
+    ASSERT_EQ("Tue, 29 Feb 2000 23:59:59 GMT", MessageHeaders::FormatHttpDate(951868799));
+    int64_t time = 0;
+    for (int64_t original: {0LL, 1LL, 784111777LL, 4102444800LL}) {
+        ASSERT_TRUE(MessageHeaders::ParseHttpDate(MessageHeaders::FormatHttpDate(original), time));
+        ASSERT_EQ(original, time);
+    }
+}
+
+TEST(HttpDateTests, FormatHttpDateClampsYears) {
+    ASSERT_EQ("Mon, 01 Jan 1601 00:00:00 GMT", MessageHeaders::FormatHttpDate(-11644473600LL));
+    ASSERT_EQ("Mon, 01 Jan 1601 00:00:00 GMT", MessageHeaders::FormatHttpDate(-11644473601LL));
+    ASSERT_EQ("Mon, 01 Jan 1601 00:00:00 GMT", MessageHeaders::FormatHttpDate(INT64_MIN));
+    ASSERT_EQ("Fri, 31 Dec 9999 23:59:59 GMT", MessageHeaders::FormatHttpDate(253402300799LL));
+    ASSERT_EQ("Fri, 31 Dec 9999 23:59:59 GMT", MessageHeaders::FormatHttpDate(253402300800LL));
+    ASSERT_EQ("Fri, 31 Dec 9999 23:59:59 GMT", MessageHeaders::FormatHttpDate(INT64_MAX));
+    int64_t time = 0;
+    ASSERT_TRUE(MessageHeaders::ParseHttpDate(MessageHeaders::FormatHttpDate(INT64_MIN), time));
+    ASSERT_EQ(-11644473600LL, time);
+    ASSERT_TRUE(MessageHeaders::ParseHttpDate(MessageHeaders::FormatHttpDate(INT64_MAX), time));
+    ASSERT_EQ(253402300799LL, time);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file JsonTests.cpp
+ *
+ * This module contains the unit tests of the helper
+ * functions used to export message headers as JSON.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/Json.hpp>
+#include <string>
+
+namespace {
+    /**
+     * This function returns the given text escaped
+     * for use within a JSON string.
+     *
+     * @param[in] text
+     *     This is the text to escape.
+     *
+     * @return
+     *     The escaped text is returned.
+     */
+    std::string Escape(std::string_view text) {
+        std::string output;
+        MessageHeaders::AppendJsonEscaped(text, output);
+        return output;
+    }
+}
+
+TEST(JsonTests, CleanTextCopied) {
+    ASSERT_EQ("", Escape(""));
+    ASSERT_EQ("text/html; charset=utf-8", Escape("text/html; charset=utf-8"));
+    ASSERT_EQ("caf\xC3\xA9", Escape("caf\xC3\xA9"));
+}
+
+TEST(JsonTests, SpecialCharactersEscaped) {
+    ASSERT_EQ("\\\"\\\\\\b\\f\\n\\r\\t\\u0001\\u001f", Escape("\"\\\b\f\n\r\t\x01\x1F"));
+    ASSERT_EQ(" ~\x7F", Escape(" ~\x7F"));
+}
+
+TEST(JsonTests, EscapesFoundAtEveryPosition) {
+    // Cover every position within and across sixteen-character chunks.
+    for (size_t length = 1; length < 50; ++length) {
+        for (size_t position = 0; position < length; ++position) {
+            std::string text(length, 'a');
+            text[position] = '"';
+            std::string expected(position, 'a');
+            expected += "\\\"";
+            expected += std::string(length - position - 1, 'a');
+            ASSERT_EQ(expected, Escape(text)) << length << " " << position;
+        }
+    }
+}
+
+TEST(JsonTests, HighBytesNotMistakenForControlCharacters) {
+    // Each byte which isn't part of valid UTF-8 is replaced,
+    // rather than escaped as a control character.
+    std::string text;
+    std::string expected;
+    for (int c = 0x80; c <= 0xFF; ++c) {
+        text += (char)c;
+        expected += "\\ufffd";
+    }
+    ASSERT_EQ(expected, Escape(text));
+}
+
+TEST(JsonTests, InvalidUtf8Replaced) {
+    ASSERT_EQ("\xC2\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80", Escape("\xC2\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80"));
+    ASSERT_EQ("a\\ufffdb", Escape("a\xE9" "b"));
+    ASSERT_EQ("\\ufffd\\ufffd", Escape("\xC0\xAF"));
+    ASSERT_EQ("\\ufffd\\ufffd\\ufffd", Escape("\xED\xA0\x80"));
+    ASSERT_EQ("\\ufffd\\ufffd\\ufffd\\ufffd", Escape("\xF4\x90\x80\x80"));
+    ASSERT_EQ("x\\ufffd\\ufffd", Escape("x\xE2\x82"));
+
+    // Cover every position within and across sixteen-character chunks.
+    for (size_t length = 1; length < 50; ++length) {
+        for (size_t position = 0; position < length; ++position) {
+            std::string text(length, 'a');
+            text[position] = '\xFF';
+            std::string expected(position, 'a');
+            expected += "\\ufffd";
+            expected += std::string(length - position - 1, 'a');
+            ASSERT_EQ(expected, Escape(text)) << length << " " << position;
+        }
+    }
+}
+
+TEST(JsonTests, AppendsToExistingText) {
+    std::string output = "x";
+    MessageHeaders::AppendJsonEscaped("\"", output);
+    ASSERT_EQ("x\\\"", output);
+}
@@ -0,0 +1,176 @@
+/**
+ * @file KeyExtractorTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::KeyExtractor class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/KeyExtractor.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    /**
+     * This function returns the extractor used by most of the tests,
+     * which combines the credentials, tenant, and client address.
+     *
+     * @return
+     *     The extractor is returned.
+     */
+    MessageHeaders::KeyExtractor MakeExtractor() {
+        MessageHeaders::KeyComponent authorization;
+        authorization.name = "Authorization";
+        authorization.credentialsOnly = true;
+        MessageHeaders::KeyComponent tenant;
+        tenant.name = "X-Tenant";
+        tenant.lowercase = true;
+        MessageHeaders::KeyComponent client;
+        client.name = "X-Forwarded-For";
+        client.firstMember = true;
+        return MessageHeaders::KeyExtractor({authorization, tenant, client});
+    }
+
+    /**
+     * This function returns the key the given extractor
+     * computes for the given raw headers.
+     *
+     * @param[in] extractor
+     *     This is the extractor to use.
+     *
+     * @param[in] rawHeaders
+     *     These are the headers to parse.
+     *
+     * @return
+     *     The key is returned.
+     */
+    uint64_t GetKey(
+        const MessageHeaders::KeyExtractor& extractor,
+        const std::string& rawHeaders
+    ) {
+        MessageHeaders::MessageHeaders headers;
+        EXPECT_TRUE(headers.ParseRawMessage(rawHeaders));
+        return extractor.GetKey(headers);
+    }
+}
+
+TEST(KeyExtractorTests, SameKeyForEquivalentHeaders) {
+    const auto extractor = MakeExtractor();
+    ASSERT_TRUE(extractor.IsValid());
+    const auto key = GetKey(
+        extractor,
+        "Authorization: Bearer abc123\r\n"
+        "X-Tenant: Acme\r\n"
+        "X-Forwarded-For: 203.0.113.7, 10.0.0.1\r\n"
+        "\r\n"
+    );
+    ASSERT_EQ(
+        key,
+        GetKey(
+            extractor,
+            "x-forwarded-for: 203.0.113.7 ,192.168.1.1\r\n"
+            "Host: www.example.com\r\n"
+            "x-tenant: ACME\r\n"
+            "authorization: Basic   abc123 \r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_NE(
+        key,
+        GetKey(
+            extractor,
+            "Authorization: Bearer abc124\r\n"
+            "X-Tenant: Acme\r\n"
+            "X-Forwarded-For: 203.0.113.7\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_NE(
+        key,
+        GetKey(
+            extractor,
+            "Authorization: Bearer abc123\r\n"
+            "X-Tenant: Acme\r\n"
+            "X-Forwarded-For: 203.0.113.8\r\n"
+            "\r\n"
+        )
+    );
+}
+
+TEST(KeyExtractorTests, CaseOfValueMattersUnlessLowercased) {
+    const auto extractor = MakeExtractor();
+    ASSERT_NE(
+        GetKey(extractor, "Authorization: Bearer abc\r\n\r\n"),
+        GetKey(extractor, "Authorization: Bearer ABC\r\n\r\n")
+    );
+}
+
+TEST(KeyExtractorTests, MissingHeaderDiffersFromEmptyHeader) {
+    const auto extractor = MakeExtractor();
+    ASSERT_NE(
+        GetKey(extractor, "X-Tenant: acme\r\n\r\n"),
+        GetKey(extractor, "Authorization:\r\nX-Tenant: acme\r\n\r\n")
+    );
+}
+
+TEST(KeyExtractorTests, ValuesDoNotRunIntoEachOther) {
+    MessageHeaders::KeyComponent a, b;
+    a.name = "X-A";
+    b.name = "X-B";
+    const MessageHeaders::KeyExtractor extractor({a, b});
+    ASSERT_NE(
+        GetKey(extractor, "X-A: ab\r\nX-B: c\r\n\r\n"),
+        GetKey(extractor, "X-A: a\r\nX-B: bc\r\n\r\n")
+    );
+}
+
+TEST(KeyExtractorTests, OnlyFirstInstanceUsed) {
+    const auto extractor = MakeExtractor();
+    ASSERT_EQ(
+        GetKey(extractor, "X-Tenant: acme\r\n\r\n"),
+        GetKey(extractor, "X-Tenant: acme\r\nX-Tenant: other\r\n\r\n")
+    );
+}
+
+TEST(KeyExtractorTests, Validity) {
+    ASSERT_FALSE(MessageHeaders::KeyExtractor({}).IsValid());
+    std::vector< MessageHeaders::KeyComponent > components(
+        MessageHeaders::KeyExtractor::MAX_COMPONENTS + 1
+    );
+    ASSERT_FALSE(MessageHeaders::KeyExtractor(components).IsValid());
+    components.pop_back();
+    ASSERT_TRUE(MessageHeaders::KeyExtractor(components).IsValid());
+}
+
+TEST(KeyExtractorTests, JumpConsistentHash) {
+    // These are the results of the reference implementation.
+    ASSERT_EQ(0, MessageHeaders::JumpConsistentHash(0, 1));
+    ASSERT_EQ(0, MessageHeaders::JumpConsistentHash(0, 100));
+    ASSERT_EQ(55, MessageHeaders::JumpConsistentHash(1, 100));
+
+    // Adding a bucket only moves keys into the new bucket.
+    size_t moved = 0;
+    for (uint64_t key = 0; key < 10000; ++key) {
+        const auto before = MessageHeaders::JumpConsistentHash(key * 0x9E3779B97F4A7C15ULL, 10);
+        const auto after = MessageHeaders::JumpConsistentHash(key * 0x9E3779B97F4A7C15ULL, 11);
+        ASSERT_LT(before, 10);
+        if (before != after) {
+            ASSERT_EQ(10, after);
+            ++moved;
+        }
+    }
+    ASSERT_GT(moved, 500);
+    ASSERT_LT(moved, 1400);
+}
+
+TEST(KeyExtractorTests, GetShard) {
+    const auto extractor = MakeExtractor();
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(headers.ParseRawMessage("X-Tenant: acme\r\n\r\n"));
+    ASSERT_EQ(
+        MessageHeaders::JumpConsistentHash(extractor.GetKey(headers), 32),
+        extractor.GetShard(headers, 32)
+    );
+}
@@ -0,0 +1,217 @@
+/**
+ * @file MemoryBudgetTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::MemoryBudget class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/MemoryBudget.hpp>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(MemoryBudgetTests, ChargeWithoutChunks) {
+    MessageHeaders::MemoryBudget budget(100, 0);
+    EXPECT_EQ(100, budget.GetLimit());
+    EXPECT_TRUE(budget.TryCharge(60));
+    EXPECT_FALSE(budget.TryCharge(41));
+    EXPECT_EQ(1, budget.GetRefusedCount());
+    EXPECT_TRUE(budget.TryCharge(40));
+    EXPECT_EQ(100, budget.GetUsed());
+    budget.Release(60);
+    EXPECT_EQ(40, budget.GetUsed());
+    budget.Charge(100);
+    EXPECT_EQ(140, budget.GetUsed());
+    EXPECT_FALSE(budget.TryCharge(1));
+}
+
+TEST(MemoryBudgetTests, ThreadTakesChunks) {
+    MessageHeaders::MemoryBudget budget(1000, 256);
+    EXPECT_TRUE(budget.TryCharge(10));
+    EXPECT_EQ(256, budget.GetUsed());
+    EXPECT_TRUE(budget.TryCharge(200));
+    EXPECT_EQ(256, budget.GetUsed());
+    EXPECT_TRUE(budget.TryCharge(100));
+    EXPECT_EQ(512, budget.GetUsed());
+
+    // A charge bigger than a chunk takes just what's needed,
+    // as does a charge near the limit.
+    EXPECT_TRUE(budget.TryCharge(600));
+    EXPECT_EQ(910, budget.GetUsed());
+    EXPECT_FALSE(budget.TryCharge(100));
+    EXPECT_TRUE(budget.TryCharge(90));
+    EXPECT_EQ(1000, budget.GetUsed());
+
+    // What's given back beyond a couple of chunks goes back
+    // to the budget.
+    budget.Release(910);
+    EXPECT_EQ(346, budget.GetUsed());
+}
+
+TEST(MemoryBudgetTests, ChargeFromSeveralThreads) {
+    MessageHeaders::MemoryBudget budget(1000000, 1024);
+    std::vector< std::thread > workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back(
+            [&budget]{
+                for (size_t i = 0; i < 1000; ++i) {
+                    EXPECT_TRUE(budget.TryCharge(100));
+                }
+                for (size_t i = 0; i < 1000; ++i) {
+                    budget.Release(100);
+                }
+            }
+        );
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_LE(budget.GetUsed(), 4 * 2 * 1024);
+    EXPECT_EQ(0, budget.GetRefusedCount());
+}
+
+TEST(MemoryBudgetTests, CreditReturnedWhenThreadExits) {
+    MessageHeaders::MemoryBudget budget(1000, 256);
+    for (size_t t = 0; t < 10; ++t) {
+        std::thread worker(
+            [&budget]{
+                EXPECT_TRUE(budget.TryCharge(10));
+                EXPECT_EQ(256, budget.GetUsed());
+                budget.Release(10);
+            }
+        );
+        worker.join();
+        EXPECT_EQ(0, budget.GetUsed());
+    }
+    EXPECT_TRUE(budget.TryCharge(1000));
+}
+
+TEST(MemoryBudgetTests, ParseFailsWhenBudgetExhausted) {
+    MessageHeaders::MemoryBudget budget(2000, 0);
+    const std::string rawHeaders = (
+        "Host: www.example.com\r\n"
+        "Cookie: " + std::string(1000, 'x') + "\r\n"
+        "\r\n"
+    );
+    MessageHeaders::MessageHeaders first;
+    first.SetMemoryBudget(&budget);
+    ASSERT_TRUE(first.ParseRawMessage(rawHeaders));
+    const auto used = budget.GetUsed();
+    EXPECT_GT(used, 1000);
+    {
+        MessageHeaders::MessageHeaders second;
+        second.SetMemoryBudget(&budget);
+        ASSERT_FALSE(second.ParseRawMessage(rawHeaders));
+        EXPECT_EQ(
+            MessageHeaders::MessageHeaders::ParseError::BudgetExhausted,
+            second.GetLastParseError()
+        );
+        EXPECT_EQ(1, second.GetHeaderCount());
+    }
+
+    // Charges are given back when the instance is destroyed.
+    EXPECT_EQ(used, budget.GetUsed());
+    first.SetMemoryBudget(nullptr);
+    EXPECT_EQ(0, budget.GetUsed());
+}
+
+TEST(MemoryBudgetTests, ParseInParallelFailsWhenBudgetExhausted) {
+    MessageHeaders::MemoryBudget budget(1000, 0);
+    std::string rawHeaders;
+    for (size_t i = 0; i < 100; ++i) {
+        rawHeaders += "X-Header-" + std::to_string(i) + ": value\r\n";
+    }
+    rawHeaders += "\r\n";
+    MessageHeaders::MessageHeaders headers;
+    headers.SetParallelParsing(64, 4);
+    headers.SetMemoryBudget(&budget);
+    ASSERT_FALSE(headers.ParseRawMessage(rawHeaders));
+    EXPECT_EQ(
+        MessageHeaders::MessageHeaders::ParseError::BudgetExhausted,
+        headers.GetLastParseError()
+    );
+    EXPECT_EQ(0, headers.GetHeaderCount());
+    EXPECT_EQ(0, budget.GetUsed());
+}
+
+TEST(MemoryBudgetTests, AddedHeadersAreCharged) {
+    MessageHeaders::MemoryBudget budget(10, 0);
+    MessageHeaders::MessageHeaders headers;
+    headers.AddHeader("Host", "www.example.com");
+    headers.SetMemoryBudget(&budget);
+    const auto used = budget.GetUsed();
+    EXPECT_GT(used, 10);
+    headers.AddHeader("Accept", "*/*");
+    EXPECT_GT(budget.GetUsed(), used);
+    const auto usedBeforeSet = budget.GetUsed();
+    headers.SetHeader("Host", "www.example.com.longer");
+    EXPECT_EQ(usedBeforeSet + 7, budget.GetUsed());
+    EXPECT_EQ(0, budget.GetRefusedCount());
+    headers.SetMemoryBudget(nullptr);
+    EXPECT_EQ(0, budget.GetUsed());
+}
+
+TEST(MemoryBudgetTests, RemovedHeadersAreReleased) {
+    MessageHeaders::MemoryBudget budget(100000, 0);
+    MessageHeaders::MessageHeaders headers;
+    headers.SetMemoryBudget(&budget);
+    for (size_t i = 0; i < 1000; ++i) {
+        headers.AddHeader("X-Cycle", "value");
+        headers.AddHeader("X-Cycle", "another value");
+        headers.RemoveHeader("X-Cycle");
+        ASSERT_TRUE(headers.ParseRawMessage("Host: www.example.com\r\n\r\n"));
+        headers.RemoveHeader("Host");
+    }
+    EXPECT_EQ(0, headers.GetHeaderCount());
+    EXPECT_EQ(0, budget.GetUsed());
+
+    // Shrinking or dropping values gives back what they took.
+    headers.AddHeader("Via", "a long value");
+    headers.AddHeader("Via", "another");
+    const auto usedBeforeSet = budget.GetUsed();
+    headers.SetHeader("Via", "short");
+    EXPECT_LT(budget.GetUsed(), usedBeforeSet - 7);
+    headers.EditHeaderValue(
+        0,
+        [](std::string& value) {
+            value += "er";
+        }
+    );
+    headers.RemoveHeader("Via");
+    EXPECT_EQ(0, budget.GetUsed());
+}
+
+TEST(MemoryBudgetTests, MergedDuplicatesChargeWhatIsKept) {
+    MessageHeaders::MemoryBudget budget(100000, 0);
+    MessageHeaders::MessageHeaders headers;
+    headers.SetMemoryBudget(&budget);
+    headers.SetDuplicatePolicy("Accept", MessageHeaders::DuplicatePolicy::Combine);
+    headers.SetDuplicatePolicy("Host", MessageHeaders::DuplicatePolicy::Reject);
+    headers.SetDuplicatePolicy("Age", MessageHeaders::DuplicatePolicy::LastWins);
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Accept: text/html\r\n"
+            "Accept: text/plain\r\n"
+            "Age: 100\r\n"
+            "Age: 5\r\n"
+            "Host: www.example.com\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_EQ(3, headers.GetHeaderCount());
+    ASSERT_FALSE(headers.ParseRawMessage("Host: www.example.org\r\n\r\n"));
+    size_t kept = 0;
+    for (size_t i = 0; i < headers.GetHeaderCount(); ++i) {
+        const auto& header = headers.GetHeader(i);
+        kept += (
+            sizeof(header)
+            + static_cast< const std::string& >(header.name).length()
+            + header.value.length()
+        );
+    }
+    EXPECT_EQ(kept, budget.GetUsed());
+}
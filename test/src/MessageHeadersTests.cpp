@@ -528,3 +528,616 @@ TEST(MessageHeadersTests, RemoveHeader) {
         headers.GenerateRawHeaders()
     );
 }
+
+TEST(MessageHeadersTests, ParseWithDfaEngine) {
+    MessageHeaders::MessageHeaders msg;
+    msg.SetParseEngine(MessageHeaders::HeaderParser::Engine::Dfa);
+    const std::string rawHeaders = (
+        "Date: Mon, 27 Jul 2009 12:28:53 GMT\r\n"
+        "Subject: This\r\n"
+        " is a test\r\n"
+        "Content-Type: text/plain\r\n"
+        "\r\n"
+    );
+    size_t bodyOffset;
+    ASSERT_TRUE(msg.ParseRawMessage(rawHeaders + "Hello!", bodyOffset));
+    ASSERT_EQ(rawHeaders.length(), bodyOffset);
+    ASSERT_EQ("This is a test", msg.GetHeaderValue("Subject"));
+    ASSERT_EQ("text/plain", msg.GetHeaderValue("Content-Type"));
+}
+
+TEST(MessageHeadersTests, ParseLargeHeaderBlockInParallel) {
+    std::string rawHeaders;
+    for (size_t i = 0; i < 2000; ++i) {
+        rawHeaders += "Received: from relay" + std::to_string(i) + ".example.com\r\n";
+        if (i % 7 == 0) {
+            rawHeaders += "    by list.example.com; Mon, 27 Jul 2009 12:28:53 GMT\r\n";
+        }
+        if (i % 13 == 0) {
+            rawHeaders += "ARC-Seal: i=" + std::to_string(i) + "; a=rsa-sha256\r\n";
+        }
+    }
+    rawHeaders += "\r\n";
+    const std::string rawMessage = rawHeaders + "Hello!\r\n";
+
+    MessageHeaders::MessageHeaders serial;
+    size_t serialBodyOffset;
+    ASSERT_TRUE(serial.ParseRawMessage(rawMessage, serialBodyOffset));
+
+    MessageHeaders::MessageHeaders parallel;
+    parallel.SetParallelParsing(1024, 4);
+    size_t parallelBodyOffset;
+    ASSERT_TRUE(parallel.ParseRawMessage(rawMessage, parallelBodyOffset));
+
+    ASSERT_EQ(rawHeaders.length(), parallelBodyOffset);
+    ASSERT_EQ(serialBodyOffset, parallelBodyOffset);
+    const auto serialHeaders = serial.GetAll();
+    const auto parallelHeaders = parallel.GetAll();
+    ASSERT_EQ(serialHeaders.size(), parallelHeaders.size());
+    for (size_t i = 0; i < serialHeaders.size(); ++i) {
+        ASSERT_EQ(serialHeaders[i].name, parallelHeaders[i].name) << i;
+        ASSERT_EQ(serialHeaders[i].value, parallelHeaders[i].value) << i;
+    }
+
+    MessageHeaders::MessageHeaders bad;
+    bad.SetParallelParsing(1024, 4);
+    const auto middle = rawHeaders.find("Received: from relay1000.");
+    ASSERT_FALSE(
+        bad.ParseRawMessage(
+            rawHeaders.substr(0, middle) + "Feels Bad Man: LUL\r\n" + rawHeaders.substr(middle)
+        )
+    );
+    ASSERT_TRUE(bad.GetAll().empty());
+}
+
+TEST(MessageHeadersTests, GetHeaderByIndex) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_EQ(0, headers.GetHeaderCount());
+    headers.SetHeader("Host", "www.example.com");
+    headers.AddHeader("Via", "A");
+    ASSERT_EQ(2, headers.GetHeaderCount());
+    ASSERT_EQ("Host", headers.GetHeader(0).name);
+    ASSERT_EQ("www.example.com", headers.GetHeader(0).value);
+    ASSERT_EQ("Via", headers.GetHeader(1).name);
+    ASSERT_EQ("A", headers.GetHeader(1).value);
+}
+
+TEST(MessageHeadersTests, DefaultDuplicatePolicies) {
+    const std::string rawMessage = (
+        "Accept: text/html\r\n"
+        "Set-Cookie: a=1\r\n"
+        "User-Agent: first\r\n"
+        "accept: text/plain\r\n"
+        "Set-Cookie: b=2\r\n"
+        "User-Agent: second\r\n"
+        "X-PePe: <3\r\n"
+        "X-PePe: SeemsGood\r\n"
+        "\r\n"
+    );
+    MessageHeaders::MessageHeaders headers;
+    headers.UseDefaultDuplicatePolicies();
+    ASSERT_TRUE(headers.ParseRawMessage(rawMessage));
+    ASSERT_EQ(
+        "Accept: text/html,text/plain\r\n"
+        "Set-Cookie: a=1\r\n"
+        "User-Agent: first\r\n"
+        "Set-Cookie: b=2\r\n"
+        "X-PePe: <3\r\n"
+        "X-PePe: SeemsGood\r\n"
+        "\r\n",
+        headers.GenerateRawHeaders()
+    );
+
+    headers = MessageHeaders::MessageHeaders();
+    headers.UseDefaultDuplicatePolicies();
+    ASSERT_FALSE(
+        headers.ParseRawMessage(
+            "Host: www.example.com\r\n"
+            "Host: evil.example.com\r\n"
+            "\r\n"
+        )
+    );
+}
+
+TEST(MessageHeadersTests, CustomDuplicatePolicies) {
+    const std::string rawMessage = (
+        "X-PePe: <3\r\n"
+        "Accept: text/html\r\n"
+        "X-PePe: SeemsGood\r\n"
+        "Accept: text/plain\r\n"
+        "Via: A\r\n"
+        "Via: B\r\n"
+        "\r\n"
+    );
+    MessageHeaders::MessageHeaders headers;
+    headers.SetDuplicatePolicy("x-pepe", MessageHeaders::DuplicatePolicy::LastWins);
+    headers.SetDuplicatePolicy("Accept", MessageHeaders::DuplicatePolicy::FirstWins);
+    ASSERT_TRUE(headers.ParseRawMessage(rawMessage));
+    ASSERT_EQ(
+        "X-PePe: SeemsGood\r\n"
+        "Accept: text/html\r\n"
+        "Via: A\r\n"
+        "Via: B\r\n"
+        "\r\n",
+        headers.GenerateRawHeaders()
+    );
+}
+
+TEST(MessageHeadersTests, DuplicatePoliciesInParallelParsing) {
+    std::string rawMessage;
+    for (size_t i = 0; i < 100; ++i) {
+        rawMessage += "Accept: type/" + std::to_string(i) + "\r\n";
+    }
+    rawMessage += "\r\n";
+    MessageHeaders::MessageHeaders headers;
+    headers.SetParallelParsing(256, 4);
+    headers.UseDefaultDuplicatePolicies();
+    ASSERT_TRUE(headers.ParseRawMessage(rawMessage));
+    ASSERT_EQ(1, headers.GetHeaderCount());
+    ASSERT_EQ(0, headers.GetHeaderValue("Accept").find("type/0,type/1,type/2,"));
+}
+
+TEST(MessageHeadersTests, ParallelParsingFailsLikeSerialParsing) {
+    std::string filler;
+    for (size_t i = 0; i < 50; ++i) {
+        filler += "X-Filler-" + std::to_string(i) + ": value\r\n";
+    }
+    const std::vector< std::string > rawMessages{
+        filler + "Host: a\r\n" + filler + "Host: b\r\n" + filler + "\r\n",
+        filler + "Host: a\r\n" + filler + "Host: b\r\n" + filler + "Bad line\r\n" + filler + "\r\n",
+        filler + "Host: a\r\n" + filler + "Bad line\r\n" + filler + "Host: b\r\n" + filler + "\r\n",
+        filler + "Host: a\r\n" + filler + "Accept: x\r\n" + filler + "Accept: y\r\n\r\n",
+    };
+    for (const auto& rawMessage : rawMessages) {
+        MessageHeaders::MessageHeaders serial;
+        MessageHeaders::MessageHeaders parallel;
+        parallel.SetParallelParsing(256, 4);
+        for (auto headers : {&serial, &parallel}) {
+            headers->UseDefaultDuplicatePolicies();
+            headers->SetDuplicatePolicy("Host", MessageHeaders::DuplicatePolicy::Reject);
+        }
+        const auto parsed = serial.ParseRawMessage(rawMessage);
+        EXPECT_EQ(parsed, parallel.ParseRawMessage(rawMessage));
+        EXPECT_EQ(serial.GetLastParseError(), parallel.GetLastParseError());
+        if (parsed) {
+            EXPECT_EQ(serial.GenerateRawHeaders(), parallel.GenerateRawHeaders());
+        }
+        else {
+            EXPECT_EQ(0, parallel.GetHeaderCount());
+        }
+    }
+
+    // The engines used for pieces and for the whole block may get
+    // different distances through a bad line before giving up.
+    std::string rawMessage = (
+        "Host: v3\r\r\n"
+        "Accept: v2\r\n"
+        "X-A: v0\r\n"
+        "Set-Cookie: v4\r\n"
+        "X-A: v3\r\n"
+        " \r\n"
+        "Accept: v4\r\n"
+    );
+    rawMessage += filler + "\r\n";
+    MessageHeaders::MessageHeaders serial;
+    serial.SetDuplicatePolicy("X-A", MessageHeaders::DuplicatePolicy::Reject);
+    ASSERT_FALSE(serial.ParseRawMessage(rawMessage));
+    EXPECT_EQ(
+        MessageHeaders::MessageHeaders::ParseError::DuplicateRejected,
+        serial.GetLastParseError()
+    );
+    for (const auto threads : {2, 4, 8}) {
+        MessageHeaders::MessageHeaders parallel;
+        parallel.SetParallelParsing(64, threads);
+        parallel.SetDuplicatePolicy("X-A", MessageHeaders::DuplicatePolicy::Reject);
+        ASSERT_FALSE(parallel.ParseRawMessage(rawMessage));
+        EXPECT_EQ(serial.GetLastParseError(), parallel.GetLastParseError()) << threads;
+        EXPECT_EQ(0, parallel.GetHeaderCount()) << threads;
+    }
+
+    // A duplicate of a header stored before parsing is rejected too.
+    MessageHeaders::MessageHeaders parallel;
+    parallel.SetParallelParsing(256, 4);
+    parallel.SetDuplicatePolicy("Host", MessageHeaders::DuplicatePolicy::Reject);
+    parallel.AddHeader("Host", "a");
+    EXPECT_FALSE(parallel.ParseRawMessage(filler + "Host: b\r\n" + filler + "\r\n"));
+    EXPECT_EQ(
+        MessageHeaders::MessageHeaders::ParseError::DuplicateRejected,
+        parallel.GetLastParseError()
+    );
+    EXPECT_EQ(1, parallel.GetHeaderCount());
+}
+
+TEST(MessageHeadersTests, WellKnownHeadersFoundAfterChanges) {
+    MessageHeaders::MessageHeaders headers;
+    headers.UseDefaultDuplicatePolicies();
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "X-Custom: 1\r\n"
+            "Host: www.example.com\r\n"
+            "Via: A\r\n"
+            "via: B\r\n"
+            "Content-Length: 10\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_EQ(1, headers.FindHeader("HOST"));
+    ASSERT_EQ(4, headers.FindHeader("Host", 2));
+    ASSERT_EQ(4, headers.FindHeader("Via", 3));
+    ASSERT_EQ("A,B", headers.GetHeaderValue("Via"));
+    headers.RemoveHeader("X-Custom");
+    ASSERT_EQ(0, headers.FindHeader("Host"));
+    ASSERT_EQ(2, headers.FindHeader("Content-Length"));
+    headers.SetHeader("Via", "C");
+    ASSERT_EQ("C", headers.GetHeaderValue("Via"));
+    headers.AddHeader("Via", "D");
+    ASSERT_EQ(3, headers.FindHeader("Via", 2));
+    headers.RemoveHeader("Host");
+    ASSERT_FALSE(headers.HasHeader("Host"));
+    ASSERT_EQ("", headers.GetHeaderValue("Host"));
+    headers.AddHeader("Host", "a");
+    headers.AddHeader("Host", "b");
+    ASSERT_TRUE(headers.HasHeader("host"));
+    ASSERT_EQ("a,b", headers.GetHeaderValue("Host"));
+    ASSERT_EQ(3, headers.FindHeader("Host", 3));
+
+    // Parsing without duplicate policies keeps the index up to date too.
+    MessageHeaders::MessageHeaders plain;
+    ASSERT_TRUE(plain.ParseRawMessage("Accept: x\r\nHost: y\r\n\r\n"));
+    ASSERT_EQ(1, plain.FindHeader("Host"));
+    ASSERT_EQ("y", plain.GetHeaderValue("Host"));
+}
+
+TEST(MessageHeadersTests, FindHeaderByName) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Via: A\r\n"
+            "Host: www.example.com\r\n"
+            "via: B\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_EQ(0, headers.FindHeader("VIA"));
+    ASSERT_EQ(2, headers.FindHeader("Via", 1));
+    ASSERT_EQ(3, headers.FindHeader("Via", 3));
+    ASSERT_EQ(1, headers.FindHeader("host"));
+    ASSERT_EQ(3, headers.FindHeader("X-PePe"));
+    ASSERT_EQ(
+        MessageHeaders::MessageHeaders::HeaderName("Via").GetHash(),
+        headers.GetHeader(2).name.GetHash()
+    );
+}
+
+TEST(MessageHeadersTests, EquivalentIgnoresInterleavingAndCase) {
+    MessageHeaders::MessageHeaders lhs, rhs;
+    ASSERT_TRUE(
+        lhs.ParseRawMessage(
+            "Via: A\r\n"
+            "Host: www.example.com\r\n"
+            "Via: B\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_TRUE(
+        rhs.ParseRawMessage(
+            "host: www.example.com\r\n"
+            "VIA: A\r\n"
+            "via: B\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_EQ(lhs.SemanticHash(), rhs.SemanticHash());
+    ASSERT_TRUE(MessageHeaders::Equivalent(lhs, rhs));
+}
+
+TEST(MessageHeadersTests, EquivalentRespectsOrderOfValuesSharingAName) {
+    MessageHeaders::MessageHeaders lhs, rhs;
+    ASSERT_TRUE(lhs.ParseRawMessage("Via: A\r\nVia: B\r\n\r\n"));
+    ASSERT_TRUE(rhs.ParseRawMessage("Via: B\r\nVia: A\r\n\r\n"));
+    ASSERT_NE(lhs.SemanticHash(), rhs.SemanticHash());
+    ASSERT_FALSE(MessageHeaders::Equivalent(lhs, rhs));
+    MessageHeaders::MessageHeaders differentValue;
+    ASSERT_TRUE(differentValue.ParseRawMessage("Via: A\r\nVia: b\r\n\r\n"));
+    ASSERT_FALSE(MessageHeaders::Equivalent(lhs, differentValue));
+    MessageHeaders::MessageHeaders extraHeader;
+    ASSERT_TRUE(extraHeader.ParseRawMessage("Via: A\r\nVia: B\r\nVia: C\r\n\r\n"));
+    ASSERT_FALSE(MessageHeaders::Equivalent(lhs, extraHeader));
+}
+
+TEST(MessageHeadersTests, EquivalentManyHeaders) {
+    MessageHeaders::MessageHeaders lhs, rhs, swapped;
+    for (size_t i = 0; i < 50; ++i) {
+        lhs.AddHeader("X-" + std::to_string(i), "a");
+        lhs.AddHeader("X-Shared", std::to_string(i));
+    }
+    for (size_t i = 50; i-- > 0;) {
+        rhs.AddHeader("x-" + std::to_string(i), "a");
+        swapped.AddHeader("x-" + std::to_string(i), "a");
+    }
+    for (size_t i = 0; i < 50; ++i) {
+        rhs.AddHeader("x-shared", std::to_string(i));
+        swapped.AddHeader("X-SHARED", std::to_string((i + 1) % 50));
+    }
+    ASSERT_TRUE(MessageHeaders::Equivalent(lhs, rhs));
+    ASSERT_TRUE(MessageHeaders::Equivalent(rhs, lhs));
+    ASSERT_FALSE(MessageHeaders::Equivalent(lhs, swapped));
+    rhs.SetHeader("X-49", "b");
+    ASSERT_FALSE(MessageHeaders::Equivalent(lhs, rhs));
+}
+
+TEST(MessageHeadersTests, SemanticHashKeptUpToDateByModifications) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_EQ(0, headers.SemanticHash());
+    headers.AddHeader("Via", "A");
+    headers.AddHeader("Host", "www.example.com");
+    headers.AddHeader("Via", "B");
+    headers.AddHeader("X-PePe", "<3");
+    headers.SetHeader("Host", "example.org");
+    headers.RemoveHeader("x-pepe");
+    headers.EditHeaderValue(2, [](std::string& value) { value += "2"; });
+    MessageHeaders::MessageHeaders expected;
+    ASSERT_TRUE(
+        expected.ParseRawMessage(
+            "Host: example.org\r\n"
+            "Via: A\r\n"
+            "Via: B2\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_EQ(expected.SemanticHash(), headers.SemanticHash());
+    ASSERT_TRUE(MessageHeaders::Equivalent(expected, headers));
+    headers.SetHeader("Via", "C");
+    ASSERT_NE(expected.SemanticHash(), headers.SemanticHash());
+    ASSERT_FALSE(MessageHeaders::Equivalent(expected, headers));
+}
+
+TEST(MessageHeadersTests, SemanticHashOfAddedWellKnownHeaders) {
+    MessageHeaders::MessageHeaders built;
+    built.AddHeader("Via", "A");
+    built.AddHeader("Host", "www.example.com");
+    built.AddHeader("via", "B");
+    built.AddHeader("X-Custom", "1");
+    built.AddHeader("VIA", "C");
+    built.AddHeader("x-custom", "2");
+    built.EditHeaderValue(1, [](std::string& value) { value = "example.org"; });
+    built.EditHeaderValue(2, [](std::string& value) { value += "2"; });
+    MessageHeaders::MessageHeaders parsed;
+    ASSERT_TRUE(
+        parsed.ParseRawMessage(
+            "Host: example.org\r\n"
+            "X-Custom: 1\r\n"
+            "Via: A\r\n"
+            "Via: B2\r\n"
+            "X-Custom: 2\r\n"
+            "Via: C\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_EQ(parsed.SemanticHash(), built.SemanticHash());
+    ASSERT_TRUE(MessageHeaders::Equivalent(parsed, built));
+}
+
+TEST(MessageHeadersTests, SemanticHashOfManyHeaders) {
+    std::string forwards, backwards;
+    for (size_t i = 0; i < 100; ++i) {
+        forwards += "Via: " + std::to_string(i) + "\r\n";
+        forwards += "X-" + std::to_string(i) + ": " + std::to_string(i) + "\r\n";
+        backwards = "X-" + std::to_string(i) + ": " + std::to_string(i) + "\r\n" + backwards;
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        backwards += "Via: " + std::to_string(i) + "\r\n";
+    }
+    MessageHeaders::MessageHeaders lhs, rhs;
+    ASSERT_TRUE(lhs.ParseRawMessage(forwards + "\r\n"));
+    ASSERT_TRUE(rhs.ParseRawMessage(backwards + "\r\n"));
+    ASSERT_EQ(lhs.SemanticHash(), rhs.SemanticHash());
+    ASSERT_TRUE(MessageHeaders::Equivalent(lhs, rhs));
+    MessageHeaders::MessageHeaders built;
+    for (size_t i = 0; i < 100; ++i) {
+        built.AddHeader("Via", std::to_string(i));
+        built.AddHeader("x-" + std::to_string(i), std::to_string(i));
+    }
+    ASSERT_EQ(lhs.SemanticHash(), built.SemanticHash());
+}
+
+TEST(MessageHeadersTests, FingerprintCoversOrderAndCasingButNotValues) {
+    const auto fingerprint = [](const std::string& rawMessage) {
+        MessageHeaders::MessageHeaders headers;
+        headers.SetFingerprinting(true);
+        EXPECT_TRUE(headers.ParseRawMessage(rawMessage));
+        return headers.GetFingerprint();
+    };
+    const auto original = fingerprint(
+        "Host: www.example.com\r\n"
+        "User-Agent: curl/7.64.1\r\n"
+        "Accept: */*\r\n"
+        "X-PePe: <3\r\n"
+        "\r\n"
+    );
+    ASSERT_NE(0, original);
+    ASSERT_EQ(
+        original,
+        fingerprint(
+            "Host: example.org\r\n"
+            "User-Agent: Mozilla/5.0\r\n"
+            "Accept: text/html\r\n"
+            "X-PePe: SeemsGood\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_NE(
+        original,
+        fingerprint(
+            "User-Agent: curl/7.64.1\r\n"
+            "Host: www.example.com\r\n"
+            "Accept: */*\r\n"
+            "X-PePe: <3\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_NE(
+        original,
+        fingerprint(
+            "host: www.example.com\r\n"
+            "user-agent: curl/7.64.1\r\n"
+            "accept: */*\r\n"
+            "x-pepe: <3\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_NE(
+        original,
+        fingerprint(
+            "Host: www.example.com\r\n"
+            "User-Agent: curl/7.64.1\r\n"
+            "Accept: */*\r\n"
+            "X-FeelsBadMan: <3\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_NE(
+        original,
+        fingerprint(
+            "Host: www.example.com\r\n"
+            "User-Agent: curl/7.64.1\r\n"
+            "Accept: */*\r\n"
+            "Accept: */*\r\n"
+            "X-PePe: <3\r\n"
+            "\r\n"
+        )
+    );
+}
+
+TEST(MessageHeadersTests, FingerprintOffByDefault) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(headers.ParseRawMessage("Host: www.example.com\r\n\r\n"));
+    ASSERT_EQ(0, headers.GetFingerprint());
+}
+
+TEST(MessageHeadersTests, FingerprintSameWhenParsedInParallel) {
+    std::string rawMessage;
+    for (size_t i = 0; i < 200; ++i) {
+        rawMessage += "Received: from host" + std::to_string(i) + "\r\n";
+        rawMessage += "X-Hop-" + std::to_string(i % 7) + ": " + std::to_string(i) + "\r\n";
+    }
+    rawMessage += "\r\n";
+    MessageHeaders::MessageHeaders serial, parallel;
+    serial.SetFingerprinting(true);
+    parallel.SetFingerprinting(true);
+    parallel.SetParallelParsing(1024, 4);
+    parallel.UseDefaultDuplicatePolicies();
+    ASSERT_TRUE(serial.ParseRawMessage(rawMessage));
+    ASSERT_TRUE(parallel.ParseRawMessage(rawMessage));
+    ASSERT_NE(0, serial.GetFingerprint());
+    ASSERT_EQ(serial.GetFingerprint(), parallel.GetFingerprint());
+}
+
+TEST(MessageHeadersTests, ToJsonCombiningDuplicates) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Via: A\r\n"
+            "Host: www.example.com\r\n"
+            "via: B\r\n"
+            "X-Quote: say \"hi\"\r\n"
+            "\r\n"
+        )
+    );
+    std::string json = "prefix ";
+    headers.ToJson(json);
+    ASSERT_EQ(
+        "prefix {\"Via\":\"A,B\",\"Host\":\"www.example.com\",\"X-Quote\":\"say \\\"hi\\\"\"}",
+        json
+    );
+}
+
+TEST(MessageHeadersTests, ToJsonArraysOfDuplicatesAndLowercaseNames) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Via: A\r\n"
+            "Host: www.example.com\r\n"
+            "VIA: B\r\n"
+            "\r\n"
+        )
+    );
+    MessageHeaders::JsonOptions options;
+    options.duplicates = MessageHeaders::JsonDuplicates::Array;
+    options.lowercaseNames = true;
+    std::string json;
+    headers.ToJson(json, options);
+    ASSERT_EQ("{\"via\":[\"A\",\"B\"],\"host\":\"www.example.com\"}", json);
+}
+
+TEST(MessageHeadersTests, ToJsonManyNamesAndObsText) {
+    MessageHeaders::MessageHeaders headers;
+    std::string expected = "{";
+    for (size_t i = 0; i < 100; ++i) {
+        headers.AddHeader("X-" + std::to_string(i), "a");
+        if (i > 0) {
+            expected += ',';
+        }
+        expected += "\"X-" + std::to_string(i) + "\":\"a,b\"";
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        headers.AddHeader("x-" + std::to_string(i), "b");
+    }
+    headers.AddHeader("X-Latin-1", "caf\xE9");
+    expected += ",\"X-Latin-1\":\"caf\\ufffd\"}";
+    std::string json;
+    headers.ToJson(json);
+    ASSERT_EQ(expected, json);
+}
+
+TEST(MessageHeadersTests, ToJsonGroupsAroundStackLimit) {
+    for (const size_t count : {63, 64, 65, 66}) {
+        MessageHeaders::MessageHeaders headers;
+        std::string expected = "{";
+        for (size_t i = 0; i < count / 2; ++i) {
+            if (i > 0) {
+                expected += ',';
+            }
+            expected += "\"X-" + std::to_string(i) + "\":\"a,b\"";
+        }
+        for (size_t i = 0; i < count; ++i) {
+            headers.AddHeader(((i % 2 == 0) ? "X-" : "x-") + std::to_string(i / 2), (i % 2 == 0) ? "a" : "b");
+        }
+        if (count % 2 != 0) {
+            expected += ",\"X-" + std::to_string(count / 2) + "\":\"a\"";
+        }
+        expected += '}';
+        std::string json;
+        headers.ToJson(json);
+        EXPECT_EQ(expected, json) << count;
+    }
+}
+
+TEST(MessageHeadersTests, ToJsonNoHeaders) {
+    MessageHeaders::MessageHeaders headers;
+    std::string json;
+    headers.ToJson(json);
+    ASSERT_EQ("{}", json);
+}
+
+TEST(MessageHeadersTests, LastParseError) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_EQ(MessageHeaders::MessageHeaders::ParseError::None, headers.GetLastParseError());
+    ASSERT_FALSE(headers.ParseRawMessage("Host www.example.com\r\n\r\n"));
+    ASSERT_EQ(MessageHeaders::MessageHeaders::ParseError::Malformed, headers.GetLastParseError());
+
+    MessageHeaders::MessageHeaders strictHeaders;
+    strictHeaders.SetDuplicatePolicy("Host", MessageHeaders::DuplicatePolicy::Reject);
+    ASSERT_FALSE(
+        strictHeaders.ParseRawMessage(
+            "Host: www.example.com\r\n"
+            "Host: www.example.org\r\n"
+            "\r\n"
+        )
+    );
+    ASSERT_EQ(MessageHeaders::MessageHeaders::ParseError::DuplicateRejected, strictHeaders.GetLastParseError());
+
+    MessageHeaders::MessageHeaders goodHeaders;
+    ASSERT_TRUE(goodHeaders.ParseRawMessage("Host: www.example.com\r\n\r\n"));
+    ASSERT_EQ(MessageHeaders::MessageHeaders::ParseError::None, goodHeaders.GetLastParseError());
+}
@@ -0,0 +1,130 @@
+/**
+ * @file RedactionPolicyTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::RedactionPolicy class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/RedactionPolicy.hpp>
+#include <string>
+
+namespace {
+    /**
+     * This function returns the value of the given header,
+     * hidden as the given policy says.
+     *
+     * @param[in] policy
+     *     This is the redaction policy to apply.
+     *
+     * @param[in] name
+     *     This is the name of the header.
+     *
+     * @param[in] value
+     *     This is the value of the header.
+     *
+     * @return
+     *     The hidden value is returned, or "(not covered)"
+     *     if the header isn't sensitive.
+     */
+    std::string Redact(
+        const MessageHeaders::RedactionPolicy& policy,
+        const std::string& name,
+        std::string_view value
+    ) {
+        std::string output;
+        if (
+            !policy.Redact(
+                name,
+                value,
+                [&output](std::string_view piece) {
+                    output += piece;
+                }
+            )
+        ) {
+            return "(not covered)";
+        }
+        return output;
+    }
+}
+
+TEST(RedactionPolicyTests, DefaultNames) {
+    MessageHeaders::RedactionPolicy policy;
+    policy.UseDefaultNames();
+    ASSERT_EQ("Bearer [REDACTED]", Redact(policy, "authorization", "Bearer abc.def.ghi"));
+    ASSERT_EQ("[REDACTED]", Redact(policy, "Proxy-Authorization", "token"));
+    ASSERT_EQ("id=[REDACTED]; lang=[REDACTED]", Redact(policy, "Cookie", "id=abc;lang=en-US"));
+    ASSERT_EQ(
+        "id=[REDACTED]; Path=[REDACTED]; Secure",
+        Redact(policy, "Set-Cookie", "id=abc; Path=/; Secure")
+    );
+    ASSERT_EQ("[REDACTED]", Redact(policy, "X-API-KEY", "12345678"));
+    ASSERT_EQ("(not covered)", Redact(policy, "Host", "www.example.com"));
+    ASSERT_TRUE(policy.Covers("x-auth-token"));
+    ASSERT_FALSE(policy.Covers("Accept"));
+}
+
+TEST(RedactionPolicyTests, CustomNamesAndKeepTail) {
+    MessageHeaders::RedactionPolicy policy;
+    policy.AddName("X-Card-Number", MessageHeaders::RedactionMode::KeepTail);
+    policy.AddName("X-Session", MessageHeaders::RedactionMode::KeepTail, 2);
+    ASSERT_EQ("[REDACTED]1111", Redact(policy, "x-card-number", "4111111111111111"));
+    ASSERT_EQ("[REDACTED]", Redact(policy, "X-Card-Number", "1111"));
+    ASSERT_EQ("[REDACTED]yz", Redact(policy, "X-Session", "abcxyz"));
+
+    // Adding a name again replaces its rule.
+    policy.AddName("x-session");
+    ASSERT_EQ("[REDACTED]", Redact(policy, "X-Session", "abcxyz"));
+}
+
+TEST(RedactionPolicyTests, RawHeadersRedacted) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Host: www.example.com\r\n"
+            "Authorization: Basic dXNlcjpwYXNz\r\n"
+            "Cookie: id=abc; theme=dark\r\n"
+            "\r\n"
+        )
+    );
+    MessageHeaders::RedactionPolicy policy;
+    policy.UseDefaultNames();
+    ASSERT_EQ(
+        "Host: www.example.com\r\n"
+        "Authorization: Basic [REDACTED]\r\n"
+        "Cookie: id=[REDACTED]; theme=[REDACTED]\r\n"
+        "\r\n",
+        headers.GenerateRawHeaders(policy)
+    );
+
+    // The headers themselves are untouched.
+    ASSERT_EQ("Basic dXNlcjpwYXNz", headers.GetHeaderValue("Authorization"));
+}
+
+TEST(RedactionPolicyTests, JsonRedacted) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Host: www.example.com\r\n"
+            "Set-Cookie: a=1\r\n"
+            "Set-Cookie: b=2\r\n"
+            "X-Api-Key: \"secret\"\r\n"
+            "\r\n"
+        )
+    );
+    MessageHeaders::RedactionPolicy policy;
+    policy.UseDefaultNames();
+    MessageHeaders::JsonOptions options;
+    options.duplicates = MessageHeaders::JsonDuplicates::Array;
+    options.redaction = &policy;
+    std::string json;
+    headers.ToJson(json, options);
+    ASSERT_EQ(
+        "{\"Host\":\"www.example.com\","
+        "\"Set-Cookie\":[\"a=[REDACTED]\",\"b=[REDACTED]\"],"
+        "\"X-Api-Key\":\"[REDACTED]\"}",
+        json
+    );
+}
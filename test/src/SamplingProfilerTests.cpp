@@ -0,0 +1,131 @@
+/**
+ * @file SamplingProfilerTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::SamplingProfiler class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/SamplingProfiler.hpp>
+#include <thread>
+#include <vector>
+
+TEST(SamplingProfilerTests, OneInEveryInterval) {
+    MessageHeaders::SamplingProfiler profiler(4);
+    size_t sampled = 0;
+    for (size_t i = 0; i < 100; ++i) {
+        if (profiler.ShouldSample()) {
+            ++sampled;
+        }
+    }
+    EXPECT_EQ(25, sampled);
+}
+
+TEST(SamplingProfilerTests, ZeroIntervalSamplesNothing) {
+    MessageHeaders::SamplingProfiler profiler(0);
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_FALSE(profiler.ShouldSample());
+    }
+}
+
+TEST(SamplingProfilerTests, RecordAndDrain) {
+    MessageHeaders::SamplingProfiler profiler(1, 8);
+    MessageHeaders::ProfileSample sample;
+    sample.operation = MessageHeaders::ProfiledOperation::Lookup;
+    sample.duration = 42;
+    sample.bytes = 7;
+    sample.headers = 3;
+    profiler.Record(sample);
+    sample.operation = MessageHeaders::ProfiledOperation::Generate;
+    profiler.Record(sample);
+    std::vector< MessageHeaders::ProfileSample > samples;
+    ASSERT_EQ(2, profiler.Drain(samples));
+    ASSERT_EQ(2, samples.size());
+    EXPECT_EQ(MessageHeaders::ProfiledOperation::Lookup, samples[0].operation);
+    EXPECT_EQ(42, samples[0].duration);
+    EXPECT_EQ(7, samples[0].bytes);
+    EXPECT_EQ(3, samples[0].headers);
+    EXPECT_EQ(MessageHeaders::ProfiledOperation::Generate, samples[1].operation);
+    EXPECT_EQ(0, profiler.Drain(samples));
+    EXPECT_EQ(2, samples.size());
+}
+
+TEST(SamplingProfilerTests, FullBufferDropsSamples) {
+    MessageHeaders::SamplingProfiler profiler(1, 4);
+    for (size_t i = 0; i < 10; ++i) {
+        MessageHeaders::ProfileSample sample;
+        sample.bytes = i;
+        profiler.Record(sample);
+    }
+    EXPECT_EQ(6, profiler.GetDroppedCount());
+    std::vector< MessageHeaders::ProfileSample > samples;
+    ASSERT_EQ(4, profiler.Drain(samples));
+    EXPECT_EQ(0, samples[0].bytes);
+    EXPECT_EQ(3, samples[3].bytes);
+
+    // Draining makes room again.
+    profiler.Record({});
+    EXPECT_EQ(1, profiler.Drain(samples));
+}
+
+TEST(SamplingProfilerTests, RecordFromSeveralThreadsWhileDraining) {
+    MessageHeaders::SamplingProfiler profiler(1, 4096);
+    std::vector< std::thread > workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back(
+            [&profiler]{
+                for (size_t i = 0; i < 1000; ++i) {
+                    MessageHeaders::ProfileSample sample;
+                    sample.bytes = i;
+                    profiler.Record(sample);
+                }
+            }
+        );
+    }
+    std::vector< MessageHeaders::ProfileSample > samples;
+    for (size_t i = 0; i < 100; ++i) {
+        (void)profiler.Drain(samples);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    (void)profiler.Drain(samples);
+    EXPECT_EQ(4000, samples.size());
+    EXPECT_EQ(0, profiler.GetDroppedCount());
+}
+
+TEST(SamplingProfilerTests, ProfilesMessageHeaders) {
+    MessageHeaders::SamplingProfiler profiler(1);
+    MessageHeaders::MessageHeaders headers;
+    headers.SetProfiler(&profiler);
+    const std::string rawHeaders = (
+        "Host: www.example.com\r\n"
+        "Accept: text/html\r\n"
+        "Accept: text/plain\r\n"
+        "\r\n"
+    );
+    ASSERT_TRUE(headers.ParseRawMessage(rawHeaders));
+    ASSERT_EQ("text/html,text/plain", headers.GetHeaderValue("Accept"));
+    ASSERT_EQ(2, headers.GetHeaderMultiValue("Accept").size());
+    const auto generated = headers.GenerateRawHeaders();
+    std::vector< MessageHeaders::ProfileSample > samples;
+    ASSERT_EQ(4, profiler.Drain(samples));
+    EXPECT_EQ(MessageHeaders::ProfiledOperation::Parse, samples[0].operation);
+    EXPECT_EQ(rawHeaders.length(), samples[0].bytes);
+    EXPECT_EQ(3, samples[0].headers);
+    EXPECT_EQ(MessageHeaders::ProfiledOperation::Lookup, samples[1].operation);
+    EXPECT_EQ(20, samples[1].bytes);
+    EXPECT_EQ(MessageHeaders::ProfiledOperation::Lookup, samples[2].operation);
+    EXPECT_EQ(19, samples[2].bytes);
+    EXPECT_EQ(MessageHeaders::ProfiledOperation::Generate, samples[3].operation);
+    EXPECT_EQ(generated.length(), samples[3].bytes);
+    EXPECT_LE(samples[0].startTime, samples[3].startTime);
+
+    // Calls aren't timed without a profiler.
+    headers.SetProfiler(nullptr);
+    (void)headers.GetHeaderValue("Host");
+    EXPECT_EQ(0, profiler.Drain(samples));
+}
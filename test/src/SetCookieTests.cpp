@@ -0,0 +1,147 @@
+/**
+ * @file SetCookieTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::SetCookie, MessageHeaders::SetCookies and
+ * MessageHeaders::SetCookieBuilder classes.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/SetCookie.hpp>
+#include <string>
+#include <vector>
+
+TEST(SetCookieTests, NameAndValue) {
+    MessageHeaders::SetCookie cookie(" sid = 31d4d96e407aad42 ");
+    ASSERT_TRUE(cookie.IsValid());
+    ASSERT_EQ("sid", cookie.GetName());
+    ASSERT_EQ("31d4d96e407aad42", cookie.GetValue());
+    ASSERT_TRUE(MessageHeaders::SetCookie("empty=").IsValid());
+    ASSERT_FALSE(MessageHeaders::SetCookie("no-equals-sign; Path=/").IsValid());
+    ASSERT_FALSE(MessageHeaders::SetCookie("=no-name").IsValid());
+}
+
+TEST(SetCookieTests, Attributes) {
+    const std::string headerValue = (
+        "sid=31d4d96e407aad42; path=/docs; Domain=.example.com; "
+        "Expires=Sun, 06 Nov 1994 08:49:37 GMT; Max-Age=3600; "
+        "secure; HttpOnly; SameSite=lax; Path=/"
+    );
+    MessageHeaders::SetCookie cookie(headerValue);
+    ASSERT_EQ("/", cookie.GetPath());
+    ASSERT_EQ("example.com", cookie.GetDomain());
+    int64_t time = 0;
+    ASSERT_TRUE(cookie.GetExpires(time));
+    ASSERT_EQ(784111777, time);
+    ASSERT_TRUE(cookie.GetMaxAge(time));
+    ASSERT_EQ(3600, time);
+    ASSERT_TRUE(cookie.IsSecure());
+    ASSERT_TRUE(cookie.IsHttpOnly());
+    ASSERT_EQ(MessageHeaders::SameSite::Lax, cookie.GetSameSite());
+    ASSERT_EQ(headerValue.data() + headerValue.find("example.com"), cookie.GetDomain().data());
+}
+
+TEST(SetCookieTests, MissingOrBadAttributes) {
+    MessageHeaders::SetCookie cookie("lang=en-US; Path=docs; Max-Age=soon; Expires=later; SameSite=sometimes");
+    ASSERT_EQ("", cookie.GetPath());
+    ASSERT_EQ("", cookie.GetDomain());
+    int64_t time = 0;
+    ASSERT_FALSE(cookie.GetExpires(time));
+    ASSERT_FALSE(cookie.GetMaxAge(time));
+    ASSERT_FALSE(cookie.IsSecure());
+    ASSERT_FALSE(cookie.IsHttpOnly());
+    ASSERT_EQ(MessageHeaders::SameSite::Unspecified, cookie.GetSameSite());
+    ASSERT_TRUE(MessageHeaders::SetCookie("a=b; Max-Age=-1").GetMaxAge(time));
+    ASSERT_EQ(-1, time);
+}
+
+TEST(SetCookieTests, MaxAgeSaturates) {
+    int64_t time = 0;
+    ASSERT_TRUE(MessageHeaders::SetCookie("a=b; Max-Age=9223372036854775807").GetMaxAge(time));
+    ASSERT_EQ(INT64_MAX, time);
+    ASSERT_TRUE(MessageHeaders::SetCookie("a=b; Max-Age=9223372036854775808").GetMaxAge(time));
+    ASSERT_EQ(INT64_MAX, time);
+    ASSERT_TRUE(MessageHeaders::SetCookie("a=b; Max-Age=99999999999999999999999").GetMaxAge(time));
+    ASSERT_EQ(INT64_MAX, time);
+    ASSERT_TRUE(MessageHeaders::SetCookie("a=b; Max-Age=-99999999999999999999999").GetMaxAge(time));
+    ASSERT_EQ(-INT64_MAX, time);
+}
+
+TEST(SetCookieTests, BuildExtremeMaxAgeAndExpires) {
+    MessageHeaders::MessageHeaders headers;
+    MessageHeaders::SetCookieBuilder(headers, "a", "b")
+        .SetMaxAge(INT64_MIN)
+        .SetExpires(INT64_MIN);
+    MessageHeaders::SetCookieBuilder(headers, "c", "d")
+        .SetMaxAge(INT64_MAX)
+        .SetExpires(INT64_MAX);
+    ASSERT_EQ(
+        "Set-Cookie: a=b; Max-Age=-9223372036854775808; Expires=Mon, 01 Jan 1601 00:00:00 GMT\r\n"
+        "Set-Cookie: c=d; Max-Age=9223372036854775807; Expires=Fri, 31 Dec 9999 23:59:59 GMT\r\n"
+        "\r\n",
+        headers.GenerateRawHeaders()
+    );
+}
+
+TEST(SetCookieTests, IterateSetCookieHeaders) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Set-Cookie: a=1; Expires=Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+            "Content-Type: text/html\r\n"
+            "set-cookie: b=2\r\n"
+            "Set-Cookie: c=3, d=4\r\n"
+            "\r\n"
+        )
+    );
+    std::vector< std::string > names;
+    for (const auto& cookie: MessageHeaders::SetCookies(headers)) {
+        names.emplace_back(cookie.GetName());
+        names.back() += '=';
+        names.back() += cookie.GetValue();
+    }
+    ASSERT_EQ(
+        (std::vector< std::string >{"a=1", "b=2", "c=3, d=4"}),
+        names
+    );
+
+    MessageHeaders::MessageHeaders noCookies;
+    noCookies.AddHeader("Content-Type", "text/html");
+    const MessageHeaders::SetCookies cookies(noCookies);
+    ASSERT_TRUE(cookies.begin() == cookies.end());
+}
+
+TEST(SetCookieTests, BuildSetCookieHeaders) {
+    MessageHeaders::MessageHeaders headers;
+    headers.AddHeader("Content-Type", "text/html");
+    MessageHeaders::SetCookieBuilder(headers, "sid", "31d4d96e407aad42")
+        .SetPath("/")
+        .SetDomain("example.com")
+        .SetExpires(784111777)
+        .SetMaxAge(3600)
+        .SetSameSite(MessageHeaders::SameSite::Strict)
+        .SetSecure()
+        .SetHttpOnly();
+    MessageHeaders::SetCookieBuilder(headers, "lang", "en-US");
+    ASSERT_EQ(
+        "Content-Type: text/html\r\n"
+        "Set-Cookie: sid=31d4d96e407aad42; Path=/; Domain=example.com; "
+        "Expires=Sun, 06 Nov 1994 08:49:37 GMT; Max-Age=3600; "
+        "SameSite=Strict; Secure; HttpOnly\r\n"
+        "Set-Cookie: lang=en-US\r\n"
+        "\r\n",
+        headers.GenerateRawHeaders()
+    );
+
+    size_t count = 0;
+    for (const auto& cookie: MessageHeaders::SetCookies(headers)) {
+        if (count++ == 0) {
+            ASSERT_EQ("sid", cookie.GetName());
+            ASSERT_EQ(MessageHeaders::SameSite::Strict, cookie.GetSameSite());
+            ASSERT_TRUE(cookie.IsHttpOnly());
+        }
+    }
+    ASSERT_EQ(2, count);
+}
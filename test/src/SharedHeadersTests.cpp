@@ -0,0 +1,114 @@
+/**
+ * @file SharedHeadersTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::SharedHeaders class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/SharedHeaders.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(SharedHeadersTests, StartsEmpty) {
+    MessageHeaders::SharedHeaders defaults;
+    const auto guard = defaults.Read();
+    EXPECT_EQ(0, guard.GetHeaders().size());
+    EXPECT_EQ("\r\n", guard.GetHeaders().GenerateRawHeaders());
+}
+
+TEST(SharedHeadersTests, PublishAndMerge) {
+    MessageHeaders::SharedHeaders defaults;
+    MessageHeaders::MessageHeaders configured;
+    configured.AddHeader("Server", "Example/1.0");
+    configured.AddHeader("X-Frame-Options", "DENY");
+    defaults.Publish(configured);
+    const auto guard = defaults.Read();
+    const auto& headers = guard.GetHeaders();
+    ASSERT_EQ(2, headers.size());
+    EXPECT_EQ("Server", headers[0].name);
+    EXPECT_EQ("Example/1.0", headers[0].value);
+    EXPECT_EQ("X-Frame-Options", headers[1].name);
+    EXPECT_EQ("DENY", headers[1].value);
+    EXPECT_EQ(configured.GenerateRawHeaders(), headers.GenerateRawHeaders());
+
+    MessageHeaders::MessageHeaders response;
+    response.AddHeader("Content-Type", "text/html");
+    response.AddHeader("Server", "Other");
+    response.SetHeaders(headers);
+    EXPECT_EQ(
+        "Content-Type: text/html\r\n"
+        "Server: Example/1.0\r\n"
+        "X-Frame-Options: DENY\r\n"
+        "\r\n",
+        response.GenerateRawHeaders()
+    );
+}
+
+TEST(SharedHeadersTests, ReplacedVersionKeptWhileRead) {
+    MessageHeaders::SharedHeaders defaults;
+    MessageHeaders::MessageHeaders configured;
+    configured.AddHeader("Server", "First");
+    defaults.Publish(configured);
+    EXPECT_EQ(0, defaults.Reclaim());
+    {
+        const auto guard = defaults.Read();
+        configured.SetHeader("Server", "Second");
+        defaults.Publish(configured);
+        EXPECT_EQ("First", guard.GetHeaders()[0].value);
+        {
+            const auto nestedGuard = defaults.Read();
+            EXPECT_EQ("Second", nestedGuard.GetHeaders()[0].value);
+            configured.SetHeader("Server", "Third");
+            defaults.Publish(configured);
+            EXPECT_EQ(2, defaults.Reclaim());
+        }
+        EXPECT_EQ("First", guard.GetHeaders()[0].value);
+        EXPECT_EQ(2, defaults.Reclaim());
+    }
+    EXPECT_EQ(0, defaults.Reclaim());
+    EXPECT_EQ("Third", defaults.Read().GetHeaders()[0].value);
+}
+
+TEST(SharedHeadersTests, ReadWhilePublishing) {
+    MessageHeaders::SharedHeaders defaults;
+    MessageHeaders::MessageHeaders configured;
+    configured.AddHeader("X-Version", "0");
+    defaults.Publish(configured);
+    std::atomic< bool > stop{false};
+    std::vector< std::thread > readers;
+    for (size_t t = 0; t < 4; ++t) {
+        readers.emplace_back(
+            [&defaults, &stop]{
+                size_t lastVersion = 0;
+                while (!stop) {
+                    const auto guard = defaults.Read();
+                    const auto& headers = guard.GetHeaders();
+                    ASSERT_EQ(1, headers.size());
+                    const auto version = std::stoul(std::string(headers[0].value));
+                    EXPECT_GE(version, lastVersion);
+                    lastVersion = version;
+                    EXPECT_EQ(
+                        "X-Version: " + std::string(headers[0].value) + "\r\n\r\n",
+                        headers.GenerateRawHeaders()
+                    );
+                }
+            }
+        );
+    }
+    for (size_t i = 1; i <= 1000; ++i) {
+        configured.SetHeader("X-Version", std::to_string(i));
+        defaults.Publish(configured);
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(0, defaults.Reclaim());
+    EXPECT_EQ("1000", defaults.Read().GetHeaders()[0].value);
+}
@@ -0,0 +1,185 @@
+/**
+ * @file SignatureBaseTests.cpp
+ *
+ * This module contains the unit tests of the
+ * HTTP Message Signatures signature base functions.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/SignatureBase.hpp>
+#include <string>
+
+namespace {
+    /**
+     * This function builds the signature base for the given
+     * message and signature parameters into a string.
+     *
+     * @param[in] headers
+     *     These are the headers of the message.
+     *
+     * @param[in] derivedComponents
+     *     These are the parts of the message from which
+     *     derived components take their values.
+     *
+     * @param[in] signatureParams
+     *     These are the signature parameters.
+     *
+     * @param[out] signatureBase
+     *     This is where to store the signature base.
+     *
+     * @return
+     *     An indication of whether or not the signature base
+     *     could be built is returned.
+     */
+    bool Build(
+        const MessageHeaders::MessageHeaders& headers,
+        const MessageHeaders::SignatureDerivedComponents& derivedComponents,
+        const std::string& signatureParams,
+        std::string& signatureBase
+    ) {
+        signatureBase.clear();
+        return MessageHeaders::BuildSignatureBase(
+            headers,
+            derivedComponents,
+            signatureParams,
+            [&signatureBase](std::string_view piece) {
+                signatureBase.append(piece.data(), piece.length());
+            }
+        );
+    }
+}
+
+TEST(SignatureBaseTests, RequestExample) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Host: example.com\r\n"
+            "Date: Tue, 20 Apr 2021 02:07:55 GMT\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Digest: sha-512=:WZDPaVn/7XgHaAy8pmojAkGWoRx2UFChF41A2svX+TaPm+AbwAgBWnrIiYllu7BNNyealdVLvRwEmTHWXvJwew==:\r\n"
+            "Content-Length: 18\r\n"
+            "\r\n"
+        )
+    );
+    MessageHeaders::SignatureDerivedComponents derivedComponents;
+    derivedComponents.method = "POST";
+    derivedComponents.authority = "Example.com";
+    derivedComponents.path = "/foo";
+    derivedComponents.query = "?param=Value&Pet=dog";
+    std::string signatureBase;
+    ASSERT_TRUE(
+        Build(
+            headers,
+            derivedComponents,
+            "(\"@method\" \"@authority\" \"@path\" \"content-digest\" \"content-length\" \"content-type\")"
+            ";created=1618884473;keyid=\"test-key-rsa-pss\"",
+            signatureBase
+        )
+    );
+    ASSERT_EQ(
+        "\"@method\": POST\n"
+        "\"@authority\": example.com\n"
+        "\"@path\": /foo\n"
+        "\"content-digest\": sha-512=:WZDPaVn/7XgHaAy8pmojAkGWoRx2UFChF41A2svX+TaPm+AbwAgBWnrIiYllu7BNNyealdVLvRwEmTHWXvJwew==:\n"
+        "\"content-length\": 18\n"
+        "\"content-type\": application/json\n"
+        "\"@signature-params\": (\"@method\" \"@authority\" \"@path\" \"content-digest\" \"content-length\" \"content-type\")"
+        ";created=1618884473;keyid=\"test-key-rsa-pss\"",
+        signatureBase
+    );
+
+    ASSERT_TRUE(
+        Build(
+            headers,
+            derivedComponents,
+            "(\"@query\" \"@query-param\";name=\"Pet\");created=1618884473",
+            signatureBase
+        )
+    );
+    ASSERT_EQ(
+        "\"@query\": ?param=Value&Pet=dog\n"
+        "\"@query-param\";name=\"Pet\": dog\n"
+        "\"@signature-params\": (\"@query\" \"@query-param\";name=\"Pet\");created=1618884473",
+        signatureBase
+    );
+}
+
+TEST(SignatureBaseTests, StructuredFieldParameters) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Example-Dict:  a=1,    b=2;x=1;y=2,   c=(a   b   c)\r\n"
+            "Example-Header: value, with, lots\r\n"
+            "Example-Header: of, commas\r\n"
+            "Example-Keys: a=1, b=2;x=1;y=2, c=(a b c)\r\n"
+            "Example-Keys: d, a=3\r\n"
+            "\r\n"
+        )
+    );
+    const MessageHeaders::SignatureDerivedComponents derivedComponents;
+    std::string signatureBase;
+    ASSERT_TRUE(
+        Build(
+            headers,
+            derivedComponents,
+            "(\"example-dict\" \"example-dict\";sf \"example-header\" \"example-header\";bs)",
+            signatureBase
+        )
+    );
+    ASSERT_EQ(
+        "\"example-dict\": a=1,    b=2;x=1;y=2,   c=(a   b   c)\n"
+        "\"example-dict\";sf: a=1, b=2;x=1;y=2, c=(a b c)\n"
+        "\"example-header\": value, with, lots, of, commas\n"
+        "\"example-header\";bs: :dmFsdWUsIHdpdGgsIGxvdHM=:, :b2YsIGNvbW1hcw==:\n"
+        "\"@signature-params\": (\"example-dict\" \"example-dict\";sf \"example-header\" \"example-header\";bs)",
+        signatureBase
+    );
+    ASSERT_TRUE(
+        Build(
+            headers,
+            derivedComponents,
+            "(\"example-keys\";key=\"a\" \"example-keys\";key=\"b\" \"example-keys\";key=\"c\" \"example-keys\";key=\"d\")",
+            signatureBase
+        )
+    );
+    ASSERT_EQ(
+        "\"example-keys\";key=\"a\": 3\n"
+        "\"example-keys\";key=\"b\": 2;x=1;y=2\n"
+        "\"example-keys\";key=\"c\": (a b c)\n"
+        "\"example-keys\";key=\"d\": ?1\n"
+        "\"@signature-params\": (\"example-keys\";key=\"a\" \"example-keys\";key=\"b\" \"example-keys\";key=\"c\" \"example-keys\";key=\"d\")",
+        signatureBase
+    );
+}
+
+TEST(SignatureBaseTests, BadSignatureParams) {
+    MessageHeaders::MessageHeaders headers;
+    headers.AddHeader("Content-Type", "application/json");
+    MessageHeaders::SignatureDerivedComponents derivedComponents;
+    derivedComponents.method = "GET";
+    std::string signatureBase;
+    for (const auto signatureParams: {
+        "",
+        "\"content-type\"",
+        "(\"content-type\"",
+        "(\"Content-Type\")",
+        "(\"content-type\" \"content-type\")",
+        "(\"content-length\")",
+        "(\"@authority\")",
+        "(\"@unknown\")",
+        "(\"@signature-params\")",
+        "(\"content-type\";req)",
+        "(\"content-type\";sf;bs)",
+        "(\"@method\";sf)",
+        "(\"@query-param\")",
+        "(\"@query-param\";name=\"missing\")",
+        "(\"example-keys\";key=\"missing\")",
+        "(\"content-type\"\"@method\")",
+    }) {
+        ASSERT_FALSE(Build(headers, derivedComponents, signatureParams, signatureBase)) << signatureParams;
+    }
+    ASSERT_TRUE(Build(headers, derivedComponents, "()", signatureBase));
+    ASSERT_EQ("\"@signature-params\": ()", signatureBase);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file StaticHeadersTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::StaticHeaders class template.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/MessageHeaders.hpp>
+#include <MessageHeaders/StaticHeaders.hpp>
+
+namespace {
+    constexpr auto SECURITY_HEADERS = MESSAGE_HEADERS_STATIC(
+        "X-Content-Type-Options: nosniff\r\n"
+        "X-Frame-Options:DENY  \r\n"
+        "Set-Cookie: a=1\r\n"
+        "Set-Cookie: b=2\r\n"
+        "\r\n"
+    );
+
+    constexpr auto NO_HEADERS = MESSAGE_HEADERS_STATIC("\r\n");
+
+    static_assert(SECURITY_HEADERS.size() == 4, "headers are counted at compile time");
+    static_assert(SECURITY_HEADERS[1].name == "X-Frame-Options", "names are parsed at compile time");
+    static_assert(SECURITY_HEADERS[1].value == "DENY", "values are parsed at compile time");
+    static_assert(NO_HEADERS.size() == 0, "an empty header block has no headers");
+}
+
+TEST(StaticHeadersTests, BadHeaderBlocks) {
+    const std::vector< std::string > badHeaderBlocks{
+        "",
+        "X: y\r\n",
+        "X: y\r\n\r\nbody",
+        "X y\r\n\r\n",
+        "Feels Bad Man: LUL\r\n\r\n",
+        "Subject: This\r\n is a test\r\n\r\n",
+    };
+    size_t index = 0;
+    for (const auto& badHeaderBlock : badHeaderBlocks) {
+        ASSERT_THROW(MessageHeaders::CountStaticHeaders(badHeaderBlock), std::invalid_argument) << index;
+        ++index;
+    }
+}
+
+TEST(StaticHeadersTests, GenerateRawHeaders) {
+    ASSERT_EQ(
+        "X-Content-Type-Options: nosniff\r\n"
+        "X-Frame-Options:DENY  \r\n"
+        "Set-Cookie: a=1\r\n"
+        "Set-Cookie: b=2\r\n"
+        "\r\n",
+        SECURITY_HEADERS.GenerateRawHeaders()
+    );
+    const MessageHeaders::StaticHeaderTable table = SECURITY_HEADERS;
+    ASSERT_EQ(SECURITY_HEADERS.GenerateRawHeaders(), table.GenerateRawHeaders());
+    ASSERT_EQ(4, table.size());
+}
+
+TEST(StaticHeadersTests, MergeIntoMessageHeaders) {
+    MessageHeaders::MessageHeaders headers;
+    headers.SetHeader("Host", "www.example.com");
+    headers.AddHeader("x-frame-options", "SAMEORIGIN");
+    headers.AddHeader("Set-Cookie", "c=3");
+    headers.SetHeaders(SECURITY_HEADERS);
+    ASSERT_EQ(
+        "Host: www.example.com\r\n"
+        "X-Content-Type-Options: nosniff\r\n"
+        "X-Frame-Options: DENY\r\n"
+        "Set-Cookie: a=1\r\n"
+        "Set-Cookie: b=2\r\n"
+        "\r\n",
+        headers.GenerateRawHeaders()
+    );
+    headers.AddHeaders(NO_HEADERS);
+    headers.AddHeaders(SECURITY_HEADERS);
+    ASSERT_EQ(9, headers.GetHeaderCount());
+}
@@ -0,0 +1,183 @@
+/**
+ * @file TraceContextTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::TraceContext class and related functions.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/TraceContext.hpp>
+#include <string>
+#include <vector>
+
+TEST(TraceContextTests, ParseTraceParent) {
+    MessageHeaders::TraceParent traceParent;
+    ASSERT_TRUE(
+        MessageHeaders::ParseTraceParent(
+            "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01",
+            traceParent
+        )
+    );
+    ASSERT_EQ(0, traceParent.version);
+    ASSERT_EQ(0x0af7651916cd43ddULL, traceParent.traceIdHigh);
+    ASSERT_EQ(0x8448eb211c80319cULL, traceParent.traceIdLow);
+    ASSERT_EQ(0xb7ad6b7169203331ULL, traceParent.parentId);
+    ASSERT_EQ(1, traceParent.flags);
+    ASSERT_TRUE(traceParent.IsSampled());
+    ASSERT_TRUE(
+        MessageHeaders::ParseTraceParent(
+            "cc-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-00-what-the-future-holds",
+            traceParent
+        )
+    );
+    ASSERT_EQ(0xcc, traceParent.version);
+    ASSERT_FALSE(traceParent.IsSampled());
+}
+
+TEST(TraceContextTests, ParseBadTraceParent) {
+    MessageHeaders::TraceParent traceParent;
+    for (const auto value: {
+        "",
+        "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331",
+        "00-0AF7651916CD43DD8448EB211C80319C-B7AD6B7169203331-01",
+        "00-0af7651916cd43dd8448eb211c80319c_b7ad6b7169203331-01",
+        "00-00000000000000000000000000000000-b7ad6b7169203331-01",
+        "00-0af7651916cd43dd8448eb211c80319c-0000000000000000-01",
+        "ff-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01",
+        "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01-extra",
+        "01-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01extra",
+        "00-0af7651916cd43dd8448eb211c80319c-b7ad6b716920333g-01",
+    }) {
+        ASSERT_FALSE(MessageHeaders::ParseTraceParent(value, traceParent)) << value;
+    }
+}
+
+TEST(TraceContextTests, ListViews) {
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "TraceParent: 00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01\r\n"
+            "tracestate: rojo=00f067aa0ba902b7, ,congo=t61rcWkgMzE\r\n"
+            "Baggage: userId=alice,serverNode = DF%2028 ; prop1;prop2=x, isProduction=false\r\n"
+            "\r\n"
+        )
+    );
+    const MessageHeaders::TraceContext context(headers);
+    MessageHeaders::TraceParent traceParent;
+    ASSERT_TRUE(context.GetTraceParent(traceParent));
+    ASSERT_EQ(0xb7ad6b7169203331ULL, traceParent.parentId);
+
+    std::vector< std::string > members;
+    for (const auto& member: context.GetTraceState()) {
+        members.emplace_back(std::string(member.key) + "|" + std::string(member.value));
+    }
+    ASSERT_EQ(
+        (std::vector< std::string >{"rojo|00f067aa0ba902b7", "congo|t61rcWkgMzE"}),
+        members
+    );
+
+    members.clear();
+    for (const auto& member: context.GetBaggage()) {
+        members.emplace_back(
+            std::string(member.key) + "|" + std::string(member.value) + "|" + std::string(member.properties)
+        );
+    }
+    ASSERT_EQ(
+        (std::vector< std::string >{"userId|alice|", "serverNode|DF%2028|prop1;prop2=x", "isProduction|false|"}),
+        members
+    );
+    std::string_view value;
+    ASSERT_TRUE(context.GetBaggage().Find("isProduction", value));
+    ASSERT_EQ("false", value);
+    ASSERT_FALSE(context.GetTraceState().Find("azul", value));
+
+    MessageHeaders::MessageHeaders noHeaders;
+    const MessageHeaders::TraceContext noContext(noHeaders);
+    ASSERT_FALSE(noContext.GetTraceParent(traceParent));
+    ASSERT_TRUE(noContext.GetBaggage().begin() == noContext.GetBaggage().end());
+}
+
+TEST(TraceContextTests, ListsOverRepeatedHeaders) {
+    // Repeated headers are read as one list, whether parsed or added.
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "baggage: userId=alice\r\n"
+            "tracestate: rojo=00f067aa0ba902b7\r\n"
+            "Baggage: isProduction=false\r\n"
+            "\r\n"
+        )
+    );
+    headers.AddHeader("TraceState", "");
+    headers.AddHeader("tracestate", "congo=t61rcWkgMzE, azul=1");
+    const MessageHeaders::TraceContext context(headers);
+
+    std::vector< std::string > members;
+    for (const auto& member: context.GetTraceState()) {
+        members.emplace_back(std::string(member.key) + "|" + std::string(member.value));
+    }
+    ASSERT_EQ(
+        (std::vector< std::string >{"rojo|00f067aa0ba902b7", "congo|t61rcWkgMzE", "azul|1"}),
+        members
+    );
+    members.clear();
+    for (const auto& member: context.GetBaggage()) {
+        members.emplace_back(std::string(member.key) + "|" + std::string(member.value));
+    }
+    ASSERT_EQ(
+        (std::vector< std::string >{"userId|alice", "isProduction|false"}),
+        members
+    );
+    std::string_view value;
+    ASSERT_TRUE(context.GetTraceState().Find("azul", value));
+    ASSERT_EQ("1", value);
+    ASSERT_TRUE(context.GetBaggage().Find("isProduction", value));
+    ASSERT_EQ("false", value);
+
+    // The same view can be made of any headers by name.
+    const MessageHeaders::TraceContextList traceState(headers, "tracestate");
+    ASSERT_TRUE(traceState.Find("congo", value));
+    ASSERT_EQ("t61rcWkgMzE", value);
+}
+
+TEST(TraceContextTests, SetAndForwardTraceParent) {
+    MessageHeaders::MessageHeaders headers;
+    headers.AddHeader("Host", "www.example.com");
+    ASSERT_FALSE(MessageHeaders::ForwardTraceParent(headers, 0x1234, true));
+
+    MessageHeaders::TraceParent traceParent;
+    traceParent.traceIdHigh = 0x0af7651916cd43ddULL;
+    traceParent.traceIdLow = 0x8448eb211c80319cULL;
+    traceParent.parentId = 0xb7ad6b7169203331ULL;
+    traceParent.flags = 0x01;
+    MessageHeaders::SetTraceParent(headers, traceParent);
+    ASSERT_EQ(
+        "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01",
+        headers.GetHeaderValue("traceparent")
+    );
+
+    const auto valueData = headers.GetHeader(1).value.data();
+    ASSERT_TRUE(MessageHeaders::ForwardTraceParent(headers, 0x00f067aa0ba902b7ULL, false));
+    ASSERT_EQ(
+        "00-0af7651916cd43dd8448eb211c80319c-00f067aa0ba902b7-00",
+        headers.GetHeaderValue("traceparent")
+    );
+    ASSERT_EQ(valueData, headers.GetHeader(1).value.data());
+
+    traceParent.parentId = 1;
+    MessageHeaders::SetTraceParent(headers, traceParent);
+    ASSERT_EQ(2, headers.GetHeaderCount());
+    ASSERT_EQ(
+        "00-0af7651916cd43dd8448eb211c80319c-0000000000000001-01",
+        headers.GetHeaderValue("traceparent")
+    );
+
+    headers.SetHeader("traceparent", "cc-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01-future");
+    ASSERT_TRUE(MessageHeaders::ForwardTraceParent(headers, 2, true));
+    ASSERT_EQ(
+        "00-0af7651916cd43dd8448eb211c80319c-0000000000000002-01",
+        headers.GetHeaderValue("traceparent")
+    );
+}
@@ -0,0 +1,214 @@
+/**
+ * @file UserAgentClassifierTests.cpp
+ *
+ * This module contains the unit tests of the
+ * MessageHeaders::UserAgentClassifier class.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/UserAgentClassifier.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(UserAgentClassifierTests, DesktopBrowsers) {
+    struct TestVector {
+        std::string userAgent;
+        MessageHeaders::UserAgentBrowser browser;
+        MessageHeaders::UserAgentOs os;
+    };
+    const std::vector< TestVector > testVectors{
+        {
+            "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/74.0.3729.169 Safari/537.36",
+            MessageHeaders::UserAgentBrowser::Chrome,
+            MessageHeaders::UserAgentOs::Windows
+        },
+        {
+            "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/74.0.3729.169 Safari/537.36 Edg/74.1.96.24",
+            MessageHeaders::UserAgentBrowser::Edge,
+            MessageHeaders::UserAgentOs::Windows
+        },
+        {
+            "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_14_5) AppleWebKit/605.1.15 (KHTML, like Gecko) Version/12.1.1 Safari/605.1.15",
+            MessageHeaders::UserAgentBrowser::Safari,
+            MessageHeaders::UserAgentOs::MacOs
+        },
+        {
+            "Mozilla/5.0 (X11; Ubuntu; Linux x86_64; rv:67.0) Gecko/20100101 Firefox/67.0",
+            MessageHeaders::UserAgentBrowser::Firefox,
+            MessageHeaders::UserAgentOs::Linux
+        },
+        {
+            "Mozilla/5.0 (X11; CrOS x86_64 11895.118.0) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/74.0.3729.159 Safari/537.36 OPR/60.0.3255.109",
+            MessageHeaders::UserAgentBrowser::Opera,
+            MessageHeaders::UserAgentOs::ChromeOs
+        },
+        {
+            "Mozilla/5.0 (Windows NT 6.1; WOW64; Trident/7.0; rv:11.0) like Gecko",
+            MessageHeaders::UserAgentBrowser::InternetExplorer,
+            MessageHeaders::UserAgentOs::Windows
+        },
+    };
+    size_t index = 0;
+    for (const auto& testVector : testVectors) {
+        const auto result = MessageHeaders::ClassifyUserAgent(testVector.userAgent);
+        EXPECT_EQ(testVector.browser, result.browser) << index;
+        EXPECT_EQ(testVector.os, result.os) << index;
+        EXPECT_EQ(MessageHeaders::UserAgentDevice::Desktop, result.device) << index;
+        EXPECT_FALSE(result.isBot) << index;
+        ++index;
+    }
+}
+
+TEST(UserAgentClassifierTests, MobileDevices) {
+    auto result = MessageHeaders::ClassifyUserAgent(
+        "Mozilla/5.0 (iPhone; CPU iPhone OS 12_3_1 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like Gecko) Version/12.1.1 Mobile/15E148 Safari/604.1"
+    );
+    EXPECT_EQ(MessageHeaders::UserAgentBrowser::Safari, result.browser);
+    EXPECT_EQ(MessageHeaders::UserAgentOs::Ios, result.os);
+    EXPECT_EQ(MessageHeaders::UserAgentDevice::Mobile, result.device);
+    result = MessageHeaders::ClassifyUserAgent(
+        "Mozilla/5.0 (iPad; CPU OS 12_2 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like Gecko) CriOS/74.0.3729.155 Mobile/15E148 Safari/605.1"
+    );
+    EXPECT_EQ(MessageHeaders::UserAgentBrowser::Chrome, result.browser);
+    EXPECT_EQ(MessageHeaders::UserAgentOs::Ios, result.os);
+    EXPECT_EQ(MessageHeaders::UserAgentDevice::Tablet, result.device);
+    result = MessageHeaders::ClassifyUserAgent(
+        "Mozilla/5.0 (Linux; Android 9; Pixel 3) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/74.0.3729.157 Mobile Safari/537.36"
+    );
+    EXPECT_EQ(MessageHeaders::UserAgentBrowser::Chrome, result.browser);
+    EXPECT_EQ(MessageHeaders::UserAgentOs::Android, result.os);
+    EXPECT_EQ(MessageHeaders::UserAgentDevice::Mobile, result.device);
+    result = MessageHeaders::ClassifyUserAgent(
+        "Mozilla/5.0 (Linux; Android 9; SM-T720) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/74.0.3729.157 Safari/537.36"
+    );
+    EXPECT_EQ(MessageHeaders::UserAgentOs::Android, result.os);
+    EXPECT_EQ(MessageHeaders::UserAgentDevice::Tablet, result.device);
+}
+
+TEST(UserAgentClassifierTests, Bots) {
+    EXPECT_TRUE(
+        MessageHeaders::ClassifyUserAgent(
+            "Mozilla/5.0 (compatible; Googlebot/2.1; +http://www.google.com/bot.html)"
+        ).isBot
+    );
+    EXPECT_TRUE(MessageHeaders::ClassifyUserAgent("curl/7.64.1").isBot);
+    EXPECT_TRUE(MessageHeaders::ClassifyUserAgent("python-requests/2.22.0").isBot);
+    EXPECT_TRUE(
+        MessageHeaders::ClassifyUserAgent(
+            "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) HeadlessChrome/74.0.3729.169 Safari/537.36"
+        ).isBot
+    );
+
+    // Tools only count as bots when the header begins with them.
+    EXPECT_FALSE(
+        MessageHeaders::ClassifyUserAgent(
+            "Mozilla/5.0 (Windows NT 10.0) Gecko/20100101 Firefox/67.0 curl/1.0"
+        ).isBot
+    );
+}
+
+TEST(UserAgentClassifierTests, BotAndChromeOsTokensNeedWordBoundaries) {
+    EXPECT_TRUE(MessageHeaders::ClassifyUserAgent("Twitterbot/1.0").isBot);
+    EXPECT_TRUE(MessageHeaders::ClassifyUserAgent("Googlebot-Image/1.0").isBot);
+    EXPECT_TRUE(MessageHeaders::ClassifyUserAgent("Mozilla/5.0 (compatible; YandexBot)").isBot);
+    EXPECT_TRUE(MessageHeaders::ClassifyUserAgent("SomeBot").isBot);
+    const auto cubot = MessageHeaders::ClassifyUserAgent(
+        "Mozilla/5.0 (Linux; Android 9; CUBOT_X19) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/74.0.3729.136 Mobile Safari/537.36"
+    );
+    EXPECT_FALSE(cubot.isBot);
+    EXPECT_EQ(MessageHeaders::UserAgentOs::Android, cubot.os);
+    EXPECT_TRUE(MessageHeaders::ClassifyUserAgent("DuckDuckBot-Https/1.1").isBot);
+    EXPECT_TRUE(MessageHeaders::ClassifyUserAgent("Mozilla/5.0 (compatible; bingbot/2.0; like Gecko)").isBot);
+    const auto cubotWithSpace = MessageHeaders::ClassifyUserAgent(
+        "Mozilla/5.0 (Linux; Android 9; CUBOT X19 Build/PPR1.180610.011) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/74.0.3729.136 Mobile Safari/537.36"
+    );
+    EXPECT_FALSE(cubotWithSpace.isBot);
+    EXPECT_EQ(MessageHeaders::UserAgentOs::Android, cubotWithSpace.os);
+    EXPECT_FALSE(MessageHeaders::ClassifyUserAgent("Mozilla/5.0 (X11; Linux x86_64) Bottle/1.0").isBot);
+
+    EXPECT_EQ(
+        MessageHeaders::UserAgentOs::ChromeOs,
+        MessageHeaders::ClassifyUserAgent("Mozilla/5.0 (X11; CrOS aarch64 13597.84.0)").os
+    );
+    EXPECT_EQ(
+        MessageHeaders::UserAgentOs::Linux,
+        MessageHeaders::ClassifyUserAgent("Mozilla/5.0 (X11; Linux x86_64) MicrosoftTeams/1.4").os
+    );
+    EXPECT_EQ(
+        MessageHeaders::UserAgentOs::Unknown,
+        MessageHeaders::ClassifyUserAgent("Microsoft-CryptoAPI/10.0").os
+    );
+}
+
+TEST(UserAgentClassifierTests, ClassifyRequestHeaders) {
+    MessageHeaders::UserAgentClassifier classifier;
+    MessageHeaders::MessageHeaders headers;
+    ASSERT_TRUE(
+        headers.ParseRawMessage(
+            "Host: www.example.com\r\n"
+            "user-agent: Mozilla/5.0 (X11; Linux x86_64; rv:67.0) Gecko/20100101 Firefox/67.0\r\n"
+            "\r\n"
+        )
+    );
+    const auto result = classifier.Classify(headers);
+    EXPECT_EQ(MessageHeaders::UserAgentBrowser::Firefox, result.browser);
+    EXPECT_EQ(MessageHeaders::UserAgentOs::Linux, result.os);
+    MessageHeaders::MessageHeaders noUserAgent;
+    const auto unknown = classifier.Classify(noUserAgent);
+    EXPECT_EQ(MessageHeaders::UserAgentBrowser::Unknown, unknown.browser);
+    EXPECT_EQ(MessageHeaders::UserAgentDevice::Unknown, unknown.device);
+    EXPECT_FALSE(unknown.isBot);
+}
+
+TEST(UserAgentClassifierTests, CacheHitsAndEviction) {
+    MessageHeaders::UserAgentClassifier classifier(16);
+    const std::string userAgent = "curl/7.64.1";
+    EXPECT_TRUE(classifier.Classify(userAgent).isBot);
+    EXPECT_TRUE(classifier.Classify(userAgent).isBot);
+    EXPECT_TRUE(classifier.Classify(userAgent).isBot);
+    EXPECT_EQ(2, classifier.GetCacheHitCount());
+    EXPECT_EQ(1, classifier.GetCacheMissCount());
+
+    // Enough other values push the first one out of the cache.
+    for (size_t i = 0; i < 1000; ++i) {
+        (void)classifier.Classify("agent/" + std::to_string(i));
+    }
+    EXPECT_EQ(1001, classifier.GetCacheMissCount());
+    EXPECT_TRUE(classifier.Classify(userAgent).isBot);
+    EXPECT_EQ(1002, classifier.GetCacheMissCount());
+}
+
+TEST(UserAgentClassifierTests, NoCache) {
+    MessageHeaders::UserAgentClassifier classifier(0);
+    (void)classifier.Classify("curl/7.64.1");
+    (void)classifier.Classify("curl/7.64.1");
+    EXPECT_EQ(0, classifier.GetCacheHitCount());
+    EXPECT_EQ(2, classifier.GetCacheMissCount());
+}
+
+TEST(UserAgentClassifierTests, ClassifyFromSeveralThreads) {
+    MessageHeaders::UserAgentClassifier classifier(64);
+    std::vector< std::thread > workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back(
+            [&classifier]{
+                for (size_t i = 0; i < 1000; ++i) {
+                    const auto result = classifier.Classify(
+                        (i % 2 == 0)
+                        ? "curl/7.64.1"
+                        : "Mozilla/5.0 (X11; Linux x86_64; rv:67.0) Gecko/20100101 Firefox/67.0"
+                    );
+                    EXPECT_EQ(i % 2 == 0, result.isBot);
+                }
+            }
+        );
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(4000, classifier.GetCacheHitCount() + classifier.GetCacheMissCount());
+    EXPECT_LE(classifier.GetCacheMissCount(), 8);
+}
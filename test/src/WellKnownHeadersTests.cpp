@@ -0,0 +1,34 @@
+/**
+ * @file WellKnownHeadersTests.cpp
+ *
+ * This module contains the unit tests of the
+ * well-known header table.
+ *
+ * 2019 by YaMing Wu
+ */
+
+#include <gtest/gtest.h>
+#include <MessageHeaders/WellKnownHeaders.hpp>
+
+TEST(WellKnownHeadersTests, FindWellKnownHeader) {
+    ASSERT_EQ(MessageHeaders::WellKnownHeader::Host, MessageHeaders::FindWellKnownHeader("Host"));
+    ASSERT_EQ(MessageHeaders::WellKnownHeader::Host, MessageHeaders::FindWellKnownHeader("hOST"));
+    ASSERT_EQ(MessageHeaders::WellKnownHeader::SetCookie, MessageHeaders::FindWellKnownHeader("set-cookie"));
+    ASSERT_EQ(MessageHeaders::WellKnownHeader::Traceparent, MessageHeaders::FindWellKnownHeader("Traceparent"));
+    ASSERT_EQ(MessageHeaders::WellKnownHeader::XRequestId, MessageHeaders::FindWellKnownHeader("X-Request-ID"));
+    ASSERT_EQ(MessageHeaders::WellKnownHeader::Unknown, MessageHeaders::FindWellKnownHeader("X-PePe"));
+    ASSERT_EQ(MessageHeaders::WellKnownHeader::Unknown, MessageHeaders::FindWellKnownHeader(""));
+}
+
+TEST(WellKnownHeadersTests, EveryEntryCanBeFound) {
+    for (size_t i = 1; i < MessageHeaders::WELL_KNOWN_HEADER_COUNT; ++i) {
+        const auto header = (MessageHeaders::WellKnownHeader)i;
+        const auto& info = MessageHeaders::GetWellKnownHeaderInfo(header);
+        ASSERT_EQ(header, MessageHeaders::FindWellKnownHeader(info.name)) << info.name;
+    }
+}
+
+TEST(WellKnownHeadersTests, HashHeaderNameIgnoresCase) {
+    ASSERT_EQ(MessageHeaders::HashHeaderName("Content-Type"), MessageHeaders::HashHeaderName("content-TYPE"));
+    ASSERT_NE(MessageHeaders::HashHeaderName("Content-Type"), MessageHeaders::HashHeaderName("Content-Length"));
+}